@@ -84,6 +84,54 @@ Page {
 
                 onToggled: recording.recordAudio = checked
             }
+            Label {
+                id: txtPreRoll
+                text: qsTr("Keep recording in the background")
+            }
+            Switch {
+                Accessible.name: txtPreRoll.text
+                Accessible.description:
+                    qsTr("Start the videos some seconds before pressing record")
+                Layout.columnSpan: 2
+                Layout.alignment: Qt.AlignRight | Qt.AlignVCenter
+                checked: recording.preRoll
+
+                onToggled: recording.preRoll = checked
+            }
+            Label {
+                id: txtPreRollDuration
+                text: qsTr("Seconds before recording")
+                enabled: recording.preRoll
+            }
+            SpinBox {
+                value: recording.preRollDuration
+                from: 1
+                to: 3600
+                stepSize: 1
+                editable: true
+                enabled: recording.preRoll
+                Accessible.name: txtPreRollDuration.text
+                Layout.columnSpan: 2
+
+                onValueChanged: recording.preRollDuration = value
+            }
+            Label {
+                id: txtPreRollMaxSize
+                text: qsTr("Maximum buffer size (MiB)")
+                enabled: recording.preRoll
+            }
+            SpinBox {
+                value: recording.preRollMaxSize
+                from: 1
+                to: 4096
+                stepSize: 1
+                editable: true
+                enabled: recording.preRoll
+                Accessible.name: txtPreRollMaxSize.text
+                Layout.columnSpan: 2
+
+                onValueChanged: recording.preRollMaxSize = value
+            }
             Label {
                 text: qsTr("Video quality")
                 font: AkTheme.fontSettings.h6
@@ -48,7 +48,9 @@
 #include <ak.h>
 #include <akaudiocaps.h>
 #include <akcaps.h>
+#include <akcompressedaudiopacket.h>
 #include <akcompressedcaps.h>
+#include <akcompressedvideopacket.h>
 #include <akfrac.h>
 #include <akpacket.h>
 #include <akplugininfo.h>
@@ -67,6 +69,12 @@
 #define DEFAULT_VIDEO_BITRATE 1500000
 #define DEFAULT_VIDEO_GOP 1000
 #define DEFAULT_RECORD_AUDIO true
+#define DEFAULT_PRE_ROLL false
+#define DEFAULT_PRE_ROLL_DURATION 30
+#define DEFAULT_PRE_ROLL_MAX_SIZE 256
+
+// Frames waiting to be encoded by each rendition before dropping frames
+#define RENDITION_MAX_PENDING_FRAMES 8
 
 struct CodecInfo
 {
@@ -97,7 +105,58 @@ struct PluginPriority
     int priority;
 };
 
+struct PreRollPacket
+{
+    AkPacket packet;
+    qreal time;
+    size_t size;
+    bool isKeyFrame;
+};
+
+struct RenditionProfile
+{
+    QString format;
+    QString videoCodec;
+    QString audioCodec;
+    int width;
+    int height;
+    int videoBitrate;
+    int audioBitrate;
+
+    static RenditionProfile fromMap(const QVariantMap &map);
+    QVariantMap toMap() const;
+    bool isValid() const;
+};
+
+class RenditionSession
+{
+    public:
+        RenditionProfile m_profile;
+        AkVideoMuxerPtr m_muxer;
+        AkAudioEncoderPtr m_audioEncoder;
+        AkVideoEncoderPtr m_videoEncoder;
+        QMetaObject::Connection m_audioHeadersChangedConnection;
+        QMetaObject::Connection m_videoHeadersChangedConnection;
+        QThreadPool m_audioThreadPool;
+        QThreadPool m_videoThreadPool;
+        std::atomic<int> m_pendingFrames {0};
+        int m_level {0};
+
+        explicit RenditionSession(const RenditionProfile &profile);
+        bool start(const QString &location,
+                   const AkAudioCaps &audioCaps,
+                   const AkVideoCaps &videoCaps,
+                   int gop);
+        void stop();
+        void pushAudio(const AkPacket &packet);
+        void pushVideo(const AkVideoPacket &packet);
+        void encodeAudio(const AkPacket &packet);
+        void encodeVideo(const AkVideoPacket &packet);
+};
+
 using ObjectPtr = QSharedPointer<QObject>;
+using RenditionSessionPtr = QSharedPointer<RenditionSession>;
+using AkVideoConverterPtr = QSharedPointer<AkVideoConverter>;
 
 class RecordingPrivate
 {
@@ -120,6 +179,8 @@ class RecordingPrivate
         QString m_videoPluginID;
         QMetaObject::Connection m_audioHeadersChangedConnection;
         QMetaObject::Connection m_videoHeadersChangedConnection;
+        QMetaObject::Connection m_audioPacketConnection;
+        QMetaObject::Connection m_videoPacketConnection;
         QString m_imageFormat {"png"};
         QString m_imagesDirectory;
         QString m_videoDirectory;
@@ -132,6 +193,14 @@ class RecordingPrivate
         QMutex m_mutex;
         QReadWriteLock m_thumbnailMutex;
         QMutex m_thumbnailerMutex;
+        QMutex m_preRollMutex;
+        QMutex m_renditionsMutex;
+        QList<RenditionProfile> m_renditions;
+        QList<RenditionSessionPtr> m_renditionSessions;
+        QVector<AkVideoConverterPtr> m_pyramid;
+        QList<PreRollPacket> m_preRollPackets;
+        size_t m_preRollBufferSize {0};
+        qreal m_timeOffset {0.0};
         QThreadPool m_threadPool;
         AkVideoPacket m_curPacket;
         QImage m_photo;
@@ -140,7 +209,12 @@ class RecordingPrivate
         AkElement::ElementState m_state {AkElement::ElementStateNull};
         int m_imageSaveQuality {-1};
         bool m_recordAudio {DEFAULT_RECORD_AUDIO};
+        int m_preRollDuration {DEFAULT_PRE_ROLL_DURATION};
+        int m_preRollMaxSize {DEFAULT_PRE_ROLL_MAX_SIZE};
+        bool m_preRoll {DEFAULT_PRE_ROLL};
         bool m_isRecording {false};
+        bool m_isPreRolling {false};
+        bool m_isMuxing {false};
         bool m_pause {false};
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_argbpack, 0, 0, {}}};
 
@@ -152,12 +226,25 @@ class RecordingPrivate
         void printRecordingParameters();
         bool init();
         void uninit();
+        void configureEncoders();
+        void startPreRoll();
+        void stopPreRoll();
+        void restartPreRoll();
+        void writePacket(const AkPacket &packet);
+        void muxPacket(const AkPacket &packet);
+        void trimPreRoll();
+        void startRenditions(const QString &currentTime);
+        void stopRenditions();
+        void feedRenditions(const AkPacket &packet);
+        void loadRenditions();
+        void saveRenditions();
         static QString normatizePluginID(const QString &pluginID);
         void loadConfigs();
         void loadFormatOptions();
         void loadCodecOptions(AkCaps::CapsType type);
         void updatePreviews();
         void readThumbnail(const QString &videoFile);
+        void loadThumbnail(qint64 mSecs);
         void thumbnailReady();
 
 #ifdef Q_OS_ANDROID
@@ -193,6 +280,9 @@ class RecordingPrivate
         void saveBitrate(AkCaps::CapsType type, int bitrate);
         void saveVideoGOP(int gop);
         void saveRecordAudio(bool recordAudio);
+        void savePreRoll(bool preRoll);
+        void savePreRollDuration(int preRollDuration);
+        void savePreRollMaxSize(int preRollMaxSize);
 
         // Picture
         void saveImagesDirectory(const QString &imagesDirectory);
@@ -220,11 +310,15 @@ Recording::Recording(QQmlApplicationEngine *engine, QObject *parent):
 
     this->d->loadConfigs();
     this->d->updatePreviews();
+    this->d->startPreRoll();
 }
 
 Recording::~Recording()
 {
+    // Don't restart the pre-roll when the recording stops.
+    this->d->m_preRoll = false;
     this->setState(AkElement::ElementStateNull);
+    this->d->stopPreRoll();
     delete this->d;
 }
 
@@ -512,6 +606,31 @@ bool Recording::recordAudio() const
     return this->d->m_recordAudio;
 }
 
+bool Recording::preRoll() const
+{
+    return this->d->m_preRoll;
+}
+
+int Recording::preRollDuration() const
+{
+    return this->d->m_preRollDuration;
+}
+
+int Recording::preRollMaxSize() const
+{
+    return this->d->m_preRollMaxSize;
+}
+
+QVariantList Recording::renditions() const
+{
+    QVariantList renditions;
+
+    for (auto &rendition: this->d->m_renditions)
+        renditions << rendition.toMap();
+
+    return renditions;
+}
+
 QString Recording::lastVideoPreview() const
 {
     return this->d->m_lastVideoPreview;
@@ -570,6 +689,7 @@ void Recording::setAudioCaps(const AkAudioCaps &audioCaps)
     this->d->m_audioCaps = audioCaps;
     emit this->audioCapsChanged(audioCaps);
     this->d->saveAudioCaps(audioCaps);
+    this->d->restartPreRoll();
 }
 
 void Recording::setVideoCaps(const AkVideoCaps &videoCaps)
@@ -580,6 +700,7 @@ void Recording::setVideoCaps(const AkVideoCaps &videoCaps)
     this->d->m_videoCaps = videoCaps;
     emit this->videoCapsChanged(videoCaps);
     this->d->saveVideoCaps(videoCaps);
+    this->d->restartPreRoll();
 }
 
 bool Recording::setState(AkElement::ElementState state)
@@ -685,11 +806,13 @@ void Recording::setVideoFormat(const QString &videoFormat)
     else
         qCritical() << "Failed to create the muxer:" << formatPluginID;
 
+    this->d->stopPreRoll();
     this->d->m_muxer = muxer;
     this->d->m_muxerPluginID = formatPluginID;
     emit this->videoFormatChanged(videoFormat);
     this->d->saveVideoFormat(videoFormat);
     this->d->loadFormatOptions();
+    this->d->startPreRoll();
 }
 
 void Recording::setCodec(AkCaps::CapsType type, const QString &codec)
@@ -715,11 +838,13 @@ void Recording::setCodec(AkCaps::CapsType type, const QString &codec)
         else
             qDebug() << "Failed to create the muxer:" << codecPluginID;
 
+        this->d->stopPreRoll();
         this->d->m_audioEncoder = encoder;
         this->d->m_audioPluginID = codecPluginID;
         emit this->codecChanged(type, codec);
         this->d->saveCodec(type, codec);
         this->d->loadCodecOptions(AkCaps::CapsAudio);
+        this->d->startPreRoll();
 
         break;
     }
@@ -744,11 +869,13 @@ void Recording::setCodec(AkCaps::CapsType type, const QString &codec)
         else
             qDebug() << "Failed to create the muxer:" << codecPluginID;
 
+        this->d->stopPreRoll();
         this->d->m_videoEncoder = encoder;
         this->d->m_videoPluginID = codecPluginID;
         emit this->codecChanged(type, codec);
         this->d->saveCodec(type, codec);
         this->d->loadCodecOptions(AkCaps::CapsVideo);
+        this->d->startPreRoll();
 
         break;
     }
@@ -818,6 +945,7 @@ void Recording::setBitrate(AkCaps::CapsType type, int bitrate)
         this->d->m_audioBitrate = bitrate;
         emit this->bitrateChanged(type, bitrate);
         this->d->saveBitrate(type, bitrate);
+        this->d->restartPreRoll();
 
         break;
 
@@ -831,6 +959,7 @@ void Recording::setBitrate(AkCaps::CapsType type, int bitrate)
         this->d->m_videoBitrate = bitrate;
         emit this->bitrateChanged(type, bitrate);
         this->d->saveBitrate(type, bitrate);
+        this->d->restartPreRoll();
 
         break;
 
@@ -847,6 +976,7 @@ void Recording::setVideoGOP(int gop)
     this->d->m_videoGOP = gop;
     emit this->videoGOPChanged(gop);
     this->d->saveVideoGOP(gop);
+    this->d->restartPreRoll();
 }
 
 void Recording::setRecordAudio(bool recordAudio)
@@ -859,6 +989,51 @@ void Recording::setRecordAudio(bool recordAudio)
     this->d->saveRecordAudio(recordAudio);
 }
 
+void Recording::setPreRoll(bool preRoll)
+{
+    if (this->d->m_preRoll == preRoll)
+        return;
+
+    this->d->m_preRoll = preRoll;
+    emit this->preRollChanged(preRoll);
+    this->d->savePreRoll(preRoll);
+
+    if (preRoll)
+        this->d->startPreRoll();
+    else
+        this->d->stopPreRoll();
+}
+
+void Recording::setPreRollDuration(int preRollDuration)
+{
+    preRollDuration = qMax(preRollDuration, 1);
+
+    if (this->d->m_preRollDuration == preRollDuration)
+        return;
+
+    this->d->m_preRollMutex.lock();
+    this->d->m_preRollDuration = preRollDuration;
+    this->d->trimPreRoll();
+    this->d->m_preRollMutex.unlock();
+    emit this->preRollDurationChanged(preRollDuration);
+    this->d->savePreRollDuration(preRollDuration);
+}
+
+void Recording::setPreRollMaxSize(int preRollMaxSize)
+{
+    preRollMaxSize = qMax(preRollMaxSize, 1);
+
+    if (this->d->m_preRollMaxSize == preRollMaxSize)
+        return;
+
+    this->d->m_preRollMutex.lock();
+    this->d->m_preRollMaxSize = preRollMaxSize;
+    this->d->trimPreRoll();
+    this->d->m_preRollMutex.unlock();
+    emit this->preRollMaxSizeChanged(preRollMaxSize);
+    this->d->savePreRollMaxSize(preRollMaxSize);
+}
+
 void Recording::setImagesDirectory(const QString &imagesDirectory)
 {
     if (this->d->m_imagesDirectory == imagesDirectory)
@@ -967,6 +1142,48 @@ void Recording::resetRecordAudio()
     this->setRecordAudio(DEFAULT_RECORD_AUDIO);
 }
 
+void Recording::setRenditions(const QVariantList &renditions)
+{
+    QList<RenditionProfile> profiles;
+    QVariantList validRenditions;
+
+    for (auto &rendition: renditions) {
+        auto profile = RenditionProfile::fromMap(rendition.toMap());
+
+        if (profile.isValid()) {
+            profiles << profile;
+            validRenditions << profile.toMap();
+        }
+    }
+
+    if (this->renditions() == validRenditions)
+        return;
+
+    this->d->m_renditions = profiles;
+    emit this->renditionsChanged(validRenditions);
+    this->d->saveRenditions();
+}
+
+void Recording::resetRenditions()
+{
+    this->setRenditions({});
+}
+
+void Recording::resetPreRoll()
+{
+    this->setPreRoll(DEFAULT_PRE_ROLL);
+}
+
+void Recording::resetPreRollDuration()
+{
+    this->setPreRollDuration(DEFAULT_PRE_ROLL_DURATION);
+}
+
+void Recording::resetPreRollMaxSize()
+{
+    this->setPreRollMaxSize(DEFAULT_PRE_ROLL_MAX_SIZE);
+}
+
 void Recording::resetImagesDirectory()
 {
     auto picturesPath =
@@ -1100,7 +1317,7 @@ AkPacket Recording::iStream(const AkPacket &packet)
         this->d->m_mutex.unlock();
     }
 
-    if (this->d->m_isRecording) {
+    if (this->d->m_isRecording || this->d->m_isPreRolling) {
         switch (packet.type()) {
         case AkPacket::PacketAudio:
             if (this->d->m_audioEncoder)
@@ -1119,6 +1336,9 @@ AkPacket Recording::iStream(const AkPacket &packet)
         }
     }
 
+    if (this->d->m_isRecording)
+        this->d->feedRenditions(packet);
+
     return {};
 }
 
@@ -1189,12 +1409,13 @@ void Recording::mediaLoaded(const QString &media)
     if (duration < 1)
         return;
 
-    QMetaObject::invokeMethod(this->d->m_thumbnailer.data(),
-                              "seek",
-                              Q_ARG(qint64, qint64(0.1 * duration)));
-    this->d->m_thumbnailerMutex.lock();
-    this->d->m_thumbnailer->setState(AkElement::ElementStatePlaying);
-    this->d->m_thumbnailerMutex.unlock();
+    // Opening and decoding the video can take a while, keep it out of the GUI.
+    auto result =
+            QtConcurrent::run(&this->d->m_threadPool,
+                              &RecordingPrivate::loadThumbnail,
+                              this->d,
+                              qint64(0.1 * duration));
+    Q_UNUSED(result)
 }
 
 RecordingPrivate::RecordingPrivate(Recording *self):
@@ -1589,6 +1810,7 @@ bool RecordingPrivate::init()
 
     auto currentTime =
             QDateTime::currentDateTime().toString("yyyy-MM-dd hh-mm-ss");
+    this->startRenditions(currentTime);
     auto location =
             QObject::tr("%1/Video %2.%3")
                 .arg(this->m_videoDirectory,
@@ -1596,14 +1818,21 @@ bool RecordingPrivate::init()
                      this->m_muxer->extension(this->m_muxer->muxer()));
     this->m_muxer->setLocation(location);
 
-    this->m_videoEncoder->setInputCaps(this->m_videoCaps);
-    this->m_videoEncoder->setBitrate(this->m_videoBitrate);
-    this->m_videoEncoder->setGop(this->m_videoGOP);
-    this->m_videoEncoder->setFillGaps(!this->m_muxer->gapsAllowed(AkCompressedCaps::CapsType_Video));
+    /* If the encoders are already running, the recording starts with the
+     * packets kept in the pre-roll buffer.
+     */
+    this->m_preRollMutex.lock();
+    bool preRolled = this->m_isPreRolling && !this->m_preRollPackets.isEmpty();
+    this->m_preRollMutex.unlock();
+
+    if (!preRolled) {
+        this->stopPreRoll();
+        this->configureEncoders();
+    }
+
     this->m_muxer->setStreamCaps(this->m_videoEncoder->outputCaps());
     this->m_muxer->setStreamBitrate(AkCompressedCaps::CapsType_Video,
                                     this->m_videoEncoder->bitrate());
-    this->m_videoEncoder->link(this->m_muxer, Qt::DirectConnection);
     this->m_videoHeadersChangedConnection =
             QObject::connect(this->m_videoEncoder.data(),
                              &AkVideoEncoder::headersChanged,
@@ -1613,13 +1842,9 @@ bool RecordingPrivate::init()
                              });
 
     if (this->m_audioEncoder) {
-        this->m_audioEncoder->setInputCaps(this->m_audioCaps);
-        this->m_audioEncoder->setBitrate(this->m_audioBitrate);
-        this->m_audioEncoder->setFillGaps(!this->m_muxer->gapsAllowed(AkCompressedCaps::CapsType_Audio));
         this->m_muxer->setStreamCaps(this->m_audioEncoder->outputCaps());
         this->m_muxer->setStreamBitrate(AkCompressedCaps::CapsType_Audio,
                                         this->m_audioEncoder->bitrate());
-        this->m_audioEncoder->link(this->m_muxer, Qt::DirectConnection);
         this->m_audioHeadersChangedConnection =
                 QObject::connect(this->m_audioEncoder.data(),
                                  &AkAudioEncoder::headersChanged,
@@ -1628,20 +1853,42 @@ bool RecordingPrivate::init()
                                                                     headers);
                                  });
 
-        this->m_audioEncoder->setState(AkElement::ElementStatePaused);
         this->m_muxer->setStreamHeaders(AkCompressedCaps::CapsType_Audio,
                                         this->m_audioEncoder->headers());
     }
 
-    this->m_videoEncoder->setState(AkElement::ElementStatePaused);
     this->m_muxer->setStreamHeaders(AkCompressedCaps::CapsType_Video,
                                     this->m_videoEncoder->headers());
-    this->m_muxer->setState(AkElement::ElementStatePlaying);
 
-    if (this->m_audioEncoder)
-        this->m_audioEncoder->setState(AkElement::ElementStatePlaying);
+    if (preRolled) {
+        this->m_preRollMutex.lock();
+        this->m_muxer->setState(AkElement::ElementStatePlaying);
+
+        // Rebase the timestamps so the file starts at the first key frame.
+        this->m_timeOffset = this->m_preRollPackets.first().time;
+        this->m_isMuxing = true;
+
+        for (auto &packet: this->m_preRollPackets)
+            this->muxPacket(packet.packet);
+
+        qInfo() << "Pre-roll:"
+                << this->m_preRollPackets.last().time - this->m_timeOffset
+                << "seconds";
+        this->m_preRollPackets.clear();
+        this->m_preRollBufferSize = 0;
+        this->m_isPreRolling = false;
+        this->m_preRollMutex.unlock();
+    } else {
+        this->m_timeOffset = 0.0;
+        this->m_isMuxing = true;
+        this->m_muxer->setState(AkElement::ElementStatePlaying);
+
+        if (this->m_audioEncoder)
+            this->m_audioEncoder->setState(AkElement::ElementStatePlaying);
+
+        this->m_videoEncoder->setState(AkElement::ElementStatePlaying);
+    }
 
-    this->m_videoEncoder->setState(AkElement::ElementStatePlaying);
     qInfo() << "Recording started";
     this->m_isRecording = true;
 
@@ -1655,15 +1902,20 @@ void RecordingPrivate::uninit()
 
     qInfo() << "Stopping recording";
     this->m_isRecording = false;
+    this->stopRenditions();
     qint64 videoDuration = 0;
     qreal videoTime = 0.0;
 
     if (this->m_videoEncoder) {
         this->m_videoEncoder->setState(AkElement::ElementStateNull);
-        videoDuration = this->m_videoEncoder->encodedTimePts();
         auto fps = this->m_videoEncoder->outputCaps().rawCaps().fps();
+        videoDuration = this->m_videoEncoder->encodedTimePts()
+                        - qRound64(this->m_timeOffset * fps.value());
         videoTime = videoDuration / fps.value();
+        qInfo() << "Video frames dropped:" << this->m_videoEncoder->droppedFrames();
+        qInfo() << "Video encoder speed level:" << this->m_videoEncoder->speedLevel();
         QObject::disconnect(this->m_videoHeadersChangedConnection);
+        QObject::disconnect(this->m_videoPacketConnection);
     }
 
     qint64 audioDuration = 0;
@@ -1671,12 +1923,18 @@ void RecordingPrivate::uninit()
 
     if (this->m_audioEncoder) {
         this->m_audioEncoder->setState(AkElement::ElementStateNull);
-        audioDuration = this->m_audioEncoder->encodedTimePts();
-        audioTime = qreal(audioDuration)
-                    / this->m_audioEncoder->outputCaps().rawCaps().rate();
+        auto rate = this->m_audioEncoder->outputCaps().rawCaps().rate();
+        audioDuration = this->m_audioEncoder->encodedTimePts()
+                        - qRound64(this->m_timeOffset * rate);
+        audioTime = qreal(audioDuration) / rate;
         QObject::disconnect(this->m_audioHeadersChangedConnection);
+        QObject::disconnect(this->m_audioPacketConnection);
     }
 
+    this->m_preRollMutex.lock();
+    this->m_isMuxing = false;
+    this->m_preRollMutex.unlock();
+
     if (this->m_muxer) {
         if (audioDuration > 0)
             this->m_muxer->setStreamDuration(AkCompressedCaps::CapsType_Audio,
@@ -1738,6 +1996,229 @@ void RecordingPrivate::uninit()
         emit self->lastVideoChanged(location);
     }
 #endif
+
+    this->startPreRoll();
+}
+
+void RecordingPrivate::configureEncoders()
+{
+    this->m_videoEncoder->setInputCaps(this->m_videoCaps);
+    this->m_videoEncoder->setBitrate(this->m_videoBitrate);
+    this->m_videoEncoder->setGop(this->m_videoGOP);
+    this->m_videoEncoder->setFillGaps(!this->m_muxer->gapsAllowed(AkCompressedCaps::CapsType_Video));
+    this->m_videoEncoder->setAdaptiveSpeed(true);
+    this->m_videoPacketConnection =
+            QObject::connect(this->m_videoEncoder.data(),
+                             &AkElement::oStream,
+                             [this] (const AkPacket &packet) {
+                                this->writePacket(packet);
+                             });
+
+    if (this->m_audioEncoder) {
+        this->m_audioEncoder->setInputCaps(this->m_audioCaps);
+        this->m_audioEncoder->setBitrate(this->m_audioBitrate);
+        this->m_audioEncoder->setFillGaps(!this->m_muxer->gapsAllowed(AkCompressedCaps::CapsType_Audio));
+        this->m_audioPacketConnection =
+                QObject::connect(this->m_audioEncoder.data(),
+                                 &AkElement::oStream,
+                                 [this] (const AkPacket &packet) {
+                                    this->writePacket(packet);
+                                 });
+        this->m_audioEncoder->setState(AkElement::ElementStatePaused);
+    }
+
+    this->m_videoEncoder->setState(AkElement::ElementStatePaused);
+}
+
+void RecordingPrivate::startPreRoll()
+{
+    if (!this->m_preRoll
+        || this->m_isRecording
+        || this->m_isPreRolling
+        || !this->m_muxer
+        || !this->m_videoEncoder
+        || !this->m_videoCaps)
+        return;
+
+    /* Keep the encoders running and store the last seconds of encoded
+     * packets, so the recording can start some time before the user asked
+     * for it. Storing the raw frames instead would take too much memory.
+     */
+    this->configureEncoders();
+
+    this->m_preRollMutex.lock();
+    this->m_preRollPackets.clear();
+    this->m_preRollBufferSize = 0;
+    this->m_isPreRolling = true;
+    this->m_preRollMutex.unlock();
+
+    if (this->m_audioEncoder)
+        this->m_audioEncoder->setState(AkElement::ElementStatePlaying);
+
+    this->m_videoEncoder->setState(AkElement::ElementStatePlaying);
+    qInfo() << "Pre-roll started";
+}
+
+void RecordingPrivate::stopPreRoll()
+{
+    if (!this->m_isPreRolling)
+        return;
+
+    this->m_preRollMutex.lock();
+    this->m_isPreRolling = false;
+    this->m_preRollMutex.unlock();
+
+    if (this->m_videoEncoder)
+        this->m_videoEncoder->setState(AkElement::ElementStateNull);
+
+    if (this->m_audioEncoder)
+        this->m_audioEncoder->setState(AkElement::ElementStateNull);
+
+    QObject::disconnect(this->m_videoPacketConnection);
+    QObject::disconnect(this->m_audioPacketConnection);
+
+    this->m_preRollMutex.lock();
+    this->m_preRollPackets.clear();
+    this->m_preRollBufferSize = 0;
+    this->m_preRollMutex.unlock();
+    qInfo() << "Pre-roll stopped";
+}
+
+void RecordingPrivate::restartPreRoll()
+{
+    if (!this->m_isPreRolling)
+        return;
+
+    this->stopPreRoll();
+    this->startPreRoll();
+}
+
+void RecordingPrivate::writePacket(const AkPacket &packet)
+{
+    this->m_preRollMutex.lock();
+
+    if (this->m_isMuxing) {
+        this->muxPacket(packet);
+    } else if (this->m_isPreRolling) {
+        PreRollPacket preRollPacket {packet, 0.0, 0, false};
+
+        switch (packet.type()) {
+        case AkPacket::PacketAudioCompressed: {
+            AkCompressedAudioPacket audioPacket(packet);
+            preRollPacket.time = audioPacket.pts()
+                                 * audioPacket.timeBase().value();
+            preRollPacket.size = audioPacket.size();
+
+            break;
+        }
+
+        case AkPacket::PacketVideoCompressed: {
+            AkCompressedVideoPacket videoPacket(packet);
+            preRollPacket.time = videoPacket.pts()
+                                 * videoPacket.timeBase().value();
+            preRollPacket.size = videoPacket.size();
+            preRollPacket.isKeyFrame =
+                    videoPacket.flags()
+                    & AkCompressedVideoPacket::VideoPacketTypeFlag_KeyFrame;
+
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        // The buffer must always start with a video key frame.
+        if (!this->m_preRollPackets.isEmpty() || preRollPacket.isKeyFrame) {
+            this->m_preRollBufferSize += preRollPacket.size;
+            this->m_preRollPackets << preRollPacket;
+            this->trimPreRoll();
+        }
+    }
+
+    this->m_preRollMutex.unlock();
+}
+
+void RecordingPrivate::muxPacket(const AkPacket &packet)
+{
+    if (qFuzzyIsNull(this->m_timeOffset)) {
+        this->m_muxer->iStream(packet);
+
+        return;
+    }
+
+    switch (packet.type()) {
+    case AkPacket::PacketAudioCompressed: {
+        AkCompressedAudioPacket audioPacket(packet);
+        auto offset =
+                qRound64(this->m_timeOffset / audioPacket.timeBase().value());
+
+        // Drop the audio that was captured before the first video frame.
+        if (audioPacket.pts() < offset)
+            break;
+
+        audioPacket.setPts(audioPacket.pts() - offset);
+        audioPacket.setDts(audioPacket.dts() - offset);
+        this->m_muxer->iStream(audioPacket);
+
+        break;
+    }
+
+    case AkPacket::PacketVideoCompressed: {
+        AkCompressedVideoPacket videoPacket(packet);
+        auto offset =
+                qRound64(this->m_timeOffset / videoPacket.timeBase().value());
+        videoPacket.setPts(videoPacket.pts() - offset);
+        videoPacket.setDts(videoPacket.dts() - offset);
+        this->m_muxer->iStream(videoPacket);
+
+        break;
+    }
+
+    default:
+        this->m_muxer->iStream(packet);
+
+        break;
+    }
+}
+
+void RecordingPrivate::trimPreRoll()
+{
+    auto maxSize = size_t(this->m_preRollMaxSize) * 1024 * 1024;
+
+    /* Remove whole GOPs from the start of the buffer, so it always starts
+     * with a key frame, while it's longer or bigger than allowed.
+     */
+    forever {
+        if (this->m_preRollPackets.isEmpty())
+            break;
+
+        auto duration = this->m_preRollPackets.last().time
+                        - this->m_preRollPackets.first().time;
+
+        if (duration <= this->m_preRollDuration
+            && this->m_preRollBufferSize <= maxSize)
+            break;
+
+        int nextKeyFrame = -1;
+
+        for (int i = 1; i < this->m_preRollPackets.size(); i++)
+            if (this->m_preRollPackets[i].isKeyFrame) {
+                nextKeyFrame = i;
+
+                break;
+            }
+
+        if (nextKeyFrame < 0)
+            break;
+
+        for (int i = 0; i < nextKeyFrame; i++)
+            this->m_preRollBufferSize -= this->m_preRollPackets[i].size;
+
+        this->m_preRollPackets.erase(this->m_preRollPackets.begin(),
+                                     this->m_preRollPackets.begin()
+                                     + nextKeyFrame);
+    }
 }
 
 QString RecordingPrivate::normatizePluginID(const QString &pluginID)
@@ -1784,6 +2265,13 @@ void RecordingPrivate::loadConfigs()
     this->m_imageSaveQuality = config.value("imageSaveQuality", -1).toInt();
     this->m_recordAudio =
             config.value("recordAudio", DEFAULT_RECORD_AUDIO).toBool();
+    this->m_preRoll = config.value("preRoll", DEFAULT_PRE_ROLL).toBool();
+    this->m_preRollDuration =
+            qMax(config.value("preRollDuration",
+                              DEFAULT_PRE_ROLL_DURATION).toInt(), 1);
+    this->m_preRollMaxSize =
+            qMax(config.value("preRollMaxSize",
+                              DEFAULT_PRE_ROLL_MAX_SIZE).toInt(), 1);
 
     // Configure the recording formats
 
@@ -1870,6 +2358,8 @@ void RecordingPrivate::loadConfigs()
     }
 
     config.endGroup();
+
+    this->loadRenditions();
 }
 
 void RecordingPrivate::loadFormatOptions()
@@ -2022,6 +2512,34 @@ void RecordingPrivate::readThumbnail(const QString &videoFile)
     this->m_thumbnailer->setProperty("sync", false);
 }
 
+void RecordingPrivate::loadThumbnail(qint64 mSecs)
+{
+    /* Decode just the key frame near the thumbnail position, if the source
+     * supports it, instead of playing the video until the frame arrives.
+     */
+    AkVideoPacket thumbnail;
+    QMetaObject::invokeMethod(this->m_thumbnailer.data(),
+                              "thumbnail",
+                              Qt::DirectConnection,
+                              Q_RETURN_ARG(AkVideoPacket, thumbnail),
+                              Q_ARG(qint64, mSecs),
+                              Q_ARG(QSize, QSize(640, 480)));
+
+    if (thumbnail) {
+        self->thumbnailUpdated(thumbnail);
+
+        return;
+    }
+
+    QMetaObject::invokeMethod(this->m_thumbnailer.data(),
+                              "seek",
+                              Qt::DirectConnection,
+                              Q_ARG(qint64, mSecs));
+    this->m_thumbnailerMutex.lock();
+    this->m_thumbnailer->setState(AkElement::ElementStatePlaying);
+    this->m_thumbnailerMutex.unlock();
+}
+
 void RecordingPrivate::thumbnailReady()
 {
     this->m_thumbnailerMutex.lock();
@@ -2833,6 +3351,199 @@ void RecordingPrivate::saveRecordAudio(bool recordAudio)
     config.endGroup();
 }
 
+void RecordingPrivate::startRenditions(const QString &currentTime)
+{
+    QList<RenditionSessionPtr> sessions;
+    QList<QSize> sizes;
+    QStringList locations;
+
+    for (int i = 0; i < this->m_renditions.size(); i++) {
+        auto &profile = this->m_renditions.at(i);
+        RenditionSessionPtr session(new RenditionSession(profile));
+        auto location =
+                QObject::tr("%1/Video %2 (%3x%4)")
+                    .arg(this->m_videoDirectory, currentTime)
+                    .arg(profile.width)
+                    .arg(profile.height);
+
+        // Don't overwrite the file of another rendition with the same size.
+        if (locations.contains(location))
+            location =
+                    QObject::tr("%1/Video %2 (%3x%4, %5)")
+                        .arg(this->m_videoDirectory, currentTime)
+                        .arg(profile.width)
+                        .arg(profile.height)
+                        .arg(i + 1);
+
+        locations << location;
+        AkVideoCaps videoCaps(this->m_videoCaps.format(),
+                              profile.width,
+                              profile.height,
+                              this->m_videoCaps.fps());
+
+        if (!session->start(location,
+                            this->m_recordAudio?
+                                this->m_audioCaps: AkAudioCaps(),
+                            videoCaps,
+                            this->m_videoGOP))
+            continue;
+
+        QSize size(profile.width, profile.height);
+
+        if (!sizes.contains(size))
+            sizes << size;
+
+        sessions << session;
+    }
+
+    /* All the renditions are scaled from a single pyramid, each level is
+     * scaled from the previous one, bigger, level, so every size is computed
+     * only once per frame, no matter how many renditions use it.
+     */
+    std::sort(sizes.begin(), sizes.end(), [] (const QSize &a, const QSize &b) {
+        return a.width() * a.height() > b.width() * b.height();
+    });
+
+    QVector<AkVideoConverterPtr> pyramid;
+
+    for (auto &size: sizes)
+        pyramid << AkVideoConverterPtr(new AkVideoConverter({this->m_videoCaps.format(),
+                                                             size.width(),
+                                                             size.height(),
+                                                             this->m_videoCaps.fps()}));
+
+    for (auto &session: sessions)
+        session->m_level = sizes.indexOf(QSize(session->m_profile.width,
+                                               session->m_profile.height));
+
+    this->m_renditionsMutex.lock();
+    this->m_renditionSessions = sessions;
+    this->m_pyramid = pyramid;
+    this->m_renditionsMutex.unlock();
+}
+
+void RecordingPrivate::stopRenditions()
+{
+    this->m_renditionsMutex.lock();
+    auto sessions = this->m_renditionSessions;
+    this->m_renditionSessions.clear();
+    this->m_pyramid.clear();
+    this->m_renditionsMutex.unlock();
+
+    for (auto &session: sessions)
+        session->stop();
+}
+
+void RecordingPrivate::feedRenditions(const AkPacket &packet)
+{
+    this->m_renditionsMutex.lock();
+
+    switch (packet.type()) {
+    case AkPacket::PacketAudio:
+        for (auto &session: this->m_renditionSessions)
+            session->pushAudio(packet);
+
+        break;
+
+    case AkPacket::PacketVideo: {
+        QVector<AkVideoPacket> levels;
+        AkVideoPacket frame(packet);
+
+        for (auto &converter: this->m_pyramid) {
+            converter->begin();
+            frame = converter->convert(frame);
+            converter->end();
+
+            if (!frame)
+                break;
+
+            levels << frame;
+        }
+
+        for (auto &session: this->m_renditionSessions)
+            if (session->m_level >= 0 && session->m_level < levels.size())
+                session->pushVideo(levels[session->m_level]);
+
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    this->m_renditionsMutex.unlock();
+}
+
+void RecordingPrivate::loadRenditions()
+{
+    QSettings config;
+    config.beginGroup("RecordConfigs");
+    int size = config.beginReadArray("renditions");
+    this->m_renditions.clear();
+
+    for (int i = 0; i < size; i++) {
+        config.setArrayIndex(i);
+        QVariantMap map;
+
+        for (auto &key: config.childKeys())
+            map[key] = config.value(key);
+
+        auto profile = RenditionProfile::fromMap(map);
+
+        if (profile.isValid())
+            this->m_renditions << profile;
+    }
+
+    config.endArray();
+    config.endGroup();
+}
+
+void RecordingPrivate::saveRenditions()
+{
+    QSettings config;
+    config.beginGroup("RecordConfigs");
+    config.remove("renditions");
+    config.beginWriteArray("renditions");
+    int i = 0;
+
+    for (auto &profile: this->m_renditions) {
+        config.setArrayIndex(i);
+        auto map = profile.toMap();
+
+        for (auto it = map.begin(); it != map.end(); it++)
+            config.setValue(it.key(), it.value());
+
+        i++;
+    }
+
+    config.endArray();
+    config.endGroup();
+}
+
+void RecordingPrivate::savePreRoll(bool preRoll)
+{
+    QSettings config;
+    config.beginGroup("RecordConfigs");
+    config.setValue("preRoll", preRoll);
+    config.endGroup();
+}
+
+void RecordingPrivate::savePreRollDuration(int preRollDuration)
+{
+    QSettings config;
+    config.beginGroup("RecordConfigs");
+    config.setValue("preRollDuration", preRollDuration);
+    config.endGroup();
+}
+
+void RecordingPrivate::savePreRollMaxSize(int preRollMaxSize)
+{
+    QSettings config;
+    config.beginGroup("RecordConfigs");
+    config.setValue("preRollMaxSize", preRollMaxSize);
+    config.endGroup();
+}
+
 void RecordingPrivate::saveImagesDirectory(const QString &imagesDirectory)
 {
     QSettings config;
@@ -2857,4 +3568,208 @@ void RecordingPrivate::saveImageSaveQuality(int imageSaveQuality)
     config.endGroup();
 }
 
+RenditionProfile RenditionProfile::fromMap(const QVariantMap &map)
+{
+    return {
+        map.value("format").toString(),
+        map.value("videoCodec").toString(),
+        map.value("audioCodec").toString(),
+        map.value("width").toInt(),
+        map.value("height").toInt(),
+        map.value("videoBitrate", DEFAULT_VIDEO_BITRATE).toInt(),
+        map.value("audioBitrate", DEFAULT_AUDIO_BITRATE).toInt(),
+    };
+}
+
+QVariantMap RenditionProfile::toMap() const
+{
+    return {
+        {"format"      , this->format      },
+        {"videoCodec"  , this->videoCodec  },
+        {"audioCodec"  , this->audioCodec  },
+        {"width"       , this->width       },
+        {"height"      , this->height      },
+        {"videoBitrate", this->videoBitrate},
+        {"audioBitrate", this->audioBitrate},
+    };
+}
+
+bool RenditionProfile::isValid() const
+{
+    return this->format.contains(':')
+           && this->videoCodec.contains(':')
+           && this->width >= 160
+           && this->height >= 90
+           && this->videoBitrate > 0
+           && this->audioBitrate > 0;
+}
+
+RenditionSession::RenditionSession(const RenditionProfile &profile):
+    m_profile(profile)
+{
+    // Each encoder runs in its own thread, and the frames are encoded in order.
+    this->m_audioThreadPool.setMaxThreadCount(1);
+    this->m_videoThreadPool.setMaxThreadCount(1);
+}
+
+bool RenditionSession::start(const QString &location,
+                             const AkAudioCaps &audioCaps,
+                             const AkVideoCaps &videoCaps,
+                             int gop)
+{
+    auto formatParts = this->m_profile.format.split(':');
+    this->m_muxer = akPluginManager->create<AkVideoMuxer>(formatParts.value(0));
+
+    if (!this->m_muxer) {
+        qCritical() << "Failed to create the muxer:" << formatParts.value(0);
+
+        return false;
+    }
+
+    this->m_muxer->setMuxer(formatParts.value(1));
+    auto videoCodecParts = this->m_profile.videoCodec.split(':');
+    this->m_videoEncoder =
+            akPluginManager->create<AkVideoEncoder>(videoCodecParts.value(0));
+
+    if (!this->m_videoEncoder) {
+        qCritical() << "Failed to create the video encoder:"
+                    << videoCodecParts.value(0);
+
+        return false;
+    }
+
+    this->m_videoEncoder->setCodec(videoCodecParts.value(1));
+
+    if (audioCaps && !this->m_profile.audioCodec.isEmpty()) {
+        auto audioCodecParts = this->m_profile.audioCodec.split(':');
+        this->m_audioEncoder =
+                akPluginManager->create<AkAudioEncoder>(audioCodecParts.value(0));
+
+        if (this->m_audioEncoder)
+            this->m_audioEncoder->setCodec(audioCodecParts.value(1));
+        else
+            qCritical() << "Failed to create the audio encoder:"
+                        << audioCodecParts.value(0);
+    }
+
+    this->m_muxer->setLocation(location
+                               + '.'
+                               + this->m_muxer->extension(this->m_muxer->muxer()));
+
+    this->m_videoEncoder->setInputCaps(videoCaps);
+    this->m_videoEncoder->setBitrate(this->m_profile.videoBitrate);
+    this->m_videoEncoder->setGop(gop);
+    this->m_videoEncoder->setFillGaps(!this->m_muxer->gapsAllowed(AkCompressedCaps::CapsType_Video));
+    this->m_videoEncoder->setAdaptiveSpeed(true);
+    this->m_muxer->setStreamCaps(this->m_videoEncoder->outputCaps());
+    this->m_muxer->setStreamBitrate(AkCompressedCaps::CapsType_Video,
+                                    this->m_videoEncoder->bitrate());
+    this->m_videoEncoder->link(this->m_muxer, Qt::DirectConnection);
+    this->m_videoHeadersChangedConnection =
+            QObject::connect(this->m_videoEncoder.data(),
+                             &AkVideoEncoder::headersChanged,
+                             [this] (const QByteArray &headers) {
+                                this->m_muxer->setStreamHeaders(AkCompressedCaps::CapsType_Video,
+                                                                headers);
+                             });
+
+    if (this->m_audioEncoder) {
+        this->m_audioEncoder->setInputCaps(audioCaps);
+        this->m_audioEncoder->setBitrate(this->m_profile.audioBitrate);
+        this->m_audioEncoder->setFillGaps(!this->m_muxer->gapsAllowed(AkCompressedCaps::CapsType_Audio));
+        this->m_muxer->setStreamCaps(this->m_audioEncoder->outputCaps());
+        this->m_muxer->setStreamBitrate(AkCompressedCaps::CapsType_Audio,
+                                        this->m_audioEncoder->bitrate());
+        this->m_audioEncoder->link(this->m_muxer, Qt::DirectConnection);
+        this->m_audioHeadersChangedConnection =
+                QObject::connect(this->m_audioEncoder.data(),
+                                 &AkAudioEncoder::headersChanged,
+                                 [this] (const QByteArray &headers) {
+                                    this->m_muxer->setStreamHeaders(AkCompressedCaps::CapsType_Audio,
+                                                                    headers);
+                                 });
+
+        this->m_audioEncoder->setState(AkElement::ElementStatePaused);
+        this->m_muxer->setStreamHeaders(AkCompressedCaps::CapsType_Audio,
+                                        this->m_audioEncoder->headers());
+    }
+
+    this->m_videoEncoder->setState(AkElement::ElementStatePaused);
+    this->m_muxer->setStreamHeaders(AkCompressedCaps::CapsType_Video,
+                                    this->m_videoEncoder->headers());
+    this->m_muxer->setState(AkElement::ElementStatePlaying);
+
+    if (this->m_audioEncoder)
+        this->m_audioEncoder->setState(AkElement::ElementStatePlaying);
+
+    this->m_videoEncoder->setState(AkElement::ElementStatePlaying);
+    qInfo() << "Recording rendition:" << this->m_muxer->location();
+
+    return true;
+}
+
+void RenditionSession::stop()
+{
+    this->m_videoThreadPool.waitForDone();
+    this->m_audioThreadPool.waitForDone();
+    this->m_videoEncoder->setState(AkElement::ElementStateNull);
+    auto videoDuration = this->m_videoEncoder->encodedTimePts();
+    QObject::disconnect(this->m_videoHeadersChangedConnection);
+    qint64 audioDuration = 0;
+
+    if (this->m_audioEncoder) {
+        this->m_audioEncoder->setState(AkElement::ElementStateNull);
+        audioDuration = this->m_audioEncoder->encodedTimePts();
+        QObject::disconnect(this->m_audioHeadersChangedConnection);
+    }
+
+    if (audioDuration > 0)
+        this->m_muxer->setStreamDuration(AkCompressedCaps::CapsType_Audio,
+                                         audioDuration);
+
+    if (videoDuration > 0)
+        this->m_muxer->setStreamDuration(AkCompressedCaps::CapsType_Video,
+                                         videoDuration);
+
+    this->m_muxer->setState(AkElement::ElementStateNull);
+    qInfo() << "Rendition saved:" << this->m_muxer->location();
+}
+
+void RenditionSession::pushAudio(const AkPacket &packet)
+{
+    if (!this->m_audioEncoder)
+        return;
+
+    auto result = QtConcurrent::run(&this->m_audioThreadPool,
+                                    &RenditionSession::encodeAudio,
+                                    this,
+                                    packet);
+    Q_UNUSED(result)
+}
+
+void RenditionSession::pushVideo(const AkVideoPacket &packet)
+{
+    // Drop the frame if the encoder can't keep up.
+    if (this->m_pendingFrames >= RENDITION_MAX_PENDING_FRAMES)
+        return;
+
+    this->m_pendingFrames++;
+    auto result = QtConcurrent::run(&this->m_videoThreadPool,
+                                    &RenditionSession::encodeVideo,
+                                    this,
+                                    packet);
+    Q_UNUSED(result)
+}
+
+void RenditionSession::encodeAudio(const AkPacket &packet)
+{
+    this->m_audioEncoder->iStream(packet);
+}
+
+void RenditionSession::encodeVideo(const AkVideoPacket &packet)
+{
+    this->m_videoEncoder->iStream(packet);
+    this->m_pendingFrames--;
+}
+
 #include "moc_recording.cpp"
@@ -87,6 +87,26 @@ class Recording: public QObject
                WRITE setRecordAudio
                RESET resetRecordAudio
                NOTIFY recordAudioChanged)
+    Q_PROPERTY(bool preRoll
+               READ preRoll
+               WRITE setPreRoll
+               RESET resetPreRoll
+               NOTIFY preRollChanged)
+    Q_PROPERTY(int preRollDuration
+               READ preRollDuration
+               WRITE setPreRollDuration
+               RESET resetPreRollDuration
+               NOTIFY preRollDurationChanged)
+    Q_PROPERTY(int preRollMaxSize
+               READ preRollMaxSize
+               WRITE setPreRollMaxSize
+               RESET resetPreRollMaxSize
+               NOTIFY preRollMaxSizeChanged)
+    Q_PROPERTY(QVariantList renditions
+               READ renditions
+               WRITE setRenditions
+               RESET resetRenditions
+               NOTIFY renditionsChanged)
     Q_PROPERTY(QString lastVideoPreview
                READ lastVideoPreview
                NOTIFY lastVideoPreviewChanged)
@@ -155,6 +175,10 @@ class Recording: public QObject
         Q_INVOKABLE int videoGOP() const;
         Q_INVOKABLE int defaultVideoGOP() const;
         Q_INVOKABLE bool recordAudio() const;
+        Q_INVOKABLE bool preRoll() const;
+        Q_INVOKABLE int preRollDuration() const;
+        Q_INVOKABLE int preRollMaxSize() const;
+        Q_INVOKABLE QVariantList renditions() const;
         Q_INVOKABLE QString lastVideoPreview() const;
         Q_INVOKABLE QString lastVideo() const;
         Q_INVOKABLE QString latestVideoUri() const;
@@ -193,6 +217,10 @@ class Recording: public QObject
         void bitrateChanged(AkCaps::CapsType type, int bitrate);
         void videoGOPChanged(int gop);
         void recordAudioChanged(bool recordAudio);
+        void preRollChanged(bool preRoll);
+        void preRollDurationChanged(int preRollDuration);
+        void preRollMaxSizeChanged(int preRollMaxSize);
+        void renditionsChanged(const QVariantList &renditions);
         void lastVideoPreviewChanged(const QString &lastVideoPreview);
         void lastVideoChanged(const QString &lastVideo);
         void latestVideoUriChanged(const QString &latestVideoUri);
@@ -222,6 +250,10 @@ class Recording: public QObject
         void setBitrate(AkCaps::CapsType type, int bitrate);
         void setVideoGOP(int gop);
         void setRecordAudio(bool recordAudio);
+        void setPreRoll(bool preRoll);
+        void setPreRollDuration(int preRollDuration);
+        void setPreRollMaxSize(int preRollMaxSize);
+        void setRenditions(const QVariantList &renditions);
 
         // Picture
         void setImagesDirectory(const QString &imagesDirectory);
@@ -245,6 +277,10 @@ class Recording: public QObject
         void resetBitrate(AkCaps::CapsType type);
         void resetVideoGOP();
         void resetRecordAudio();
+        void resetPreRoll();
+        void resetPreRollDuration();
+        void resetPreRollMaxSize();
+        void resetRenditions();
 
         // Picture
         void resetImagesDirectory();
@@ -29,6 +29,7 @@
 #endif
 
 #include "ak.h"
+#include "akasyncfilewriter.h"
 #include "akaudiocaps.h"
 #include "akaudioconverter.h"
 #include "akaudiopacket.h"
@@ -40,7 +41,10 @@
 #include "akcompressedaudiopacket.h"
 #include "akcompressedvideocaps.h"
 #include "akcompressedvideopacket.h"
+#include "akedgedetector.h"
 #include "akfrac.h"
+#include "akframering.h"
+#include "akglyphatlas.h"
 #include "akmenuoption.h"
 #include "akpacket.h"
 #include "akplugininfo.h"
@@ -49,8 +53,10 @@
 #include "aksubtitlecaps.h"
 #include "aksubtitlepacket.h"
 #include "akunit.h"
+#include "akvideoblur.h"
 #include "akvideocaps.h"
 #include "akvideoconverter.h"
+#include "akvideoconvolver.h"
 #include "akvideoformatspec.h"
 #include "akvideomixer.h"
 #include "akvideopacket.h"
@@ -107,6 +113,7 @@ void Ak::registerTypes()
 
         return new Ak();
     });
+    AkAsyncFileWriter::registerTypes();
     AkAudioCaps::registerTypes();
     AkAudioConverter::registerTypes();
     AkAudioPacket::registerTypes();
@@ -119,9 +126,12 @@ void Ak::registerTypes()
     AkCompressedAudioPacket::registerTypes();
     AkCompressedVideoCaps::registerTypes();
     AkCompressedVideoPacket::registerTypes();
+    AkEdgeDetector::registerTypes();
     AkElement::registerTypes();
     AkFontSettings::registerTypes();
     AkFrac::registerTypes();
+    AkFrameRing::registerTypes();
+    AkGlyphAtlas::registerTypes();
     AkMenuOption::registerTypes();
     AkPacket::registerTypes();
     AkPalette::registerTypes();
@@ -134,8 +144,10 @@ void Ak::registerTypes()
     AkTheme::registerTypes();
     AkUnit::registerTypes();
     AkUtils::registerTypes();
+    AkVideoBlur::registerTypes();
     AkVideoCaps::registerTypes();
     AkVideoConverter::registerTypes();
+    AkVideoConvolver::registerTypes();
     AkVideoFormatSpec::registerTypes();
     AkVideoMixer::registerTypes();
     AkVideoPacket::registerTypes();
@@ -0,0 +1,737 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QQmlEngine>
+#include <QQueue>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <limits>
+
+#ifdef Q_OS_WIN32
+#include <io.h>
+#elif defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "akasyncfilewriter.h"
+#include "aksimd.h"
+#include "iak/akvideomuxer.h"
+
+#define DEFAULT_BUFFER_SIZE (4 * 1024 * 1024)
+#define DEFAULT_MAX_BACKLOG (64 * 1024 * 1024)
+#define MIN_BUFFER_SIZE (64 * 1024)
+#define BUFFER_ALIGN 4096
+
+struct AkAsyncFileWriterBlock
+{
+    quint8 *data {nullptr};
+    qint64 offset {0};
+    qint64 size {0};
+    qint64 capacity {0};
+};
+
+class AkAsyncFileWriterPrivate
+{
+    public:
+        QString m_fileName;
+        QFile m_file;
+        QThreadPool m_threadPool;
+        mutable QMutex m_mutex;
+        QWaitCondition m_blockQueued;
+        QWaitCondition m_blockWritten;
+        QQueue<AkAsyncFileWriterBlock> m_queue;
+        QVector<AkAsyncFileWriterBlock> m_freeBlocks;
+        AkAsyncFileWriterBlock m_block;
+        int m_bufferSize {DEFAULT_BUFFER_SIZE};
+        qint64 m_maxBacklog {DEFAULT_MAX_BACKLOG};
+        qint64 m_preallocationSize {0};
+        int m_syncInterval {0};
+        qint64 m_pos {0};
+        qint64 m_size {0};
+        qint64 m_backlog {0};
+        qint64 m_maxBacklogReached {0};
+        qint64 m_allocated {0};
+        qreal m_writeLatency {0.0};
+        qreal m_maxWriteLatency {0.0};
+        bool m_isOpen {false};
+        bool m_run {false};
+        bool m_writing {false};
+        bool m_error {false};
+
+        AkAsyncFileWriterPrivate();
+        void writeLoop();
+        bool writeBlock(const AkAsyncFileWriterBlock &block,
+                        qint64 preallocationSize);
+        void preallocate(qint64 end, qint64 preallocationSize);
+        void sync();
+        void releasePreallocation();
+        AkAsyncFileWriterBlock newBlock(qint64 offset);
+        void queueBlock();
+        void recycleBlock(const AkAsyncFileWriterBlock &block);
+        bool waitQueue();
+        void freeBlocks();
+};
+
+AkAsyncFileWriter::AkAsyncFileWriter(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkAsyncFileWriterPrivate();
+}
+
+AkAsyncFileWriter::~AkAsyncFileWriter()
+{
+    this->close();
+    delete this->d;
+}
+
+QObject *AkAsyncFileWriter::create()
+{
+    return new AkAsyncFileWriter();
+}
+
+AkPropertyOptions AkAsyncFileWriter::options()
+{
+    return {
+        {"writeBufferSize" ,
+         QObject::tr("Write buffer size (KiB)"),
+         "",
+         AkPropertyOption::OptionType_Number,
+         64.0,
+         65536.0,
+         64.0,
+         4096.0,
+         {}},
+        {"maxWriteBacklog" ,
+         QObject::tr("Maximum write backlog (MiB)"),
+         QObject::tr("Data waiting to be written before blocking the recording"),
+         AkPropertyOption::OptionType_Number,
+         0.0,
+         4096.0,
+         1.0,
+         64.0,
+         {}},
+        {"preallocationSize" ,
+         QObject::tr("Preallocation size (MiB)"),
+         QObject::tr("Reserve the disk space in chunks of this size, 0 to disable"),
+         AkPropertyOption::OptionType_Number,
+         0.0,
+         4096.0,
+         1.0,
+         0.0,
+         {}},
+        {"syncInterval" ,
+         QObject::tr("Sync interval (ms)"),
+         QObject::tr("Force the data to the disk periodically, 0 to disable"),
+         AkPropertyOption::OptionType_Number,
+         0.0,
+         60000.0,
+         100.0,
+         0.0,
+         {}},
+    };
+}
+
+int AkAsyncFileWriter::bufferSize() const
+{
+    return this->d->m_bufferSize;
+}
+
+qint64 AkAsyncFileWriter::maxBacklog() const
+{
+    return this->d->m_maxBacklog;
+}
+
+qint64 AkAsyncFileWriter::preallocationSize() const
+{
+    return this->d->m_preallocationSize;
+}
+
+int AkAsyncFileWriter::syncInterval() const
+{
+    return this->d->m_syncInterval;
+}
+
+qreal AkAsyncFileWriter::writeLatency() const
+{
+    this->d->m_mutex.lock();
+    auto writeLatency = this->d->m_writeLatency;
+    this->d->m_mutex.unlock();
+
+    return writeLatency;
+}
+
+qreal AkAsyncFileWriter::maxWriteLatency() const
+{
+    this->d->m_mutex.lock();
+    auto maxWriteLatency = this->d->m_maxWriteLatency;
+    this->d->m_mutex.unlock();
+
+    return maxWriteLatency;
+}
+
+qint64 AkAsyncFileWriter::backlog() const
+{
+    this->d->m_mutex.lock();
+    auto backlog = this->d->m_backlog;
+    this->d->m_mutex.unlock();
+
+    return backlog;
+}
+
+qint64 AkAsyncFileWriter::maxBacklogReached() const
+{
+    this->d->m_mutex.lock();
+    auto maxBacklogReached = this->d->m_maxBacklogReached;
+    this->d->m_mutex.unlock();
+
+    return maxBacklogReached;
+}
+
+QString AkAsyncFileWriter::fileName() const
+{
+    return this->d->m_fileName;
+}
+
+bool AkAsyncFileWriter::isOpen() const
+{
+    return this->d->m_isOpen;
+}
+
+bool AkAsyncFileWriter::error() const
+{
+    this->d->m_mutex.lock();
+    auto error = this->d->m_error;
+    this->d->m_mutex.unlock();
+
+    return error;
+}
+
+bool AkAsyncFileWriter::open(const QString &fileName)
+{
+    this->close();
+    this->d->m_file.setFileName(fileName);
+
+    if (!this->d->m_file.open(QIODevice::ReadWrite
+                              | QIODevice::Truncate
+                              | QIODevice::Unbuffered)) {
+        qCritical() << "Failed to open file for writting:" << fileName;
+
+        return false;
+    }
+
+    this->d->m_fileName = fileName;
+    this->d->m_pos = 0;
+    this->d->m_size = 0;
+    this->d->m_backlog = 0;
+    this->d->m_maxBacklogReached = 0;
+    this->d->m_allocated = 0;
+    this->d->m_writeLatency = 0.0;
+    this->d->m_maxWriteLatency = 0.0;
+    this->d->m_error = false;
+    this->d->m_writing = false;
+    this->d->m_run = true;
+    this->d->m_isOpen = true;
+    this->d->m_threadPool.start([this] () {
+        this->d->writeLoop();
+    });
+
+    return true;
+}
+
+void AkAsyncFileWriter::close()
+{
+    if (!this->d->m_isOpen)
+        return;
+
+    this->flush();
+
+    this->d->m_mutex.lock();
+    this->d->m_run = false;
+    this->d->m_blockQueued.wakeAll();
+    this->d->m_mutex.unlock();
+    this->d->m_threadPool.waitForDone();
+
+    this->d->releasePreallocation();
+
+    if (this->d->m_syncInterval > 0)
+        this->d->sync();
+
+    this->d->m_file.close();
+    this->d->freeBlocks();
+    this->d->m_isOpen = false;
+}
+
+qint64 AkAsyncFileWriter::write(const void *data, qint64 size)
+{
+    if (!this->d->m_isOpen || !data || size < 0)
+        return -1;
+
+    auto src = reinterpret_cast<const quint8 *>(data);
+    qint64 written = 0;
+
+    this->d->m_mutex.lock();
+
+    while (written < size && !this->d->m_error) {
+        auto &block = this->d->m_block;
+        auto blockPos = this->d->m_pos - block.offset;
+
+        /* The data is appended to the current buffer as long as the cursor
+         * stays inside of it, otherwise the buffer is queued and a new one
+         * starts at the cursor position.
+         */
+        if (!block.data
+            || blockPos < 0
+            || blockPos > block.size
+            || blockPos >= block.capacity) {
+            this->d->queueBlock();
+            this->d->m_block = this->d->newBlock(this->d->m_pos);
+
+            continue;
+        }
+
+        auto copySize = qMin(size - written, block.capacity - blockPos);
+        memcpy(block.data + blockPos, src + written, size_t(copySize));
+        block.size = qMax(block.size, blockPos + copySize);
+        written += copySize;
+        this->d->m_pos += copySize;
+        this->d->m_size = qMax(this->d->m_size, this->d->m_pos);
+    }
+
+    auto error = this->d->m_error;
+    this->d->m_mutex.unlock();
+
+    return error? -1: written;
+}
+
+qint64 AkAsyncFileWriter::read(void *data, qint64 size)
+{
+    if (!this->d->m_isOpen || !data || size < 0)
+        return -1;
+
+    if (!this->flush())
+        return -1;
+
+    // At this point the writer thread is idle, it's safe to use the file.
+    this->d->m_mutex.lock();
+
+    if (!this->d->m_file.seek(this->d->m_pos)) {
+        this->d->m_mutex.unlock();
+
+        return -1;
+    }
+
+    auto dataRead = this->d->m_file.read(reinterpret_cast<char *>(data), size);
+
+    if (dataRead > 0)
+        this->d->m_pos += dataRead;
+
+    this->d->m_mutex.unlock();
+
+    return dataRead;
+}
+
+bool AkAsyncFileWriter::seek(qint64 pos)
+{
+    if (!this->d->m_isOpen || pos < 0)
+        return false;
+
+    this->d->m_mutex.lock();
+    this->d->m_pos = pos;
+    this->d->m_mutex.unlock();
+
+    return true;
+}
+
+qint64 AkAsyncFileWriter::pos() const
+{
+    this->d->m_mutex.lock();
+    auto pos = this->d->m_pos;
+    this->d->m_mutex.unlock();
+
+    return pos;
+}
+
+qint64 AkAsyncFileWriter::size() const
+{
+    this->d->m_mutex.lock();
+    auto size = this->d->m_size;
+    this->d->m_mutex.unlock();
+
+    return size;
+}
+
+bool AkAsyncFileWriter::resize(qint64 size)
+{
+    if (!this->d->m_isOpen || size < 0)
+        return false;
+
+    if (!this->flush())
+        return false;
+
+    this->d->m_mutex.lock();
+    auto ok = this->d->m_file.resize(size);
+
+    if (ok)
+        this->d->m_size = size;
+
+    this->d->m_mutex.unlock();
+
+    return ok;
+}
+
+void AkAsyncFileWriter::configure(const AkVideoMuxer *muxer)
+{
+    if (!muxer)
+        return;
+
+    this->setBufferSize(1024 * muxer->optionValue("writeBufferSize").toInt());
+    this->setMaxBacklog(1024 * 1024 * muxer->optionValue("maxWriteBacklog").toLongLong());
+    this->setPreallocationSize(1024 * 1024 * muxer->optionValue("preallocationSize").toLongLong());
+    this->setSyncInterval(muxer->optionValue("syncInterval").toInt());
+}
+
+void AkAsyncFileWriter::logStats() const
+{
+    qInfo() << "Write latency:" << this->writeLatency() << "ms,"
+            << "max:" << this->maxWriteLatency() << "ms,"
+            << "max backlog:" << this->maxBacklogReached() << "bytes";
+}
+
+bool AkAsyncFileWriter::flush()
+{
+    if (!this->d->m_isOpen)
+        return false;
+
+    this->d->m_mutex.lock();
+    this->d->queueBlock();
+    auto ok = this->d->waitQueue();
+    this->d->m_mutex.unlock();
+
+    return ok;
+}
+
+void AkAsyncFileWriter::setBufferSize(int bufferSize)
+{
+    bufferSize = qMax(bufferSize, MIN_BUFFER_SIZE);
+
+    if (this->d->m_bufferSize == bufferSize)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_bufferSize = bufferSize;
+    this->d->m_mutex.unlock();
+    emit this->bufferSizeChanged(bufferSize);
+}
+
+void AkAsyncFileWriter::setMaxBacklog(qint64 maxBacklog)
+{
+    maxBacklog = qMax<qint64>(maxBacklog, 0);
+
+    if (this->d->m_maxBacklog == maxBacklog)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_maxBacklog = maxBacklog;
+    this->d->m_blockWritten.wakeAll();
+    this->d->m_mutex.unlock();
+    emit this->maxBacklogChanged(maxBacklog);
+}
+
+void AkAsyncFileWriter::setPreallocationSize(qint64 preallocationSize)
+{
+    preallocationSize = qMax<qint64>(preallocationSize, 0);
+
+    if (this->d->m_preallocationSize == preallocationSize)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_preallocationSize = preallocationSize;
+    this->d->m_mutex.unlock();
+    emit this->preallocationSizeChanged(preallocationSize);
+}
+
+void AkAsyncFileWriter::setSyncInterval(int syncInterval)
+{
+    syncInterval = qMax(syncInterval, 0);
+
+    if (this->d->m_syncInterval == syncInterval)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_syncInterval = syncInterval;
+    this->d->m_mutex.unlock();
+    emit this->syncIntervalChanged(syncInterval);
+}
+
+void AkAsyncFileWriter::resetBufferSize()
+{
+    this->setBufferSize(DEFAULT_BUFFER_SIZE);
+}
+
+void AkAsyncFileWriter::resetMaxBacklog()
+{
+    this->setMaxBacklog(DEFAULT_MAX_BACKLOG);
+}
+
+void AkAsyncFileWriter::resetPreallocationSize()
+{
+    this->setPreallocationSize(0);
+}
+
+void AkAsyncFileWriter::resetSyncInterval()
+{
+    this->setSyncInterval(0);
+}
+
+void AkAsyncFileWriter::registerTypes()
+{
+    qmlRegisterType<AkAsyncFileWriter>("Ak", 1, 0, "AkAsyncFileWriter");
+}
+
+AkAsyncFileWriterPrivate::AkAsyncFileWriterPrivate()
+{
+    // The writer loop runs for all the life of the file.
+    this->m_threadPool.setMaxThreadCount(1);
+}
+
+void AkAsyncFileWriterPrivate::writeLoop()
+{
+    QElapsedTimer syncTimer;
+    syncTimer.start();
+
+    for (;;) {
+        this->m_mutex.lock();
+
+        while (this->m_queue.isEmpty() && this->m_run)
+            this->m_blockQueued.wait(&this->m_mutex);
+
+        if (this->m_queue.isEmpty()) {
+            this->m_mutex.unlock();
+
+            break;
+        }
+
+        /* The block stays in the queue while it's being written, so flush()
+         * won't return before the data reaches the file.
+         */
+        auto block = this->m_queue.head();
+        auto preallocationSize = this->m_preallocationSize;
+        auto syncInterval = this->m_syncInterval;
+        auto error = this->m_error;
+        this->m_writing = true;
+        this->m_mutex.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        bool ok = error || this->writeBlock(block, preallocationSize);
+
+        if (ok && !error
+            && syncInterval > 0
+            && syncTimer.elapsed() >= syncInterval) {
+            this->sync();
+            syncTimer.restart();
+        }
+
+        auto latency = qreal(timer.nsecsElapsed()) / 1e6;
+
+        this->m_mutex.lock();
+        this->m_queue.dequeue();
+        this->m_backlog -= block.capacity;
+        this->recycleBlock(block);
+
+        if (!error) {
+            this->m_writeLatency =
+                    this->m_writeLatency > 0.0?
+                        0.9 * this->m_writeLatency + 0.1 * latency:
+                        latency;
+            this->m_maxWriteLatency = qMax(this->m_maxWriteLatency, latency);
+        }
+
+        if (!ok) {
+            qCritical() << "Failed writing to" << this->m_fileName
+                        << ":" << this->m_file.errorString();
+            this->m_error = true;
+        }
+
+        this->m_writing = false;
+        this->m_blockWritten.wakeAll();
+        this->m_mutex.unlock();
+    }
+}
+
+bool AkAsyncFileWriterPrivate::writeBlock(const AkAsyncFileWriterBlock &block,
+                                          qint64 preallocationSize)
+{
+    if (preallocationSize > 0)
+        this->preallocate(block.offset + block.size, preallocationSize);
+
+    if (!this->m_file.seek(block.offset))
+        return false;
+
+    auto data = reinterpret_cast<const char *>(block.data);
+    qint64 written = 0;
+
+    while (written < block.size) {
+        auto result = this->m_file.write(data + written, block.size - written);
+
+        if (result < 1)
+            return false;
+
+        written += result;
+    }
+
+    return true;
+}
+
+void AkAsyncFileWriterPrivate::preallocate(qint64 end, qint64 preallocationSize)
+{
+#ifdef Q_OS_LINUX
+    if (end <= this->m_allocated)
+        return;
+
+    /* Reserve the space in big chunks without changing the file size, so the
+     * file won't end with garbage if the recording is interrupted.
+     */
+    auto size = preallocationSize
+                * ((end - this->m_allocated + preallocationSize - 1)
+                   / preallocationSize);
+
+    if (fallocate(this->m_file.handle(),
+                  FALLOC_FL_KEEP_SIZE,
+                  off_t(this->m_allocated),
+                  off_t(size)) == 0) {
+        this->m_allocated += size;
+    } else {
+        // Not supported by the file system, don't try again.
+        this->m_allocated = std::numeric_limits<qint64>::max();
+    }
+#else
+    Q_UNUSED(end)
+    Q_UNUSED(preallocationSize)
+#endif
+}
+
+void AkAsyncFileWriterPrivate::sync()
+{
+#ifdef Q_OS_WIN32
+    _commit(this->m_file.handle());
+#elif defined(Q_OS_LINUX)
+    fdatasync(this->m_file.handle());
+#elif defined(Q_OS_UNIX)
+    fsync(this->m_file.handle());
+#endif
+}
+
+void AkAsyncFileWriterPrivate::releasePreallocation()
+{
+#ifdef Q_OS_LINUX
+    /* Truncating the file to its own size releases the blocks reserved past
+     * the end of the file.
+     */
+    if (this->m_allocated > 0
+        && ftruncate(this->m_file.handle(), off_t(this->m_file.size())) != 0)
+        qWarning() << "Failed releasing the preallocated space of"
+                   << this->m_fileName;
+#endif
+}
+
+AkAsyncFileWriterBlock AkAsyncFileWriterPrivate::newBlock(qint64 offset)
+{
+    AkAsyncFileWriterBlock block;
+
+    if (!this->m_freeBlocks.isEmpty()) {
+        block = this->m_freeBlocks.takeLast();
+    } else {
+        block.capacity = this->m_bufferSize;
+        block.data = AkSimd::amallocT<quint8>(size_t(block.capacity),
+                                              BUFFER_ALIGN);
+    }
+
+    block.offset = offset;
+    block.size = 0;
+
+    return block;
+}
+
+void AkAsyncFileWriterPrivate::queueBlock()
+{
+    if (!this->m_block.data)
+        return;
+
+    if (this->m_block.size < 1) {
+        this->recycleBlock(this->m_block);
+        this->m_block = {};
+
+        return;
+    }
+
+    /* Count the whole buffer, small blocks queued by seeks and flushes
+     * take as much memory as full ones.
+     */
+    this->m_backlog += this->m_block.capacity;
+    this->m_maxBacklogReached = qMax(this->m_maxBacklogReached,
+                                     this->m_backlog);
+    this->m_queue.enqueue(this->m_block);
+    this->m_block = {};
+    this->m_blockQueued.wakeAll();
+
+    /* Block the producer until the memory used by the pending blocks is
+     * below the limit.
+     */
+    while (this->m_backlog >= this->m_maxBacklog
+           && !this->m_queue.isEmpty())
+        this->m_blockWritten.wait(&this->m_mutex);
+}
+
+void AkAsyncFileWriterPrivate::recycleBlock(const AkAsyncFileWriterBlock &block)
+{
+    if (block.capacity == this->m_bufferSize)
+        this->m_freeBlocks << block;
+    else
+        AkSimd::afree(block.data);
+}
+
+bool AkAsyncFileWriterPrivate::waitQueue()
+{
+    while (!this->m_queue.isEmpty() || this->m_writing)
+        this->m_blockWritten.wait(&this->m_mutex);
+
+    return !this->m_error;
+}
+
+void AkAsyncFileWriterPrivate::freeBlocks()
+{
+    if (this->m_block.data) {
+        AkSimd::afree(this->m_block.data);
+        this->m_block = {};
+    }
+
+    for (auto &block: this->m_freeBlocks)
+        AkSimd::afree(block.data);
+
+    this->m_freeBlocks.clear();
+}
+
+#include "moc_akasyncfilewriter.cpp"
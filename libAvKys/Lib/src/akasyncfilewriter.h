@@ -0,0 +1,147 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKASYNCFILEWRITER_H
+#define AKASYNCFILEWRITER_H
+
+#include <QObject>
+
+#include "akcommons.h"
+#include "akpropertyoption.h"
+
+class AkAsyncFileWriterPrivate;
+class AkVideoMuxer;
+
+/* Write-behind file writer for the muxers.
+ *
+ * The data is accumulated in large aligned buffers that are written to disk
+ * by a dedicated thread, so a slow disk doesn't stall the thread that
+ * produces the packets. The memory used by the pending buffers is bounded by
+ * maxBacklog, when the limit is reached write() blocks until the writer
+ * thread catches up.
+ *
+ * The writer can also preallocate the file in chunks of preallocationSize
+ * bytes to reduce the fragmentation, and force the data to the disk every
+ * syncInterval milliseconds.
+ *
+ * Seeking and reading are supported, since the muxers rewrite the headers
+ * after writing the data, reading flushes all the pending buffers first.
+ *
+ * The muxers using the writer can expose options() as their own options, and
+ * apply them with configure() before opening the file.
+ */
+class AKCOMMONS_EXPORT AkAsyncFileWriter: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int bufferSize
+               READ bufferSize
+               WRITE setBufferSize
+               RESET resetBufferSize
+               NOTIFY bufferSizeChanged)
+    Q_PROPERTY(qint64 maxBacklog
+               READ maxBacklog
+               WRITE setMaxBacklog
+               RESET resetMaxBacklog
+               NOTIFY maxBacklogChanged)
+    Q_PROPERTY(qint64 preallocationSize
+               READ preallocationSize
+               WRITE setPreallocationSize
+               RESET resetPreallocationSize
+               NOTIFY preallocationSizeChanged)
+    Q_PROPERTY(int syncInterval
+               READ syncInterval
+               WRITE setSyncInterval
+               RESET resetSyncInterval
+               NOTIFY syncIntervalChanged)
+    Q_PROPERTY(qreal writeLatency
+               READ writeLatency)
+    Q_PROPERTY(qreal maxWriteLatency
+               READ maxWriteLatency)
+    Q_PROPERTY(qint64 backlog
+               READ backlog)
+    Q_PROPERTY(qint64 maxBacklogReached
+               READ maxBacklogReached)
+
+    public:
+        AkAsyncFileWriter(QObject *parent=nullptr);
+        ~AkAsyncFileWriter();
+
+        Q_INVOKABLE static QObject *create();
+
+        // Writer options, in the units shown to the user.
+        Q_INVOKABLE static AkPropertyOptions options();
+
+        Q_INVOKABLE int bufferSize() const;
+        Q_INVOKABLE qint64 maxBacklog() const;
+        Q_INVOKABLE qint64 preallocationSize() const;
+        Q_INVOKABLE int syncInterval() const;
+
+        // Average time in milliseconds that takes writing a buffer.
+        Q_INVOKABLE qreal writeLatency() const;
+
+        Q_INVOKABLE qreal maxWriteLatency() const;
+
+        // Memory used by the buffers waiting to be written to the disk.
+        Q_INVOKABLE qint64 backlog() const;
+
+        Q_INVOKABLE qint64 maxBacklogReached() const;
+
+        Q_INVOKABLE QString fileName() const;
+        Q_INVOKABLE bool isOpen() const;
+        Q_INVOKABLE bool error() const;
+        Q_INVOKABLE bool open(const QString &fileName);
+        Q_INVOKABLE void close();
+        qint64 write(const void *data, qint64 size);
+        qint64 read(void *data, qint64 size);
+        Q_INVOKABLE bool seek(qint64 pos);
+        Q_INVOKABLE qint64 pos() const;
+        Q_INVOKABLE qint64 size() const;
+        Q_INVOKABLE bool resize(qint64 size);
+
+        // Read the writer options from the muxer.
+        Q_INVOKABLE void configure(const AkVideoMuxer *muxer);
+
+        // Print the write statistics of the file.
+        Q_INVOKABLE void logStats() const;
+
+        // Wait until all the pending buffers are written.
+        Q_INVOKABLE bool flush();
+
+    private:
+        AkAsyncFileWriterPrivate *d;
+
+    Q_SIGNALS:
+        void bufferSizeChanged(int bufferSize);
+        void maxBacklogChanged(qint64 maxBacklog);
+        void preallocationSizeChanged(qint64 preallocationSize);
+        void syncIntervalChanged(int syncInterval);
+
+    public Q_SLOTS:
+        void setBufferSize(int bufferSize);
+        void setMaxBacklog(qint64 maxBacklog);
+        void setPreallocationSize(qint64 preallocationSize);
+        void setSyncInterval(int syncInterval);
+        void resetBufferSize();
+        void resetMaxBacklog();
+        void resetPreallocationSize();
+        void resetSyncInterval();
+        static void registerTypes();
+};
+
+#endif // AKASYNCFILEWRITER_H
@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <atomic>
 #include <QDebug>
 #include <QGenericMatrix>
 #include <QMutex>
@@ -28,17 +29,89 @@
 #include "akaudiopacket.h"
 #include "akfrac.h"
 
+// Maximum number of filters in the polyphase filter bank
+#define MAX_SINC_PHASES 1024
+
+// Number of samples converted at once by the conversion plan
+#define PLAN_BLOCK_SIZE 256
+
 using AudioConvertFuntion =
     AkAudioPacket (*)(const AkAudioPacket &src);
 
+struct SincQuality
+{
+    AkAudioConverter::ResampleQuality quality;
+    int halfTaps;   // Zero crossings at each side of the filter
+    qreal beta;     // Kaiser window shape
+    qreal rolloff;  // Cutoff frequency relative to the Nyquist frequency
+
+    static inline const SincQuality *byQuality(AkAudioConverter::ResampleQuality quality)
+    {
+        static const SincQuality sincQualityTable[] = {
+            {AkAudioConverter::ResampleQuality_Low   ,  8, 5.0, 0.80},
+            {AkAudioConverter::ResampleQuality_Medium, 16, 7.0, 0.90},
+            {AkAudioConverter::ResampleQuality_High  , 32, 9.0, 0.95},
+        };
+
+        for (auto &sincQuality: sincQualityTable)
+            if (sincQuality.quality == quality)
+                return &sincQuality;
+
+        return sincQualityTable;
+    }
+};
+
+struct SincResampler
+{
+    int iRate {0};
+    int oRate {0};
+    int channels {0};
+    AkAudioConverter::ResampleQuality quality {AkAudioConverter::ResampleQuality_Medium};
+
+    // Output rate = input rate * upFactor / downFactor
+    qint64 upFactor {1};
+    qint64 downFactor {1};
+
+    int phases {0};
+    int halfLength {0};
+    int taps {0};
+    QVector<qreal> filters;
+
+    // Input samples still needed by the next output samples
+    QVector<QVector<qreal>> history;
+
+    // Time of the next output sample, in 1/upFactor input samples
+    qint64 position {0};
+};
+
 class AkAudioConverterPrivate
 {
     public:
         QMutex m_mutex;
         AkAudioCaps m_outputCaps;
-        AkAudioCaps m_previousCaps;
         AkAudioConverter::ResampleMethod m_resampleMethod {AkAudioConverter::ResampleMethod_Fast};
+        AkAudioConverter::ResampleQuality m_resampleQuality {AkAudioConverter::ResampleQuality_Medium};
+
+        /* Increased each time the configuration changes, so convert() only
+         * needs to lock when the plan must be rebuilt.
+         */
+        std::atomic<quint64> m_configVersion {0};
+
+        // The state of the conversion, only used by convert().
+        quint64 m_planVersion {quint64(-1)};
+        AkAudioCaps m_planInputCaps;
+        AkAudioCaps m_planOutputCaps;
+        AkAudioCaps m_planCaps;
+        AkAudioConverter::ResampleMethod m_planResampleMethod {AkAudioConverter::ResampleMethod_Fast};
+        AkAudioConverter::ResampleQuality m_planResampleQuality {AkAudioConverter::ResampleQuality_Medium};
+        QVector<qreal> m_mixMatrix;
+        QVector<qreal> m_decodeBuffer;
+        QVector<qreal> m_mixBuffer;
+        QVector<qreal> m_resampleBuffer;
+        bool m_planIsValid {false};
+        bool m_planIsPassthrough {false};
         qreal m_sampleCorrection {0};
+        SincResampler m_sinc;
 
         template<typename InputType, typename OutputType, typename OpType>
         inline static OutputType scaleValue(InputType value)
@@ -128,364 +201,101 @@ class AkAudioConverterPrivate
             return qToBigEndian(value);
         }
 
-        template<typename InputType,
-                 typename OutputType,
-                 typename OpType,
-                 typename TransformFuncType1,
-                 typename TransformFuncType2>
-        inline static AkAudioPacket convertSampleFormat(const AkAudioPacket &src,
-                                                        AkAudioCaps::SampleFormat format,
-                                                        TransformFuncType1 transformFrom,
-                                                        TransformFuncType2 transformTo)
-        {
-            auto caps = src.caps();
-            caps.setFormat(format);
-            AkAudioPacket dst(caps, src.samples());
-            dst.copyMetadata(src);
-            dst.setDuration(dst.samples());
-            auto n = caps.channels() - src.planes() + 1;
-
-            for (int plane = 0; plane < src.planes(); ++plane) {
-                auto src_line = reinterpret_cast<const InputType *>(src.constPlane(plane));
-                auto dst_line = reinterpret_cast<OutputType *>(dst.plane(plane));
-
-                for (int i = 0; i < n * src.samples(); ++i)
-                    dst_line[i] =
-                            transformTo(scaleValue<InputType,
-                                                   OutputType,
-                                                   OpType>(transformFrom(src_line[i])));
-            }
-
-            return dst;
-        }
-
-#define DEFINE_SAMPLE_CONVERT_FUNCTION(sitype, \
-                                       sotype, \
-                                       itype, \
-                                       otype, \
-                                       optype, \
-                                       inEndian, \
-                                       outEndian) \
-        {AkAudioCaps::SampleFormat_##sitype, \
-         AkAudioCaps::SampleFormat_##sotype, \
-         [] (const AkAudioPacket &src) -> AkAudioPacket { \
-            return convertSampleFormat<itype, otype, optype> \
-                    (src, \
-                     AkAudioCaps::SampleFormat_##sotype, \
-                     from##inEndian<itype>, \
-                     to##outEndian<otype>); \
-         }}, \
-        {AkAudioCaps::SampleFormat_##sotype, \
-         AkAudioCaps::SampleFormat_##sitype, \
-         [] (const AkAudioPacket &src) -> AkAudioPacket { \
-             return convertSampleFormat<otype, itype, optype> \
-                    (src, \
-                     AkAudioCaps::SampleFormat_##sitype, \
-                     from##outEndian<otype>, \
-                     to##inEndian<itype>); \
-         }}
-
-        struct AudioSampleFormatConvert
-        {
-            AkAudioCaps::SampleFormat from;
-            AkAudioCaps::SampleFormat to;
-            AudioConvertFuntion convert;
-        };
-
-        using AudioSampleFormatConvertFuncs = QVector<AudioSampleFormatConvert>;
-
-        inline static const AudioSampleFormatConvertFuncs &sampleFormatConvert()
-        {
-            // Convert sample formats
-            static const AudioSampleFormatConvertFuncs convert {
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s8   , dbl,   qint8, qreal, qreal,  _, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u8   , dbl,  quint8, qreal, qreal,  _, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s16le, dbl,  qint16, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s16be, dbl,  qint16, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u16le, dbl, quint16, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u16be, dbl, quint16, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s32le, dbl,  qint32, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s32be, dbl,  qint32, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u32le, dbl, quint32, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u32be, dbl, quint32, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s64le, dbl,  qint64, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(s64be, dbl,  qint64, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u64le, dbl, quint64, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(u64be, dbl, quint64, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(fltle, dbl,   float, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(fltbe, dbl,   float, qreal, qreal, BE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(dblle, dbl,   qreal, qreal, qreal, LE, _),
-                DEFINE_SAMPLE_CONVERT_FUNCTION(dblbe, dbl,   qreal, qreal, qreal, BE, _),
-            };
-
-            return convert;
-        }
-
-        template<typename SampleType,
-                 typename SumType,
-                 typename TransformFuncType>
-        inline static AkAudioPacket mixChannels(AkAudioCaps::SampleFormat sumFormat,
-                                                AkAudioCaps::ChannelLayout outputLayout,
-                                                const AkAudioPacket &src,
-                                                TransformFuncType transformFrom,
-                                                TransformFuncType transformTo)
-        {
-            // Create a summatory packet which type is big enough to contain
-            // the sum of all values.
-            auto caps = src.caps();
-            caps.setFormat(sumFormat);
-            caps.setLayout(outputLayout);
-            AkAudioPacket sumPacket(caps, src.samples(), true);
-
-            // Create output packet.
-            caps = src.caps();
-            caps.setLayout(outputLayout);
-            AkAudioPacket dst(caps, src.samples());
-            dst.copyMetadata(src);
-            dst.setDuration(dst.samples());
-
-            // Precalculate positional factors
-            QVector<qreal> factors;
-
-            for (int ochannel = 0; ochannel < sumPacket.caps().channels(); ++ochannel) {
-                auto oposition = sumPacket.caps().position(ochannel);
-
-                for (int ichannel = 0; ichannel < src.caps().channels(); ++ichannel) {
-                    auto iposition = src.caps().position(ichannel);
-                    factors << AkAudioCaps::distanceFactor(iposition, oposition);
-                }
-            }
-
-            // Wave limits
-            auto xmin = std::numeric_limits<SumType>::max();
-            auto xmax = std::numeric_limits<SumType>::min();
-            auto ymin = std::numeric_limits<SampleType>::max();
-            auto ymax = std::numeric_limits<SampleType>::min();
-
-            /* We use inverse square law to sum the samples
-             * according to the speaker position in the sound dome.
-             *
-             * http://digitalsoundandmusic.com/4-3-4-the-mathematics-of-the-inverse-square-law-and-pag-equations/
-             */
-            if (src.caps().planar()) {
-                for (int ochannel = 0; ochannel < dst.caps().channels(); ++ochannel) {
-                    auto sum_line = reinterpret_cast<SumType *>(sumPacket.plane(ochannel));
-
-                    for (int ichannel = 0; ichannel < src.caps().channels(); ++ichannel) {
-                        auto k = factors[ichannel + ochannel * src.caps().channels()];
-                        auto src_line = reinterpret_cast<const SampleType *>(src.constPlane(ichannel));
-
-                        for (int sample = 0; sample < dst.samples(); ++sample) {
-                            auto sampleValue = transformFrom(src_line[sample]);
-                            sum_line[sample] += SumType(k * qreal(sampleValue));
-
-                            // Calculate minimum and maximum values of the wave.
-
-                            if (ichannel == src.caps().channels() - 1) {
-                                xmin = qMin(xmin, sum_line[sample]);
-                                xmax = qMax(xmax, sum_line[sample]);
-                            }
-
-                            if (ochannel == 0) {
-                                ymin = qMin(ymin, sampleValue);
-                                ymax = qMax(ymax, sampleValue);
-                            }
-                        }
-                    }
-                }
-
-                // Recreate frame with the wave scaled to fit it.
-                for (int ochannel = 0; ochannel < dst.caps().channels(); ++ochannel) {
-                    auto dst_line = reinterpret_cast<SampleType *>(dst.plane(ochannel));
-                    auto sum_line = reinterpret_cast<SumType *>(sumPacket.plane(ochannel));
-
-                    for (int sample = 0; sample < dst.samples(); ++sample) {
-                        dst_line[sample] = transformTo(scaleValue<SumType,
-                                                                  SampleType,
-                                                                  SumType>(sum_line[sample],
-                                                                           xmin,
-                                                                           xmax,
-                                                                           ymin,
-                                                                           ymax));
-                    }
-                }
-            } else {
-                auto src_line = reinterpret_cast<const SampleType *>(src.constPlane(0));
-                auto dst_line = reinterpret_cast<SampleType *>(dst.plane(0));
-                auto sum_line = reinterpret_cast<SumType *>(sumPacket.plane(0));
-
-                for (int sample = 0; sample < dst.samples(); ++sample) {
-                    auto iSampleOffset = sample * src.caps().channels();
-                    auto oSampleOffset = sample * dst.caps().channels();
-
-                    for (int ochannel = 0; ochannel < dst.caps().channels(); ++ochannel) {
-                        auto sumOffset = oSampleOffset + ochannel;
-
-                        for (int ichannel = 0; ichannel < src.caps().channels(); ++ichannel) {
-                            auto k = factors[ichannel + ochannel * src.caps().channels()];
-                            auto sampleValue = transformFrom(src_line[iSampleOffset + ichannel]);
-                            sum_line[sumOffset] += SumType(k * qreal(sampleValue));
-
-                            // Calculate minimum and maximum values of the wave.
-
-                            if (ichannel == src.caps().channels() - 1) {
-                                xmin = qMin(xmin, sum_line[sumOffset]);
-                                xmax = qMax(xmax, sum_line[sumOffset]);
-                            }
-
-                            if (ochannel == 0) {
-                                ymin = qMin(ymin, sampleValue);
-                                ymax = qMax(ymax, sampleValue);
-                            }
-                        }
-                    }
-                }
-
-                // Recreate frame with the wave scaled to fit it.
-                for (int sample = 0; sample < dst.samples(); ++sample) {
-                    auto oSampleOffset = sample * dst.caps().channels();
-
-                    for (int ochannel = 0; ochannel < dst.caps().channels(); ++ochannel) {
-                        auto sumOffset = oSampleOffset + ochannel;
-                        dst_line[sumOffset] = transformTo(scaleValue<SumType,
-                                                                     SampleType,
-                                                                     SumType>(sum_line[sumOffset],
-                                                                              xmin,
-                                                                              xmax,
-                                                                              ymin,
-                                                                              ymax));
-                    }
-                }
-            }
-
-            return dst;
-        }
-
-#define HANDLE_CASE_CONVERT_LAYOUT(olayout, \
-                                   src, \
-                                   format, \
-                                   sumFormat, \
-                                   sampleType, \
-                                   sumType, \
-                                   endian) \
-        case AkAudioCaps::SampleFormat_##format: \
-            return mixChannels<sampleType, sumType> \
-                    (AkAudioCaps::SampleFormat_##sumFormat, \
-                     olayout, \
-                     src, \
-                     from##endian<sampleType>, \
-                     to##endian<sampleType>);
-
-        inline static AkAudioPacket convertChannels(AkAudioCaps::ChannelLayout outputLayout,
-                                                    const AkAudioPacket &src)
+        /* The conversion plan reads the input samples to double precision
+         * values in the [-1, 1] range, mixes the channels and writes them in
+         * the output format. The samples are processed in blocks that fit in
+         * the cache, so the whole conversion is done in a single pass.
+         */
+        template<typename SampleType, typename TransformFuncType>
+        inline static void decodeSamples(const quint8 *src,
+                                         size_t stride,
+                                         qreal *dst,
+                                         int samples,
+                                         TransformFuncType transformFrom)
         {
-            switch (src.caps().format()) {
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s8   , dbl, qint8  , qreal,  _)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u8   , dbl, quint8 , qreal,  _)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s16le, dbl, qint16 , qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s16be, dbl, qint16 , qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u16le, dbl, quint16, qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u16be, dbl, quint16, qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s32le, dbl, qint32 , qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s32be, dbl, qint32 , qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u32le, dbl, quint32, qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u32be, dbl, quint32, qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s64le, dbl, qint64 , qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, s64be, dbl, qint64 , qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u64le, dbl, quint64, qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, u64be, dbl, quint64, qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, fltle, dbl, float  , qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, fltbe, dbl, float  , qreal, BE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, dblle, dbl, qreal  , qreal, LE)
-            HANDLE_CASE_CONVERT_LAYOUT(outputLayout, src, dblbe, dbl, qreal  , qreal, BE)
-            default:
-                return {};
-            }
+            auto src_line = reinterpret_cast<const SampleType *>(src);
+
+            #pragma omp simd
+            for (int sample = 0; sample < samples; ++sample)
+                dst[sample] =
+                        scaleValue<SampleType,
+                                   qreal,
+                                   qreal>(transformFrom(src_line[size_t(sample) * stride]));
         }
 
-        template<typename SampleType>
-        inline static AkAudioPacket convertChannelModel(const AkAudioPacket &packet,
-                                                        bool planar)
+        template<typename SampleType, typename TransformFuncType>
+        inline static void encodeSamples(const qreal *src,
+                                         quint8 *dst,
+                                         size_t stride,
+                                         int samples,
+                                         TransformFuncType transformTo)
         {
-            auto caps = packet.caps();
-            caps.setPlanar(planar);
-            AkAudioPacket outPacket(caps, packet.samples());
-            outPacket.copyMetadata(packet);
-            outPacket.setDuration(outPacket.samples());
-
-            if (planar) {
-                auto src_line = reinterpret_cast<const SampleType *>(packet.constPlane(0));
-
-                for (int channel = 0; channel < caps.channels(); ++channel) {
-                    auto dst_line = reinterpret_cast<SampleType *>(outPacket.plane(channel));
-
-                    for (int sample = 0; sample < packet.samples(); ++sample)
-                        dst_line[sample] = src_line[sample * caps.channels() + channel];
-                }
-            } else {
-                auto dst_line = reinterpret_cast<SampleType *>(outPacket.plane(0));
-
-                for (int channel = 0; channel < packet.caps().channels(); ++channel) {
-                    auto src_line = reinterpret_cast<const SampleType *>(packet.constPlane(channel));
-
-                    for (int sample = 0; sample < packet.samples(); ++sample)
-                        dst_line[sample * caps.channels() + channel] = src_line[sample];
-                }
-            }
-
-            return outPacket;
+            auto dst_line = reinterpret_cast<SampleType *>(dst);
+
+            #pragma omp simd
+            for (int sample = 0; sample < samples; ++sample)
+                dst_line[size_t(sample) * stride] =
+                        transformTo(scaleValue<qreal,
+                                               SampleType,
+                                               qreal>(src[sample]));
         }
 
-        using ConvertChannelModelFunction =
-            AkAudioPacket (*)(const AkAudioPacket &packet, bool planar);
+        using DecodeSamplesFunction =
+            void (*)(const quint8 *src, size_t stride, qreal *dst, int samples);
+        using EncodeSamplesFunction =
+            void (*)(const qreal *src, quint8 *dst, size_t stride, int samples);
 
-#define DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(sitype, itype) \
+#define DEFINE_SAMPLE_CODEC_FUNCTION(sitype, itype, endian) \
         {AkAudioCaps::SampleFormat_##sitype, \
-         [] (const AkAudioPacket &packet, bool planar) -> AkAudioPacket { \
-            return convertChannelModel<itype>(packet, planar); \
+         [] (const quint8 *src, size_t stride, qreal *dst, int samples) { \
+            decodeSamples<itype>(src, stride, dst, samples, from##endian<itype>); \
+         }, \
+         [] (const qreal *src, quint8 *dst, size_t stride, int samples) { \
+            encodeSamples<itype>(src, dst, stride, samples, to##endian<itype>); \
          }}
 
-        struct AudioSamplesConvertChannelModel
+        struct AudioSampleCodec
         {
             AkAudioCaps::SampleFormat format;
-            ConvertChannelModelFunction convert;
+            DecodeSamplesFunction decode;
+            EncodeSamplesFunction encode;
         };
 
-        using AudioSamplesConvertChannelModelFuncs = QVector<AudioSamplesConvertChannelModel>;
+        using AudioSampleCodecFuncs = QVector<AudioSampleCodec>;
 
-        inline static const AudioSamplesConvertChannelModelFuncs &samplesConvertChannelModel()
+        inline static const AudioSampleCodecFuncs &sampleCodecs()
         {
-            static const AudioSamplesConvertChannelModelFuncs convert {
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s8   ,   qint8),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u8   ,  quint8),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s16le,  qint16),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s16be,  qint16),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u16le, quint16),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u16be, quint16),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s32le,  qint32),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s32be,  qint32),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u32le, quint32),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u32be, quint32),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s64le,  qint64),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(s64be,  qint64),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u64le, quint64),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(u64be, quint64),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(fltle,   float),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(fltbe,   float),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(dblle,   qreal),
-                DEFINE_CONVERT_CHANNEL_MODEL_FUNCTION(dblbe,   qreal),
+            static const AudioSampleCodecFuncs codecs {
+                DEFINE_SAMPLE_CODEC_FUNCTION(s8   ,   qint8,  _),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u8   ,  quint8,  _),
+                DEFINE_SAMPLE_CODEC_FUNCTION(s16le,  qint16, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(s16be,  qint16, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u16le, quint16, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u16be, quint16, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(s32le,  qint32, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(s32be,  qint32, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u32le, quint32, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u32be, quint32, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(s64le,  qint64, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(s64be,  qint64, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u64le, quint64, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(u64be, quint64, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(fltle,   float, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(fltbe,   float, BE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(dblle,   qreal, LE),
+                DEFINE_SAMPLE_CODEC_FUNCTION(dblbe,   qreal, BE),
             };
 
-            return convert;
+            return codecs;
         }
 
-        inline static const AudioSamplesConvertChannelModel *byChannelModelFormat(AkAudioCaps::SampleFormat format)
+        inline static const AudioSampleCodec *bySampleCodecFormat(AkAudioCaps::SampleFormat format)
         {
-            for (auto &model: samplesConvertChannelModel())
-                if (model.format == format)
-                    return &model;
+            for (auto &codec: sampleCodecs())
+                if (codec.format == format)
+                    return &codec;
 
-            return &samplesConvertChannelModel().front();
+            return nullptr;
         }
 
         template<typename SampleType,
@@ -543,10 +353,11 @@ class AkAudioConverterPrivate
 
         template<typename SampleType>
         inline static AkAudioPacket scaleSamplesFast(const AkAudioPacket &packet,
+                                                     const AkAudioCaps &oCaps,
                                                      int samples)
         {
             auto iSamples = packet.samples();
-            AkAudioPacket outPacket(packet.caps(), samples);
+            AkAudioPacket outPacket(oCaps, samples);
             outPacket.copyMetadata(packet);
             outPacket.setDuration(outPacket.samples());
             QVector<int> sampleValues;
@@ -608,12 +419,13 @@ class AkAudioConverterPrivate
                  typename SumType,
                  typename TransformFuncType>
         inline static AkAudioPacket scaleSamplesLinear(const AkAudioPacket &packet,
+                                                       const AkAudioCaps &oCaps,
                                                        int samples,
                                                        TransformFuncType transformFrom,
                                                        TransformFuncType transformTo)
         {
             auto iSamples = packet.samples();
-            AkAudioPacket outPacket(packet.caps(), samples);
+            AkAudioPacket outPacket(oCaps, samples);
             outPacket.copyMetadata(packet);
             outPacket.setDuration(outPacket.samples());
             QVector<ValuesMinMax> sampleValues;
@@ -675,12 +487,13 @@ class AkAudioConverterPrivate
                  typename SumType,
                  typename TransformFuncType>
         inline static AkAudioPacket scaleSamplesQuadratic(const AkAudioPacket &packet,
+                                                          const AkAudioCaps &oCaps,
                                                           int samples,
                                                           TransformFuncType transformFrom,
                                                           TransformFuncType transformTo)
         {
             auto iSamples = int(packet.samples());
-            AkAudioPacket outPacket(packet.caps(), samples);
+            AkAudioPacket outPacket(oCaps, samples);
             outPacket.copyMetadata(packet);
             outPacket.setDuration(outPacket.samples());
             QVector<ValuesMinMax> sampleValues;
@@ -746,26 +559,36 @@ class AkAudioConverterPrivate
         }
 
         using ScalingFunction =
-            AkAudioPacket (*)(const AkAudioPacket &packet, int samples);
+            AkAudioPacket (*)(const AkAudioPacket &packet,
+                              const AkAudioCaps &oCaps,
+                              int samples);
 
 #define DEFINE_SAMPLE_SCALING_FUNCTION(sitype, \
                                        itype, \
                                        optype, \
                                        endian) \
         {AkAudioCaps::SampleFormat_##sitype, \
-         [] (const AkAudioPacket &packet, int samples) -> AkAudioPacket { \
-            return scaleSamplesFast<itype>(packet, samples); \
+         [] (const AkAudioPacket &packet, \
+             const AkAudioCaps &oCaps, \
+             int samples) -> AkAudioPacket { \
+            return scaleSamplesFast<itype>(packet, oCaps, samples); \
          }, \
-         [] (const AkAudioPacket &packet, int samples) -> AkAudioPacket { \
+         [] (const AkAudioPacket &packet, \
+             const AkAudioCaps &oCaps, \
+             int samples) -> AkAudioPacket { \
             return scaleSamplesLinear<itype, optype> \
                     (packet, \
+                     oCaps, \
                      samples, \
                      from##endian<itype>, \
                      to##endian<itype>); \
          }, \
-         [] (const AkAudioPacket &packet, int samples) -> AkAudioPacket { \
+         [] (const AkAudioPacket &packet, \
+             const AkAudioCaps &oCaps, \
+             int samples) -> AkAudioPacket { \
             return scaleSamplesQuadratic<itype, optype> \
                     (packet, \
+                     oCaps, \
                      samples, \
                      from##endian<itype>, \
                      to##endian<itype>); \
@@ -816,10 +639,19 @@ class AkAudioConverterPrivate
             return &samplesScaling().front();
         }
 
-        AkAudioPacket convertFormat(const AkAudioPacket &packet);
-        AkAudioPacket convertLayout(const AkAudioPacket &packet);
-        AkAudioPacket convertPlanar(const AkAudioPacket &packet);
+        DecodeSamplesFunction m_decode {nullptr};
+        EncodeSamplesFunction m_encode {nullptr};
+        EncodeSamplesFunction m_encodeOutput {nullptr};
+
+        void configurePlan(const AkAudioCaps &inputCaps);
+        AkAudioPacket runPlan(const AkAudioPacket &packet);
         AkAudioPacket convertSampleRate(const AkAudioPacket &packet);
+        static qreal besselI0(qreal x);
+        void configureSinc(int iRate,
+                           int oRate,
+                           int channels,
+                           AkAudioConverter::ResampleQuality quality);
+        AkAudioPacket resampleSinc(const AkAudioPacket &packet, int oSampleRate);
 };
 
 AkAudioConverter::AkAudioConverter(const AkAudioCaps &outputCaps, QObject *parent):
@@ -834,8 +666,8 @@ AkAudioConverter::AkAudioConverter(const AkAudioConverter &other):
 {
     this->d = new AkAudioConverterPrivate();
     this->d->m_outputCaps = other.d->m_outputCaps;
-    this->d->m_previousCaps = other.d->m_previousCaps;
-    this->d->m_sampleCorrection = other.d->m_sampleCorrection;
+    this->d->m_resampleMethod = other.d->m_resampleMethod;
+    this->d->m_resampleQuality = other.d->m_resampleQuality;
 }
 
 AkAudioConverter::~AkAudioConverter()
@@ -846,9 +678,12 @@ AkAudioConverter::~AkAudioConverter()
 AkAudioConverter &AkAudioConverter::operator =(const AkAudioConverter &other)
 {
     if (this != &other) {
+        this->d->m_mutex.lock();
         this->d->m_outputCaps = other.d->m_outputCaps;
-        this->d->m_previousCaps = other.d->m_previousCaps;
-        this->d->m_sampleCorrection = other.d->m_sampleCorrection;
+        this->d->m_resampleMethod = other.d->m_resampleMethod;
+        this->d->m_resampleQuality = other.d->m_resampleQuality;
+        this->d->m_mutex.unlock();
+        this->d->m_configVersion++;
     }
 
     return *this;
@@ -869,63 +704,50 @@ AkAudioConverter::ResampleMethod AkAudioConverter::resampleMethod() const
     return this->d->m_resampleMethod;
 }
 
+AkAudioConverter::ResampleQuality AkAudioConverter::resampleQuality() const
+{
+    return this->d->m_resampleQuality;
+}
+
 bool AkAudioConverter::canConvertFormat(AkAudioCaps::SampleFormat input,
                                         AkAudioCaps::SampleFormat output)
 {
     if (input == output)
         return true;
 
-    bool fromFormat = false;
-    bool toFormat = false;
-
-    for (auto &convert: AkAudioConverterPrivate::sampleFormatConvert()) {
-        if (convert.from == input)
-            fromFormat = true;
-
-        if (convert.to == output)
-            toFormat = true;
-
-        if (fromFormat && toFormat)
-            return true;
-    }
-
-    return false;
+    return AkAudioConverterPrivate::bySampleCodecFormat(input)
+           && AkAudioConverterPrivate::bySampleCodecFormat(output);
 }
 
 AkAudioPacket AkAudioConverter::convert(const AkAudioPacket &packet)
 {
-    this->d->m_mutex.lock();
-    auto outputCaps = this->d->m_outputCaps;
-    this->d->m_mutex.unlock();
+    auto configVersion = this->d->m_configVersion.load();
+
+    if (configVersion != this->d->m_planVersion) {
+        this->d->m_mutex.lock();
+        this->d->m_planOutputCaps = this->d->m_outputCaps;
+        this->d->m_planResampleMethod = this->d->m_resampleMethod;
+        this->d->m_planResampleQuality = this->d->m_resampleQuality;
+        this->d->m_mutex.unlock();
+        this->d->m_planVersion = configVersion;
+        this->d->m_planInputCaps = {};
+    }
 
-    if (!outputCaps)
+    if (!this->d->m_planOutputCaps)
         return packet;
 
     if (packet.size() < 1)
         return {};
 
-    this->d->m_mutex.lock();
-
-    if (packet.caps() != this->d->m_previousCaps) {
-        this->d->m_previousCaps = packet.caps();
-        this->d->m_sampleCorrection = 0;
-    }
-
-    this->d->m_mutex.unlock();
-    auto outPacket = this->d->convertFormat(packet);
-
-    if (!outPacket)
-        return {};
-
-    outPacket = this->d->convertLayout(outPacket);
+    if (packet.caps() != this->d->m_planInputCaps)
+        this->d->configurePlan(packet.caps());
 
-    if (!outPacket)
+    if (!this->d->m_planIsValid)
         return {};
 
-    outPacket = this->d->convertPlanar(outPacket);
-
-    if (!outPacket)
-        return {};
+    auto outPacket = this->d->m_planIsPassthrough?
+                         packet:
+                         this->d->runPlan(packet);
 
     return this->d->convertSampleRate(outPacket);
 }
@@ -950,13 +772,16 @@ AkAudioPacket AkAudioConverter::scale(const AkAudioPacket &packet,
 
     switch (method) {
     case AkAudioConverter::ResampleMethod_Fast:
-        return ssf->fast(packet, samples);
+        return ssf->fast(packet, packet.caps(), samples);
 
     case AkAudioConverter::ResampleMethod_Linear:
-        return ssf->linear(packet, samples);
+        return ssf->linear(packet, packet.caps(), samples);
 
+    // The sinc filter needs the history of the stream, use the nearest
+    // stateless method for the isolated packets.
     case AkAudioConverter::ResampleMethod_Quadratic:
-        return ssf->quadratic(packet, samples);
+    case AkAudioConverter::ResampleMethod_Sinc:
+        return ssf->quadratic(packet, packet.caps(), samples);
     }
 
     return {};
@@ -970,6 +795,7 @@ void AkAudioConverter::setOutputCaps(const AkAudioCaps &outputCaps)
     this->d->m_mutex.lock();
     this->d->m_outputCaps = outputCaps;
     this->d->m_mutex.unlock();
+    this->d->m_configVersion++;
     emit this->outputCapsChanged(outputCaps);
 }
 
@@ -978,10 +804,25 @@ void AkAudioConverter::setResampleMethod(ResampleMethod resampleMethod)
     if (this->d->m_resampleMethod == resampleMethod)
         return;
 
+    this->d->m_mutex.lock();
     this->d->m_resampleMethod = resampleMethod;
+    this->d->m_mutex.unlock();
+    this->d->m_configVersion++;
     emit this->resampleMethodChanged(resampleMethod);
 }
 
+void AkAudioConverter::setResampleQuality(ResampleQuality resampleQuality)
+{
+    if (this->d->m_resampleQuality == resampleQuality)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_resampleQuality = resampleQuality;
+    this->d->m_mutex.unlock();
+    this->d->m_configVersion++;
+    emit this->resampleQualityChanged(resampleQuality);
+}
+
 void AkAudioConverter::resetOutputCaps()
 {
     this->setOutputCaps({});
@@ -992,12 +833,15 @@ void AkAudioConverter::resetResampleMethod()
     this->setResampleMethod(AkAudioConverter::ResampleMethod_Fast);
 }
 
+void AkAudioConverter::resetResampleQuality()
+{
+    this->setResampleQuality(AkAudioConverter::ResampleQuality_Medium);
+}
+
 void AkAudioConverter::reset()
 {
-    this->d->m_mutex.lock();
-    this->d->m_previousCaps = AkAudioCaps();
-    this->d->m_sampleCorrection = 0;
-    this->d->m_mutex.unlock();
+    // The plan and the resampling state are rebuilt in the next convert().
+    this->d->m_configVersion++;
 }
 
 void AkAudioConverter::registerTypes()
@@ -1026,84 +870,182 @@ QDebug operator <<(QDebug debug, AkAudioConverter::ResampleMethod method)
     return debug;
 }
 
-AkAudioPacket AkAudioConverterPrivate::convertFormat(const AkAudioPacket &packet)
+QDebug operator <<(QDebug debug, AkAudioConverter::ResampleQuality quality)
 {
-    auto iFormat = packet.caps().format();
-    this->m_mutex.lock();
-    auto oFormat = this->m_outputCaps.format();
-    this->m_mutex.unlock();
-
-    if (iFormat == oFormat)
-        return packet;
+    AkAudioConverter converter;
+    int resampleQualityIndex = converter.metaObject()->indexOfEnumerator("ResampleQuality");
+    QMetaEnum resampleQualityEnum = converter.metaObject()->enumerator(resampleQualityIndex);
+    QString resampleQualityStr(resampleQualityEnum.valueToKey(quality));
+    resampleQualityStr.remove("ResampleQuality_");
+    QDebugStateSaver saver(debug);
+    debug.nospace() << resampleQualityStr.toStdString().c_str();
 
-    AudioConvertFuntion convertFrom;
-    AudioConvertFuntion convertTo;
+    return debug;
+}
 
-    for (auto &convert: AkAudioConverterPrivate::sampleFormatConvert()) {
-        if (convert.from == iFormat)
-            convertFrom = convert.convert;
+void AkAudioConverterPrivate::configurePlan(const AkAudioCaps &inputCaps)
+{
+    this->m_planInputCaps = inputCaps;
+    this->m_sampleCorrection = 0;
+    this->m_sinc = {};
+
+    auto &outputCaps = this->m_planOutputCaps;
+
+    /* The plan converts the format, the channels and the sample model at the
+     * input sample rate. The sinc filter reads planar double precision
+     * samples, and writes the output format by itself.
+     */
+    auto caps = outputCaps;
+    caps.setRate(inputCaps.rate());
+
+    if (inputCaps.rate() != outputCaps.rate()
+        && this->m_planResampleMethod == AkAudioConverter::ResampleMethod_Sinc) {
+        caps.setFormat(AkAudioCaps::SampleFormat_dbl);
+        caps.setPlanar(true);
+    }
 
-        if (convert.to == oFormat)
-            convertTo = convert.convert;
+    this->m_planCaps = caps;
+    auto decoder = bySampleCodecFormat(inputCaps.format());
+    auto encoder = bySampleCodecFormat(caps.format());
+    auto outputEncoder = bySampleCodecFormat(outputCaps.format());
+    this->m_decode = decoder? decoder->decode: nullptr;
+    this->m_encode = encoder? encoder->encode: nullptr;
+    this->m_encodeOutput = outputEncoder? outputEncoder->encode: nullptr;
+    this->m_planIsValid = this->m_decode
+                          && this->m_encode
+                          && this->m_encodeOutput;
+    this->m_planIsPassthrough = inputCaps.format() == caps.format()
+                                && inputCaps.layout() == caps.layout()
+                                && inputCaps.planar() == caps.planar();
+
+    auto iChannels = inputCaps.channels();
+    auto oChannels = caps.channels();
+    this->m_mixMatrix.clear();
+
+    /* We use inverse square law to mix the channels according to the speaker
+     * position in the sound dome. The factors of each output channel are
+     * normalized, so the sum never clips and there is no need to rescale the
+     * wave on each packet.
+     */
+    if (inputCaps.layout() != caps.layout()) {
+        this->m_mixMatrix.resize(oChannels * iChannels);
+
+        for (int ochannel = 0; ochannel < oChannels; ++ochannel) {
+            auto oposition = caps.position(ochannel);
+            auto factors = this->m_mixMatrix.data() + ochannel * iChannels;
+            qreal sum = 0.0;
+
+            for (int ichannel = 0; ichannel < iChannels; ++ichannel) {
+                auto iposition = inputCaps.position(ichannel);
+                factors[ichannel] = AkAudioCaps::distanceFactor(iposition,
+                                                                oposition);
+                sum += factors[ichannel];
+            }
 
-        if (convert.from == iFormat && convert.to == oFormat)
-            return convert.convert(packet);
+            if (sum > 0.0)
+                for (int ichannel = 0; ichannel < iChannels; ++ichannel)
+                    factors[ichannel] /= sum;
+        }
     }
 
-    if (convertFrom && convertTo)
-        return convertTo(convertFrom(packet));
-
-    return {};
+    this->m_decodeBuffer.resize(iChannels * PLAN_BLOCK_SIZE);
+    this->m_mixBuffer.resize(oChannels * PLAN_BLOCK_SIZE);
 }
 
-AkAudioPacket AkAudioConverterPrivate::convertLayout(const AkAudioPacket &packet)
+AkAudioPacket AkAudioConverterPrivate::runPlan(const AkAudioPacket &packet)
 {
-    this->m_mutex.lock();
-    auto oLayout = this->m_outputCaps.layout();
-    this->m_mutex.unlock();
+    auto &iCaps = packet.caps();
+    auto &oCaps = this->m_planCaps;
+    AkAudioPacket dst(oCaps, packet.samples());
+    dst.copyMetadata(packet);
+    dst.setDuration(dst.samples());
+
+    auto iChannels = iCaps.channels();
+    auto oChannels = oCaps.channels();
+    auto iSampleSize = size_t(iCaps.bps() / 8);
+    auto oSampleSize = size_t(oCaps.bps() / 8);
+    auto iStride = iCaps.planar()? size_t(1): size_t(iChannels);
+    auto oStride = oCaps.planar()? size_t(1): size_t(oChannels);
+    auto decodeBuffer = this->m_decodeBuffer.data();
+    auto mixBuffer = this->m_mixBuffer.data();
+    auto mixMatrix = this->m_mixMatrix.constData();
+    bool mix = !this->m_mixMatrix.isEmpty();
+    auto samples = int(packet.samples());
+
+    for (int offset = 0; offset < samples; offset += PLAN_BLOCK_SIZE) {
+        auto blockSize = qMin(PLAN_BLOCK_SIZE, samples - offset);
+
+        // Read the samples of each channel.
+        for (int ichannel = 0; ichannel < iChannels; ++ichannel) {
+            auto src = iCaps.planar()?
+                           packet.constPlane(ichannel)
+                           + size_t(offset) * iSampleSize:
+                           packet.constPlane(0)
+                           + (size_t(offset) * iChannels + ichannel) * iSampleSize;
+            this->m_decode(src,
+                           iStride,
+                           decodeBuffer + ichannel * PLAN_BLOCK_SIZE,
+                           blockSize);
+        }
 
-    if (packet.caps().layout() == oLayout)
-        return packet;
+        const qreal *channels = decodeBuffer;
 
-    return AkAudioConverterPrivate::convertChannels(oLayout, packet);
-}
+        // Mix the channels.
+        if (mix) {
+            for (int ochannel = 0; ochannel < oChannels; ++ochannel) {
+                auto mix_line = mixBuffer + ochannel * PLAN_BLOCK_SIZE;
+                auto factors = mixMatrix + ochannel * iChannels;
+                memset(mix_line, 0, size_t(blockSize) * sizeof(qreal));
 
-AkAudioPacket AkAudioConverterPrivate::convertPlanar(const AkAudioPacket &packet)
-{
-    this->m_mutex.lock();
-    auto planar = this->m_outputCaps.planar();
-    this->m_mutex.unlock();
+                for (int ichannel = 0; ichannel < iChannels; ++ichannel) {
+                    auto k = factors[ichannel];
 
-    if (packet.caps().planar() == planar)
-        return packet;
+                    if (qFuzzyIsNull(k))
+                        continue;
 
-    auto cmf =
-            AkAudioConverterPrivate::byChannelModelFormat(packet.caps().format());
+                    auto src_line = decodeBuffer + ichannel * PLAN_BLOCK_SIZE;
 
-    if (!cmf)
-        return {};
+                    #pragma omp simd
+                    for (int sample = 0; sample < blockSize; ++sample)
+                        mix_line[sample] += k * src_line[sample];
+                }
+            }
 
-    return cmf->convert(packet, planar);
+            channels = mixBuffer;
+        }
+
+        // Write the samples in the output format.
+        for (int ochannel = 0; ochannel < oChannels; ++ochannel) {
+            auto dstData = oCaps.planar()?
+                               dst.plane(ochannel)
+                               + size_t(offset) * oSampleSize:
+                               dst.plane(0)
+                               + (size_t(offset) * oChannels + ochannel) * oSampleSize;
+            this->m_encode(channels + ochannel * PLAN_BLOCK_SIZE,
+                           dstData,
+                           oStride,
+                           blockSize);
+        }
+    }
+
+    return dst;
 }
 
 AkAudioPacket AkAudioConverterPrivate::convertSampleRate(const AkAudioPacket &packet)
 {
     auto iSamples = packet.samples();
-    this->m_mutex.lock();
-    auto oSampleRate = this->m_outputCaps.rate();
-    this->m_mutex.unlock();
+    auto oSampleRate = this->m_planOutputCaps.rate();
 
     if (packet.caps().rate() == oSampleRate)
         return packet;
 
-    this->m_mutex.lock();
-    auto sampleCorrection = this->m_sampleCorrection;
-    this->m_mutex.unlock();
+    if (this->m_planResampleMethod == AkAudioConverter::ResampleMethod_Sinc)
+        return this->resampleSinc(packet, oSampleRate);
 
     auto rSamples = qreal(iSamples)
                     * oSampleRate
                     / packet.caps().rate()
-                    + sampleCorrection;
+                    + this->m_sampleCorrection;
     auto samples = qRound(rSamples);
 
     if (samples < 1)
@@ -1114,45 +1056,219 @@ AkAudioPacket AkAudioConverterPrivate::convertSampleRate(const AkAudioPacket &pa
 
     auto ssf =
             AkAudioConverterPrivate::bySamplesScalingFormat(packet.caps().format());
-    auto method = this->m_resampleMethod;
+    auto method = this->m_planResampleMethod;
 
     if (samples < iSamples)
         method = AkAudioConverter::ResampleMethod_Fast;
 
-    AkAudioPacket tmpPacket;
+    // The samples are scaled straight into a packet with the output rate.
+    auto caps = packet.caps();
+    caps.setRate(oSampleRate);
+    AkAudioPacket outPacket;
 
     switch (method) {
     case AkAudioConverter::ResampleMethod_Fast:
-        tmpPacket = ssf->fast(packet, samples);
+        outPacket = ssf->fast(packet, caps, samples);
         break;
 
     case AkAudioConverter::ResampleMethod_Linear:
-        tmpPacket = ssf->linear(packet, samples);
+        outPacket = ssf->linear(packet, caps, samples);
         break;
 
     case AkAudioConverter::ResampleMethod_Quadratic:
-        tmpPacket = ssf->quadratic(packet, samples);
+    case AkAudioConverter::ResampleMethod_Sinc:
+        outPacket = ssf->quadratic(packet, caps, samples);
         break;
     }
 
-    auto caps = packet.caps();
-    caps.setRate(oSampleRate);
-    AkAudioPacket outPacket(caps, samples);
-    outPacket.copyMetadata(tmpPacket);
     outPacket.setPts(packet.pts() * oSampleRate / packet.caps().rate());
-    outPacket.setDuration(outPacket.samples());
     outPacket.setTimeBase({1, oSampleRate});
 
-    for (int plane = 0; plane < outPacket.planes(); plane++)
-        memcpy(outPacket.plane(plane),
-               tmpPacket.constPlane(plane),
-               qMin(outPacket.planeSize(plane), tmpPacket.planeSize(plane)));
-
-    this->m_mutex.lock();
     this->m_sampleCorrection = rSamples - samples;
-    this->m_mutex.unlock();
 
     return outPacket;
 }
 
+qreal AkAudioConverterPrivate::besselI0(qreal x)
+{
+    // Modified Bessel function of the first kind, order 0.
+    qreal sum = 1.0;
+    qreal term = 1.0;
+    qreal x2 = x * x / 4.0;
+
+    for (int k = 1; k < 64; k++) {
+        term *= x2 / (qreal(k) * k);
+        sum += term;
+
+        if (term < 1e-12 * sum)
+            break;
+    }
+
+    return sum;
+}
+
+void AkAudioConverterPrivate::configureSinc(int iRate,
+                                            int oRate,
+                                            int channels,
+                                            AkAudioConverter::ResampleQuality quality)
+{
+    auto &sinc = this->m_sinc;
+
+    if (sinc.iRate == iRate
+        && sinc.oRate == oRate
+        && sinc.channels == channels
+        && sinc.quality == quality)
+        return;
+
+    sinc = {};
+    sinc.iRate = iRate;
+    sinc.oRate = oRate;
+    sinc.channels = channels;
+    sinc.quality = quality;
+
+    qint64 a = iRate;
+    qint64 b = oRate;
+
+    while (b != 0) {
+        auto r = a % b;
+        a = b;
+        b = r;
+    }
+
+    sinc.upFactor = oRate / a;
+    sinc.downFactor = iRate / a;
+
+    /* The time of the output samples is tracked exactly, but when the rates
+     * have too many phases, the nearest precomputed filter is used.
+     */
+    sinc.phases = int(qMin<qint64>(sinc.upFactor, MAX_SINC_PHASES));
+
+    // When downsampling, the cutoff goes down to the output Nyquist frequency.
+    auto sincQuality = SincQuality::byQuality(quality);
+    auto scale = qMin(1.0, qreal(oRate) / iRate);
+    auto cutoff = sincQuality->rolloff * scale;
+    sinc.halfLength = qCeil(sincQuality->halfTaps / scale);
+    sinc.taps = 2 * sinc.halfLength;
+    sinc.filters.resize(sinc.phases * sinc.taps);
+    auto i0Beta = besselI0(sincQuality->beta);
+
+    for (int phase = 0; phase < sinc.phases; phase++) {
+        auto filter = sinc.filters.data() + phase * sinc.taps;
+        auto offset = qreal(phase) / sinc.phases;
+        qreal sum = 0.0;
+
+        for (int tap = 0; tap < sinc.taps; tap++) {
+            auto x = tap - sinc.halfLength + 1 - offset;
+            auto y = M_PI * cutoff * x;
+            auto h = qAbs(y) < 1e-9? cutoff: cutoff * qSin(y) / y;
+            auto r = x / sinc.halfLength;
+            auto window = qAbs(r) < 1.0?
+                              besselI0(sincQuality->beta * qSqrt(1.0 - r * r)) / i0Beta:
+                              0.0;
+            filter[tap] = h * window;
+            sum += filter[tap];
+        }
+
+        // Normalize the gain of each phase.
+        if (qAbs(sum) > 1e-9)
+            for (int tap = 0; tap < sinc.taps; tap++)
+                filter[tap] /= sum;
+    }
+
+    // Start with silence, the first output sample is the first input sample.
+    sinc.history =
+            QVector<QVector<qreal>>(channels,
+                                    QVector<qreal>(sinc.halfLength - 1, 0.0));
+    sinc.position = qint64(sinc.halfLength - 1) * sinc.upFactor;
+}
+
+AkAudioPacket AkAudioConverterPrivate::resampleSinc(const AkAudioPacket &packet,
+                                                    int oSampleRate)
+{
+    // The plan already converted the packet to planar double precision.
+    auto channels = packet.caps().channels();
+    this->configureSinc(packet.caps().rate(),
+                        oSampleRate,
+                        channels,
+                        this->m_planResampleQuality);
+    auto &sinc = this->m_sinc;
+    auto iSamples = int(packet.samples());
+
+    for (int channel = 0; channel < channels; channel++) {
+        auto &history = sinc.history[channel];
+        auto historySize = history.size();
+        history.resize(historySize + iSamples);
+        memcpy(history.data() + historySize,
+               packet.constPlane(channel),
+               size_t(iSamples) * sizeof(qreal));
+    }
+
+    // Count the output samples that have all their input samples available.
+    auto bufferSize = qint64(sinc.history.value(0).size());
+    auto lastPosition = (bufferSize - sinc.halfLength) * sinc.upFactor - 1;
+    int oSamples = 0;
+
+    if (sinc.position <= lastPosition)
+        oSamples = int((lastPosition - sinc.position) / sinc.downFactor + 1);
+
+    auto startPosition = sinc.position;
+
+    if (oSamples < 1)
+        return {};
+
+    // Filter the samples and write them straight in the output format.
+    auto &oCaps = this->m_planOutputCaps;
+    AkAudioPacket oPacket(oCaps, oSamples);
+    auto oSampleSize = size_t(oCaps.bps() / 8);
+    auto oStride = oCaps.planar()? size_t(1): size_t(channels);
+
+    if (this->m_resampleBuffer.size() < oSamples)
+        this->m_resampleBuffer.resize(oSamples);
+
+    auto dst = this->m_resampleBuffer.data();
+
+    for (int channel = 0; channel < channels; channel++) {
+        auto src = sinc.history[channel].constData();
+        auto position = startPosition;
+
+        for (int sample = 0; sample < oSamples; sample++) {
+            auto iSample = position / sinc.upFactor;
+            auto phase = position % sinc.upFactor * sinc.phases / sinc.upFactor;
+            auto x = src + iSample - sinc.halfLength + 1;
+            auto h = sinc.filters.constData() + phase * sinc.taps;
+            qreal sum = 0.0;
+
+            #pragma omp simd reduction(+: sum)
+            for (int tap = 0; tap < sinc.taps; tap++)
+                sum += x[tap] * h[tap];
+
+            dst[sample] = sum;
+            position += sinc.downFactor;
+        }
+
+        auto dstData = oCaps.planar()?
+                           oPacket.plane(channel):
+                           oPacket.plane(0) + size_t(channel) * oSampleSize;
+        this->m_encodeOutput(dst, dstData, oStride, oSamples);
+    }
+
+    // Drop the input samples that won't be needed anymore.
+    auto position = startPosition + oSamples * sinc.downFactor;
+    auto consumed = int(qMax<qint64>(position / sinc.upFactor - sinc.halfLength + 1, 0));
+
+    for (auto &history: sinc.history)
+        history.remove(0, consumed);
+
+    sinc.position = position - qint64(consumed) * sinc.upFactor;
+
+    // Time of the first output sample, relative to the start of the packet.
+    auto firstSample = startPosition - (bufferSize - iSamples) * sinc.upFactor;
+    oPacket.copyMetadata(packet);
+    oPacket.setPts((packet.pts() * sinc.upFactor + firstSample) / sinc.downFactor);
+    oPacket.setDuration(oPacket.samples());
+    oPacket.setTimeBase({1, oSampleRate});
+
+    return oPacket;
+}
+
 #include "moc_akaudioconverter.cpp"
@@ -38,16 +38,31 @@ class AKCOMMONS_EXPORT AkAudioConverter: public QObject
                WRITE setResampleMethod
                RESET resetResampleMethod
                NOTIFY resampleMethodChanged)
+    Q_PROPERTY(AkAudioConverter::ResampleQuality resampleQuality
+               READ resampleQuality
+               WRITE setResampleQuality
+               RESET resetResampleQuality
+               NOTIFY resampleQualityChanged)
 
     public:
         enum ResampleMethod
         {
             ResampleMethod_Fast,
             ResampleMethod_Linear,
-            ResampleMethod_Quadratic
+            ResampleMethod_Quadratic,
+            ResampleMethod_Sinc
         };
         Q_ENUM(ResampleMethod)
 
+        // Length of the filter used by ResampleMethod_Sinc
+        enum ResampleQuality
+        {
+            ResampleQuality_Low,
+            ResampleQuality_Medium,
+            ResampleQuality_High
+        };
+        Q_ENUM(ResampleQuality)
+
         AkAudioConverter(const AkAudioCaps &outputCaps={},
                          QObject *parent=nullptr);
         AkAudioConverter(const AkAudioConverter &other);
@@ -58,6 +73,7 @@ class AKCOMMONS_EXPORT AkAudioConverter: public QObject
 
         Q_INVOKABLE AkAudioCaps outputCaps() const;
         Q_INVOKABLE AkAudioConverter::ResampleMethod resampleMethod() const;
+        Q_INVOKABLE AkAudioConverter::ResampleQuality resampleQuality() const;
         Q_INVOKABLE static bool canConvertFormat(AkAudioCaps::SampleFormat input,
                                                  AkAudioCaps::SampleFormat output);
         Q_INVOKABLE AkAudioPacket convert(const AkAudioPacket &packet);
@@ -70,19 +86,24 @@ class AKCOMMONS_EXPORT AkAudioConverter: public QObject
     Q_SIGNALS:
         void outputCapsChanged(const AkAudioCaps &outputCaps);
         void resampleMethodChanged(AkAudioConverter::ResampleMethod resampleMethod);
+        void resampleQualityChanged(AkAudioConverter::ResampleQuality resampleQuality);
 
     public Q_SLOTS:
         void setOutputCaps(const AkAudioCaps &outputCaps);
         void setResampleMethod(AkAudioConverter::ResampleMethod resampleMethod);
+        void setResampleQuality(AkAudioConverter::ResampleQuality resampleQuality);
         void resetOutputCaps();
         void resetResampleMethod();
+        void resetResampleQuality();
         void reset();
         static void registerTypes();
 };
 
 AKCOMMONS_EXPORT QDebug operator <<(QDebug debug, AkAudioConverter::ResampleMethod method);
+AKCOMMONS_EXPORT QDebug operator <<(QDebug debug, AkAudioConverter::ResampleQuality quality);
 
 Q_DECLARE_METATYPE(AkAudioConverter)
 Q_DECLARE_METATYPE(AkAudioConverter::ResampleMethod)
+Q_DECLARE_METATYPE(AkAudioConverter::ResampleQuality)
 
 #endif // AKAUDIOCONVERTER_H
@@ -19,6 +19,7 @@
 
 #include <QDebug>
 #include <QQmlEngine>
+#include <QSharedPointer>
 
 #include "akcompressedvideopacket.h"
 #include "akcompressedvideocaps.h"
@@ -30,6 +31,7 @@ class AkCompressedVideoPacketPrivate
 {
     public:
         AkCompressedVideoCaps m_caps;
+        QSharedPointer<char> m_externalData;
         QByteArray m_data;
         AkCompressedVideoPacket::VideoPacketTypeFlag m_flags {AkCompressedVideoPacket::VideoPacketTypeFlag_None};
 };
@@ -54,6 +56,23 @@ AkCompressedVideoPacket::AkCompressedVideoPacket(const AkCompressedVideoCaps &ca
         this->d->m_data = QByteArray(int(size), Qt::Uninitialized);
 }
 
+AkCompressedVideoPacket::AkCompressedVideoPacket(const AkCompressedVideoCaps &caps,
+                                                 char *data,
+                                                 size_t size,
+                                                 ExternalDataRelease release,
+                                                 void *userData):
+    AkPacketBase()
+{
+    this->d = new AkCompressedVideoPacketPrivate();
+    this->d->m_caps = caps;
+    this->d->m_externalData =
+            QSharedPointer<char>(data, [release, userData] (char *) {
+                if (release)
+                    release(userData);
+            });
+    this->d->m_data = QByteArray::fromRawData(data, int(size));
+}
+
 AkCompressedVideoPacket::AkCompressedVideoPacket(const AkPacket &other):
     AkPacketBase(other)
 {
@@ -62,6 +81,7 @@ AkCompressedVideoPacket::AkCompressedVideoPacket(const AkPacket &other):
     if (other.type() == AkPacket::PacketVideoCompressed) {
         auto data = reinterpret_cast<AkCompressedVideoPacket *>(other.privateData());
         this->d->m_caps = data->d->m_caps;
+        this->d->m_externalData = data->d->m_externalData;
         this->d->m_data = data->d->m_data;
         this->d->m_flags = data->d->m_flags;
     }
@@ -74,6 +94,7 @@ AkCompressedVideoPacket::AkCompressedVideoPacket(const AkCompressedPacket &other
     if (other.type() == AkCompressedPacket::PacketType_Video) {
         auto data = reinterpret_cast<AkCompressedVideoPacket *>(other.privateData());
         this->d->m_caps = data->d->m_caps;
+        this->d->m_externalData = data->d->m_externalData;
         this->d->m_data = data->d->m_data;
         this->d->m_flags = data->d->m_flags;
     }
@@ -84,6 +105,7 @@ AkCompressedVideoPacket::AkCompressedVideoPacket(const AkCompressedVideoPacket &
 {
     this->d = new AkCompressedVideoPacketPrivate();
     this->d->m_caps = other.d->m_caps;
+    this->d->m_externalData = other.d->m_externalData;
     this->d->m_data = other.d->m_data;
     this->d->m_flags = other.d->m_flags;
 }
@@ -98,11 +120,13 @@ AkCompressedVideoPacket &AkCompressedVideoPacket::operator =(const AkPacket &oth
     if (other.type() == AkPacket::PacketVideoCompressed) {
         auto data = reinterpret_cast<AkCompressedVideoPacket *>(other.privateData());
         this->d->m_caps = data->d->m_caps;
+        this->d->m_externalData = data->d->m_externalData;
         this->d->m_data = data->d->m_data;
         this->d->m_flags = data->d->m_flags;
     } else {
         this->d->m_caps = AkCompressedVideoCaps();
         this->d->m_data.clear();
+        this->d->m_externalData.clear();
         this->d->m_flags = VideoPacketTypeFlag_None;
     }
 
@@ -116,11 +140,13 @@ AkCompressedVideoPacket &AkCompressedVideoPacket::operator =(const AkCompressedP
     if (other.type() == AkCompressedPacket::PacketType_Video) {
         auto data = reinterpret_cast<AkCompressedVideoPacket *>(other.privateData());
         this->d->m_caps = data->d->m_caps;
+        this->d->m_externalData = data->d->m_externalData;
         this->d->m_data = data->d->m_data;
         this->d->m_flags = data->d->m_flags;
     } else {
         this->d->m_caps = AkCompressedVideoCaps();
         this->d->m_data.clear();
+        this->d->m_externalData.clear();
         this->d->m_flags = VideoPacketTypeFlag_None;
     }
 
@@ -133,6 +159,7 @@ AkCompressedVideoPacket &AkCompressedVideoPacket::operator =(const AkCompressedV
 {
     if (this != &other) {
         this->d->m_caps = other.d->m_caps;
+        this->d->m_externalData = other.d->m_externalData;
         this->d->m_data = other.d->m_data;
         this->d->m_flags = other.d->m_flags;
         this->copyMetadata(other);
@@ -185,6 +212,12 @@ const AkCompressedVideoCaps &AkCompressedVideoPacket::caps() const
 
 char *AkCompressedVideoPacket::data() const
 {
+    // Copy the external buffer before giving write access to it.
+    if (this->d->m_externalData) {
+        this->d->m_data.detach();
+        this->d->m_externalData.clear();
+    }
+
     return this->d->m_data.data();
 }
 
@@ -193,6 +226,11 @@ const char *AkCompressedVideoPacket::constData() const
     return this->d->m_data.constData();
 }
 
+bool AkCompressedVideoPacket::isExternal() const
+{
+    return !this->d->m_externalData.isNull();
+}
+
 size_t AkCompressedVideoPacket::size() const
 {
     return this->d->m_data.size();
@@ -57,10 +57,21 @@ class AKCOMMONS_EXPORT AkCompressedVideoPacket: public AkPacketBase
         Q_FLAG(VideoPacketTypeFlags)
         Q_ENUM(VideoPacketTypeFlag)
 
+        using ExternalDataRelease = void (*)(void *userData);
+
         AkCompressedVideoPacket(QObject *parent=nullptr);
         AkCompressedVideoPacket(const AkCompressedVideoCaps &caps,
                                 size_t size,
                                 bool initialized=false);
+
+        /* Wrap an external buffer without copying it, release is called
+         * with userData once the last copy of the packet is destroyed.
+         */
+        AkCompressedVideoPacket(const AkCompressedVideoCaps &caps,
+                                char *data,
+                                size_t size,
+                                ExternalDataRelease release,
+                                void *userData);
         AkCompressedVideoPacket(const AkPacket &other);
         AkCompressedVideoPacket(const AkCompressedPacket &other);
         AkCompressedVideoPacket(const AkCompressedVideoPacket &other);
@@ -75,6 +86,7 @@ class AKCOMMONS_EXPORT AkCompressedVideoPacket: public AkPacketBase
         Q_INVOKABLE const AkCompressedVideoCaps &caps() const;
         Q_INVOKABLE char *data() const;
         Q_INVOKABLE const char *constData() const;
+        Q_INVOKABLE bool isExternal() const;
         Q_INVOKABLE size_t size() const;
         Q_INVOKABLE VideoPacketTypeFlag flags() const;
 
@@ -0,0 +1,514 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <cstring>
+#include <QQmlEngine>
+#include <QVector>
+
+#ifdef OPENMP_ENABLED
+#include <omp.h>
+#endif
+
+#include "akedgedetector.h"
+#include "akcpufeatures.h"
+#include "aksimd.h"
+#include "akvideocaps.h"
+#include "akvideopacket.h"
+
+// tan(22.5) and tan(67.5) in 16.16 fixed point.
+#define TAN_22_5 27146
+#define TAN_67_5 158218
+
+// Number of lines processed by each thread in a row.
+#define BAND_HEIGHT 32
+
+using CreateEdgeParametersType =
+    void *(*)();
+using FreeEdgeParametersType =
+    void (*)(void *edgeParameters);
+using SobelLineType =
+    void (*)(void *edgeParameters,
+             int width,
+             const quint8 *src_line_m1,
+             const quint8 *src_line,
+             const quint8 *src_line_p1,
+             qint32 *grad_x,
+             qint32 *grad_y,
+             quint16 *gradient,
+             int *x);
+
+class AkEdgeDetectorPrivate
+{
+    public:
+        // SIMD functions
+
+        void *m_simdEdgeParameters {nullptr};
+        CreateEdgeParametersType m_createSIMDEdgeParameters {nullptr};
+        FreeEdgeParametersType m_freeSIMDEdgeParameters {nullptr};
+        SobelLineType m_sobelSIMDLine {nullptr};
+        size_t m_parallelizationThreshold {0};
+
+        AkEdgeDetectorPrivate();
+        ~AkEdgeDetectorPrivate();
+        void loadSimd();
+        void sobel(const AkVideoPacket &gray,
+                   AkVideoPacket &gradient,
+                   AkVideoPacket *direction) const;
+        void sobelBand(const AkVideoPacket &gray,
+                       AkVideoPacket &gradient,
+                       AkVideoPacket *direction,
+                       int yStart,
+                       int yEnd) const;
+        AkVideoPacket thinning(const AkVideoPacket &gradient,
+                               const AkVideoPacket &direction) const;
+        inline static void padLine(const quint8 *srcLine,
+                                   int width,
+                                   quint8 *dstLine);
+        inline static quint8 direction(int gradX, int gradY);
+};
+
+AkEdgeDetector::AkEdgeDetector(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkEdgeDetectorPrivate();
+}
+
+AkEdgeDetector::AkEdgeDetector(const AkEdgeDetector &other):
+    QObject()
+{
+    Q_UNUSED(other)
+    this->d = new AkEdgeDetectorPrivate();
+}
+
+AkEdgeDetector::~AkEdgeDetector()
+{
+    delete this->d;
+}
+
+AkEdgeDetector &AkEdgeDetector::operator =(const AkEdgeDetector &other)
+{
+    Q_UNUSED(other)
+
+    return *this;
+}
+
+QObject *AkEdgeDetector::create()
+{
+    return new AkEdgeDetector();
+}
+
+AkVideoPacket AkEdgeDetector::gradient(const AkVideoPacket &gray) const
+{
+    if (!gray || gray.caps().format() != AkVideoCaps::Format_y8)
+        return {};
+
+    AkVideoPacket gradient;
+    this->d->sobel(gray, gradient, nullptr);
+
+    return gradient;
+}
+
+AkVideoPacket AkEdgeDetector::thinnedGradient(const AkVideoPacket &gray) const
+{
+    if (!gray || gray.caps().format() != AkVideoCaps::Format_y8)
+        return {};
+
+    AkVideoPacket gradient;
+    AkVideoPacket direction;
+    this->d->sobel(gray, gradient, &direction);
+
+    return this->d->thinning(gradient, direction);
+}
+
+AkVideoPacket AkEdgeDetector::hysteresis(const AkVideoPacket &thinned,
+                                         int thLow,
+                                         int thHi) const
+{
+    if (!thinned || thinned.caps().format() != AkVideoCaps::Format_y16)
+        return {};
+
+    int width = thinned.caps().width();
+    int height = thinned.caps().height();
+    auto caps = thinned.caps();
+    caps.setFormat(AkVideoCaps::Format_y8);
+
+    /* Classify the pixels in non edges (0), weak edges (127) and strong
+     * edges (255).
+     */
+    AkVideoPacket marked(caps);
+    bool paralelize = thinned.size() > this->d->m_parallelizationThreshold;
+
+    #pragma omp parallel for if(paralelize)
+    for (int y = 0; y < height; y++) {
+        auto srcLine = reinterpret_cast<const quint16 *>(thinned.constLine(0, y));
+        auto dstLine = marked.line(0, y);
+
+        for (int x = 0; x < width; x++) {
+            auto &pixel = srcLine[x];
+
+            if (pixel <= thLow)
+                dstLine[x] = 0;
+            else if (pixel <= thHi)
+                dstLine[x] = 127;
+            else
+                dstLine[x] = 255;
+        }
+    }
+
+    // Promote the weak edges connected to a strong edge.
+
+    QVector<int> stack;
+
+    for (int y = 0; y < height; y++) {
+        auto line = marked.constLine(0, y);
+
+        for (int x = 0; x < width; x++) {
+            if (line[x] != 255)
+                continue;
+
+            stack << y * width + x;
+
+            while (!stack.isEmpty()) {
+                auto point = stack.takeLast();
+                int px = point % width;
+                int py = point / width;
+
+                for (int j = qMax(py - 1, 0); j <= qMin(py + 1, height - 1); j++) {
+                    auto nextLine = marked.line(0, j);
+
+                    for (int i = qMax(px - 1, 0); i <= qMin(px + 1, width - 1); i++)
+                        if (nextLine[i] == 127) {
+                            nextLine[i] = 255;
+                            stack << j * width + i;
+                        }
+                }
+            }
+        }
+    }
+
+    /* Remove the remaining weak edges and the strong edges without any
+     * neighbour.
+     */
+    AkVideoPacket canny(caps);
+    canny.copyMetadata(thinned);
+
+    #pragma omp parallel for if(paralelize)
+    for (int y = 0; y < height; y++) {
+        auto srcLine = marked.constLine(0, y);
+        auto dstLine = canny.line(0, y);
+
+        for (int x = 0; x < width; x++) {
+            if (srcLine[x] != 255) {
+                dstLine[x] = 0;
+
+                continue;
+            }
+
+            bool isPoint = true;
+
+            for (int j = qMax(y - 1, 0); j <= qMin(y + 1, height - 1) && isPoint; j++) {
+                auto nextLine = marked.constLine(0, j);
+
+                for (int i = qMax(x - 1, 0); i <= qMin(x + 1, width - 1); i++)
+                    if ((i != x || j != y) && nextLine[i] > 0) {
+                        isPoint = false;
+
+                        break;
+                    }
+            }
+
+            dstLine[x] = isPoint? 0: 255;
+        }
+    }
+
+    return canny;
+}
+
+AkVideoPacket AkEdgeDetector::canny(const AkVideoPacket &gray,
+                                    int thLow,
+                                    int thHi) const
+{
+    return this->hysteresis(this->thinnedGradient(gray), thLow, thHi);
+}
+
+void AkEdgeDetector::registerTypes()
+{
+    qRegisterMetaType<AkEdgeDetector>("AkEdgeDetector");
+    qmlRegisterSingletonType<AkEdgeDetector>("Ak", 1, 0, "AkEdgeDetector",
+                                             [] (QQmlEngine *qmlEngine,
+                                                 QJSEngine *jsEngine) -> QObject * {
+        Q_UNUSED(qmlEngine)
+        Q_UNUSED(jsEngine)
+
+        return new AkEdgeDetector();
+    });
+}
+
+AkEdgeDetectorPrivate::AkEdgeDetectorPrivate()
+{
+    this->loadSimd();
+}
+
+AkEdgeDetectorPrivate::~AkEdgeDetectorPrivate()
+{
+    if (this->m_freeSIMDEdgeParameters && this->m_simdEdgeParameters)
+        this->m_freeSIMDEdgeParameters(this->m_simdEdgeParameters);
+}
+
+void AkEdgeDetectorPrivate::loadSimd()
+{
+    AkSimd simd("Core");
+
+    this->m_createSIMDEdgeParameters = reinterpret_cast<CreateEdgeParametersType>(simd.resolve("createEdgeParameters"));
+    this->m_freeSIMDEdgeParameters = reinterpret_cast<FreeEdgeParametersType>(simd.resolve("freeEdgeParameters"));
+    this->m_sobelSIMDLine = reinterpret_cast<SobelLineType>(simd.resolve("sobelLine"));
+
+    if (this->m_createSIMDEdgeParameters)
+        this->m_simdEdgeParameters = this->m_createSIMDEdgeParameters();
+
+    // Around 16 operations per pixel for the gradient and its direction.
+    this->m_parallelizationThreshold =
+            AkCpuFeatures::paralellizableBytesThreshold(16,
+                                                        simd.loadedInstructionSet());
+}
+
+void AkEdgeDetectorPrivate::sobel(const AkVideoPacket &gray,
+                                  AkVideoPacket &gradient,
+                                  AkVideoPacket *direction) const
+{
+    auto caps = gray.caps();
+    caps.setFormat(AkVideoCaps::Format_y16);
+    gradient = {caps};
+    gradient.copyMetadata(gray);
+
+    if (direction) {
+        caps.setFormat(AkVideoCaps::Format_y8);
+        *direction = {caps};
+        direction->copyMetadata(gray);
+    }
+
+    int height = gray.caps().height();
+    int nBands = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    bool paralelize =
+            nBands > 1 && gray.size() > this->m_parallelizationThreshold;
+
+    #pragma omp parallel for schedule(dynamic, 1) if(paralelize)
+    for (int band = 0; band < nBands; band++) {
+        int yStart = band * BAND_HEIGHT;
+        int yEnd = qMin(yStart + BAND_HEIGHT, height);
+        this->sobelBand(gray, gradient, direction, yStart, yEnd);
+    }
+}
+
+void AkEdgeDetectorPrivate::sobelBand(const AkVideoPacket &gray,
+                                      AkVideoPacket &gradient,
+                                      AkVideoPacket *direction,
+                                      int yStart,
+                                      int yEnd) const
+{
+    int width = gray.caps().width();
+    int height_1 = gray.caps().height() - 1;
+    int paddedWidth = width + 2;
+
+    QVector<quint8> paddedLines(3 * paddedWidth);
+    auto line_m1 = paddedLines.data();
+    auto line = line_m1 + paddedWidth;
+    auto line_p1 = line + paddedWidth;
+    QVector<qint32> gradXLine(width);
+    QVector<qint32> gradYLine(width);
+    auto gradX = gradXLine.data();
+    auto gradY = gradYLine.data();
+
+    for (int y = yStart; y < yEnd; y++) {
+        padLine(gray.constLine(0, qMax(y - 1, 0)), width, line_m1);
+        padLine(gray.constLine(0, y), width, line);
+        padLine(gray.constLine(0, qMin(y + 1, height_1)), width, line_p1);
+
+        auto gradientLine = reinterpret_cast<quint16 *>(gradient.line(0, y));
+        int x = 0;
+
+        if (this->m_sobelSIMDLine)
+            this->m_sobelSIMDLine(this->m_simdEdgeParameters,
+                                  width,
+                                  line_m1,
+                                  line,
+                                  line_p1,
+                                  gradX,
+                                  gradY,
+                                  gradientLine,
+                                  &x);
+
+        for (; x < width; x++) {
+            gradX[x] = line_m1[x + 2]
+                     + 2 * line[x + 2]
+                     + line_p1[x + 2]
+                     - line_m1[x]
+                     - 2 * line[x]
+                     - line_p1[x];
+
+            gradY[x] = line_m1[x]
+                     + 2 * line_m1[x + 1]
+                     + line_m1[x + 2]
+                     - line_p1[x]
+                     - 2 * line_p1[x + 1]
+                     - line_p1[x + 2];
+
+            gradientLine[x] = quint16(qAbs(gradX[x]) + qAbs(gradY[x]));
+        }
+
+        if (direction) {
+            auto directionLine = direction->line(0, y);
+
+            for (int x = 0; x < width; x++)
+                directionLine[x] = AkEdgeDetectorPrivate::direction(gradX[x],
+                                                                    gradY[x]);
+        }
+    }
+}
+
+AkVideoPacket AkEdgeDetectorPrivate::thinning(const AkVideoPacket &gradient,
+                                              const AkVideoPacket &direction) const
+{
+    AkVideoPacket thinned(gradient.caps(), true);
+    thinned.copyMetadata(gradient);
+
+    auto width_1 = gradient.caps().width() - 1;
+    auto height_1 = gradient.caps().height() - 1;
+    bool paralelize = gradient.size() > this->m_parallelizationThreshold;
+
+    #pragma omp parallel for if(paralelize)
+    for (int y = 0; y < gradient.caps().height(); y++) {
+        auto edgesLine = reinterpret_cast<const quint16 *>(gradient.constLine(0, y));
+        auto edgesLine_m1 = reinterpret_cast<const quint16 *>(gradient.constLine(0, qMax(y - 1, 0)));
+        auto edgesLine_p1 = reinterpret_cast<const quint16 *>(gradient.constLine(0, qMin(y + 1, height_1)));
+
+        auto edgesAngleLine = direction.constLine(0, y);
+        auto thinnedLine = reinterpret_cast<quint16 *>(thinned.line(0, y));
+
+        for (int x = 0; x < gradient.caps().width(); x++) {
+            int x_m1 = qMax(x - 1, 0);
+            int x_p1 = qMin(x + 1,  width_1);
+
+            auto &pixel = edgesLine[x];
+            quint16 pixel1;
+            quint16 pixel2;
+
+            switch (edgesAngleLine[x]) {
+            case 0:
+                /* x x x
+                 * - - -
+                 * x x x
+                 */
+                pixel1 = edgesLine[x_m1];
+                pixel2 = edgesLine[x_p1];
+
+                break;
+            case 1:
+                /* x x /
+                 * x / x
+                 * / x x
+                 */
+                pixel1 = edgesLine_m1[x_p1];
+                pixel2 = edgesLine_p1[x_m1];
+
+                break;
+            case 2:
+                /* \ x x
+                 * x \ x
+                 * x x \
+                 */
+                pixel1 = edgesLine_m1[x_m1];
+                pixel2 = edgesLine_p1[x_p1];
+
+                break;
+            default:
+                /* x | x
+                 * x | x
+                 * x | x
+                 */
+                pixel1 = edgesLine_m1[x];
+                pixel2 = edgesLine_p1[x];
+
+                break;
+            }
+
+            if (pixel >= pixel1 && pixel >= pixel2)
+                thinnedLine[x] = pixel;
+        }
+    }
+
+    return thinned;
+}
+
+void AkEdgeDetectorPrivate::padLine(const quint8 *srcLine,
+                                    int width,
+                                    quint8 *dstLine)
+{
+    memcpy(dstLine + 1, srcLine, size_t(width));
+    dstLine[0] = srcLine[0];
+    dstLine[width + 1] = srcLine[width - 1];
+}
+
+quint8 AkEdgeDetectorPrivate::direction(int gradX, int gradY)
+{
+    /* Gradient directions are classified in 4 possible cases
+     *
+     * dir 0
+     *
+     * x x x
+     * - - -
+     * x x x
+     *
+     * dir 1
+     *
+     * x x /
+     * x / x
+     * / x x
+     *
+     * dir 2
+     *
+     * \ x x
+     * x \ x
+     * x x \
+     *
+     * dir 3
+     *
+     * x | x
+     * x | x
+     * x | x
+     *
+     * The angle of the gradient is compared against the tangents of the
+     * sector limits, so no trigonometric function is needed.
+     */
+    if (gradX == 0 && gradY == 0)
+        return 0;
+
+    int absX = qAbs(gradX);
+    int absY = qAbs(gradY) << 16;
+
+    if (absY < TAN_22_5 * absX)
+        return 0;
+
+    if (absY < TAN_67_5 * absX)
+        return (gradX > 0) == (gradY > 0)? 1: 2;
+
+    return 3;
+}
+
+#include "moc_akedgedetector.cpp"
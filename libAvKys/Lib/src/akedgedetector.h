@@ -0,0 +1,77 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKEDGEDETECTOR_H
+#define AKEDGEDETECTOR_H
+
+#include <QObject>
+
+#include "akcommons.h"
+
+class AkEdgeDetectorPrivate;
+class AkVideoPacket;
+
+/* Sobel and Canny edge detection.
+ *
+ * All the functions take a y8 frame as input. Gradients are returned as y16
+ * frames containing |Gx| + |Gy|, and Canny edges as y8 frames where edge
+ * pixels are 255 and the rest 0.
+ *
+ * The gradient is computed in integer arithmetic with vectorized code, the
+ * gradient direction is quantized with integer comparisons, and the
+ * hysteresis is done with an explicit stack, so it is safe to use with big
+ * connected edges.
+ */
+class AKCOMMONS_EXPORT AkEdgeDetector: public QObject
+{
+    Q_OBJECT
+
+    public:
+        AkEdgeDetector(QObject *parent=nullptr);
+        AkEdgeDetector(const AkEdgeDetector &other);
+        ~AkEdgeDetector();
+        AkEdgeDetector &operator =(const AkEdgeDetector &other);
+
+        Q_INVOKABLE static QObject *create();
+
+        Q_INVOKABLE AkVideoPacket gradient(const AkVideoPacket &gray) const;
+
+        // Gradient after the non-maximum suppression.
+        Q_INVOKABLE AkVideoPacket thinnedGradient(const AkVideoPacket &gray) const;
+
+        /* Pixels above thHi are edges, pixels between thLow and thHi are
+         * edges only if they are connected to another edge.
+         */
+        Q_INVOKABLE AkVideoPacket hysteresis(const AkVideoPacket &thinned,
+                                             int thLow,
+                                             int thHi) const;
+        Q_INVOKABLE AkVideoPacket canny(const AkVideoPacket &gray,
+                                        int thLow,
+                                        int thHi) const;
+
+    private:
+        AkEdgeDetectorPrivate *d;
+
+    public Q_SLOTS:
+        static void registerTypes();
+};
+
+Q_DECLARE_METATYPE(AkEdgeDetector)
+
+#endif // AKEDGEDETECTOR_H
@@ -0,0 +1,410 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QDebug>
+#include <QMetaEnum>
+#include <QQmlEngine>
+#include <QVector>
+#include <qrgb.h>
+
+#include "akframering.h"
+#include "akvideocaps.h"
+#include "akvideoconverter.h"
+#include "akvideopacket.h"
+
+#define DEFAULT_CAPACITY 1
+
+class AkFrameRingPrivate
+{
+    public:
+        QVector<AkVideoPacket> m_slots;
+        AkVideoCaps m_caps;
+        AkVideoCaps m_inputCaps;
+        AkFrameRing::StorageMode m_storageMode {AkFrameRing::StorageMode_Full};
+        int m_capacity {DEFAULT_CAPACITY};
+        int m_scaleDiv {0};
+        int m_head {0};
+        int m_size {0};
+        AkVideoConverter m_videoConverter;
+        AkVideoPacket m_null;
+
+        inline int slotIndex(int index) const;
+        void resize(int capacity);
+        void storeFrame(const AkVideoPacket &src, AkVideoPacket &dst);
+        void storeArgbLuma(const AkVideoPacket &src, AkVideoPacket &dst) const;
+        void storeArgbScaled(const AkVideoPacket &src, AkVideoPacket &dst) const;
+        static void copyFrame(const AkVideoPacket &src, AkVideoPacket &dst);
+};
+
+AkFrameRing::AkFrameRing(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkFrameRingPrivate();
+    this->d->m_slots.resize(this->d->m_capacity);
+}
+
+AkFrameRing::AkFrameRing(int capacity,
+                         StorageMode storageMode,
+                         int scaleDiv,
+                         QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkFrameRingPrivate();
+    this->d->m_capacity = qMax(capacity, 1);
+    this->d->m_storageMode = storageMode;
+    this->d->m_scaleDiv = qMax(scaleDiv, 0);
+    this->d->m_slots.resize(this->d->m_capacity);
+}
+
+AkFrameRing::AkFrameRing(const AkFrameRing &other):
+    QObject()
+{
+    this->d = new AkFrameRingPrivate();
+    this->d->m_slots = other.d->m_slots;
+    this->d->m_caps = other.d->m_caps;
+    this->d->m_inputCaps = other.d->m_inputCaps;
+    this->d->m_storageMode = other.d->m_storageMode;
+    this->d->m_capacity = other.d->m_capacity;
+    this->d->m_scaleDiv = other.d->m_scaleDiv;
+    this->d->m_head = other.d->m_head;
+    this->d->m_size = other.d->m_size;
+}
+
+AkFrameRing::~AkFrameRing()
+{
+    delete this->d;
+}
+
+AkFrameRing &AkFrameRing::operator =(const AkFrameRing &other)
+{
+    if (this != &other) {
+        this->d->m_slots = other.d->m_slots;
+        this->d->m_caps = other.d->m_caps;
+        this->d->m_inputCaps = other.d->m_inputCaps;
+        this->d->m_storageMode = other.d->m_storageMode;
+        this->d->m_capacity = other.d->m_capacity;
+        this->d->m_scaleDiv = other.d->m_scaleDiv;
+        this->d->m_head = other.d->m_head;
+        this->d->m_size = other.d->m_size;
+    }
+
+    return *this;
+}
+
+QObject *AkFrameRing::create()
+{
+    return new AkFrameRing();
+}
+
+int AkFrameRing::capacity() const
+{
+    return this->d->m_capacity;
+}
+
+AkFrameRing::StorageMode AkFrameRing::storageMode() const
+{
+    return this->d->m_storageMode;
+}
+
+int AkFrameRing::scaleDiv() const
+{
+    return this->d->m_scaleDiv;
+}
+
+int AkFrameRing::size() const
+{
+    return this->d->m_size;
+}
+
+bool AkFrameRing::isEmpty() const
+{
+    return this->d->m_size < 1;
+}
+
+bool AkFrameRing::isFull() const
+{
+    return this->d->m_size >= this->d->m_capacity;
+}
+
+AkVideoCaps AkFrameRing::caps() const
+{
+    return this->d->m_caps;
+}
+
+AkVideoCaps AkFrameRing::storageCaps(const AkVideoCaps &caps) const
+{
+    if (!caps)
+        return {};
+
+    auto format = this->d->m_storageMode == StorageMode_Luma?
+                      AkVideoCaps::Format_y8:
+                      caps.format();
+
+    return AkVideoCaps(format,
+                       qMax(caps.width() >> this->d->m_scaleDiv, 1),
+                       qMax(caps.height() >> this->d->m_scaleDiv, 1),
+                       caps.fps());
+}
+
+const AkVideoPacket &AkFrameRing::at(int index) const
+{
+    if (index < 0 || index >= this->d->m_size)
+        return this->d->m_null;
+
+    return this->d->m_slots[this->d->slotIndex(index)];
+}
+
+const AkVideoPacket &AkFrameRing::delayed(int delay) const
+{
+    return this->at(this->d->m_size - delay - 1);
+}
+
+const AkVideoPacket &AkFrameRing::first() const
+{
+    return this->at(0);
+}
+
+const AkVideoPacket &AkFrameRing::last() const
+{
+    return this->at(this->d->m_size - 1);
+}
+
+AkVideoPacket &AkFrameRing::next(const AkVideoCaps &caps)
+{
+    if (!caps.isSameFormat(this->d->m_caps)) {
+        this->d->m_head = 0;
+        this->d->m_size = 0;
+        this->d->m_caps = caps;
+    }
+
+    auto &slot = this->d->m_slots[this->d->m_head];
+
+    // Slots are allocated on first use and recycled afterwards.
+    if (!slot || !slot.caps().isSameFormat(caps))
+        slot = AkVideoPacket(caps);
+
+    this->d->m_head = (this->d->m_head + 1) % this->d->m_capacity;
+    this->d->m_size = qMin(this->d->m_size + 1, this->d->m_capacity);
+
+    return slot;
+}
+
+const AkVideoPacket &AkFrameRing::push(const AkVideoPacket &packet)
+{
+    if (!packet)
+        return this->d->m_null;
+
+    if (!packet.caps().isSameFormat(this->d->m_inputCaps)) {
+        this->clear();
+        this->d->m_inputCaps = packet.caps();
+    }
+
+    auto &slot = this->next(this->storageCaps(packet.caps()));
+    this->d->storeFrame(packet, slot);
+    slot.copyMetadata(packet);
+
+    return slot;
+}
+
+void AkFrameRing::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 1);
+
+    if (this->d->m_capacity == capacity)
+        return;
+
+    this->d->resize(capacity);
+    emit this->capacityChanged(capacity);
+}
+
+void AkFrameRing::setStorageMode(AkFrameRing::StorageMode storageMode)
+{
+    if (this->d->m_storageMode == storageMode)
+        return;
+
+    this->d->m_storageMode = storageMode;
+    this->clear();
+    emit this->storageModeChanged(storageMode);
+}
+
+void AkFrameRing::setScaleDiv(int scaleDiv)
+{
+    scaleDiv = qMax(scaleDiv, 0);
+
+    if (this->d->m_scaleDiv == scaleDiv)
+        return;
+
+    this->d->m_scaleDiv = scaleDiv;
+    this->clear();
+    emit this->scaleDivChanged(scaleDiv);
+}
+
+void AkFrameRing::resetCapacity()
+{
+    this->setCapacity(DEFAULT_CAPACITY);
+}
+
+void AkFrameRing::resetStorageMode()
+{
+    this->setStorageMode(StorageMode_Full);
+}
+
+void AkFrameRing::resetScaleDiv()
+{
+    this->setScaleDiv(0);
+}
+
+void AkFrameRing::clear()
+{
+    this->d->m_head = 0;
+    this->d->m_size = 0;
+    this->d->m_caps = AkVideoCaps();
+    this->d->m_inputCaps = AkVideoCaps();
+}
+
+void AkFrameRing::registerTypes()
+{
+    qRegisterMetaType<AkFrameRing>("AkFrameRing");
+    qRegisterMetaType<StorageMode>("AkFrameRingStorageMode");
+    qmlRegisterSingletonType<AkFrameRing>("Ak", 1, 0, "AkFrameRing",
+                                          [] (QQmlEngine *qmlEngine,
+                                              QJSEngine *jsEngine) -> QObject * {
+        Q_UNUSED(qmlEngine)
+        Q_UNUSED(jsEngine)
+
+        return new AkFrameRing();
+    });
+}
+
+QDebug operator <<(QDebug debug, AkFrameRing::StorageMode mode)
+{
+    AkFrameRing ring;
+    int storageModeIndex = ring.metaObject()->indexOfEnumerator("StorageMode");
+    QMetaEnum storageModeEnum = ring.metaObject()->enumerator(storageModeIndex);
+    QString storageModeStr(storageModeEnum.valueToKey(mode));
+    storageModeStr.remove("StorageMode_");
+    QDebugStateSaver saver(debug);
+    debug.nospace() << storageModeStr.toStdString().c_str();
+
+    return debug;
+}
+
+int AkFrameRingPrivate::slotIndex(int index) const
+{
+    return (this->m_head - this->m_size + index + this->m_capacity)
+           % this->m_capacity;
+}
+
+void AkFrameRingPrivate::resize(int capacity)
+{
+    // Keep the newest frames that still fit in the ring.
+    QVector<AkVideoPacket> slots(capacity);
+    int size = qMin(this->m_size, capacity);
+
+    for (int i = 0; i < size; i++)
+        slots[i] = this->m_slots[this->slotIndex(this->m_size - size + i)];
+
+    this->m_slots = slots;
+    this->m_capacity = capacity;
+    this->m_size = size;
+    this->m_head = size % capacity;
+}
+
+void AkFrameRingPrivate::storeFrame(const AkVideoPacket &src, AkVideoPacket &dst)
+{
+    auto &icaps = src.caps();
+    auto &ocaps = dst.caps();
+
+    if (icaps.isSameFormat(ocaps)) {
+        copyFrame(src, dst);
+
+        return;
+    }
+
+    if (icaps.format() == AkVideoCaps::Format_argbpack) {
+        if (ocaps.format() == AkVideoCaps::Format_y8)
+            this->storeArgbLuma(src, dst);
+        else
+            this->storeArgbScaled(src, dst);
+
+        return;
+    }
+
+    // Generic path for the formats that doesn't have a direct conversion.
+    this->m_videoConverter.setOutputCaps(ocaps);
+    this->m_videoConverter.begin();
+    auto frame = this->m_videoConverter.convert(src);
+    this->m_videoConverter.end();
+
+    if (frame)
+        copyFrame(frame, dst);
+}
+
+void AkFrameRingPrivate::storeArgbLuma(const AkVideoPacket &src,
+                                       AkVideoPacket &dst) const
+{
+    auto scaleDiv = this->m_scaleDiv;
+    auto width = dst.caps().width();
+    auto height = dst.caps().height();
+
+    for (int y = 0; y < height; y++) {
+        auto srcLine =
+                reinterpret_cast<const QRgb *>(src.constLine(0, y << scaleDiv));
+        auto dstLine = dst.line(0, y);
+
+        for (int x = 0; x < width; x++)
+            dstLine[x] = quint8(qGray(srcLine[x << scaleDiv]));
+    }
+}
+
+void AkFrameRingPrivate::storeArgbScaled(const AkVideoPacket &src,
+                                         AkVideoPacket &dst) const
+{
+    auto scaleDiv = this->m_scaleDiv;
+    auto width = dst.caps().width();
+    auto height = dst.caps().height();
+
+    for (int y = 0; y < height; y++) {
+        auto srcLine =
+                reinterpret_cast<const QRgb *>(src.constLine(0, y << scaleDiv));
+        auto dstLine = reinterpret_cast<QRgb *>(dst.line(0, y));
+
+        for (int x = 0; x < width; x++)
+            dstLine[x] = srcLine[x << scaleDiv];
+    }
+}
+
+void AkFrameRingPrivate::copyFrame(const AkVideoPacket &src, AkVideoPacket &dst)
+{
+    if (src.size() == dst.size()) {
+        memcpy(dst.data(), src.constData(), src.size());
+
+        return;
+    }
+
+    for (size_t plane = 0; plane < src.planes(); plane++) {
+        auto lineSize = qMin(src.lineSize(plane), dst.lineSize(plane));
+        auto heightDiv = src.heightDiv(plane);
+
+        for (int y = 0; y < src.caps().height(); y += 1 << heightDiv)
+            memcpy(dst.line(plane, y), src.constLine(plane, y), lineSize);
+    }
+}
+
+#include "moc_akframering.cpp"
@@ -0,0 +1,126 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKFRAMERING_H
+#define AKFRAMERING_H
+
+#include <QObject>
+
+#include "akcommons.h"
+
+class AkFrameRingPrivate;
+class AkVideoCaps;
+class AkVideoPacket;
+
+/* Fixed capacity history of video frames.
+ *
+ * The frame slots are allocated once and reused, pushing a new frame evicts
+ * the oldest one in O(1) and copies the frame data into the recycled slot
+ * without any further allocation. Frames can be optionally stored in
+ * luma-only (y8) format and/or downscaled by a power of two to reduce the
+ * memory footprint of long histories.
+ */
+class AKCOMMONS_EXPORT AkFrameRing: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int capacity
+               READ capacity
+               WRITE setCapacity
+               RESET resetCapacity
+               NOTIFY capacityChanged)
+    Q_PROPERTY(AkFrameRing::StorageMode storageMode
+               READ storageMode
+               WRITE setStorageMode
+               RESET resetStorageMode
+               NOTIFY storageModeChanged)
+    Q_PROPERTY(int scaleDiv
+               READ scaleDiv
+               WRITE setScaleDiv
+               RESET resetScaleDiv
+               NOTIFY scaleDivChanged)
+    Q_PROPERTY(int size
+               READ size)
+
+    public:
+        enum StorageMode
+        {
+            StorageMode_Full,
+            StorageMode_Luma,
+        };
+        Q_ENUM(StorageMode)
+
+        AkFrameRing(QObject *parent=nullptr);
+        AkFrameRing(int capacity,
+                    StorageMode storageMode=StorageMode_Full,
+                    int scaleDiv=0,
+                    QObject *parent=nullptr);
+        AkFrameRing(const AkFrameRing &other);
+        ~AkFrameRing();
+        AkFrameRing &operator =(const AkFrameRing &other);
+
+        Q_INVOKABLE static QObject *create();
+
+        Q_INVOKABLE int capacity() const;
+        Q_INVOKABLE AkFrameRing::StorageMode storageMode() const;
+        Q_INVOKABLE int scaleDiv() const;
+        Q_INVOKABLE int size() const;
+        Q_INVOKABLE bool isEmpty() const;
+        Q_INVOKABLE bool isFull() const;
+        Q_INVOKABLE AkVideoCaps caps() const;
+        Q_INVOKABLE AkVideoCaps storageCaps(const AkVideoCaps &caps) const;
+
+        // Index 0 is the oldest frame, size() - 1 the newest one.
+        Q_INVOKABLE const AkVideoPacket &at(int index) const;
+
+        // Delay 0 is the newest frame, size() - 1 the oldest one.
+        Q_INVOKABLE const AkVideoPacket &delayed(int delay) const;
+
+        Q_INVOKABLE const AkVideoPacket &first() const;
+        Q_INVOKABLE const AkVideoPacket &last() const;
+
+        // Evict the oldest frame if needed and return its slot for writing.
+        Q_INVOKABLE AkVideoPacket &next(const AkVideoCaps &caps);
+
+        Q_INVOKABLE const AkVideoPacket &push(const AkVideoPacket &packet);
+
+    private:
+        AkFrameRingPrivate *d;
+
+    Q_SIGNALS:
+        void capacityChanged(int capacity);
+        void storageModeChanged(AkFrameRing::StorageMode storageMode);
+        void scaleDivChanged(int scaleDiv);
+
+    public Q_SLOTS:
+        void setCapacity(int capacity);
+        void setStorageMode(AkFrameRing::StorageMode storageMode);
+        void setScaleDiv(int scaleDiv);
+        void resetCapacity();
+        void resetStorageMode();
+        void resetScaleDiv();
+        void clear();
+        static void registerTypes();
+};
+
+AKCOMMONS_EXPORT QDebug operator <<(QDebug debug, AkFrameRing::StorageMode mode);
+
+Q_DECLARE_METATYPE(AkFrameRing)
+Q_DECLARE_METATYPE(AkFrameRing::StorageMode)
+
+#endif // AKFRAMERING_H
@@ -0,0 +1,469 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <algorithm>
+#include <QCache>
+#include <QFontMetrics>
+#include <QGuiApplication>
+#include <QImage>
+#include <QMutex>
+#include <QPainter>
+#include <QQmlEngine>
+#include <QSharedPointer>
+
+#include "akglyphatlas.h"
+#include "aksimd.h"
+#include "akvideocaps.h"
+#include "akvideopacket.h"
+
+// Maximum size in bytes of the rendered glyphs kept in the cache.
+#define CACHE_MAX_BYTES (8 * 1024 * 1024)
+
+using CreateGlyphParametersType =
+    void *(*)();
+using FreeGlyphParametersType =
+    void (*)(void *glyphParameters);
+using DrawGlyphLine3Type =
+    void (*)(void *glyphParameters,
+             int width,
+             const quint8 *alpha_line,
+             const qint32 *fg,
+             const qint32 *bg,
+             quint32 *dst_line,
+             int *x);
+using DrawGlyphLine1Type =
+    void (*)(void *glyphParameters,
+             int width,
+             const quint8 *alpha_line,
+             qint32 fg,
+             qint32 bg,
+             quint8 *dst_line,
+             int *x);
+
+struct AkGlyphAtlasData
+{
+    QString m_characters;
+    QSize m_glyphSize;
+    QVector<int> m_weights;
+    QVector<int> m_lumaTable[2];
+    AkVideoPacket m_atlas;
+};
+
+using AkGlyphAtlasDataPtr = QSharedPointer<const AkGlyphAtlasData>;
+
+class AkGlyphAtlasCache
+{
+    public:
+        QMutex m_mutex;
+        QCache<QString, AkGlyphAtlasDataPtr> m_cache {CACHE_MAX_BYTES};
+};
+
+Q_GLOBAL_STATIC(AkGlyphAtlasCache, akGlyphAtlasCache)
+
+class AkGlyphAtlasPrivate
+{
+    public:
+        QFont m_font {QGuiApplication::font()};
+        QString m_charTable;
+        AkGlyphAtlasDataPtr m_data;
+
+        // SIMD functions
+
+        void *m_simdGlyphParameters {nullptr};
+        CreateGlyphParametersType m_createSIMDGlyphParameters {nullptr};
+        FreeGlyphParametersType m_freeSIMDGlyphParameters {nullptr};
+        DrawGlyphLine3Type m_drawSIMDGlyphLine3 {nullptr};
+        DrawGlyphLine1Type m_drawSIMDGlyphLine1 {nullptr};
+
+        AkGlyphAtlasPrivate();
+        ~AkGlyphAtlasPrivate();
+        void loadSimd();
+        void updateAtlas();
+        static QString defaultCharTable();
+        static AkGlyphAtlasDataPtr renderAtlas(const QFont &font,
+                                               const QString &charTable);
+        inline static int div255(int value);
+};
+
+AkGlyphAtlas::AkGlyphAtlas(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkGlyphAtlasPrivate();
+    this->d->m_charTable = AkGlyphAtlasPrivate::defaultCharTable();
+    this->d->updateAtlas();
+}
+
+AkGlyphAtlas::AkGlyphAtlas(const QFont &font,
+                           const QString &charTable,
+                           QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkGlyphAtlasPrivate();
+    this->d->m_font = font;
+    this->d->m_charTable = charTable;
+    this->d->updateAtlas();
+}
+
+AkGlyphAtlas::AkGlyphAtlas(const AkGlyphAtlas &other):
+    QObject()
+{
+    this->d = new AkGlyphAtlasPrivate();
+    this->d->m_font = other.d->m_font;
+    this->d->m_charTable = other.d->m_charTable;
+    this->d->m_data = other.d->m_data;
+}
+
+AkGlyphAtlas::~AkGlyphAtlas()
+{
+    delete this->d;
+}
+
+AkGlyphAtlas &AkGlyphAtlas::operator =(const AkGlyphAtlas &other)
+{
+    if (this != &other) {
+        this->d->m_font = other.d->m_font;
+        this->d->m_charTable = other.d->m_charTable;
+        this->d->m_data = other.d->m_data;
+    }
+
+    return *this;
+}
+
+QObject *AkGlyphAtlas::create()
+{
+    return new AkGlyphAtlas();
+}
+
+QFont AkGlyphAtlas::font() const
+{
+    return this->d->m_font;
+}
+
+QString AkGlyphAtlas::charTable() const
+{
+    return this->d->m_charTable;
+}
+
+QSize AkGlyphAtlas::glyphSize() const
+{
+    return this->d->m_data->m_glyphSize;
+}
+
+int AkGlyphAtlas::size() const
+{
+    return this->d->m_data->m_characters.size();
+}
+
+QChar AkGlyphAtlas::character(int index) const
+{
+    return this->d->m_data->m_characters.at(index);
+}
+
+int AkGlyphAtlas::weight(int index) const
+{
+    return this->d->m_data->m_weights.value(index);
+}
+
+const QVector<int> &AkGlyphAtlas::lumaTable(bool reversed) const
+{
+    return this->d->m_data->m_lumaTable[reversed? 1: 0];
+}
+
+const AkVideoPacket &AkGlyphAtlas::atlas() const
+{
+    return this->d->m_data->m_atlas;
+}
+
+const quint8 *AkGlyphAtlas::glyphLine(int index, int y) const
+{
+    auto &data = this->d->m_data;
+
+    return data->m_atlas.constLine(0, index * data->m_glyphSize.height() + y);
+}
+
+void AkGlyphAtlas::drawGlyphLine(int index,
+                                 int y,
+                                 QRgb foreground,
+                                 QRgb background,
+                                 QRgb *dstLine) const
+{
+    auto alphaLine = this->glyphLine(index, y);
+    int width = this->d->m_data->m_glyphSize.width();
+    qint32 fg[] {qRed(foreground), qGreen(foreground), qBlue(foreground)};
+    qint32 bg[] {qRed(background), qGreen(background), qBlue(background)};
+    int x = 0;
+
+    if (this->d->m_drawSIMDGlyphLine3)
+        this->d->m_drawSIMDGlyphLine3(this->d->m_simdGlyphParameters,
+                                      width,
+                                      alphaLine,
+                                      fg,
+                                      bg,
+                                      reinterpret_cast<quint32 *>(dstLine),
+                                      &x);
+
+    for (; x < width; x++) {
+        int a = alphaLine[x];
+        dstLine[x] =
+            qRgb(AkGlyphAtlasPrivate::div255(a * (fg[0] - bg[0]) + 255 * bg[0]),
+                 AkGlyphAtlasPrivate::div255(a * (fg[1] - bg[1]) + 255 * bg[1]),
+                 AkGlyphAtlasPrivate::div255(a * (fg[2] - bg[2]) + 255 * bg[2]));
+    }
+}
+
+void AkGlyphAtlas::drawGlyphLine(int index,
+                                 int y,
+                                 int foreground,
+                                 int background,
+                                 quint8 *dstLine) const
+{
+    auto alphaLine = this->glyphLine(index, y);
+    int width = this->d->m_data->m_glyphSize.width();
+    int x = 0;
+
+    if (this->d->m_drawSIMDGlyphLine1)
+        this->d->m_drawSIMDGlyphLine1(this->d->m_simdGlyphParameters,
+                                      width,
+                                      alphaLine,
+                                      foreground,
+                                      background,
+                                      dstLine,
+                                      &x);
+
+    for (; x < width; x++) {
+        int a = alphaLine[x];
+        dstLine[x] =
+            quint8(AkGlyphAtlasPrivate::div255(a * (foreground - background)
+                                               + 255 * background));
+    }
+}
+
+void AkGlyphAtlas::setFont(const QFont &font)
+{
+    if (this->d->m_font == font
+        && this->d->m_font.hintingPreference() == font.hintingPreference()
+        && this->d->m_font.styleStrategy() == font.styleStrategy())
+        return;
+
+    auto glyphSize = this->glyphSize();
+    this->d->m_font = font;
+    this->d->updateAtlas();
+    emit this->fontChanged(font);
+
+    if (this->glyphSize() != glyphSize)
+        emit this->glyphSizeChanged(this->glyphSize());
+}
+
+void AkGlyphAtlas::setCharTable(const QString &charTable)
+{
+    if (this->d->m_charTable == charTable)
+        return;
+
+    auto glyphSize = this->glyphSize();
+    this->d->m_charTable = charTable;
+    this->d->updateAtlas();
+    emit this->charTableChanged(charTable);
+
+    if (this->glyphSize() != glyphSize)
+        emit this->glyphSizeChanged(this->glyphSize());
+}
+
+void AkGlyphAtlas::resetFont()
+{
+    this->setFont(QGuiApplication::font());
+}
+
+void AkGlyphAtlas::resetCharTable()
+{
+    this->setCharTable(AkGlyphAtlasPrivate::defaultCharTable());
+}
+
+void AkGlyphAtlas::registerTypes()
+{
+    qRegisterMetaType<AkGlyphAtlas>("AkGlyphAtlas");
+    qmlRegisterSingletonType<AkGlyphAtlas>("Ak", 1, 0, "AkGlyphAtlas",
+                                           [] (QQmlEngine *qmlEngine,
+                                               QJSEngine *jsEngine) -> QObject * {
+        Q_UNUSED(qmlEngine)
+        Q_UNUSED(jsEngine)
+
+        return new AkGlyphAtlas();
+    });
+}
+
+AkGlyphAtlasPrivate::AkGlyphAtlasPrivate()
+{
+    this->loadSimd();
+}
+
+AkGlyphAtlasPrivate::~AkGlyphAtlasPrivate()
+{
+    if (this->m_freeSIMDGlyphParameters && this->m_simdGlyphParameters)
+        this->m_freeSIMDGlyphParameters(this->m_simdGlyphParameters);
+}
+
+void AkGlyphAtlasPrivate::loadSimd()
+{
+    AkSimd simd("Core");
+
+    this->m_createSIMDGlyphParameters = reinterpret_cast<CreateGlyphParametersType>(simd.resolve("createGlyphParameters"));
+    this->m_freeSIMDGlyphParameters = reinterpret_cast<FreeGlyphParametersType>(simd.resolve("freeGlyphParameters"));
+    this->m_drawSIMDGlyphLine3 = reinterpret_cast<DrawGlyphLine3Type>(simd.resolve("drawGlyphLine3"));
+    this->m_drawSIMDGlyphLine1 = reinterpret_cast<DrawGlyphLine1Type>(simd.resolve("drawGlyphLine1"));
+
+    if (this->m_createSIMDGlyphParameters)
+        this->m_simdGlyphParameters = this->m_createSIMDGlyphParameters();
+}
+
+void AkGlyphAtlasPrivate::updateAtlas()
+{
+    // The hinting and the style strategy are not part of the font string.
+    auto key = QString("%1|%2|%3|%4")
+                   .arg(this->m_font.toString())
+                   .arg(int(this->m_font.hintingPreference()))
+                   .arg(int(this->m_font.styleStrategy()))
+                   .arg(this->m_charTable);
+
+    QMutexLocker locker(&akGlyphAtlasCache->m_mutex);
+    auto cached = akGlyphAtlasCache->m_cache.object(key);
+
+    if (cached) {
+        this->m_data = *cached;
+
+        return;
+    }
+
+    this->m_data = renderAtlas(this->m_font, this->m_charTable);
+    auto cost = qMax<qsizetype>(this->m_data->m_atlas.size(), 1);
+    akGlyphAtlasCache->m_cache.insert(key,
+                                      new AkGlyphAtlasDataPtr(this->m_data),
+                                      cost);
+}
+
+QString AkGlyphAtlasPrivate::defaultCharTable()
+{
+    QString charTable;
+
+    for (int i = 32; i < 127; i++)
+        charTable.append(QChar(i));
+
+    return charTable;
+}
+
+AkGlyphAtlasDataPtr AkGlyphAtlasPrivate::renderAtlas(const QFont &font,
+                                                     const QString &charTable)
+{
+    auto data = new AkGlyphAtlasData;
+    data->m_characters = charTable.isEmpty()? QString(" "): charTable;
+
+    // All the glyphs share the size of the biggest one.
+
+    QFontMetrics metrics(font);
+    int width = 1;
+    int height = 1;
+
+    for (auto &chr: data->m_characters) {
+        auto size = metrics.size(Qt::TextSingleLine, chr);
+        width = qMax(width, size.width());
+        height = qMax(height, size.height());
+    }
+
+    data->m_glyphSize = {width, height};
+    int nGlyphs = data->m_characters.size();
+
+    // Render the glyphs one below the other.
+
+    QImage atlasImg(width, height * nGlyphs, QImage::Format_Grayscale8);
+    atlasImg.fill(qRgb(0, 0, 0));
+
+    QPainter painter;
+    painter.begin(&atlasImg);
+    painter.setPen(qRgb(255, 255, 255));
+    painter.setFont(font);
+
+    for (int i = 0; i < nGlyphs; i++)
+        painter.drawText(QRect(0, i * height, width, height),
+                         data->m_characters[i],
+                         Qt::AlignHCenter | Qt::AlignVCenter);
+
+    painter.end();
+
+    data->m_atlas = AkVideoPacket({AkVideoCaps::Format_y8,
+                                   width,
+                                   height * nGlyphs,
+                                   {}});
+    auto lineSize = qMin<size_t>(atlasImg.bytesPerLine(),
+                                 data->m_atlas.lineSize(0));
+
+    for (int y = 0; y < atlasImg.height(); y++)
+        memcpy(data->m_atlas.line(0, y),
+               atlasImg.constScanLine(y),
+               lineSize);
+
+    // Calculate the weight of each glyph.
+
+    data->m_weights.resize(nGlyphs);
+
+    for (int i = 0; i < nGlyphs; i++) {
+        int weight = 0;
+
+        for (int y = 0; y < height; y++) {
+            auto line = data->m_atlas.constLine(0, i * height + y);
+
+            for (int x = 0; x < width; x++)
+                weight += line[x];
+        }
+
+        data->m_weights[i] = weight / (width * height);
+    }
+
+    // Map each luma value to a glyph, from the lightest to the heaviest one.
+
+    for (int reversed = 0; reversed < 2; reversed++) {
+        QVector<int> order(nGlyphs);
+
+        for (int i = 0; i < nGlyphs; i++)
+            order[i] = i;
+
+        auto &weights = data->m_weights;
+        std::stable_sort(order.begin(),
+                         order.end(),
+                         [&weights, reversed] (int glyph1, int glyph2) {
+                             return reversed?
+                                        weights[glyph1] > weights[glyph2]:
+                                        weights[glyph1] < weights[glyph2];
+                         });
+
+        auto &lumaTable = data->m_lumaTable[reversed];
+        lumaTable.resize(256);
+        int glyphMax = charTable.isEmpty()? 0: nGlyphs - 1;
+
+        for (int i = 0; i < 256; i++)
+            lumaTable[i] = order[glyphMax * i / 255];
+    }
+
+    return AkGlyphAtlasDataPtr(data);
+}
+
+int AkGlyphAtlasPrivate::div255(int value)
+{
+    return (value * 257 + 32896) >> 16;
+}
+
+#include "moc_akglyphatlas.cpp"
@@ -0,0 +1,119 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKGLYPHATLAS_H
+#define AKGLYPHATLAS_H
+
+#include <QFont>
+#include <QObject>
+#include <QSize>
+#include <QVector>
+#include <qrgb.h>
+
+#include "akcommons.h"
+
+class AkGlyphAtlasPrivate;
+class AkVideoPacket;
+
+/* Pre-rendered glyphs of a character table.
+ *
+ * All the glyphs are rendered once in a single y8 texture, one glyph cell
+ * below the other, and shared between all the atlases using the same font
+ * and character table through a process wide cache. Glyphs are selected from
+ * the luma of a pixel with a precomputed look-up table, and their lines are
+ * blended into the output frame with vectorized code.
+ *
+ * An empty character table renders a single blank space glyph.
+ */
+class AKCOMMONS_EXPORT AkGlyphAtlas: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QFont font
+               READ font
+               WRITE setFont
+               RESET resetFont
+               NOTIFY fontChanged)
+    Q_PROPERTY(QString charTable
+               READ charTable
+               WRITE setCharTable
+               RESET resetCharTable
+               NOTIFY charTableChanged)
+    Q_PROPERTY(QSize glyphSize
+               READ glyphSize
+               NOTIFY glyphSizeChanged)
+    Q_PROPERTY(int size
+               READ size)
+
+    public:
+        AkGlyphAtlas(QObject *parent=nullptr);
+        AkGlyphAtlas(const QFont &font,
+                     const QString &charTable,
+                     QObject *parent=nullptr);
+        AkGlyphAtlas(const AkGlyphAtlas &other);
+        ~AkGlyphAtlas();
+        AkGlyphAtlas &operator =(const AkGlyphAtlas &other);
+
+        Q_INVOKABLE static QObject *create();
+
+        Q_INVOKABLE QFont font() const;
+        Q_INVOKABLE QString charTable() const;
+        Q_INVOKABLE QSize glyphSize() const;
+        Q_INVOKABLE int size() const;
+        Q_INVOKABLE QChar character(int index) const;
+
+        // Mean coverage of the glyph, in the [0, 255] range.
+        Q_INVOKABLE int weight(int index) const;
+
+        // Luma to glyph index table, from the lightest glyph to the heaviest.
+        Q_INVOKABLE const QVector<int> &lumaTable(bool reversed=false) const;
+
+        Q_INVOKABLE const AkVideoPacket &atlas() const;
+        Q_INVOKABLE const quint8 *glyphLine(int index, int y) const;
+
+        // Blend a line of the glyph between the foreground and the background.
+        Q_INVOKABLE void drawGlyphLine(int index,
+                                       int y,
+                                       QRgb foreground,
+                                       QRgb background,
+                                       QRgb *dstLine) const;
+        Q_INVOKABLE void drawGlyphLine(int index,
+                                       int y,
+                                       int foreground,
+                                       int background,
+                                       quint8 *dstLine) const;
+
+    private:
+        AkGlyphAtlasPrivate *d;
+
+    Q_SIGNALS:
+        void fontChanged(const QFont &font);
+        void charTableChanged(const QString &charTable);
+        void glyphSizeChanged(const QSize &glyphSize);
+
+    public Q_SLOTS:
+        void setFont(const QFont &font);
+        void setCharTable(const QString &charTable);
+        void resetFont();
+        void resetCharTable();
+        static void registerTypes();
+};
+
+Q_DECLARE_METATYPE(AkGlyphAtlas)
+
+#endif // AKGLYPHATLAS_H
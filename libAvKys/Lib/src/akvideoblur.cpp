@@ -0,0 +1,485 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QDebug>
+#include <QMetaEnum>
+#include <QMutex>
+#include <QQmlEngine>
+#include <QThread>
+#include <QtMath>
+
+#ifdef OPENMP_ENABLED
+#include <omp.h>
+#endif
+
+#include "akvideoblur.h"
+#include "akcpufeatures.h"
+#include "aksimd.h"
+#include "akvideocaps.h"
+#include "akvideopacket.h"
+
+// Keep the column sums below this radius to fit in 32 bits.
+#define MAX_RADIUS 1024
+
+using CreateBlurParametersType =
+    void *(*)();
+using FreeBlurParametersType =
+    void (*)(void *blurParameters);
+using BlurSumLineType =
+    void (*)(void *blurParameters,
+             int width,
+             const qint32 *add_line,
+             const qint32 *sub_line,
+             qint32 *sum_line,
+             int *x);
+
+class AkVideoBlurPrivate
+{
+    public:
+        int m_radius {0};
+        AkVideoBlur::BlurMode m_blurMode {AkVideoBlur::BlurMode_Box};
+        QMutex m_mutex;
+
+        // Box radius of each pass.
+        QVector<int> m_passes;
+
+        // Reusable buffers, a ring of line sums and a column sums line per
+        // band of lines.
+        QVector<qint32> m_sums;
+        AkVideoPacket m_passFrame;
+
+        // SIMD functions
+
+        void *m_simdBlurParameters {nullptr};
+        CreateBlurParametersType m_createSIMDBlurParameters {nullptr};
+        FreeBlurParametersType m_freeSIMDBlurParameters {nullptr};
+        BlurSumLineType m_blurSIMDSumLine {nullptr};
+        size_t m_parallelizationThreshold {0};
+
+        AkVideoBlurPrivate();
+        ~AkVideoBlurPrivate();
+        void loadSimd();
+        void updatePasses();
+        static int nComponents(AkVideoCaps::PixelFormat format);
+        inline static void horizontalSum(const quint8 *srcLine,
+                                         qint32 *rowSums,
+                                         int width,
+                                         int components,
+                                         int radius);
+        inline void sumLine(int width,
+                            int radius,
+                            const qint32 *addLine,
+                            const qint32 *subLine,
+                            qint32 *sumLine) const;
+        void blurPass(const AkVideoPacket &src,
+                      AkVideoPacket &dst,
+                      int components,
+                      int radius,
+                      bool paralelize);
+};
+
+AkVideoBlur::AkVideoBlur(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoBlurPrivate();
+}
+
+AkVideoBlur::AkVideoBlur(int radius,
+                         BlurMode blurMode,
+                         QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoBlurPrivate();
+    this->d->m_radius = qBound(0, radius, MAX_RADIUS);
+    this->d->m_blurMode = blurMode;
+    this->d->updatePasses();
+}
+
+AkVideoBlur::AkVideoBlur(const AkVideoBlur &other):
+    QObject()
+{
+    this->d = new AkVideoBlurPrivate();
+    this->d->m_radius = other.d->m_radius;
+    this->d->m_blurMode = other.d->m_blurMode;
+    this->d->updatePasses();
+}
+
+AkVideoBlur::~AkVideoBlur()
+{
+    delete this->d;
+}
+
+AkVideoBlur &AkVideoBlur::operator =(const AkVideoBlur &other)
+{
+    if (this != &other) {
+        QMutexLocker locker(&this->d->m_mutex);
+        this->d->m_radius = other.d->m_radius;
+        this->d->m_blurMode = other.d->m_blurMode;
+        this->d->updatePasses();
+    }
+
+    return *this;
+}
+
+QObject *AkVideoBlur::create()
+{
+    return new AkVideoBlur();
+}
+
+int AkVideoBlur::radius() const
+{
+    return this->d->m_radius;
+}
+
+AkVideoBlur::BlurMode AkVideoBlur::blurMode() const
+{
+    return this->d->m_blurMode;
+}
+
+AkVideoPacket AkVideoBlur::blur(const AkVideoPacket &packet)
+{
+    if (!packet)
+        return {};
+
+    auto components = AkVideoBlurPrivate::nComponents(packet.caps().format());
+
+    if (components < 1)
+        return {};
+
+    QMutexLocker locker(&this->d->m_mutex);
+
+    if (this->d->m_passes.isEmpty())
+        return packet;
+
+    AkVideoPacket dst(packet.caps());
+    dst.copyMetadata(packet);
+
+    auto nPasses = this->d->m_passes.size();
+
+    if (nPasses > 1 && this->d->m_passFrame.caps() != packet.caps())
+        this->d->m_passFrame = AkVideoPacket(packet.caps());
+
+    bool paralelize =
+            packet.size() * size_t(nPasses) > this->d->m_parallelizationThreshold;
+
+    /* Alternate between the output frame and the intermediate frame, so the
+     * last pass always writes to the output frame.
+     */
+    const AkVideoPacket *src = &packet;
+
+    for (int i = 0; i < nPasses; i++) {
+        auto out = (nPasses - 1 - i) % 2?
+                       &this->d->m_passFrame:
+                       &dst;
+        this->d->blurPass(*src,
+                          *out,
+                          components,
+                          this->d->m_passes[i],
+                          paralelize);
+        src = out;
+    }
+
+    return dst;
+}
+
+void AkVideoBlur::setRadius(int radius)
+{
+    radius = qBound(0, radius, MAX_RADIUS);
+
+    if (this->d->m_radius == radius)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_radius = radius;
+    this->d->updatePasses();
+    this->d->m_mutex.unlock();
+    emit this->radiusChanged(radius);
+}
+
+void AkVideoBlur::setBlurMode(BlurMode blurMode)
+{
+    if (this->d->m_blurMode == blurMode)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_blurMode = blurMode;
+    this->d->updatePasses();
+    this->d->m_mutex.unlock();
+    emit this->blurModeChanged(blurMode);
+}
+
+void AkVideoBlur::resetRadius()
+{
+    this->setRadius(0);
+}
+
+void AkVideoBlur::resetBlurMode()
+{
+    this->setBlurMode(BlurMode_Box);
+}
+
+void AkVideoBlur::registerTypes()
+{
+    qRegisterMetaType<AkVideoBlur>("AkVideoBlur");
+    qRegisterMetaType<BlurMode>("AkVideoBlurBlurMode");
+    qmlRegisterSingletonType<AkVideoBlur>("Ak", 1, 0, "AkVideoBlur",
+                                          [] (QQmlEngine *qmlEngine,
+                                              QJSEngine *jsEngine) -> QObject * {
+        Q_UNUSED(qmlEngine)
+        Q_UNUSED(jsEngine)
+
+        return new AkVideoBlur();
+    });
+}
+
+QDebug operator <<(QDebug debug, AkVideoBlur::BlurMode mode)
+{
+    AkVideoBlur blur;
+    int blurModeIndex = blur.metaObject()->indexOfEnumerator("BlurMode");
+    QMetaEnum blurModeEnum = blur.metaObject()->enumerator(blurModeIndex);
+    QString blurModeStr(blurModeEnum.valueToKey(mode));
+    blurModeStr.remove("BlurMode_");
+    QDebugStateSaver saver(debug);
+    debug.nospace() << blurModeStr.toStdString().c_str();
+
+    return debug;
+}
+
+AkVideoBlurPrivate::AkVideoBlurPrivate()
+{
+    this->loadSimd();
+}
+
+AkVideoBlurPrivate::~AkVideoBlurPrivate()
+{
+    if (this->m_freeSIMDBlurParameters && this->m_simdBlurParameters)
+        this->m_freeSIMDBlurParameters(this->m_simdBlurParameters);
+}
+
+void AkVideoBlurPrivate::loadSimd()
+{
+    AkSimd simd("Core");
+
+    this->m_createSIMDBlurParameters = reinterpret_cast<CreateBlurParametersType>(simd.resolve("createBlurParameters"));
+    this->m_freeSIMDBlurParameters = reinterpret_cast<FreeBlurParametersType>(simd.resolve("freeBlurParameters"));
+    this->m_blurSIMDSumLine = reinterpret_cast<BlurSumLineType>(simd.resolve("blurSumLine"));
+
+    if (this->m_createSIMDBlurParameters)
+        this->m_simdBlurParameters = this->m_createSIMDBlurParameters();
+
+    // Two running sums and one scaling per component and pass.
+    this->m_parallelizationThreshold =
+            AkCpuFeatures::paralellizableBytesThreshold(5,
+                                                        simd.loadedInstructionSet());
+}
+
+void AkVideoBlurPrivate::updatePasses()
+{
+    this->m_passes.clear();
+
+    if (this->m_radius < 1)
+        return;
+
+    if (this->m_blurMode == AkVideoBlur::BlurMode_Box) {
+        this->m_passes << this->m_radius;
+
+        return;
+    }
+
+    /* Approximate a Gaussian with 3 box blurs, the box sizes are chosen so the
+     * variance of the blurs sum matches the variance of the Gaussian.
+     * The radius is taken as 2 sigma, so the blur strength is close to the
+     * box blur of the same radius.
+     */
+    const int n = 3;
+    qreal sigma = this->m_radius / 2.0;
+    qreal variance12 = 12 * sigma * sigma;
+    int wl = qFloor(qSqrt(variance12 / n + 1));
+
+    if (wl % 2 == 0)
+        wl--;
+
+    int wu = wl + 2;
+    int m = qRound((variance12 - n * wl * wl - 4 * n * wl - 3 * n)
+                   / (-4 * wl - 4));
+
+    for (int i = 0; i < n; i++) {
+        int radius = ((i < m? wl: wu) - 1) / 2;
+
+        if (radius > 0)
+            this->m_passes << radius;
+    }
+}
+
+int AkVideoBlurPrivate::nComponents(AkVideoCaps::PixelFormat format)
+{
+    switch (format) {
+    case AkVideoCaps::Format_argbpack:
+        return 4;
+    case AkVideoCaps::Format_ya88pack:
+        return 2;
+    case AkVideoCaps::Format_y8:
+        return 1;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+void AkVideoBlurPrivate::horizontalSum(const quint8 *srcLine,
+                                       qint32 *rowSums,
+                                       int width,
+                                       int components,
+                                       int radius)
+{
+    for (int c = 0; c < components; c++) {
+        auto srcComponent = srcLine + c;
+        auto sumComponent = rowSums + c;
+        qint32 sum = 0;
+
+        for (int k = -radius; k <= radius; k++)
+            sum += srcComponent[qBound(0, k, width - 1) * components];
+
+        for (int x = 0; x < width; x++) {
+            sumComponent[x * components] = sum;
+            int xAdd = qMin(x + radius + 1, width - 1);
+            int xSub = qMax(x - radius, 0);
+            sum += srcComponent[xAdd * components]
+                   - srcComponent[xSub * components];
+        }
+    }
+}
+
+void AkVideoBlurPrivate::sumLine(int width,
+                                 int radius,
+                                 const qint32 *addLine,
+                                 const qint32 *subLine,
+                                 qint32 *sumLine) const
+{
+    int x = 0;
+
+    /* The SIMD code may be running with floats, which are exact only up to
+     * 24 bits.
+     */
+    int kernelSize = 2 * radius + 1;
+
+    if (this->m_blurSIMDSumLine
+        && 255 * kernelSize * kernelSize < (1 << 24))
+        this->m_blurSIMDSumLine(this->m_simdBlurParameters,
+                                width,
+                                addLine,
+                                subLine,
+                                sumLine,
+                                &x);
+
+    for (; x < width; x++)
+        sumLine[x] += addLine[x] - subLine[x];
+}
+
+void AkVideoBlurPrivate::blurPass(const AkVideoPacket &src,
+                                  AkVideoPacket &dst,
+                                  int components,
+                                  int radius,
+                                  bool paralelize)
+{
+    int width = src.caps().width();
+    int height = src.caps().height();
+    int lineWidth = width * components;
+
+    /* The lines of the frame are split in bands, one per thread. Each band
+     * only keeps the horizontal sums of the 2 * radius + 1 lines of the
+     * vertical window, plus the line entering it, in a ring buffer.
+     */
+    int ringSize = qMin(2 * radius + 2, height);
+    int nBands = paralelize? qMin(QThread::idealThreadCount(), height): 1;
+    auto bandSize = size_t(ringSize + 1) * size_t(lineWidth);
+
+    if (size_t(this->m_sums.size()) < size_t(nBands) * bandSize)
+        this->m_sums.resize(int(size_t(nBands) * bandSize));
+
+    auto sums = this->m_sums.data();
+    int kernelSize = 2 * radius + 1;
+    auto area = quint64(kernelSize) * quint64(kernelSize);
+
+    // Divide by the kernel area with a 32 bits reciprocal.
+    auto reciprocal = ((quint64(1) << 32) + area / 2) / area;
+    auto rounding = quint64(1) << 31;
+
+    #pragma omp parallel for if(paralelize)
+    for (int band = 0; band < nBands; band++) {
+        int yStart = band * height / nBands;
+        int yEnd = (band + 1) * height / nBands;
+        auto ring = sums + size_t(band) * bandSize;
+        auto columnSum = ring + size_t(ringSize) * size_t(lineWidth);
+        auto rowSums = [ring, ringSize, lineWidth] (int y) -> qint32 * {
+            return ring + size_t(y % ringSize) * size_t(lineWidth);
+        };
+
+        // Fill the window of the first line of the band.
+
+        int nextRow = qMax(yStart - radius, 0);
+
+        for (; nextRow <= qMin(yStart + radius, height - 1); nextRow++)
+            horizontalSum(src.constLine(0, nextRow),
+                          rowSums(nextRow),
+                          width,
+                          components,
+                          radius);
+
+        memset(columnSum, 0, size_t(lineWidth) * sizeof(qint32));
+
+        for (int k = yStart - radius; k <= yStart + radius; k++) {
+            auto line = rowSums(qBound(0, k, height - 1));
+
+            for (int x = 0; x < lineWidth; x++)
+                columnSum[x] += line[x];
+        }
+
+        for (int y = yStart; y < yEnd; y++) {
+            auto dstLine = dst.line(0, y);
+
+            for (int x = 0; x < lineWidth; x++)
+                dstLine[x] = quint8((quint64(columnSum[x]) * reciprocal
+                                     + rounding) >> 32);
+
+            if (y + 1 >= yEnd)
+                break;
+
+            int addRow = qMin(y + radius + 1, height - 1);
+
+            if (addRow >= nextRow) {
+                horizontalSum(src.constLine(0, addRow),
+                              rowSums(addRow),
+                              width,
+                              components,
+                              radius);
+                nextRow = addRow + 1;
+            }
+
+            this->sumLine(lineWidth,
+                          radius,
+                          rowSums(addRow),
+                          rowSums(qMax(y - radius, 0)),
+                          columnSum);
+        }
+    }
+}
+
+#include "moc_akvideoblur.cpp"
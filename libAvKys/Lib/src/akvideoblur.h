@@ -0,0 +1,96 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKVIDEOBLUR_H
+#define AKVIDEOBLUR_H
+
+#include <QObject>
+
+#include "akcommons.h"
+
+class AkVideoBlurPrivate;
+class AkVideoPacket;
+
+/* Box and Gaussian blur of video frames.
+ *
+ * The blur is computed with horizontal and vertical running sums, so the cost
+ * per pixel is constant regardless of the radius. The Gaussian mode
+ * approximates a true Gaussian with three successive box blurs.
+ * Pixels outside the frame take the value of the nearest border pixel.
+ *
+ * Supported formats are argbpack, ya88pack and y8, all the components,
+ * alpha included, are blurred.
+ */
+class AKCOMMONS_EXPORT AkVideoBlur: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int radius
+               READ radius
+               WRITE setRadius
+               RESET resetRadius
+               NOTIFY radiusChanged)
+    Q_PROPERTY(AkVideoBlur::BlurMode blurMode
+               READ blurMode
+               WRITE setBlurMode
+               RESET resetBlurMode
+               NOTIFY blurModeChanged)
+
+    public:
+        enum BlurMode
+        {
+            BlurMode_Box,
+            BlurMode_Gaussian,
+        };
+        Q_ENUM(BlurMode)
+
+        AkVideoBlur(QObject *parent=nullptr);
+        AkVideoBlur(int radius,
+                    BlurMode blurMode=BlurMode_Box,
+                    QObject *parent=nullptr);
+        AkVideoBlur(const AkVideoBlur &other);
+        ~AkVideoBlur();
+        AkVideoBlur &operator =(const AkVideoBlur &other);
+
+        Q_INVOKABLE static QObject *create();
+
+        Q_INVOKABLE int radius() const;
+        Q_INVOKABLE AkVideoBlur::BlurMode blurMode() const;
+        Q_INVOKABLE AkVideoPacket blur(const AkVideoPacket &packet);
+
+    private:
+        AkVideoBlurPrivate *d;
+
+    Q_SIGNALS:
+        void radiusChanged(int radius);
+        void blurModeChanged(AkVideoBlur::BlurMode blurMode);
+
+    public Q_SLOTS:
+        void setRadius(int radius);
+        void setBlurMode(AkVideoBlur::BlurMode blurMode);
+        void resetRadius();
+        void resetBlurMode();
+        static void registerTypes();
+};
+
+AKCOMMONS_EXPORT QDebug operator <<(QDebug debug, AkVideoBlur::BlurMode mode);
+
+Q_DECLARE_METATYPE(AkVideoBlur)
+Q_DECLARE_METATYPE(AkVideoBlur::BlurMode)
+
+#endif // AKVIDEOBLUR_H
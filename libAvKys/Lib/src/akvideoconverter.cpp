@@ -324,6 +324,9 @@ class FrameConvertParameters
         AkColorConvert::YuvColorSpaceType yuvColorSpaceType {AkColorConvert::YuvColorSpaceType_StudioSwing};
         AkVideoConverter::ScalingMode scalingMode {AkVideoConverter::ScalingMode_Fast};
         AkVideoConverter::AspectRatioMode aspectRatioMode {AkVideoConverter::AspectRatioMode_Ignore};
+        bool horizontalFlip {false};
+        bool verticalFlip {false};
+        bool swapRedBlue {false};
         ConvertType convertType {ConvertType_Vector};
         ConvertDataTypes convertDataTypes {ConvertDataTypes_8_8};
         ConvertAlphaMode alphaMode {ConvertAlphaMode_AI_AO};
@@ -465,11 +468,14 @@ class FrameConvertParameters
                        const AkVideoCaps &ocaps,
                        AkColorConvert &colorConvert,
                        AkColorConvert::YuvColorSpace yuvColorSpace,
-                       AkColorConvert::YuvColorSpaceType yuvColorSpaceType);
+                       AkColorConvert::YuvColorSpaceType yuvColorSpaceType,
+                       bool swapRedBlue);
         void configureScaling(const AkVideoCaps &icaps,
                               const AkVideoCaps &ocaps,
                               const QRect &inputRect,
-                              AkVideoConverter::AspectRatioMode aspectRatioMode);
+                              AkVideoConverter::AspectRatioMode aspectRatioMode,
+                              bool horizontalFlip,
+                              bool verticalFlip);
         void reset();
 };
 
@@ -486,6 +492,9 @@ class AkVideoConverterPrivate
         AkVideoConverter::ScalingMode m_scalingMode {AkVideoConverter::ScalingMode_Fast};
         AkVideoConverter::AspectRatioMode m_aspectRatioMode {AkVideoConverter::AspectRatioMode_Ignore};
         QRect m_inputRect;
+        bool m_horizontalFlip {false};
+        bool m_verticalFlip {false};
+        bool m_swapRedBlue {false};
 
         /* Color blendig functions
          *
@@ -8222,6 +8231,11 @@ class AkVideoConverterPrivate
             }
         }
 
+        inline FrameConvertParameters *frameConvertParameters(const AkVideoPacket &packet,
+                                                              const AkVideoCaps &ocaps);
+        inline void convertFrame(FrameConvertParameters &fc,
+                                 const AkVideoPacket &packet,
+                                 AkVideoPacket &dst);
         inline AkVideoPacket convert(const AkVideoPacket &packet,
                                      const AkVideoCaps &ocaps);
 };
@@ -8250,6 +8264,9 @@ AkVideoConverter::AkVideoConverter(const AkVideoConverter &other):
     this->d->m_scalingMode = other.d->m_scalingMode;
     this->d->m_aspectRatioMode = other.d->m_aspectRatioMode;
     this->d->m_inputRect = other.d->m_inputRect;
+    this->d->m_horizontalFlip = other.d->m_horizontalFlip;
+    this->d->m_verticalFlip = other.d->m_verticalFlip;
+    this->d->m_swapRedBlue = other.d->m_swapRedBlue;
 }
 
 AkVideoConverter::~AkVideoConverter()
@@ -8271,6 +8288,9 @@ AkVideoConverter &AkVideoConverter::operator =(const AkVideoConverter &other)
         this->d->m_scalingMode = other.d->m_scalingMode;
         this->d->m_aspectRatioMode = other.d->m_aspectRatioMode;
         this->d->m_inputRect = other.d->m_inputRect;
+        this->d->m_horizontalFlip = other.d->m_horizontalFlip;
+        this->d->m_verticalFlip = other.d->m_verticalFlip;
+        this->d->m_swapRedBlue = other.d->m_swapRedBlue;
     }
 
     return *this;
@@ -8311,6 +8331,21 @@ QRect AkVideoConverter::inputRect() const
     return this->d->m_inputRect;
 }
 
+bool AkVideoConverter::horizontalFlip() const
+{
+    return this->d->m_horizontalFlip;
+}
+
+bool AkVideoConverter::verticalFlip() const
+{
+    return this->d->m_verticalFlip;
+}
+
+bool AkVideoConverter::swapRedBlue() const
+{
+    return this->d->m_swapRedBlue;
+}
+
 bool AkVideoConverter::begin()
 {
     this->d->m_cacheIndex = 0;
@@ -8333,12 +8368,47 @@ AkVideoPacket AkVideoConverter::convert(const AkVideoPacket &packet)
     if (caps.format() == this->d->m_outputCaps.format()
         && caps.width() == this->d->m_outputCaps.width()
         && caps.height() == this->d->m_outputCaps.height()
-        && this->d->m_inputRect.isEmpty())
+        && this->d->m_inputRect.isEmpty()
+        && !this->d->m_horizontalFlip
+        && !this->d->m_verticalFlip
+        && !this->d->m_swapRedBlue)
         return packet;
 
     return this->d->convert(packet, this->d->m_outputCaps);
 }
 
+bool AkVideoConverter::convert(const AkVideoPacket &packet,
+                               AkVideoPacket &output)
+{
+    if (!packet || !output)
+        return false;
+
+    auto fc = this->d->frameConvertParameters(packet, output.caps());
+
+    if (!fc)
+        return false;
+
+    // The output must be able to hold the whole converted frame.
+    if (fc->outputConvertCaps.format() != output.caps().format()
+        || fc->outputConvertCaps.width() != output.caps().width()
+        || fc->outputConvertCaps.height() != output.caps().height()) {
+        this->d->m_cacheIndex++;
+
+        return false;
+    }
+
+    // Clear the borders, they are not touched by the conversion.
+    if (fc->aspectRatioMode == AspectRatioMode_Fit
+        && (fc->xmin > 0 || fc->ymin > 0))
+        output.fillRgb(qRgba(0, 0, 0, 0));
+
+    this->d->convertFrame(*fc, packet, output);
+    output.copyMetadata(packet);
+    this->d->m_cacheIndex++;
+
+    return true;
+}
+
 void AkVideoConverter::setCacheIndex(int index)
 {
     this->d->m_cacheIndex = index;
@@ -8400,6 +8470,33 @@ void AkVideoConverter::setInputRect(const QRect &inputRect)
     emit this->inputRectChanged(inputRect);
 }
 
+void AkVideoConverter::setHorizontalFlip(bool horizontalFlip)
+{
+    if (this->d->m_horizontalFlip == horizontalFlip)
+        return;
+
+    this->d->m_horizontalFlip = horizontalFlip;
+    emit this->horizontalFlipChanged(horizontalFlip);
+}
+
+void AkVideoConverter::setVerticalFlip(bool verticalFlip)
+{
+    if (this->d->m_verticalFlip == verticalFlip)
+        return;
+
+    this->d->m_verticalFlip = verticalFlip;
+    emit this->verticalFlipChanged(verticalFlip);
+}
+
+void AkVideoConverter::setSwapRedBlue(bool swapRedBlue)
+{
+    if (this->d->m_swapRedBlue == swapRedBlue)
+        return;
+
+    this->d->m_swapRedBlue = swapRedBlue;
+    emit this->swapRedBlueChanged(swapRedBlue);
+}
+
 void AkVideoConverter::resetOutputCaps()
 {
     this->setOutputCaps({});
@@ -8430,6 +8527,21 @@ void AkVideoConverter::resetInputRect()
     this->setInputRect({});
 }
 
+void AkVideoConverter::resetHorizontalFlip()
+{
+    this->setHorizontalFlip(false);
+}
+
+void AkVideoConverter::resetVerticalFlip()
+{
+    this->setVerticalFlip(false);
+}
+
+void AkVideoConverter::resetSwapRedBlue()
+{
+    this->setSwapRedBlue(false);
+}
+
 void AkVideoConverter::reset()
 {
     if (this->d->m_fc) {
@@ -8485,15 +8597,15 @@ QDebug operator <<(QDebug debug, AkVideoConverter::AspectRatioMode mode)
     case ConvertDataTypes_##isize##_##osize: \
         this->convert<quint##isize, quint##osize>(fc, \
                                                   packet, \
-                                                  fc.outputFrame); \
+                                                  dst); \
         \
         if (fc.toEndian != Q_BYTE_ORDER) \
-            AkAlgorithm::swapDataBytes(reinterpret_cast<quint##osize *>(fc.outputFrame.data()), fc.outputFrame.size()); \
+            AkAlgorithm::swapDataBytes(reinterpret_cast<quint##osize *>(dst.data()), dst.size()); \
         \
         break;
 
-AkVideoPacket AkVideoConverterPrivate::convert(const AkVideoPacket &packet,
-                                               const AkVideoCaps &ocaps)
+FrameConvertParameters *AkVideoConverterPrivate::frameConvertParameters(const AkVideoPacket &packet,
+                                                                        const AkVideoCaps &ocaps)
 {
     static const int maxCacheAlloc = 1 << 16;
 
@@ -8514,7 +8626,7 @@ AkVideoPacket AkVideoConverterPrivate::convert(const AkVideoPacket &packet,
     }
 
     if (this->m_cacheIndex >= maxCacheAlloc)
-        return {};
+        return nullptr;
 
     auto &fc = this->m_fc[this->m_cacheIndex];
 
@@ -8524,16 +8636,22 @@ AkVideoPacket AkVideoConverterPrivate::convert(const AkVideoPacket &packet,
         || this->m_yuvColorSpaceType != fc.yuvColorSpaceType
         || this->m_scalingMode != fc.scalingMode
         || this->m_aspectRatioMode != fc.aspectRatioMode
-        || this->m_inputRect != fc.inputRect) {
+        || this->m_inputRect != fc.inputRect
+        || this->m_horizontalFlip != fc.horizontalFlip
+        || this->m_verticalFlip != fc.verticalFlip
+        || this->m_swapRedBlue != fc.swapRedBlue) {
         fc.configure(packet.caps(),
                      ocaps,
                      fc.colorConvert,
                      this->m_yuvColorSpace,
-                     this->m_yuvColorSpaceType);
+                     this->m_yuvColorSpaceType,
+                     this->m_swapRedBlue);
         fc.configureScaling(packet.caps(),
                             ocaps,
                             this->m_inputRect,
-                            this->m_aspectRatioMode);
+                            this->m_aspectRatioMode,
+                            this->m_horizontalFlip,
+                            this->m_verticalFlip);
         fc.inputCaps = packet.caps();
         fc.outputCaps = ocaps;
         fc.yuvColorSpace = this->m_yuvColorSpace;
@@ -8541,16 +8659,20 @@ AkVideoPacket AkVideoConverterPrivate::convert(const AkVideoPacket &packet,
         fc.scalingMode = this->m_scalingMode;
         fc.aspectRatioMode = this->m_aspectRatioMode;
         fc.inputRect = this->m_inputRect;
+        fc.horizontalFlip = this->m_horizontalFlip;
+        fc.verticalFlip = this->m_verticalFlip;
+        fc.swapRedBlue = this->m_swapRedBlue;
     }
 
-    if (fc.outputConvertCaps.isSameFormat(packet.caps())) {
-        this->m_cacheIndex++;
-
-        return packet;
-    }
+    return &fc;
+}
 
+void AkVideoConverterPrivate::convertFrame(FrameConvertParameters &fc,
+                                           const AkVideoPacket &packet,
+                                           AkVideoPacket &dst)
+{
     if (fc.fastConvertion) {
-        this->convertFast8bits(fc, packet, fc.outputFrame);
+        this->convertFast8bits(fc, packet, dst);
     } else {
         switch (fc.convertDataTypes) {
         DEFINE_CONVERT_FUNC(8 , 8 )
@@ -8564,11 +8686,30 @@ AkVideoPacket AkVideoConverterPrivate::convert(const AkVideoPacket &packet,
         DEFINE_CONVERT_FUNC(32, 32)
         }
     }
+}
+
+AkVideoPacket AkVideoConverterPrivate::convert(const AkVideoPacket &packet,
+                                               const AkVideoCaps &ocaps)
+{
+    auto fc = this->frameConvertParameters(packet, ocaps);
+
+    if (!fc)
+        return {};
+
+    if (fc->outputConvertCaps.isSameFormat(packet.caps())
+        && !fc->horizontalFlip
+        && !fc->verticalFlip
+        && !fc->swapRedBlue) {
+        this->m_cacheIndex++;
 
-    fc.outputFrame.copyMetadata(packet);
+        return packet;
+    }
+
+    this->convertFrame(*fc, packet, fc->outputFrame);
+    fc->outputFrame.copyMetadata(packet);
     this->m_cacheIndex++;
 
-    return fc.outputFrame;
+    return fc->outputFrame;
 }
 
 FrameConvertParameters::FrameConvertParameters()
@@ -8582,6 +8723,9 @@ FrameConvertParameters::FrameConvertParameters(const FrameConvertParameters &oth
     outputFrame(other.outputFrame),
     scalingMode(other.scalingMode),
     aspectRatioMode(other.aspectRatioMode),
+    horizontalFlip(other.horizontalFlip),
+    verticalFlip(other.verticalFlip),
+    swapRedBlue(other.swapRedBlue),
     convertType(other.convertType),
     convertDataTypes(other.convertDataTypes),
     alphaMode(other.alphaMode),
@@ -8821,6 +8965,9 @@ FrameConvertParameters &FrameConvertParameters::operator =(const FrameConvertPar
         this->outputFrame = other.outputFrame;
         this->scalingMode = other.scalingMode;
         this->aspectRatioMode = other.aspectRatioMode;
+        this->horizontalFlip = other.horizontalFlip;
+        this->verticalFlip = other.verticalFlip;
+        this->swapRedBlue = other.swapRedBlue;
         this->convertType = other.convertType;
         this->convertDataTypes = other.convertDataTypes;
         this->alphaMode = other.alphaMode;
@@ -9263,7 +9410,8 @@ void FrameConvertParameters::configure(const AkVideoCaps &icaps,
                                        const AkVideoCaps &ocaps,
                                        AkColorConvert &colorConvert,
                                        AkColorConvert::YuvColorSpace yuvColorSpace,
-                                       AkColorConvert::YuvColorSpaceType yuvColorSpaceType)
+                                       AkColorConvert::YuvColorSpaceType yuvColorSpaceType,
+                                       bool swapRedBlue)
 {
     auto ispecs = AkVideoCaps::formatSpecs(icaps.format());
     auto oFormat = ocaps.format();
@@ -9303,15 +9451,28 @@ void FrameConvertParameters::configure(const AkVideoCaps &icaps,
     colorConvert.setYuvColorSpaceType(yuvColorSpaceType);
     colorConvert.loadMatrix(ispecs, ospecs);
 
+    /* Red and blue are swapped by reading them swapped from the input frame,
+     * or by writing them swapped to the output frame if the input is not RGB.
+     */
+    auto swapInput = swapRedBlue
+                     && ispecs.type() == AkVideoFormatSpec::VFT_RGB;
+    auto swapOutput = swapRedBlue
+                      && !swapInput
+                      && ospecs.type() == AkVideoFormatSpec::VFT_RGB;
+    auto redi = swapInput? AkColorComponent::CT_B: AkColorComponent::CT_R;
+    auto bluei = swapInput? AkColorComponent::CT_R: AkColorComponent::CT_B;
+    auto redo = swapOutput? AkColorComponent::CT_B: AkColorComponent::CT_R;
+    auto blueo = swapOutput? AkColorComponent::CT_R: AkColorComponent::CT_B;
+
     switch (ispecs.type()) {
     case AkVideoFormatSpec::VFT_RGB:
-        this->planeXi = ispecs.componentPlane(AkColorComponent::CT_R);
+        this->planeXi = ispecs.componentPlane(redi);
         this->planeYi = ispecs.componentPlane(AkColorComponent::CT_G);
-        this->planeZi = ispecs.componentPlane(AkColorComponent::CT_B);
+        this->planeZi = ispecs.componentPlane(bluei);
 
-        this->compXi = ispecs.component(AkColorComponent::CT_R);
+        this->compXi = ispecs.component(redi);
         this->compYi = ispecs.component(AkColorComponent::CT_G);
-        this->compZi = ispecs.component(AkColorComponent::CT_B);
+        this->compZi = ispecs.component(bluei);
 
         break;
 
@@ -9341,13 +9502,13 @@ void FrameConvertParameters::configure(const AkVideoCaps &icaps,
 
     switch (ospecs.type()) {
     case AkVideoFormatSpec::VFT_RGB:
-        this->planeXo = ospecs.componentPlane(AkColorComponent::CT_R);
+        this->planeXo = ospecs.componentPlane(redo);
         this->planeYo = ospecs.componentPlane(AkColorComponent::CT_G);
-        this->planeZo = ospecs.componentPlane(AkColorComponent::CT_B);
+        this->planeZo = ospecs.componentPlane(blueo);
 
-        this->compXo = ospecs.component(AkColorComponent::CT_R);
+        this->compXo = ospecs.component(redo);
         this->compYo = ospecs.component(AkColorComponent::CT_G);
-        this->compZo = ospecs.component(AkColorComponent::CT_B);
+        this->compZo = ospecs.component(blueo);
 
         break;
 
@@ -9546,7 +9707,9 @@ void FrameConvertParameters::configure(const AkVideoCaps &icaps,
 void FrameConvertParameters::configureScaling(const AkVideoCaps &icaps,
                                               const AkVideoCaps &ocaps,
                                               const QRect &inputRect,
-                                              AkVideoConverter::AspectRatioMode aspectRatioMode)
+                                              AkVideoConverter::AspectRatioMode aspectRatioMode,
+                                              bool horizontalFlip,
+                                              bool verticalFlip)
 {
     QRect irect(0, 0, icaps.width(), icaps.height());
 
@@ -9634,14 +9797,24 @@ void FrameConvertParameters::configureScaling(const AkVideoCaps &icaps,
         return ((x - xomin) * wi_1 + irect.x() * wo_1) / wo_1;
     };
 
+    /* The frame is flipped by reading the source pixels from the mirrored
+     * coordinates of the drawing area.
+     */
+    auto xFlip = [this, horizontalFlip] (int x) -> int {
+        return horizontalFlip && x >= this->xmin && x < this->xmax?
+                   this->xmin + this->xmax - 1 - x:
+                   x;
+    };
+
     for (int x = 0; x < this->outputConvertCaps.width(); ++x) {
-        auto xs = xDstToSrc(x);
-        auto xs_1 = xDstToSrc(qMin(x + 1, this->outputConvertCaps.width() - 1));
+        auto xf = xFlip(x);
+        auto xs = xDstToSrc(xf);
+        auto xs_1 = xDstToSrc(qMin(xf + 1, this->outputConvertCaps.width() - 1));
         auto xmin = xSrcToDst(xs);
         auto xmax = xSrcToDst(xs + 1);
 
         this->srcWidth[x]   = xs;
-        this->srcWidth_1[x] = qMin(xDstToSrc(x + 1), icaps.width());
+        this->srcWidth_1[x] = qMin(xDstToSrc(xf + 1), icaps.width());
         this->srcWidthOffsetX[x] = (xs >> this->compXi.widthDiv()) * this->compXi.step();
         this->srcWidthOffsetY[x] = (xs >> this->compYi.widthDiv()) * this->compYi.step();
         this->srcWidthOffsetZ[x] = (xs >> this->compZi.widthDiv()) * this->compZi.step();
@@ -9658,7 +9831,7 @@ void FrameConvertParameters::configureScaling(const AkVideoCaps &icaps,
         this->dstWidthOffsetA[x] = (x >> this->compAo.widthDiv()) * this->compAo.step();
 
         if (xmax > xmin)
-            this->kx[x] = SCALE_EMULT * (x - xmin) / (xmax - xmin);
+            this->kx[x] = SCALE_EMULT * (xf - xmin) / (xmax - xmin);
         else
             this->kx[x] = 0;
     }
@@ -9676,13 +9849,21 @@ void FrameConvertParameters::configureScaling(const AkVideoCaps &icaps,
         return ((y - yomin) * hi_1 + irect.y() * ho_1) / ho_1;
     };
 
+    auto yFlip = [this, verticalFlip] (int y) -> int {
+        return verticalFlip && y >= this->ymin && y < this->ymax?
+                   this->ymin + this->ymax - 1 - y:
+                   y;
+    };
+
     for (int y = 0; y < this->outputConvertCaps.height(); ++y) {
+        auto yf = yFlip(y);
+
         if (this->resizeMode == ResizeMode_Down) {
-            this->srcHeight[y] = yDstToSrc(y);
-            this->srcHeight_1[y] = qMin(yDstToSrc(y + 1), icaps.height());
+            this->srcHeight[y] = yDstToSrc(yf);
+            this->srcHeight_1[y] = qMin(yDstToSrc(yf + 1), icaps.height());
         } else {
-            auto ys = yDstToSrc(y);
-            auto ys_1 = yDstToSrc(qMin(y + 1, this->outputConvertCaps.height() - 1));
+            auto ys = yDstToSrc(yf);
+            auto ys_1 = yDstToSrc(qMin(yf + 1, this->outputConvertCaps.height() - 1));
             auto ymin = ySrcToDst(ys);
             auto ymax = ySrcToDst(ys + 1);
 
@@ -9690,7 +9871,7 @@ void FrameConvertParameters::configureScaling(const AkVideoCaps &icaps,
             this->srcHeight_1[y] = ys_1;
 
             if (ymax > ymin)
-                this->ky[y] = SCALE_EMULT * (y - ymin) / (ymax - ymin);
+                this->ky[y] = SCALE_EMULT * (yf - ymin) / (ymax - ymin);
             else
                 this->ky[y] = 0;
         }
@@ -9746,6 +9927,9 @@ void FrameConvertParameters::reset()
     this->outputFrame = AkVideoPacket();
     this->scalingMode = AkVideoConverter::ScalingMode_Fast;
     this->aspectRatioMode = AkVideoConverter::AspectRatioMode_Ignore;
+    this->horizontalFlip = false;
+    this->verticalFlip = false;
+    this->swapRedBlue = false;
     this->convertType = ConvertType_Vector;
     this->convertDataTypes = ConvertDataTypes_8_8;
     this->alphaMode = ConvertAlphaMode_AI_AO;
@@ -59,6 +59,21 @@ class AKCOMMONS_EXPORT AkVideoConverter: public QObject
                WRITE setInputRect
                RESET resetInputRect
                NOTIFY inputRectChanged)
+    Q_PROPERTY(bool horizontalFlip
+               READ horizontalFlip
+               WRITE setHorizontalFlip
+               RESET resetHorizontalFlip
+               NOTIFY horizontalFlipChanged)
+    Q_PROPERTY(bool verticalFlip
+               READ verticalFlip
+               WRITE setVerticalFlip
+               RESET resetVerticalFlip
+               NOTIFY verticalFlipChanged)
+    Q_PROPERTY(bool swapRedBlue
+               READ swapRedBlue
+               WRITE setSwapRedBlue
+               RESET resetSwapRedBlue
+               NOTIFY swapRedBlueChanged)
 
     public:
         enum ScalingMode {
@@ -90,11 +105,21 @@ class AKCOMMONS_EXPORT AkVideoConverter: public QObject
         Q_INVOKABLE AkVideoConverter::ScalingMode scalingMode() const;
         Q_INVOKABLE AkVideoConverter::AspectRatioMode aspectRatioMode() const;
         Q_INVOKABLE QRect inputRect() const;
+        Q_INVOKABLE bool horizontalFlip() const;
+        Q_INVOKABLE bool verticalFlip() const;
+        Q_INVOKABLE bool swapRedBlue() const;
 
         Q_INVOKABLE bool begin();
         Q_INVOKABLE void end();
         Q_INVOKABLE AkVideoPacket convert(const AkVideoPacket &packet);
 
+        /* Convert the packet directly into the buffer of the output packet,
+         * which must be writable and have the caps of the converted frame.
+         * The caps of the output packet are used as the output caps.
+         * Returns false if the frame can't be converted into the output.
+         */
+        bool convert(const AkVideoPacket &packet, AkVideoPacket &output);
+
     private:
         AkVideoConverterPrivate *d;
 
@@ -105,6 +130,9 @@ class AKCOMMONS_EXPORT AkVideoConverter: public QObject
         void scalingModeChanged(AkVideoConverter::ScalingMode scalingMode);
         void aspectRatioModeChanged(AkVideoConverter::AspectRatioMode aspectRatioMode);
         void inputRectChanged(const QRect &inputRect);
+        void horizontalFlipChanged(bool horizontalFlip);
+        void verticalFlipChanged(bool verticalFlip);
+        void swapRedBlueChanged(bool swapRedBlue);
 
     public Q_SLOTS:
         void setCacheIndex(int index);
@@ -114,12 +142,18 @@ class AKCOMMONS_EXPORT AkVideoConverter: public QObject
         void setScalingMode(AkVideoConverter::ScalingMode scalingMode);
         void setAspectRatioMode(AkVideoConverter::AspectRatioMode aspectRatioMode);
         void setInputRect(const QRect &inputRect);
+        void setHorizontalFlip(bool horizontalFlip);
+        void setVerticalFlip(bool verticalFlip);
+        void setSwapRedBlue(bool swapRedBlue);
         void resetOutputCaps();
         void resetYuvColorSpace();
         void resetYuvColorSpaceType();
         void resetScalingMode();
         void resetAspectRatioMode();
         void resetInputRect();
+        void resetHorizontalFlip();
+        void resetVerticalFlip();
+        void resetSwapRedBlue();
         void reset();
         static void registerTypes();
 };
@@ -0,0 +1,774 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QMutex>
+#include <QQmlEngine>
+#include <qrgb.h>
+
+#ifdef OPENMP_ENABLED
+#include <omp.h>
+#endif
+
+#include "akvideoconvolver.h"
+#include "akcpufeatures.h"
+#include "aksimd.h"
+#include "akvideocaps.h"
+#include "akvideopacket.h"
+
+// Number of fractional bits used for the output scaling factor.
+#define SCALE_SHIFT 16
+
+// Number of output lines processed by each thread in a row.
+#define BAND_HEIGHT 32
+
+using CreateConvolveParametersType =
+    void *(*)();
+using FreeConvolveParametersType =
+    void (*)(void *convolveParameters);
+using ConvolveLineHType =
+    void (*)(void *convolveParameters,
+             const qint32 *kernel,
+             int kernelSize,
+             int width,
+             const qint32 *src_line,
+             qint32 *dst_line,
+             int *x);
+using ConvolveLineVType =
+    void (*)(void *convolveParameters,
+             const qint32 *kernel,
+             int kernelSize,
+             int width,
+             const qint32 * const *src_lines,
+             qint32 *dst_line,
+             int *x);
+
+enum ConvolveFormat
+{
+    ConvolveFormat_Unknown,
+    ConvolveFormat_ARGB,
+    ConvolveFormat_YA,
+    ConvolveFormat_Y,
+};
+
+class AkVideoConvolverPrivate
+{
+    public:
+        QVector<int> m_kernel;
+        QSize m_kernelSize;
+        AkFrac m_factor {1, 1};
+        int m_bias {0};
+        QMutex m_mutex;
+
+        // Compiled kernel
+
+        bool m_separable {false};
+        QVector<qint32> m_kernel2D;
+        QVector<qint32> m_kernelH;
+        QVector<qint32> m_kernelV;
+        qint64 m_scale {1 << SCALE_SHIFT};
+        bool m_nullFactor {false};
+        bool m_simdExact {false};
+
+        // SIMD functions
+
+        void *m_simdConvolveParameters {nullptr};
+        CreateConvolveParametersType m_createSIMDConvolveParameters {nullptr};
+        FreeConvolveParametersType m_freeSIMDConvolveParameters {nullptr};
+        ConvolveLineHType m_convolveSIMDLineH {nullptr};
+        ConvolveLineVType m_convolveSIMDLineV {nullptr};
+        size_t m_parallelizationThreshold {0};
+
+        AkVideoConvolverPrivate();
+        ~AkVideoConvolverPrivate();
+        void loadSimd();
+        void updateKernel();
+        static ConvolveFormat convolveFormat(AkVideoCaps::PixelFormat format);
+        static int nChannels(ConvolveFormat format);
+        inline void convolveLineH(const qint32 *kernel,
+                                  int kernelSize,
+                                  int width,
+                                  const qint32 *srcLine,
+                                  qint32 *dstLine) const;
+        inline void convolveLineV(const qint32 *kernel,
+                                  int kernelSize,
+                                  int width,
+                                  const qint32 * const *srcLines,
+                                  qint32 *dstLine) const;
+        inline void unpackLine(ConvolveFormat format,
+                               const quint8 *srcLine,
+                               int width,
+                               int padLeft,
+                               int padRight,
+                               qint32 **dstLines) const;
+        inline void packLine(ConvolveFormat format,
+                             const quint8 *srcLine,
+                             const qint32 * const *accLines,
+                             int width,
+                             quint8 *dstLine) const;
+        void convolveBand(ConvolveFormat format,
+                          const AkVideoPacket &src,
+                          AkVideoPacket &dst,
+                          int yStart,
+                          int yEnd) const;
+};
+
+AkVideoConvolver::AkVideoConvolver(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoConvolverPrivate();
+    this->resetKernel();
+}
+
+AkVideoConvolver::AkVideoConvolver(const AkVideoConvolver &other):
+    QObject()
+{
+    this->d = new AkVideoConvolverPrivate();
+    this->d->m_kernel = other.d->m_kernel;
+    this->d->m_kernelSize = other.d->m_kernelSize;
+    this->d->m_factor = other.d->m_factor;
+    this->d->m_bias = other.d->m_bias;
+    this->d->updateKernel();
+}
+
+AkVideoConvolver::~AkVideoConvolver()
+{
+    delete this->d;
+}
+
+AkVideoConvolver &AkVideoConvolver::operator =(const AkVideoConvolver &other)
+{
+    if (this != &other) {
+        QMutexLocker locker(&this->d->m_mutex);
+        this->d->m_kernel = other.d->m_kernel;
+        this->d->m_kernelSize = other.d->m_kernelSize;
+        this->d->m_factor = other.d->m_factor;
+        this->d->m_bias = other.d->m_bias;
+        this->d->updateKernel();
+    }
+
+    return *this;
+}
+
+QObject *AkVideoConvolver::create()
+{
+    return new AkVideoConvolver();
+}
+
+QVector<int> AkVideoConvolver::kernel() const
+{
+    return this->d->m_kernel;
+}
+
+QSize AkVideoConvolver::kernelSize() const
+{
+    return this->d->m_kernelSize;
+}
+
+AkFrac AkVideoConvolver::factor() const
+{
+    return this->d->m_factor;
+}
+
+int AkVideoConvolver::bias() const
+{
+    return this->d->m_bias;
+}
+
+bool AkVideoConvolver::isSeparable() const
+{
+    return this->d->m_separable;
+}
+
+AkVideoPacket AkVideoConvolver::convolve(const AkVideoPacket &packet)
+{
+    if (!packet)
+        return {};
+
+    auto format = AkVideoConvolverPrivate::convolveFormat(packet.caps().format());
+
+    if (format == ConvolveFormat_Unknown)
+        return {};
+
+    QMutexLocker locker(&this->d->m_mutex);
+
+    if (this->d->m_kernel2D.isEmpty())
+        return packet;
+
+    AkVideoPacket dst(packet.caps());
+    dst.copyMetadata(packet);
+
+    int height = packet.caps().height();
+    int nBands = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    bool paralelize =
+            nBands > 1
+            && packet.size() * size_t(this->d->m_kernel2D.size())
+               > this->d->m_parallelizationThreshold;
+
+    #pragma omp parallel for schedule(dynamic, 1) if(paralelize)
+    for (int band = 0; band < nBands; band++) {
+        int yStart = band * BAND_HEIGHT;
+        int yEnd = qMin(yStart + BAND_HEIGHT, height);
+        this->d->convolveBand(format, packet, dst, yStart, yEnd);
+    }
+
+    return dst;
+}
+
+void AkVideoConvolver::setKernel(const QVector<int> &kernel)
+{
+    if (this->d->m_kernel == kernel)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_kernel = kernel;
+    this->d->updateKernel();
+    this->d->m_mutex.unlock();
+    emit this->kernelChanged(kernel);
+}
+
+void AkVideoConvolver::setKernel(const QVector<int> &kernel,
+                                 const QSize &kernelSize)
+{
+    bool kernelChanged = this->d->m_kernel != kernel;
+    bool kernelSizeChanged = this->d->m_kernelSize != kernelSize;
+
+    if (!kernelChanged && !kernelSizeChanged)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_kernel = kernel;
+    this->d->m_kernelSize = kernelSize;
+    this->d->updateKernel();
+    this->d->m_mutex.unlock();
+
+    if (kernelChanged)
+        emit this->kernelChanged(kernel);
+
+    if (kernelSizeChanged)
+        emit this->kernelSizeChanged(kernelSize);
+}
+
+void AkVideoConvolver::setKernelSize(const QSize &kernelSize)
+{
+    if (this->d->m_kernelSize == kernelSize)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_kernelSize = kernelSize;
+    this->d->updateKernel();
+    this->d->m_mutex.unlock();
+    emit this->kernelSizeChanged(kernelSize);
+}
+
+void AkVideoConvolver::setFactor(const AkFrac &factor)
+{
+    if (this->d->m_factor == factor)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_factor = factor;
+    this->d->updateKernel();
+    this->d->m_mutex.unlock();
+    emit this->factorChanged(factor);
+}
+
+void AkVideoConvolver::setBias(int bias)
+{
+    if (this->d->m_bias == bias)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_bias = bias;
+    this->d->m_mutex.unlock();
+    emit this->biasChanged(bias);
+}
+
+void AkVideoConvolver::resetKernel()
+{
+    this->setKernel({0, 0, 0,
+                     0, 1, 0,
+                     0, 0, 0},
+                    {3, 3});
+}
+
+void AkVideoConvolver::resetKernelSize()
+{
+    this->setKernelSize({3, 3});
+}
+
+void AkVideoConvolver::resetFactor()
+{
+    this->setFactor({1, 1});
+}
+
+void AkVideoConvolver::resetBias()
+{
+    this->setBias(0);
+}
+
+void AkVideoConvolver::registerTypes()
+{
+    qRegisterMetaType<AkVideoConvolver>("AkVideoConvolver");
+    qmlRegisterSingletonType<AkVideoConvolver>("Ak", 1, 0, "AkVideoConvolver",
+                                               [] (QQmlEngine *qmlEngine,
+                                                   QJSEngine *jsEngine) -> QObject * {
+        Q_UNUSED(qmlEngine)
+        Q_UNUSED(jsEngine)
+
+        return new AkVideoConvolver();
+    });
+}
+
+AkVideoConvolverPrivate::AkVideoConvolverPrivate()
+{
+    this->loadSimd();
+}
+
+AkVideoConvolverPrivate::~AkVideoConvolverPrivate()
+{
+    if (this->m_freeSIMDConvolveParameters && this->m_simdConvolveParameters)
+        this->m_freeSIMDConvolveParameters(this->m_simdConvolveParameters);
+}
+
+void AkVideoConvolverPrivate::loadSimd()
+{
+    AkSimd simd("Core");
+
+    this->m_createSIMDConvolveParameters = reinterpret_cast<CreateConvolveParametersType>(simd.resolve("createConvolveParameters"));
+    this->m_freeSIMDConvolveParameters = reinterpret_cast<FreeConvolveParametersType>(simd.resolve("freeConvolveParameters"));
+    this->m_convolveSIMDLineH = reinterpret_cast<ConvolveLineHType>(simd.resolve("convolveLineH"));
+    this->m_convolveSIMDLineV = reinterpret_cast<ConvolveLineVType>(simd.resolve("convolveLineV"));
+
+    if (this->m_createSIMDConvolveParameters)
+        this->m_simdConvolveParameters = this->m_createSIMDConvolveParameters();
+
+    // Roughly one multiply-add per byte per kernel tap.
+    this->m_parallelizationThreshold =
+            AkCpuFeatures::paralellizableBytesThreshold(2,
+                                                        simd.loadedInstructionSet());
+}
+
+void AkVideoConvolverPrivate::updateKernel()
+{
+    this->m_kernel2D.clear();
+    this->m_kernelH.clear();
+    this->m_kernelV.clear();
+    this->m_separable = false;
+    this->m_simdExact = false;
+
+    int kw = this->m_kernelSize.width();
+    int kh = this->m_kernelSize.height();
+
+    if (kw < 1 || kh < 1 || this->m_kernel.size() < kw * kh)
+        return;
+
+    for (int i = 0; i < kw * kh; i++)
+        this->m_kernel2D << this->m_kernel[i];
+
+    /* The SIMD code may be running with floats, which are exact only up to
+     * 24 bits. The sum of the absolute values of the kernel bounds every
+     * partial sum of both the 2D and the separable passes, since the
+     * separated kernel is the exact factorization of the 2D one.
+     */
+    qint64 kernelNorm = 0;
+
+    for (auto &k: this->m_kernel2D)
+        kernelNorm += qAbs(k);
+
+    this->m_simdExact = 255 * kernelNorm < (1 << 24);
+
+    auto num = this->m_factor.num();
+    auto den = this->m_factor.den();
+    this->m_nullFactor = num == 0 || den == 0;
+    this->m_scale = this->m_nullFactor? 0: (num << SCALE_SHIFT) / den;
+
+    /* Find a pivot element and check if all the 2x2 minors involving it are
+     * zero, in that case the kernel is the outer product of the pivot column
+     * and the pivot row.
+     */
+    int pivotRow = -1;
+    int pivotCol = -1;
+
+    for (int i = 0; i < kw * kh; i++)
+        if (this->m_kernel2D[i]) {
+            pivotRow = i / kw;
+            pivotCol = i % kw;
+
+            break;
+        }
+
+    if (pivotRow < 0)
+        return;
+
+    qint64 pivot = this->m_kernel2D[pivotRow * kw + pivotCol];
+
+    for (int y = 0; y < kh; y++)
+        for (int x = 0; x < kw; x++) {
+            qint64 a = this->m_kernel2D[y * kw + x];
+            qint64 b = this->m_kernel2D[y * kw + pivotCol];
+            qint64 c = this->m_kernel2D[pivotRow * kw + x];
+
+            if (a * pivot != b * c)
+                return;
+        }
+
+    /* Normalize the row by the GCD of its elements, then the column elements
+     * are guaranteed to be integers.
+     */
+    int gcd = 0;
+
+    for (int x = 0; x < kw; x++) {
+        int a = qAbs(this->m_kernel2D[pivotRow * kw + x]);
+        int b = gcd;
+
+        while (b) {
+            auto t = a % b;
+            a = b;
+            b = t;
+        }
+
+        gcd = a;
+    }
+
+    for (int x = 0; x < kw; x++)
+        this->m_kernelH << this->m_kernel2D[pivotRow * kw + x] / gcd;
+
+    for (int y = 0; y < kh; y++)
+        this->m_kernelV << qint32(this->m_kernel2D[y * kw + pivotCol]
+                                  * qint64(gcd) / pivot);
+
+    // Only worth it if it saves multiplications.
+    this->m_separable = kw > 1 && kh > 1;
+}
+
+ConvolveFormat AkVideoConvolverPrivate::convolveFormat(AkVideoCaps::PixelFormat format)
+{
+    switch (format) {
+    case AkVideoCaps::Format_argbpack:
+        return ConvolveFormat_ARGB;
+    case AkVideoCaps::Format_ya88pack:
+        return ConvolveFormat_YA;
+    case AkVideoCaps::Format_y8:
+        return ConvolveFormat_Y;
+    default:
+        break;
+    }
+
+    return ConvolveFormat_Unknown;
+}
+
+int AkVideoConvolverPrivate::nChannels(ConvolveFormat format)
+{
+    return format == ConvolveFormat_ARGB? 3: 1;
+}
+
+void AkVideoConvolverPrivate::convolveLineH(const qint32 *kernel,
+                                            int kernelSize,
+                                            int width,
+                                            const qint32 *srcLine,
+                                            qint32 *dstLine) const
+{
+    int x = 0;
+
+    if (this->m_convolveSIMDLineH && this->m_simdExact)
+        this->m_convolveSIMDLineH(this->m_simdConvolveParameters,
+                                  kernel,
+                                  kernelSize,
+                                  width,
+                                  srcLine,
+                                  dstLine,
+                                  &x);
+
+    for (int k = 0; k < kernelSize; k++) {
+        auto &kv = kernel[k];
+
+        if (!kv)
+            continue;
+
+        auto src = srcLine + k;
+
+        for (int i = x; i < width; i++)
+            dstLine[i] += kv * src[i];
+    }
+}
+
+void AkVideoConvolverPrivate::convolveLineV(const qint32 *kernel,
+                                            int kernelSize,
+                                            int width,
+                                            const qint32 * const *srcLines,
+                                            qint32 *dstLine) const
+{
+    int x = 0;
+
+    if (this->m_convolveSIMDLineV && this->m_simdExact)
+        this->m_convolveSIMDLineV(this->m_simdConvolveParameters,
+                                  kernel,
+                                  kernelSize,
+                                  width,
+                                  srcLines,
+                                  dstLine,
+                                  &x);
+
+    for (int i = x; i < width; i++)
+        dstLine[i] = 0;
+
+    for (int k = 0; k < kernelSize; k++) {
+        auto &kv = kernel[k];
+
+        if (!kv)
+            continue;
+
+        auto src = srcLines[k];
+
+        for (int i = x; i < width; i++)
+            dstLine[i] += kv * src[i];
+    }
+}
+
+void AkVideoConvolverPrivate::unpackLine(ConvolveFormat format,
+                                         const quint8 *srcLine,
+                                         int width,
+                                         int padLeft,
+                                         int padRight,
+                                         qint32 **dstLines) const
+{
+    switch (format) {
+    case ConvolveFormat_ARGB: {
+        auto line = reinterpret_cast<const QRgb *>(srcLine);
+        auto r = dstLines[0] + padLeft;
+        auto g = dstLines[1] + padLeft;
+        auto b = dstLines[2] + padLeft;
+
+        for (int x = 0; x < width; x++) {
+            auto &pixel = line[x];
+            r[x] = qRed(pixel);
+            g[x] = qGreen(pixel);
+            b[x] = qBlue(pixel);
+        }
+
+        break;
+    }
+    case ConvolveFormat_YA: {
+        auto line = reinterpret_cast<const quint16 *>(srcLine);
+        auto y = dstLines[0] + padLeft;
+
+        for (int x = 0; x < width; x++)
+            y[x] = line[x] >> 8;
+
+        break;
+    }
+    case ConvolveFormat_Y: {
+        auto y = dstLines[0] + padLeft;
+
+        for (int x = 0; x < width; x++)
+            y[x] = srcLine[x];
+
+        break;
+    }
+    default:
+        break;
+    }
+
+    // Replicate the border pixels.
+
+    for (int c = 0; c < nChannels(format); c++) {
+        auto line = dstLines[c];
+
+        for (int x = 0; x < padLeft; x++)
+            line[x] = line[padLeft];
+
+        auto last = line[padLeft + width - 1];
+
+        for (int x = 0; x < padRight; x++)
+            line[padLeft + width + x] = last;
+    }
+}
+
+void AkVideoConvolverPrivate::packLine(ConvolveFormat format,
+                                       const quint8 *srcLine,
+                                       const qint32 * const *accLines,
+                                       int width,
+                                       quint8 *dstLine) const
+{
+    auto scale = this->m_scale;
+    auto bias = (qint64(this->m_bias) << SCALE_SHIFT)
+                + (qint64(1) << (SCALE_SHIFT - 1));
+    auto nullFactor = this->m_nullFactor;
+
+#define SCALE_VALUE(acc) \
+    (nullFactor? 255: qBound<qint64>(0, (qint64(acc) * scale + bias) >> SCALE_SHIFT, 255))
+
+    switch (format) {
+    case ConvolveFormat_ARGB: {
+        auto iLine = reinterpret_cast<const QRgb *>(srcLine);
+        auto oLine = reinterpret_cast<QRgb *>(dstLine);
+        auto r = accLines[0];
+        auto g = accLines[1];
+        auto b = accLines[2];
+
+        for (int x = 0; x < width; x++)
+            oLine[x] = qRgba(int(SCALE_VALUE(r[x])),
+                             int(SCALE_VALUE(g[x])),
+                             int(SCALE_VALUE(b[x])),
+                             qAlpha(iLine[x]));
+
+        break;
+    }
+    case ConvolveFormat_YA: {
+        auto iLine = reinterpret_cast<const quint16 *>(srcLine);
+        auto oLine = reinterpret_cast<quint16 *>(dstLine);
+        auto y = accLines[0];
+
+        for (int x = 0; x < width; x++)
+            oLine[x] = quint16(SCALE_VALUE(y[x]) << 8) | (iLine[x] & 0xff);
+
+        break;
+    }
+    case ConvolveFormat_Y: {
+        auto y = accLines[0];
+
+        for (int x = 0; x < width; x++)
+            dstLine[x] = quint8(SCALE_VALUE(y[x]));
+
+        break;
+    }
+    default:
+        break;
+    }
+
+#undef SCALE_VALUE
+}
+
+void AkVideoConvolverPrivate::convolveBand(ConvolveFormat format,
+                                           const AkVideoPacket &src,
+                                           AkVideoPacket &dst,
+                                           int yStart,
+                                           int yEnd) const
+{
+    int width = src.caps().width();
+    int height = src.caps().height();
+    int kw = this->m_kernelSize.width();
+    int kh = this->m_kernelSize.height();
+    int padLeft = (kw - 1) / 2;
+    int padRight = kw - 1 - padLeft;
+    int padTop = (kh - 1) / 2;
+    int paddedWidth = width + kw - 1;
+    int channels = nChannels(format);
+
+    // Input lines needed for computing this band.
+    int bandLines = yEnd - yStart + kh - 1;
+
+    qint32 *unpacked[3];
+    qint32 *acc[3];
+
+    if (this->m_separable) {
+        /* First pass: filter every input line horizontally, the second pass
+         * combines the filtered lines vertically.
+         */
+        QVector<qint32> padded(channels * paddedWidth);
+        QVector<qint32> filtered(channels * bandLines * width);
+        QVector<qint32> accBuffer(channels * width);
+        QVector<const qint32 *> lines(kh);
+
+        for (int c = 0; c < channels; c++) {
+            unpacked[c] = padded.data() + c * paddedWidth;
+            acc[c] = accBuffer.data() + c * width;
+        }
+
+        for (int line = 0; line < bandLines; line++) {
+            int y = qBound(0, yStart - padTop + line, height - 1);
+            this->unpackLine(format,
+                             src.constLine(0, y),
+                             width,
+                             padLeft,
+                             padRight,
+                             unpacked);
+
+            for (int c = 0; c < channels; c++) {
+                auto filteredLine =
+                        filtered.data() + (c * bandLines + line) * width;
+                memset(filteredLine, 0, width * sizeof(qint32));
+                this->convolveLineH(this->m_kernelH.constData(),
+                                    kw,
+                                    width,
+                                    unpacked[c],
+                                    filteredLine);
+            }
+        }
+
+        for (int y = yStart; y < yEnd; y++) {
+            for (int c = 0; c < channels; c++) {
+                auto channelLines =
+                        filtered.constData() + c * bandLines * width;
+
+                for (int k = 0; k < kh; k++)
+                    lines[k] = channelLines + (y - yStart + k) * width;
+
+                this->convolveLineV(this->m_kernelV.constData(),
+                                    kh,
+                                    width,
+                                    lines.constData(),
+                                    acc[c]);
+            }
+
+            this->packLine(format, src.constLine(0, y), acc, width, dst.line(0, y));
+        }
+    } else {
+        QVector<qint32> padded(channels * bandLines * paddedWidth);
+        QVector<qint32> accBuffer(channels * width);
+
+        for (int c = 0; c < channels; c++)
+            acc[c] = accBuffer.data() + c * width;
+
+        for (int line = 0; line < bandLines; line++) {
+            int y = qBound(0, yStart - padTop + line, height - 1);
+
+            for (int c = 0; c < channels; c++)
+                unpacked[c] = padded.data() + (c * bandLines + line) * paddedWidth;
+
+            this->unpackLine(format,
+                             src.constLine(0, y),
+                             width,
+                             padLeft,
+                             padRight,
+                             unpacked);
+        }
+
+        auto kernel = this->m_kernel2D.constData();
+
+        for (int y = yStart; y < yEnd; y++) {
+            for (int c = 0; c < channels; c++) {
+                memset(acc[c], 0, width * sizeof(qint32));
+                auto channelLines =
+                        padded.constData() + c * bandLines * paddedWidth;
+
+                for (int k = 0; k < kh; k++)
+                    this->convolveLineH(kernel + k * kw,
+                                        kw,
+                                        width,
+                                        channelLines + (y - yStart + k) * paddedWidth,
+                                        acc[c]);
+            }
+
+            this->packLine(format, src.constLine(0, y), acc, width, dst.line(0, y));
+        }
+    }
+}
+
+#include "moc_akvideoconvolver.cpp"
@@ -0,0 +1,109 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKVIDEOCONVOLVER_H
+#define AKVIDEOCONVOLVER_H
+
+#include <QObject>
+#include <QSize>
+#include <QVector>
+
+#include "akfrac.h"
+
+class AkVideoConvolverPrivate;
+class AkVideoPacket;
+
+/* Integer 2D convolution of video frames.
+ *
+ * Rank-1 kernels are detected automatically and applied as a horizontal pass
+ * followed by a vertical one. The borders are handled by clamping the input
+ * lines into padded buffers, and the frame is processed in bands of rows
+ * that are distributed between the available threads. The result is scaled
+ * by the factor and rounded to the nearest integer.
+ *
+ * Supported formats are argbpack (RGB convolved, alpha kept), ya88pack
+ * (luma convolved, alpha kept) and y8.
+ */
+class AKCOMMONS_EXPORT AkVideoConvolver: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVector<int> kernel
+               READ kernel
+               WRITE setKernel
+               RESET resetKernel
+               NOTIFY kernelChanged)
+    Q_PROPERTY(QSize kernelSize
+               READ kernelSize
+               WRITE setKernelSize
+               RESET resetKernelSize
+               NOTIFY kernelSizeChanged)
+    Q_PROPERTY(AkFrac factor
+               READ factor
+               WRITE setFactor
+               RESET resetFactor
+               NOTIFY factorChanged)
+    Q_PROPERTY(int bias
+               READ bias
+               WRITE setBias
+               RESET resetBias
+               NOTIFY biasChanged)
+    Q_PROPERTY(bool isSeparable
+               READ isSeparable
+               NOTIFY kernelChanged)
+
+    public:
+        AkVideoConvolver(QObject *parent=nullptr);
+        AkVideoConvolver(const AkVideoConvolver &other);
+        ~AkVideoConvolver();
+        AkVideoConvolver &operator =(const AkVideoConvolver &other);
+
+        Q_INVOKABLE static QObject *create();
+
+        Q_INVOKABLE QVector<int> kernel() const;
+        Q_INVOKABLE QSize kernelSize() const;
+        Q_INVOKABLE AkFrac factor() const;
+        Q_INVOKABLE int bias() const;
+        Q_INVOKABLE bool isSeparable() const;
+        Q_INVOKABLE AkVideoPacket convolve(const AkVideoPacket &packet);
+
+    private:
+        AkVideoConvolverPrivate *d;
+
+    Q_SIGNALS:
+        void kernelChanged(const QVector<int> &kernel);
+        void kernelSizeChanged(const QSize &kernelSize);
+        void factorChanged(const AkFrac &factor);
+        void biasChanged(int bias);
+
+    public Q_SLOTS:
+        void setKernel(const QVector<int> &kernel);
+        void setKernel(const QVector<int> &kernel, const QSize &kernelSize);
+        void setKernelSize(const QSize &kernelSize);
+        void setFactor(const AkFrac &factor);
+        void setBias(int bias);
+        void resetKernel();
+        void resetKernelSize();
+        void resetFactor();
+        void resetBias();
+        static void registerTypes();
+};
+
+Q_DECLARE_METATYPE(AkVideoConvolver)
+
+#endif // AKVIDEOCONVOLVER_H
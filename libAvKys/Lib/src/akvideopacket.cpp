@@ -21,6 +21,7 @@
 #include <QVariant>
 #include <QImage>
 #include <QQmlEngine>
+#include <QSharedPointer>
 
 #include "akvideopacket.h"
 #include "akalgorithm.h"
@@ -128,9 +129,15 @@ class AkVideoPacketPrivate
         size_t m_heightDiv[MAX_PLANES];
         size_t m_align {32};
         FillParametersPtr m_fc;
+        QSharedPointer<quint8> m_externalData;
+        bool m_externalWritable {false};
+        QVector<QRect> m_dirtyRegion;
 
         void updateParams(const AkVideoFormatSpec &specs);
         inline void updatePlanes();
+        inline void copyData(const AkVideoPacketPrivate *other);
+        inline void freeData();
+        inline void detach();
 
         /* Fill functions */
 
@@ -413,6 +420,53 @@ AkVideoPacket::AkVideoPacket(const AkVideoCaps &caps, bool initialized):
     this->d->updatePlanes();
 }
 
+AkVideoPacket::AkVideoPacket(const AkVideoCaps &caps,
+                             quint8 *data,
+                             size_t dataSize,
+                             const size_t *lineSize,
+                             ExternalDataRelease release,
+                             void *userData,
+                             bool writable):
+    AkPacketBase()
+{
+    this->d = new AkVideoPacketPrivate;
+    this->d->m_caps = caps;
+    this->d->m_align = AkSimd::preferredAlign();
+    auto specs = AkVideoCaps::formatSpecs(this->d->m_caps.format());
+    this->d->m_nPlanes = specs.planes();
+    this->d->updateParams(specs);
+
+    // Replace the default layout with the layout of the external buffer.
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < this->d->m_nPlanes; ++i) {
+        this->d->m_lineSize[i] = lineSize[i];
+        this->d->m_planeSize[i] =
+                (lineSize[i] * this->d->m_caps.height()) >> this->d->m_heightDiv[i];
+        this->d->m_planeOffset[i] = offset;
+        offset += this->d->m_planeSize[i];
+    }
+
+    if (data && offset > 0 && offset <= dataSize) {
+        this->d->m_data = data;
+        this->d->m_dataSize = dataSize;
+        this->d->m_externalData =
+                QSharedPointer<quint8>(data, [release, userData] (quint8 *) {
+                    if (release)
+                        release(userData);
+                });
+        this->d->m_externalWritable = writable;
+        this->d->updatePlanes();
+    } else {
+        // The buffer is too small for the frame, release it right now.
+        this->d->m_dataSize = 0;
+
+        if (release)
+            release(userData);
+    }
+}
+
 AkVideoPacket::AkVideoPacket(const AkPacket &other):
     AkPacketBase(other)
 {
@@ -422,11 +476,7 @@ AkVideoPacket::AkVideoPacket(const AkPacket &other):
         auto data = reinterpret_cast<AkVideoPacket *>(other.privateData());
         this->d->m_caps = data->d->m_caps;
 
-        if (data->d->m_data && data->d->m_dataSize > 0) {
-                this->d->m_data =
-                        AkSimd::amallocT<quint8>(data->d->m_dataSize, data->d->m_align);
-                memcpy(this->d->m_data, data->d->m_data, data->d->m_dataSize);
-        }
+        this->d->copyData(data->d);
 
         this->d->m_dataSize = data->d->m_dataSize;
         this->d->m_nPlanes = data->d->m_nPlanes;
@@ -444,6 +494,7 @@ AkVideoPacket::AkVideoPacket(const AkPacket &other):
 
         this->d->m_align = data->d->m_align;
         this->d->m_fc = data->d->m_fc;
+        this->d->m_dirtyRegion = data->d->m_dirtyRegion;
         this->d->updatePlanes();
     }
 }
@@ -454,11 +505,7 @@ AkVideoPacket::AkVideoPacket(const AkVideoPacket &other):
     this->d = new AkVideoPacketPrivate;
     this->d->m_caps = other.d->m_caps;
 
-    if (other.d->m_data && other.d->m_dataSize > 0) {
-        this->d->m_data =
-                AkSimd::amallocT<quint8>(other.d->m_dataSize, other.d->m_align);
-        memcpy(this->d->m_data, other.d->m_data, other.d->m_dataSize);
-    }
+    this->d->copyData(other.d);
 
     this->d->m_dataSize = other.d->m_dataSize;
     this->d->m_nPlanes = other.d->m_nPlanes;
@@ -476,14 +523,13 @@ AkVideoPacket::AkVideoPacket(const AkVideoPacket &other):
 
     this->d->m_align = other.d->m_align;
     this->d->m_fc = other.d->m_fc;
+    this->d->m_dirtyRegion = other.d->m_dirtyRegion;
     this->d->updatePlanes();
 }
 
 AkVideoPacket::~AkVideoPacket()
 {
-    if (this->d->m_data)
-        AkSimd::afree(this->d->m_data);
-
+    this->d->freeData();
     delete this->d;
 }
 
@@ -493,16 +539,9 @@ AkVideoPacket &AkVideoPacket::operator =(const AkPacket &other)
         auto data = reinterpret_cast<AkVideoPacket *>(other.privateData());
         this->d->m_caps = data->d->m_caps;
 
-        if (this->d->m_data) {
-            AkSimd::afree(this->d->m_data);
-            this->d->m_data = nullptr;
-        }
+        this->d->freeData();
 
-        if (data->d->m_data && data->d->m_dataSize > 0) {
-            this->d->m_data =
-                    AkSimd::amallocT<quint8>(data->d->m_dataSize, data->d->m_align);
-            memcpy(this->d->m_data, data->d->m_data, data->d->m_dataSize);
-        }
+        this->d->copyData(data->d);
 
         this->d->m_dataSize = data->d->m_dataSize;
         this->d->m_nPlanes = data->d->m_nPlanes;
@@ -520,18 +559,17 @@ AkVideoPacket &AkVideoPacket::operator =(const AkPacket &other)
 
         this->d->m_align = data->d->m_align;
         this->d->m_fc = data->d->m_fc;
+        this->d->m_dirtyRegion = data->d->m_dirtyRegion;
         this->d->updatePlanes();
     } else {
         this->d->m_caps = AkVideoCaps();
 
-        if (this->d->m_data) {
-            AkSimd::afree(this->d->m_data);
-            this->d->m_data = nullptr;
-        }
+        this->d->freeData();
 
         this->d->m_dataSize = 0;
         this->d->m_nPlanes = 0;
         this->d->m_align = AkSimd::preferredAlign();
+        this->d->m_dirtyRegion.clear();
     }
 
     this->copyMetadata(other);
@@ -544,16 +582,9 @@ AkVideoPacket &AkVideoPacket::operator =(const AkVideoPacket &other)
     if (this != &other) {
         this->d->m_caps = other.d->m_caps;
 
-        if (this->d->m_data) {
-            AkSimd::afree(this->d->m_data);
-            this->d->m_data = nullptr;
-        }
+        this->d->freeData();
 
-        if (other.d->m_data && other.d->m_dataSize > 0) {
-            this->d->m_data =
-                    AkSimd::amallocT<quint8>(other.d->m_dataSize, other.d->m_align);
-            memcpy(this->d->m_data, other.d->m_data, other.d->m_dataSize);
-        }
+        this->d->copyData(other.d);
 
         this->d->m_dataSize = other.d->m_dataSize;
         this->d->m_nPlanes = other.d->m_nPlanes;
@@ -571,6 +602,7 @@ AkVideoPacket &AkVideoPacket::operator =(const AkVideoPacket &other)
         this->copyMetadata(other);
         this->d->m_align = other.d->m_align;
         this->d->m_fc = other.d->m_fc;
+        this->d->m_dirtyRegion = other.d->m_dirtyRegion;
         this->d->updatePlanes();
     }
 
@@ -648,8 +680,15 @@ const char *AkVideoPacket::constData() const
     return reinterpret_cast<char *>(this->d->m_data);
 }
 
+bool AkVideoPacket::isExternal() const
+{
+    return !this->d->m_externalData.isNull();
+}
+
 char *AkVideoPacket::data()
 {
+    this->d->detach();
+
     return reinterpret_cast<char *>(this->d->m_data);
 }
 
@@ -660,6 +699,8 @@ const quint8 *AkVideoPacket::constPlane(int plane) const
 
 quint8 *AkVideoPacket::plane(int plane)
 {
+    this->d->detach();
+
     return this->d->m_planes[plane];
 }
 
@@ -672,6 +713,8 @@ const quint8 *AkVideoPacket::constLine(int plane, int y) const
 
 quint8 *AkVideoPacket::line(int plane, int y)
 {
+    this->d->detach();
+
     return this->d->m_planes[plane]
             + size_t(y >> this->d->m_heightDiv[plane])
             * this->d->m_lineSize[plane];
@@ -717,8 +760,59 @@ AkVideoPacket AkVideoPacket::copy(int x, int y, int width, int height) const
     return dst;
 }
 
+AkVideoPacket AkVideoPacket::toExternal() const
+{
+    /* The external buffer layout packs the planes without the alignment
+     * padding, so the planes size must be computed the same way.
+     */
+    size_t planeSize[MAX_PLANES];
+    size_t dataSize = 0;
+
+    for (size_t plane = 0; plane < this->d->m_nPlanes; ++plane) {
+        planeSize[plane] =
+                (this->d->m_lineSize[plane] * this->d->m_caps.height())
+                >> this->d->m_heightDiv[plane];
+        dataSize += planeSize[plane];
+    }
+
+    if (dataSize < 1)
+        return {};
+
+    auto data = AkSimd::amallocT<quint8>(dataSize, AkSimd::preferredAlign());
+    auto dst = data;
+
+    for (size_t plane = 0; plane < this->d->m_nPlanes; ++plane) {
+        memcpy(dst, this->d->m_planes[plane], planeSize[plane]);
+        dst += planeSize[plane];
+    }
+
+    AkVideoPacket packet(this->d->m_caps,
+                         data,
+                         dataSize,
+                         this->d->m_lineSize,
+                         [] (void *userData) {
+                             AkSimd::afree(userData);
+                         },
+                         data);
+    packet.copyMetadata(*this);
+
+    return packet;
+}
+
+QVector<QRect> AkVideoPacket::dirtyRegion() const
+{
+    return this->d->m_dirtyRegion;
+}
+
+void AkVideoPacket::setDirtyRegion(const QVector<QRect> &dirtyRegion)
+{
+    this->d->m_dirtyRegion = dirtyRegion;
+}
+
 void AkVideoPacket::fillRgb(QRgb color)
 {
+    this->d->detach();
+
     return this->d->fill(color);
 }
 
@@ -813,6 +907,47 @@ void AkVideoPacketPrivate::updatePlanes()
         this->m_planes[i] = this->m_data + this->m_planeOffset[i];
 }
 
+void AkVideoPacketPrivate::copyData(const AkVideoPacketPrivate *other)
+{
+    // External buffers are shared between the copies of the packet.
+    if (other->m_externalData) {
+        this->m_data = other->m_data;
+        this->m_externalData = other->m_externalData;
+        this->m_externalWritable = other->m_externalWritable;
+    } else if (other->m_data && other->m_dataSize > 0) {
+        this->m_data =
+                AkSimd::amallocT<quint8>(other->m_dataSize, other->m_align);
+        memcpy(this->m_data, other->m_data, other->m_dataSize);
+    }
+}
+
+void AkVideoPacketPrivate::freeData()
+{
+    if (this->m_externalData) {
+        this->m_externalData.clear();
+        this->m_externalWritable = false;
+        this->m_data = nullptr;
+    } else if (this->m_data) {
+        AkSimd::afree(this->m_data);
+        this->m_data = nullptr;
+    }
+}
+
+void AkVideoPacketPrivate::detach()
+{
+    /* Copy the external buffer before writing on it, so the other packets
+     * and the owner of the buffer does not see the changes.
+     */
+    if (!this->m_externalData || this->m_externalWritable)
+        return;
+
+    auto data = AkSimd::amallocT<quint8>(this->m_dataSize, this->m_align);
+    memcpy(data, this->m_data, this->m_dataSize);
+    this->m_externalData.clear();
+    this->m_data = data;
+    this->updatePlanes();
+}
+
 #define DEFINE_FILL_FUNC(size) \
     case FillDataTypes_##size: \
         this->fill<quint##size>(*this->m_fc, color); \
@@ -20,6 +20,7 @@
 #ifndef AKVIDEOPACKET_H
 #define AKVIDEOPACKET_H
 
+#include <QRect>
 #include <qrgb.h>
 
 #include "akpacketbase.h"
@@ -77,8 +78,26 @@ class AKCOMMONS_EXPORT AkVideoPacket: public AkPacketBase
                CONSTANT)
 
     public:
+        using ExternalDataRelease = void (*)(void *userData);
+
         AkVideoPacket(QObject *parent=nullptr);
         AkVideoPacket(const AkVideoCaps &caps, bool initialized=false);
+
+        /* Wrap an external buffer without copying it.
+         *
+         * The planes are stored one after the other with the given line
+         * sizes. The buffer is shared between all the copies of the packet,
+         * and release is called with userData once the last of them is
+         * destroyed. Writing to the packet copies the buffer first, unless
+         * the buffer is writable, then the changes go straight to the buffer.
+         */
+        AkVideoPacket(const AkVideoCaps &caps,
+                      quint8 *data,
+                      size_t dataSize,
+                      const size_t *lineSize,
+                      ExternalDataRelease release,
+                      void *userData,
+                      bool writable=false);
         AkVideoPacket(const AkPacket &other);
         AkVideoPacket(const AkVideoPacket &other);
         ~AkVideoPacket();
@@ -96,6 +115,7 @@ class AKCOMMONS_EXPORT AkVideoPacket: public AkPacketBase
         Q_INVOKABLE size_t bytesUsed(int plane) const;
         Q_INVOKABLE size_t widthDiv(int plane) const;
         Q_INVOKABLE size_t heightDiv(int plane) const;
+        Q_INVOKABLE bool isExternal() const;
         Q_INVOKABLE const char *constData() const;
         Q_INVOKABLE char *data();
         Q_INVOKABLE const quint8 *constPlane(int plane) const;
@@ -107,6 +127,19 @@ class AKCOMMONS_EXPORT AkVideoPacket: public AkPacketBase
                                        int width,
                                        int height) const;
 
+        /* Copy the frame to an external buffer. The copies of the returned
+         * packet share that buffer instead of copying the frame, useful for
+         * frames that are cached and sent many times.
+         */
+        Q_INVOKABLE AkVideoPacket toExternal() const;
+
+        /* Areas of the frame that changed since the previous frame of the
+         * same stream. An empty list means that the whole frame must be
+         * considered changed.
+         */
+        Q_INVOKABLE QVector<QRect> dirtyRegion() const;
+        Q_INVOKABLE void setDirtyRegion(const QVector<QRect> &dirtyRegion);
+
         template <typename T>
         inline T pixel(int plane, int x, int y) const
         {
@@ -20,8 +20,26 @@
 #include <QVariant>
 
 #include "akvideoencoder.h"
+#include "../akfrac.h"
 #include "../akvideocaps.h"
 
+// Smoothing factor of the encoding load average.
+#define SPEED_GOVERNOR_SMOOTHING 0.1
+
+/* The encoder goes faster when the frames take more than this fraction of the
+ * frame duration, and slower when they take less than the lower limit.
+ * The gap between both limits avoids switching back and forth.
+ */
+#define SPEED_GOVERNOR_HIGH_LOAD 0.85
+#define SPEED_GOVERNOR_LOW_LOAD  0.5
+
+/* Time in seconds to wait after changing the speed before changing it again,
+ * going slower waits longer since it's the step that can cause the encoder to
+ * fall behind.
+ */
+#define SPEED_GOVERNOR_FASTER_HOLD 1
+#define SPEED_GOVERNOR_SLOWER_HOLD 5
+
 class AkVideoEncoderPrivate
 {
     public:
@@ -30,7 +48,19 @@ class AkVideoEncoderPrivate
         int m_bitrate {1500000};
         int m_gop {1000};
         bool m_fillGaps {false};
+        bool m_adaptiveSpeed {false};
         QVariantMap m_optionValues;
+
+        // Speed governor
+        qreal m_frameDuration {0.0};
+        qreal m_load {-1.0};
+        qreal m_lag {0.0};
+        int m_speedLevel {0};
+        int m_maxSpeedLevel {0};
+        int m_fasterHold {0};
+        int m_slowerHold {0};
+        int m_holdFrames {0};
+        quint64 m_droppedFrames {0};
 };
 
 AkVideoEncoder::AkVideoEncoder(QObject *parent):
@@ -74,6 +104,21 @@ bool AkVideoEncoder::fillGaps() const
     return this->d->m_fillGaps;
 }
 
+bool AkVideoEncoder::adaptiveSpeed() const
+{
+    return this->d->m_adaptiveSpeed;
+}
+
+int AkVideoEncoder::speedLevel() const
+{
+    return this->d->m_speedLevel;
+}
+
+quint64 AkVideoEncoder::droppedFrames() const
+{
+    return this->d->m_droppedFrames;
+}
+
 AkPropertyOptions AkVideoEncoder::options() const
 {
     return {};
@@ -159,6 +204,15 @@ void AkVideoEncoder::setFillGaps(bool fillGaps)
     emit this->fillGapsChanged(fillGaps);
 }
 
+void AkVideoEncoder::setAdaptiveSpeed(bool adaptiveSpeed)
+{
+    if (this->d->m_adaptiveSpeed == adaptiveSpeed)
+        return;
+
+    this->d->m_adaptiveSpeed = adaptiveSpeed;
+    emit this->adaptiveSpeedChanged(adaptiveSpeed);
+}
+
 void AkVideoEncoder::setOptionValue(const QString &option, const QVariant &value)
 {
     auto curValue = this->optionValue(option);
@@ -215,6 +269,11 @@ void AkVideoEncoder::resetFillGaps()
     this->setFillGaps(false);
 }
 
+void AkVideoEncoder::resetAdaptiveSpeed()
+{
+    this->setAdaptiveSpeed(false);
+}
+
 void AkVideoEncoder::resetOptionValue(const QString &option)
 {
     auto options = this->options();
@@ -245,4 +304,83 @@ void AkVideoEncoder::resetOptions()
         this->resetOptionValue(option.name());
 }
 
+void AkVideoEncoder::startSpeedGovernor(const AkFrac &fps, int maxSpeedLevel)
+{
+    auto frameRate = fps? fps.value(): 30.0;
+    this->d->m_frameDuration = 1e9 / frameRate;
+    this->d->m_load = -1.0;
+    this->d->m_lag = 0.0;
+    this->d->m_maxSpeedLevel = qMax(maxSpeedLevel, 0);
+    this->d->m_fasterHold = qMax(qRound(SPEED_GOVERNOR_FASTER_HOLD * frameRate), 1);
+    this->d->m_slowerHold = qMax(qRound(SPEED_GOVERNOR_SLOWER_HOLD * frameRate), 1);
+    this->d->m_holdFrames = this->d->m_fasterHold;
+
+    if (this->d->m_speedLevel != 0) {
+        this->d->m_speedLevel = 0;
+        emit this->speedLevelChanged(0);
+    }
+
+    if (this->d->m_droppedFrames != 0) {
+        this->d->m_droppedFrames = 0;
+        emit this->droppedFramesChanged(0);
+    }
+}
+
+int AkVideoEncoder::updateSpeedGovernor(qint64 encodingTime)
+{
+    if (this->d->m_frameDuration <= 0.0)
+        return this->d->m_speedLevel;
+
+    /* Accumulate the time the encoder spent over the frame duration, each
+     * frame duration of delay is a frame the encoder couldn't take in time.
+     * The time left over by the fast frames pays off the delay.
+     */
+    this->d->m_lag = qMax(this->d->m_lag
+                          + qreal(encodingTime)
+                          - this->d->m_frameDuration,
+                          0.0);
+
+    if (this->d->m_lag >= this->d->m_frameDuration) {
+        auto frames = quint64(this->d->m_lag / this->d->m_frameDuration);
+        this->d->m_lag -= qreal(frames) * this->d->m_frameDuration;
+        this->d->m_droppedFrames += frames;
+        emit this->droppedFramesChanged(this->d->m_droppedFrames);
+    }
+
+    if (!this->d->m_adaptiveSpeed || this->d->m_maxSpeedLevel < 1)
+        return this->d->m_speedLevel;
+
+    auto load = qreal(encodingTime) / this->d->m_frameDuration;
+
+    if (this->d->m_load < 0.0)
+        this->d->m_load = load;
+    else
+        this->d->m_load += SPEED_GOVERNOR_SMOOTHING * (load - this->d->m_load);
+
+    // Give the encoder some time to settle after the last change.
+    if (this->d->m_holdFrames > 0) {
+        this->d->m_holdFrames--;
+
+        return this->d->m_speedLevel;
+    }
+
+    auto speedLevel = this->d->m_speedLevel;
+
+    if (this->d->m_load > SPEED_GOVERNOR_HIGH_LOAD
+        && speedLevel < this->d->m_maxSpeedLevel) {
+        speedLevel++;
+        this->d->m_holdFrames = this->d->m_fasterHold;
+    } else if (this->d->m_load < SPEED_GOVERNOR_LOW_LOAD && speedLevel > 0) {
+        speedLevel--;
+        this->d->m_holdFrames = this->d->m_slowerHold;
+    }
+
+    if (this->d->m_speedLevel != speedLevel) {
+        this->d->m_speedLevel = speedLevel;
+        emit this->speedLevelChanged(speedLevel);
+    }
+
+    return speedLevel;
+}
+
 #include "moc_akvideoencoder.cpp"
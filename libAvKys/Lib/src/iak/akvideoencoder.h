@@ -29,6 +29,7 @@
 class AkVideoEncoder;
 class AkVideoEncoderPrivate;
 class AkVideoCaps;
+class AkFrac;
 
 using AkVideoEncoderPtr = QSharedPointer<AkVideoEncoder>;
 using AkVideoEncoderCodecID = AkCompressedVideoCaps::VideoCodecID;
@@ -73,6 +74,17 @@ class AKCOMMONS_EXPORT AkVideoEncoder: public AkElement
                WRITE setFillGaps
                RESET resetFillGaps
                NOTIFY fillGapsChanged)
+    Q_PROPERTY(bool adaptiveSpeed
+               READ adaptiveSpeed
+               WRITE setAdaptiveSpeed
+               RESET resetAdaptiveSpeed
+               NOTIFY adaptiveSpeedChanged)
+    Q_PROPERTY(int speedLevel
+               READ speedLevel
+               NOTIFY speedLevelChanged)
+    Q_PROPERTY(quint64 droppedFrames
+               READ droppedFrames
+               NOTIFY droppedFramesChanged)
     Q_PROPERTY(AkPropertyOptions options
                READ options
                NOTIFY optionsChanged)
@@ -92,10 +104,32 @@ class AKCOMMONS_EXPORT AkVideoEncoder: public AkElement
         Q_INVOKABLE virtual QByteArray headers() const;
         Q_INVOKABLE virtual qint64 encodedTimePts() const = 0;
         Q_INVOKABLE bool fillGaps() const;
+        Q_INVOKABLE bool adaptiveSpeed() const;
+
+        /* Number of steps the encoder is running faster than the configured
+         * speed, 0 means the encoder is using the configured speed.
+         */
+        Q_INVOKABLE int speedLevel() const;
+
+        /* Frames that couldn't be encoded in time, estimated from the time
+         * the encoder spent over the frame duration.
+         */
+        Q_INVOKABLE quint64 droppedFrames() const;
+
         Q_INVOKABLE virtual AkPropertyOptions options() const;
         Q_INVOKABLE QVariant optionValue(const QString &option) const;
         Q_INVOKABLE bool isOptionSet(const QString &option) const;
 
+        /* Restart the speed governor, maxSpeedLevel is the number of steps
+         * the encoder can go faster than the configured speed.
+         */
+        void startSpeedGovernor(const AkFrac &fps, int maxSpeedLevel);
+
+        /* Report the time in nanoseconds that took encoding the last frame.
+         * Returns the speed level the encoder must use for the next frame.
+         */
+        int updateSpeedGovernor(qint64 encodingTime);
+
     private:
         AkVideoEncoderPrivate *d;
 
@@ -108,6 +142,9 @@ class AKCOMMONS_EXPORT AkVideoEncoder: public AkElement
         void headersChanged(const QByteArray &headers);
         void encodedTimePtsChanged(qint64 encodedTimePts);
         void fillGapsChanged(bool fillGaps);
+        void adaptiveSpeedChanged(bool adaptiveSpeed);
+        void speedLevelChanged(int speedLevel);
+        void droppedFramesChanged(quint64 droppedFrames);
         void optionsChanged(const AkPropertyOptions &options);
         void optionValueChanged(const QString &option, const QVariant &value);
 
@@ -117,12 +154,14 @@ class AKCOMMONS_EXPORT AkVideoEncoder: public AkElement
         void setBitrate(int bitrate);
         void setGop(int gop);
         void setFillGaps(bool fillGaps);
+        void setAdaptiveSpeed(bool adaptiveSpeed);
         void setOptionValue(const QString &option, const QVariant &value);
         void resetCodec();
         void resetInputCaps();
         void resetBitrate();
         void resetGop();
         void resetFillGaps();
+        void resetAdaptiveSpeed();
         void resetOptionValue(const QString &option);
         virtual void resetOptions();
 };
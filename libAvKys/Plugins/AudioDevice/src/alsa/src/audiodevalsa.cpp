@@ -270,6 +270,48 @@ QByteArray AudioDevAlsa::read()
     return buffer;
 }
 
+bool AudioDevAlsa::readPacket(AkAudioPacket &packet)
+{
+    QMutexLocker mutexLocker(&this->d->m_mutex);
+
+    if (!this->d->m_pcmHnd)
+        return false;
+
+    auto samples = snd_pcm_sframes_t(packet.samples());
+    auto data = packet.data();
+
+    while (samples > 0) {
+        auto rsamples = snd_pcm_readi(this->d->m_pcmHnd,
+                                      data,
+                                      snd_pcm_uframes_t(samples));
+
+        if (rsamples >= 0) {
+            data += snd_pcm_frames_to_bytes(this->d->m_pcmHnd, rsamples);
+            samples -= rsamples;
+        } else if (rsamples == -EAGAIN) {
+            snd_pcm_wait(this->d->m_pcmHnd, 1000);
+        } else if (rsamples == -EPIPE) {
+            // The capture buffer overflowed, restart the stream.
+            if (snd_pcm_prepare(this->d->m_pcmHnd) < 0)
+                return false;
+
+            this->addXrun();
+        } else {
+            return false;
+        }
+    }
+
+    // Samples captured by the device that were not read yet.
+    snd_pcm_sframes_t delay = 0;
+
+    if (snd_pcm_delay(this->d->m_pcmHnd, &delay) < 0)
+        delay = 0;
+
+    this->timestampPacket(packet, qMax<qint64>(delay, 0));
+
+    return true;
+}
+
 bool AudioDevAlsa::write(const AkAudioPacket &packet)
 {
     QMutexLocker mutexLocker(&this->d->m_mutex);
@@ -17,6 +17,8 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <atomic>
+#include <QElapsedTimer>
 #include <QVector>
 #include <akaudiopacket.h>
 
@@ -28,7 +30,14 @@ class AudioDevPrivate
 {
     public:
         QVector<int> m_commonSampleRates;
+        QElapsedTimer m_clock;
+        qint64 m_position {0};
+        qint64 m_clockOffset {0};
+        qint64 m_lastPts {-1};
+        std::atomic<qint64> m_drift {0};
+        std::atomic<quint64> m_xruns {0};
         int m_latency {25};
+        bool m_xrunPending {false};
 };
 
 AudioDev::AudioDev(QObject *parent):
@@ -62,6 +71,16 @@ int AudioDev::latency() const
     return this->d->m_latency;
 }
 
+qint64 AudioDev::drift() const
+{
+    return this->d->m_drift;
+}
+
+quint64 AudioDev::xruns() const
+{
+    return this->d->m_xruns;
+}
+
 const QVector<int> &AudioDev::commonSampleRates() const
 {
     return this->d->m_commonSampleRates;
@@ -140,6 +159,28 @@ QByteArray AudioDev::read()
     return {};
 }
 
+bool AudioDev::readPacket(AkAudioPacket &packet)
+{
+    // Fallback for the backends that can only return a new buffer.
+    auto buffer = this->read();
+
+    if (buffer.isEmpty())
+        return false;
+
+    auto caps = packet.caps();
+    size_t samples = 8 * buffer.size() / (caps.channels() * caps.bps());
+
+    if (samples != packet.samples())
+        packet = AkAudioPacket(caps, samples);
+
+    memcpy(packet.data(),
+           buffer.constData(),
+           qMin<size_t>(packet.size(), buffer.size()));
+    this->timestampPacket(packet, 0);
+
+    return true;
+}
+
 bool AudioDev::write(const AkAudioPacket &packet)
 {
     Q_UNUSED(packet)
@@ -166,4 +207,77 @@ void AudioDev::resetLatency()
     this->setLatency(25);
 }
 
+void AudioDev::resetClock()
+{
+    this->d->m_clock.invalidate();
+    this->d->m_position = 0;
+    this->d->m_clockOffset = 0;
+    this->d->m_lastPts = -1;
+    this->d->m_xrunPending = false;
+
+    if (this->d->m_drift.exchange(0) != 0)
+        Q_EMIT this->driftChanged(0);
+
+    if (this->d->m_xruns.exchange(0) != 0)
+        Q_EMIT this->xrunsChanged(0);
+}
+
+void AudioDev::timestampPacket(AkAudioPacket &packet, qint64 latency)
+{
+    auto rate = packet.caps().rate();
+
+    if (rate < 1)
+        return;
+
+    auto samples = qint64(packet.samples());
+
+    // The samples captured by the device until now.
+    auto deviceSamples = this->d->m_position + samples + latency;
+
+    if (!this->d->m_clock.isValid()) {
+        this->d->m_clock.start();
+        this->d->m_clockOffset = deviceSamples;
+    }
+
+    // The samples that should have been captured according to the system.
+    auto systemSamples =
+            qRound64(qreal(this->d->m_clock.nsecsElapsed()) * rate / 1e9)
+            + this->d->m_clockOffset;
+
+    if (this->d->m_xrunPending) {
+        auto lostSamples = systemSamples - deviceSamples;
+
+        if (lostSamples > 0) {
+            this->d->m_position += lostSamples;
+            deviceSamples += lostSamples;
+        }
+
+        this->d->m_xrunPending = false;
+    }
+
+    /* The first sample of the packet was captured samples + latency samples
+     * before now. The reading thread can wake up late, but then the device
+     * buffers more samples, so the capture time doesn't depend on when the
+     * packet is read. The clock offset makes the first packet start at 0.
+     */
+    auto pts = qMax(systemSamples - samples - latency,
+                    this->d->m_lastPts + 1);
+    this->d->m_lastPts = pts;
+    packet.setPts(pts);
+    packet.setDuration(samples);
+    packet.setTimeBase({1, rate});
+    this->d->m_position += samples;
+
+    auto drift = 1000 * (deviceSamples - systemSamples) / rate;
+
+    if (this->d->m_drift.exchange(drift) != drift)
+        Q_EMIT this->driftChanged(drift);
+}
+
+void AudioDev::addXrun()
+{
+    this->d->m_xrunPending = true;
+    Q_EMIT this->xrunsChanged(++this->d->m_xruns);
+}
+
 #include "moc_audiodev.cpp"
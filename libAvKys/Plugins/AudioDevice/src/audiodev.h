@@ -36,12 +36,21 @@ class AudioDev: public QObject
     Q_PROPERTY(QString error
                READ error
                NOTIFY errorChanged)
+    // Difference between the device clock and the system clock, in milliseconds
+    Q_PROPERTY(qint64 drift
+               READ drift
+               NOTIFY driftChanged)
+    Q_PROPERTY(quint64 xruns
+               READ xruns
+               NOTIFY xrunsChanged)
 
     public:
         AudioDev(QObject *parent=nullptr);
         virtual ~AudioDev();
 
         Q_INVOKABLE int latency() const;
+        Q_INVOKABLE qint64 drift() const;
+        Q_INVOKABLE quint64 xruns() const;
         Q_INVOKABLE const QVector<int> &commonSampleRates() const;
         Q_INVOKABLE virtual QString error() const;
         Q_INVOKABLE virtual QString defaultInput();
@@ -55,15 +64,35 @@ class AudioDev: public QObject
         Q_INVOKABLE virtual QList<int> supportedSampleRates(const QString &device);
         Q_INVOKABLE virtual bool init(const QString &device, const AkAudioCaps &caps);
         Q_INVOKABLE virtual QByteArray read();
+
+        /* Read the captured samples straight into the memory of the packet,
+         * and timestamp it with the clock of the device.
+         */
+        virtual bool readPacket(AkAudioPacket &packet);
         Q_INVOKABLE virtual bool write(const AkAudioPacket &packet);
         Q_INVOKABLE virtual bool uninit();
 
     private:
         AudioDevPrivate *d;
 
+    protected:
+        /* Set the pts of the packet to the capture time of its first sample,
+         * in samples since the first packet. latency is the number of samples
+         * still buffered in the device after the last sample of the packet.
+         */
+        void timestampPacket(AkAudioPacket &packet, qint64 latency);
+
+        /* Notify an overrun of the capture buffer. The timestamps are
+         * realigned with the system clock on the next packet, so the samples
+         * lost leave a gap instead of delaying the rest of the stream.
+         */
+        void addXrun();
+
     Q_SIGNALS:
         void latencyChanged(int latency);
         void errorChanged(const QString &error);
+        void driftChanged(qint64 drift);
+        void xrunsChanged(quint64 xruns);
         void defaultInputChanged(const QString &defaultInput);
         void defaultOutputChanged(const QString &defaultOutput);
         void inputsChanged(const QStringList &inputs);
@@ -72,6 +101,7 @@ class AudioDev: public QObject
     public Q_SLOTS:
         void setLatency(int latency);
         void resetLatency();
+        void resetClock();
 };
 
 #endif // AUDIODEV_H
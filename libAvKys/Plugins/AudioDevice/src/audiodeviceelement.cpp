@@ -88,6 +88,14 @@ AudioDeviceElement::AudioDeviceElement():
                          &AudioDev::latencyChanged,
                          this,
                          &AudioDeviceElement::latencyChanged);
+        QObject::connect(this->d->m_audioDevice.data(),
+                         &AudioDev::driftChanged,
+                         this,
+                         &AudioDeviceElement::driftChanged);
+        QObject::connect(this->d->m_audioDevice.data(),
+                         &AudioDev::xrunsChanged,
+                         this,
+                         &AudioDeviceElement::xrunsChanged);
         QObject::connect(this->d->m_audioDevice.data(),
                          &AudioDev::inputsChanged,
                          this,
@@ -184,6 +192,30 @@ int AudioDeviceElement::latency() const
     return 25;
 }
 
+qint64 AudioDeviceElement::drift() const
+{
+    this->d->m_mutexLib.lock();
+    auto audioDevice = this->d->m_audioDevice;
+    this->d->m_mutexLib.unlock();
+
+    if (audioDevice)
+        return audioDevice->drift();
+
+    return 0;
+}
+
+quint64 AudioDeviceElement::xruns() const
+{
+    this->d->m_mutexLib.lock();
+    auto audioDevice = this->d->m_audioDevice;
+    this->d->m_mutexLib.unlock();
+
+    if (audioDevice)
+        return audioDevice->xruns();
+
+    return 0;
+}
+
 AkAudioCaps AudioDeviceElement::caps() const
 {
     return this->d->m_caps;
@@ -295,8 +327,8 @@ void AudioDeviceElementPrivate::readFramesLoop()
     qint64 streamId = Ak::id();
 
     if (audioDevice->init(device, caps)) {
-        QElapsedTimer et;
-        et.start();
+        audioDevice->resetClock();
+        size_t samples = qMax(audioDevice->latency() * caps.rate() / 1000, 1);
 
         while (this->m_readFramesLoop) {
             if (this->m_pause) {
@@ -305,19 +337,12 @@ void AudioDeviceElementPrivate::readFramesLoop()
                 continue;
             }
 
-            auto buffer = audioDevice->read();
+            // The device writes the samples and the timestamps to the packet.
+            AkAudioPacket packet(caps, samples);
 
-            if (buffer.isEmpty())
+            if (!audioDevice->readPacket(packet))
                 continue;
 
-            size_t samples = 8 * buffer.size() / (caps.channels() * caps.bps());
-            AkAudioPacket packet(caps, samples);
-            memcpy(packet.data(),
-                   buffer.constData(),
-                   qMin<size_t>(packet.size(), buffer.size()));
-            packet.setPts(et.elapsed() * caps.rate() / 1000);
-            packet.setDuration(samples);
-            packet.setTimeBase({1, caps.rate()});
             packet.setIndex(0);
             packet.setId(streamId);
 
@@ -388,6 +413,14 @@ void AudioDeviceElementPrivate::linksChanged(const AkPluginLinks &links)
                      &AudioDev::latencyChanged,
                      self,
                      &AudioDeviceElement::latencyChanged);
+    QObject::connect(this->m_audioDevice.data(),
+                     &AudioDev::driftChanged,
+                     self,
+                     &AudioDeviceElement::driftChanged);
+    QObject::connect(this->m_audioDevice.data(),
+                     &AudioDev::xrunsChanged,
+                     self,
+                     &AudioDeviceElement::xrunsChanged);
     QObject::connect(this->m_audioDevice.data(),
                      &AudioDev::inputsChanged,
                      self,
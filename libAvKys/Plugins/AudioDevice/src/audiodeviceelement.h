@@ -56,6 +56,13 @@ class AudioDeviceElement: public AkElement
                WRITE setCaps
                RESET resetCaps
                NOTIFY capsChanged)
+    // In milliseconds
+    Q_PROPERTY(qint64 drift
+               READ drift
+               NOTIFY driftChanged)
+    Q_PROPERTY(quint64 xruns
+               READ xruns
+               NOTIFY xrunsChanged)
 
     public:
         AudioDeviceElement();
@@ -69,6 +76,8 @@ class AudioDeviceElement: public AkElement
         Q_INVOKABLE QString device() const;
         Q_INVOKABLE int latency() const;
         Q_INVOKABLE AkAudioCaps caps() const;
+        Q_INVOKABLE qint64 drift() const;
+        Q_INVOKABLE quint64 xruns() const;
         Q_INVOKABLE AkAudioCaps preferredFormat(const QString &device);
         Q_INVOKABLE QList<AkAudioCaps::SampleFormat> supportedFormats(const QString &device);
         Q_INVOKABLE QList<AkAudioCaps::ChannelLayout> supportedChannelLayouts(const QString &device);
@@ -88,6 +97,8 @@ class AudioDeviceElement: public AkElement
         void deviceChanged(const QString &device);
         void latencyChanged(int latency);
         void capsChanged(const AkAudioCaps &caps);
+        void driftChanged(qint64 drift);
+        void xrunsChanged(quint64 xruns);
 
     public slots:
         void setDevice(const QString &device);
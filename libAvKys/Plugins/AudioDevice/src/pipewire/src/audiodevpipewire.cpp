@@ -17,7 +17,9 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <atomic>
 #include <QCoreApplication>
+#include <QDeadlineTimer>
 #include <QDir>
 #include <QMap>
 #include <QMutex>
@@ -152,6 +154,10 @@ class AudioDevPipeWirePrivate
         AkAudioCaps m_deviceCaps;
         AkAudioCaps m_curCaps;
         QByteArray m_buffers;
+        QByteArray m_ring;
+        std::atomic<size_t> m_ringRead {0};
+        std::atomic<size_t> m_ringWrite {0};
+        std::atomic<bool> m_ringOverflow {false};
         AkAudioConverter m_audioConvert;
         size_t m_maxBufferSize {0};
         bool m_isCapture {false};
@@ -497,19 +503,101 @@ bool AudioDevPipeWire::init(const QString &device, const AkAudioCaps &caps)
 
 QByteArray AudioDevPipeWire::read()
 {
-    QMutexLocker mutexLocker(&this->d->m_mutex);
+    AkAudioPacket packet(this->d->m_curCaps,
+                         qMax(this->latency() * this->d->m_curCaps.rate() / 1000, 1));
 
-    if (!this->d->m_pwStream)
+    if (!this->readPacket(packet))
         return {};
 
-    if (this->d->m_buffers.isEmpty())
-        if (!this->d->m_bufferIsNotEmpty.wait(&this->d->m_mutex, 1000))
-            return {};
+    return {packet.constData(), int(packet.size())};
+}
 
-    auto buffers = this->d->m_buffers;
-    this->d->m_buffers.clear();
+bool AudioDevPipeWire::readPacket(AkAudioPacket &packet)
+{
+    QMutexLocker mutexLocker(&this->d->m_mutex);
+
+    if (!this->d->m_pwStream || !this->d->m_isCapture)
+        return false;
+
+    QDeadlineTimer deadline(1000);
+
+    // The ring is allocated once the stream negotiated the format.
+    while (this->d->m_ring.isEmpty()) {
+        if (deadline.hasExpired())
+            return false;
+
+        this->d->m_bufferIsNotEmpty.wait(&this->d->m_mutex, 10);
+
+        if (!this->d->m_pwStream)
+            return false;
+    }
+
+    auto ringSize = size_t(this->d->m_ring.size());
+
+    // Never wait for more data than half the ring can hold.
+    auto readSize = qMin(packet.size(), ringSize / 2);
+    auto readPos = this->d->m_ringRead.load(std::memory_order_relaxed);
+
+    /* The process callback doesn't lock the mutex, so a wake up can be lost,
+     * check the ring again after a short while.
+     */
+    while (this->d->m_ringWrite.load(std::memory_order_acquire) - readPos < readSize) {
+        if (deadline.hasExpired())
+            return false;
+
+        this->d->m_bufferIsNotEmpty.wait(&this->d->m_mutex, 10);
+
+        if (!this->d->m_pwStream)
+            return false;
+    }
+
+    auto offset = readPos % ringSize;
+    auto firstPart = qMin(readSize, ringSize - offset);
+    memcpy(packet.data(), this->d->m_ring.constData() + offset, firstPart);
+
+    if (readSize > firstPart)
+        memcpy(packet.data() + firstPart,
+               this->d->m_ring.constData(),
+               readSize - firstPart);
+
+    this->d->m_ringRead.store(readPos + readSize, std::memory_order_release);
+
+    if (this->d->m_ringOverflow.exchange(false))
+        this->addXrun();
+
+    // Samples waiting in the ring plus the samples queued in the graph.
+    auto frameSize = size_t(this->d->m_deviceCaps.bps()
+                            * this->d->m_deviceCaps.channels()
+                            / 8);
+    qint64 latency = 0;
+
+    if (frameSize > 0)
+        latency = qint64((this->d->m_ringWrite.load(std::memory_order_acquire)
+                          - readPos
+                          - readSize)
+                         / frameSize);
+
+    pw_time time;
+    memset(&time, 0, sizeof(pw_time));
+
+#if PW_CHECK_VERSION(0, 3, 50)
+    auto result = pw_stream_get_time_n(this->d->m_pwStream,
+                                       &time,
+                                       sizeof(pw_time));
+#else
+    auto result = pw_stream_get_time(this->d->m_pwStream, &time);
+#endif
+
+    if (result >= 0 && time.rate.denom > 0)
+        latency += time.delay
+                   * time.rate.num
+                   * packet.caps().rate()
+                   / time.rate.denom;
+
+    mutexLocker.unlock();
+    this->timestampPacket(packet, qMax<qint64>(latency, 0));
 
-    return buffers;
+    return true;
 }
 
 bool AudioDevPipeWire::write(const AkAudioPacket &packet)
@@ -558,7 +646,13 @@ bool AudioDevPipeWire::uninit()
         this->d->m_pwStreamLoop = nullptr;
     }
 
+    this->d->m_mutex.lock();
     this->d->m_buffers.clear();
+    this->d->m_ring.clear();
+    this->d->m_ringRead = 0;
+    this->d->m_ringWrite = 0;
+    this->d->m_ringOverflow = false;
+    this->d->m_mutex.unlock();
 
     return true;
 }
@@ -849,6 +943,21 @@ void AudioDevPipeWirePrivate::onParamChanged(void *userData,
         self->m_audioConvert.setOutputCaps(self->m_deviceCaps);
         self->m_audioConvert.reset();
 
+        /* The captured samples are copied to a ring allocated just once,
+         * so the real time thread never allocates memory nor waits for the
+         * reader.
+         */
+        if (self->m_isCapture) {
+            self->m_mutex.lock();
+            self->m_ring = QByteArray(int(2 * self->m_maxBufferSize),
+                                      Qt::Uninitialized);
+            self->m_ringRead = 0;
+            self->m_ringWrite = 0;
+            self->m_ringOverflow = false;
+            self->m_bufferIsNotEmpty.wakeAll();
+            self->m_mutex.unlock();
+        }
+
         break;
     }
 
@@ -870,48 +979,63 @@ void AudioDevPipeWirePrivate::onProcess(void *userData)
 
     auto data = reinterpret_cast<quint8 *>(buffer->buffer->datas[0].data);
 
-    QMutexLocker mutexLocker(&self->m_mutex);
-
     if (self->m_isCapture) {
-        auto dataSize = buffer->buffer->datas[0].chunk->size;
-        QByteArray buffer(reinterpret_cast<char *>(data), dataSize);
-
-        if (dataSize >= self->m_maxBufferSize) {
-            self->m_buffers = buffer;
-        } else {
-            auto totalSize = qMin<size_t>(self->m_buffers.size() + dataSize,
-                                          self->m_maxBufferSize);
-            auto prevSize = totalSize - dataSize;
-            self->m_buffers =
-                    self->m_buffers.mid(self->m_buffers.size() - int(prevSize),
-                                        int(prevSize))
-                    + buffer;
+        auto chunk = buffer->buffer->datas[0].chunk;
+        auto ringSize = size_t(self->m_ring.size());
+        size_t dataSize = chunk->size;
+
+        if (ringSize > 0 && dataSize > 0) {
+            auto writePos = self->m_ringWrite.load(std::memory_order_relaxed);
+            auto readPos = self->m_ringRead.load(std::memory_order_acquire);
+            auto freeSize = ringSize - (writePos - readPos);
+
+            // Keep the samples already queued and drop the new ones.
+            if (dataSize > freeSize) {
+                dataSize = freeSize;
+                self->m_ringOverflow = true;
+            }
+
+            auto offset = writePos % ringSize;
+            auto firstPart = qMin(dataSize, ringSize - offset);
+            auto ring = self->m_ring.data();
+            memcpy(ring + offset, data + chunk->offset, firstPart);
+
+            if (dataSize > firstPart)
+                memcpy(ring, data + chunk->offset + firstPart, dataSize - firstPart);
+
+            self->m_ringWrite.store(writePos + dataSize,
+                                    std::memory_order_release);
+            self->m_bufferIsNotEmpty.wakeAll();
         }
 
-        self->m_bufferIsNotEmpty.wakeAll();
-    } else {
-        auto dataSize = buffer->buffer->datas[0].maxsize;
-        auto copySize = qMin<qsizetype>(dataSize, self->m_buffers.size());
+        pw_stream_queue_buffer(self->m_pwStream, buffer);
+
+        return;
+    }
+
+    QMutexLocker mutexLocker(&self->m_mutex);
 
-        if (copySize > 0)
-            memcpy(data, self->m_buffers.constData(), copySize);
+    auto dataSize = buffer->buffer->datas[0].maxsize;
+    auto copySize = qMin<qsizetype>(dataSize, self->m_buffers.size());
 
-        auto remainingSize = self->m_buffers.size() - copySize;
+    if (copySize > 0)
+        memcpy(data, self->m_buffers.constData(), copySize);
 
-        if (remainingSize > 0)
-            self->m_buffers = self->m_buffers.mid(copySize, remainingSize);
-        else
-            self->m_buffers.clear();
+    auto remainingSize = self->m_buffers.size() - copySize;
 
-        if (self->m_buffers.size() < self->m_maxBufferSize)
-            self->m_bufferIsNotFull.wakeAll();
+    if (remainingSize > 0)
+        self->m_buffers = self->m_buffers.mid(copySize, remainingSize);
+    else
+        self->m_buffers.clear();
 
-        if (copySize > 0) {
-            auto chunk = buffer->buffer->datas[0].chunk;
-            chunk->offset = 0;
-            chunk->stride = self->m_deviceCaps.bps() * self->m_deviceCaps.channels() / 8;
-            chunk->size = copySize;
-        }
+    if (self->m_buffers.size() < self->m_maxBufferSize)
+        self->m_bufferIsNotFull.wakeAll();
+
+    if (copySize > 0) {
+        auto chunk = buffer->buffer->datas[0].chunk;
+        chunk->offset = 0;
+        chunk->stride = self->m_deviceCaps.bps() * self->m_deviceCaps.channels() / 8;
+        chunk->size = copySize;
     }
 
     pw_stream_queue_buffer(self->m_pwStream, buffer);
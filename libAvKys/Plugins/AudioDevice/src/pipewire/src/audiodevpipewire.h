@@ -44,6 +44,7 @@ class AudioDevPipeWire: public AudioDev
         Q_INVOKABLE QList<int> supportedSampleRates(const QString &device) override;
         Q_INVOKABLE bool init(const QString &device, const AkAudioCaps &caps) override;
         Q_INVOKABLE QByteArray read() override;
+        bool readPacket(AkAudioPacket &packet) override;
         Q_INVOKABLE bool write(const AkAudioPacket &frame) override;
         Q_INVOKABLE bool uninit() override;
 
@@ -407,6 +407,43 @@ QByteArray AudioDevPulseAudio::read()
     return buffer;
 }
 
+bool AudioDevPulseAudio::readPacket(AkAudioPacket &packet)
+{
+    this->d->m_streamMutex.lock();
+
+    if (!this->d->m_paSimple) {
+        this->d->m_streamMutex.unlock();
+
+        return false;
+    }
+
+    int error;
+
+    if (pa_simple_read(this->d->m_paSimple,
+                       packet.data(),
+                       packet.size(),
+                       &error) < 0) {
+        this->d->m_error = QString(pa_strerror(error));
+        this->d->m_streamMutex.unlock();
+        emit this->errorChanged(this->d->m_error);
+
+        return false;
+    }
+
+    // Time of the samples that are still waiting in the server.
+    auto latency = pa_simple_get_latency(this->d->m_paSimple, &error);
+    this->d->m_streamMutex.unlock();
+
+    if (latency == pa_usec_t(-1))
+        latency = 0;
+
+    this->timestampPacket(packet,
+                          qint64(latency * pa_usec_t(packet.caps().rate())
+                                 / PA_USEC_PER_SEC));
+
+    return true;
+}
+
 bool AudioDevPulseAudio::write(const AkAudioPacket &packet)
 {
     this->d->m_streamMutex.lock();
@@ -32,6 +32,11 @@ GridLayout {
             sldRadius.value = radius
             spbRadius.value = radius
         }
+
+        function onGaussianChanged(gaussian)
+        {
+            chkGaussian.checked = gaussian
+        }
     }
 
     // Configure blur radius.
@@ -59,4 +64,23 @@ GridLayout {
 
         onValueChanged: Blur.radius = Number(value)
     }
+
+    Label {
+        id: txtGaussian
+        text: qsTr("Gaussian")
+    }
+    RowLayout {
+        Layout.columnSpan: 2
+
+        Item {
+            Layout.fillWidth: true
+        }
+        Switch {
+            id: chkGaussian
+            checked: Blur.gaussian
+            Accessible.name: txtGaussian.text
+
+            onCheckedChanged: Blur.gaussian = checked
+        }
+    }
 }
@@ -20,20 +20,18 @@
 #include <QQmlContext>
 #include <akfrac.h>
 #include <akpacket.h>
+#include <akvideoblur.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
 #include <akvideopacket.h>
 
 #include "blurelement.h"
-#include "pixel.h"
 
 class BlurElementPrivate
 {
     public:
-        int m_radius {5};
+        AkVideoBlur m_blur {5};
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_argbpack, 0, 0, {}}};
-
-        void integralImage(const AkVideoPacket &src, PixelU32 *integral);
 };
 
 BlurElement::BlurElement():
@@ -49,7 +47,12 @@ BlurElement::~BlurElement()
 
 int BlurElement::radius() const
 {
-    return this->d->m_radius;
+    return this->d->m_blur.radius();
+}
+
+bool BlurElement::gaussian() const
+{
+    return this->d->m_blur.blurMode() == AkVideoBlur::BlurMode_Gaussian;
 }
 
 QString BlurElement::controlInterfaceProvide(const QString &controlId) const
@@ -77,33 +80,7 @@ AkPacket BlurElement::iVideoStream(const AkVideoPacket &packet)
     if (!src)
         return {};
 
-    AkVideoPacket dst(src.caps());
-    dst.copyMetadata(src);
-
-    int oWidth = src.caps().width() + 1;
-    int oHeight = src.caps().height() + 1;
-    auto integral = new PixelU32[oWidth * oHeight];
-    this->d->integralImage(src, integral);
-
-    int radius = this->d->m_radius;
-
-    for (int y = 0; y < src.caps().height(); ++y) {
-        auto oLine = reinterpret_cast<QRgb *>(dst.line(0, y));
-        int yp = qMax(y - radius, 0);
-        int kh = qMin(y + radius, src.caps().height() - 1) - yp + 1;
-
-        for (int x = 0; x < src.caps().width(); ++x) {
-            int xp = qMax(x - radius, 0);
-            int kw = qMin(x + radius, src.caps().width() - 1) - xp + 1;
-
-            PixelU32 sum = integralSum(integral, oWidth, xp, yp, kw, kh);
-            PixelU32 mean = sum / quint32(kw * kh);
-
-            oLine[x] = qRgba(int(mean.r), int(mean.g), int(mean.b), int(mean.a));
-        }
-    }
-
-    delete [] integral;
+    auto dst = this->d->m_blur.blur(src);
 
     if (dst)
         emit this->oStream(dst);
@@ -113,11 +90,22 @@ AkPacket BlurElement::iVideoStream(const AkVideoPacket &packet)
 
 void BlurElement::setRadius(int radius)
 {
-    if (this->d->m_radius == radius)
+    if (this->d->m_blur.radius() == radius)
         return;
 
-    this->d->m_radius = radius;
-    emit this->radiusChanged(radius);
+    this->d->m_blur.setRadius(radius);
+    emit this->radiusChanged(this->d->m_blur.radius());
+}
+
+void BlurElement::setGaussian(bool gaussian)
+{
+    if (this->gaussian() == gaussian)
+        return;
+
+    this->d->m_blur.setBlurMode(gaussian?
+                                    AkVideoBlur::BlurMode_Gaussian:
+                                    AkVideoBlur::BlurMode_Box);
+    emit this->gaussianChanged(gaussian);
 }
 
 void BlurElement::resetRadius()
@@ -125,32 +113,9 @@ void BlurElement::resetRadius()
     this->setRadius(5);
 }
 
-void BlurElementPrivate::integralImage(const AkVideoPacket &src,
-                                       PixelU32 *integral)
+void BlurElement::resetGaussian()
 {
-    int oWidth = src.caps().width() + 1;
-    int oHeight = src.caps().height() + 1;
-
-    auto integralLine = integral + oWidth;
-    auto prevIntegralLine = integral;
-
-    for (int y = 1; y < oHeight; ++y) {
-        auto line = reinterpret_cast<const QRgb *>(src.constLine(0, y - 1));
-
-        // Reset current line summation.
-        PixelU32 sum;
-
-        for (int x = 1; x < oWidth; ++x) {
-            // Accumulate pixels in current line.
-            sum += line[x - 1];
-
-            // Accumulate current line and previous line.
-            integralLine[x] = sum + prevIntegralLine[x];
-        }
-
-        integralLine += oWidth;
-        prevIntegralLine += oWidth;
-    }
+    this->setGaussian(false);
 }
 
 #include "moc_blurelement.cpp"
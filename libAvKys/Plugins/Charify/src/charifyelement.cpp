@@ -19,18 +19,16 @@
 
 #include <QApplication>
 #include <QDataStream>
-#include <QFontMetrics>
 #include <QMutex>
 #include <QQmlContext>
 #include <akfrac.h>
+#include <akglyphatlas.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
-#include <akvideomixer.h>
 #include <akvideopacket.h>
 
 #include "charifyelement.h"
-#include "character.h"
 
 using HintingPreferenceToStr = QMap<QFont::HintingPreference, QString>;
 
@@ -80,33 +78,24 @@ class CharifyElementPrivate
 {
     public:
         AkVideoConverter m_videoConverter;
-        AkVideoMixer m_videoMixer;
+        AkGlyphAtlas m_atlas;
         CharifyElement::ColorMode m_mode {CharifyElement::ColorModeNatural};
         QString m_charTable;
         QFont m_font {QApplication::font()};
         QRgb m_foregroundColor {qRgb(255, 255, 255)};
         QRgb m_backgroundColor {qRgb(0, 0, 0)};
-        Character *m_characters {nullptr};
         QRgb m_palette[256];
-        int m_colorTable[256];
-        QSize m_fontSize;
         QMutex m_mutex;
         bool m_smooth {true};
         bool m_reversed {false};
 
         void updateCharTable();
         void updatePalette();
-        QSize fontSize(const QString &chrTable, const QFont &font) const;
-        QSize fontSize(const QChar &chr, const QFont &font) const;
-        AkVideoPacket createMask(const AkVideoPacket &src,
-                                 const QSize &fontSize,
-                                 const Character *characters);
 };
 
 CharifyElement::CharifyElement(): AkElement()
 {
     this->d = new CharifyElementPrivate;
-    this->d->m_videoMixer.setFlags(AkVideoMixer::MixerFlagLightweightCache);
 
     for (int i = 32; i < 127; i++)
         this->d->m_charTable.append(QChar(i));
@@ -119,9 +108,6 @@ CharifyElement::CharifyElement(): AkElement()
 
 CharifyElement::~CharifyElement()
 {
-    if (this->d->m_characters)
-        delete [] this->d->m_characters;
-
     delete this->d;
 }
 
@@ -191,7 +177,7 @@ void CharifyElement::controlInterfaceConfigure(QQmlContext *context,
 AkPacket CharifyElement::iVideoStream(const AkVideoPacket &packet)
 {
     this->d->m_mutex.lock();
-    auto fontSize = this->d->m_fontSize;
+    auto fontSize = this->d->m_atlas.glyphSize();
 
     int textWidth = packet.caps().width() / fontSize.width();
     int textHeight = packet.caps().height() / fontSize.height();
@@ -233,50 +219,46 @@ AkPacket CharifyElement::iVideoStream(const AkVideoPacket &packet)
     int outWidth = textWidth * fontSize.width();
     int outHeight = textHeight * fontSize.height();
 
-    auto mask = this->d->createMask(src, fontSize, this->d->m_characters);
-    this->d->m_mutex.unlock();
-
     auto ocaps = src.caps();
     ocaps.setWidth(outWidth);
     ocaps.setHeight(outHeight);
     AkVideoPacket dst(ocaps);
     dst.copyMetadata(src);
 
-    if (this->d->m_mode == ColorModeFixed) {
-        this->d->m_mutex.lock();
-
-        for (int y = 0; y < dst.caps().height(); y++) {
-            auto maskLine = mask.constLine(0, y);
-            auto line = reinterpret_cast<QRgb *>(dst.line(0, y));
-
-            for (int x = 0; x < dst.caps().width(); x++)
-                line[x] = this->d->m_palette[maskLine[x]];
-        }
+    // Pick a glyph for each pixel and blend it directly in the output frame.
 
-        this->d->m_mutex.unlock();
-    } else {
-        auto br = qRed(this->d->m_backgroundColor);
-        auto bg = qGreen(this->d->m_backgroundColor);
-        auto bb = qBlue(this->d->m_backgroundColor);
+    auto &lumaTable = this->d->m_atlas.lumaTable(this->d->m_reversed);
 
-        for (int y = 0; y < dst.caps().height(); y++) {
-            int ys = y / fontSize.height();
-            auto srcLine = reinterpret_cast<const QRgb *>(src.constLine(0, ys));
-            auto maskLine = mask.constLine(0, y);
-            auto dstLine = reinterpret_cast<QRgb *>(dst.line(0, y));
+    for (int ys = 0; ys < textHeight; ys++) {
+        auto srcLine = reinterpret_cast<const QRgb *>(src.constLine(0, ys));
 
-            for (int x = 0; x < dst.caps().width(); x++) {
-                int xs = x / fontSize.width();
+        for (int y = 0; y < fontSize.height(); y++) {
+            auto dstLine =
+                    reinterpret_cast<QRgb *>(dst.line(0, ys * fontSize.height() + y));
 
+            for (int xs = 0; xs < textWidth; xs++) {
                 auto &pixel = srcLine[xs];
-                auto &alpha = maskLine[x];
-                dstLine[x] = qRgb((alpha * qRed(pixel)   + (255 - alpha) * br) / 255,
-                                  (alpha * qGreen(pixel) + (255 - alpha) * bg) / 255,
-                                  (alpha * qBlue(pixel)  + (255 - alpha) * bb) / 255);
+                auto glyph = lumaTable[qGray(pixel)];
+                auto dstGlyphLine = dstLine + xs * fontSize.width();
+
+                if (this->d->m_mode == ColorModeFixed) {
+                    auto glyphLine = this->d->m_atlas.glyphLine(glyph, y);
+
+                    for (int x = 0; x < fontSize.width(); x++)
+                        dstGlyphLine[x] = this->d->m_palette[glyphLine[x]];
+                } else {
+                    this->d->m_atlas.drawGlyphLine(glyph,
+                                                   y,
+                                                   pixel,
+                                                   this->d->m_backgroundColor,
+                                                   dstGlyphLine);
+                }
             }
         }
     }
 
+    this->d->m_mutex.unlock();
+
     if (dst)
         emit this->oStream(dst);
 
@@ -290,7 +272,6 @@ void CharifyElement::setMode(ColorMode mode)
 
     this->d->m_mode = mode;
     emit this->modeChanged(mode);
-    this->d->updateCharTable();
 }
 
 void CharifyElement::setCharTable(const QString &charTable)
@@ -393,7 +374,6 @@ void CharifyElement::setReversed(bool reversed)
 
     this->d->m_mutex.lock();
     this->d->m_reversed = reversed;
-    this->d->updateCharTable();
     this->d->m_mutex.unlock();
     emit this->reversedChanged(reversed);
 }
@@ -466,41 +446,8 @@ QDataStream &operator <<(QDataStream &ostream, CharifyElement::ColorMode mode)
 
 void CharifyElementPrivate::updateCharTable()
 {
-    if (this->m_characters)
-        delete [] this->m_characters;
-
-    if (this->m_charTable.isEmpty()) {
-        this->m_fontSize = this->fontSize(' ', this->m_font);
-        this->m_characters = new Character [1];
-        this->m_characters[0] = Character(' ',
-                                          this->m_font,
-                                          this->m_fontSize,
-                                          this->m_reversed);
-        memset(this->m_colorTable, 0, 256);
-    } else {
-        this->m_fontSize = this->fontSize(this->m_charTable, this->m_font);
-        this->m_characters = new Character [this->m_charTable.size()];
-        int i = 0;
-
-        for (auto &chr: this->m_charTable) {
-            this->m_characters[i] = Character(chr,
-                                              this->m_font,
-                                              this->m_fontSize,
-                                              this->m_reversed);
-            i++;
-        }
-
-        std::sort(this->m_characters,
-                  this->m_characters + this->m_charTable.size(),
-                  [] (const Character &chr1, const Character &chr2) {
-                      return chr1.weight() < chr2.weight();
-                  });
-
-        auto charMax = this->m_charTable.size() - 1;
-
-        for (int i = 0; i < 256; i++)
-            this->m_colorTable[i] = charMax * i / 255;
-    }
+    this->m_atlas.setFont(this->m_font);
+    this->m_atlas.setCharTable(this->m_charTable);
 }
 
 void CharifyElementPrivate::updatePalette()
@@ -519,60 +466,4 @@ void CharifyElementPrivate::updatePalette()
                                   (i * fb + (255 - i) * bb) / 255);
 }
 
-QSize CharifyElementPrivate::fontSize(const QString &chrTable,
-                                      const QFont &font) const
-{
-    QFontMetrics metrics(font);
-    int width = -1;
-    int height = -1;
-
-    for (auto &chr: chrTable) {
-        auto size = metrics.size(Qt::TextSingleLine, chr);
-
-        if (size.width() > width)
-            width = size.width();
-
-        if (size.height() > height)
-            height = size.height();
-    }
-
-    return {width, height};
-}
-
-QSize CharifyElementPrivate::fontSize(const QChar &chr, const QFont &font) const
-{
-    return QFontMetrics(font).size(Qt::TextSingleLine, chr);
-}
-
-AkVideoPacket CharifyElementPrivate::createMask(const AkVideoPacket &src,
-                                                const QSize &fontSize,
-                                                const Character *characters)
-{
-    int outWidth = src.caps().width() * fontSize.width();
-    int outHeight = src.caps().height() * fontSize.height();
-
-    AkVideoPacket dst({AkVideoCaps::Format_y8,
-                       outWidth,
-                       outHeight,
-                       src.caps().fps()});
-    dst.copyMetadata(src);
-
-    this->m_videoMixer.begin(&dst);
-
-    for (int y = 0; y < src.caps().height(); y++) {
-        auto ys = y * fontSize.height();
-        auto srcLine = reinterpret_cast<const QRgb *>(src.constLine(0, y));
-
-        for (int x = 0; x < src.caps().width(); x++) {
-            auto xs = x * fontSize.width();
-            auto &chr = characters[this->m_colorTable[qGray(srcLine[x])]];
-            this->m_videoMixer.draw(xs, ys, chr.image());
-        }
-    }
-
-    this->m_videoMixer.end();
-
-    return dst;
-}
-
 #include "moc_charifyelement.cpp"
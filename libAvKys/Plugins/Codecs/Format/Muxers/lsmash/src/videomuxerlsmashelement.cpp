@@ -23,6 +23,8 @@
 #include <QVariant>
 #include <QVector>
 #include <QWaitCondition>
+#include <cstdio>
+#include <akasyncfilewriter.h>
 #include <akaudiocaps.h>
 #include <akcompressedaudiocaps.h>
 #include <akcompressedaudiopacket.h>
@@ -129,10 +131,14 @@ class VideoMuxerLSmashElementPrivate
 {
     public:
         VideoMuxerLSmashElement *self;
+        AkPropertyOptions m_options;
         lsmash_root_t *m_root {nullptr};
         lsmash_file_parameters_t m_fileParams;
+        AkAsyncFileWriter m_writer;
         uint32_t m_globalTimeScale {90000};
         QVector<TrackInfo> m_trackInfo;
+        qreal m_fragmentDuration {0.0};
+        qreal m_fragmentStart {-1.0};
         bool m_initialized {false};
         bool m_paused {false};
         AkElementPtr m_packetSync {akPluginManager->create<AkElement>("Utils/PacketSync")};
@@ -140,8 +146,16 @@ class VideoMuxerLSmashElementPrivate
         explicit VideoMuxerLSmashElementPrivate(VideoMuxerLSmashElement *self);
         ~VideoMuxerLSmashElementPrivate();
         static const char *errorToString(int error);
+        static int readFile(void *opaque, uint8_t *buffer, int size);
+        static int writeFile(void *opaque, uint8_t *buffer, int size);
+        static int64_t seekFile(void *opaque, int64_t offset, int whence);
         bool init();
         void uninit();
+        bool openFile(const QString &fileName);
+        void closeFile();
+        bool flushSamples();
+        bool createFragment();
+        void finishFragments();
         uint32_t addAudioTrack(lsmash_root_t *root,
                                lsmash_codec_type_t codecID,
                                const AkCompressedAudioCaps &audioCaps,
@@ -245,6 +259,11 @@ AkCodecID VideoMuxerLSmashElement::defaultCodec(const QString &muxer,
     return codecs.first();
 }
 
+AkPropertyOptions VideoMuxerLSmashElement::options() const
+{
+    return this->d->m_options;
+}
+
 AkPacket VideoMuxerLSmashElement::iStream(const AkPacket &packet)
 {
     if (this->d->m_paused || !this->d->m_initialized || !this->d->m_packetSync)
@@ -316,6 +335,18 @@ bool VideoMuxerLSmashElement::setState(ElementState state)
 VideoMuxerLSmashElementPrivate::VideoMuxerLSmashElementPrivate(VideoMuxerLSmashElement *self):
     self(self)
 {
+    this->m_options = AkAsyncFileWriter::options() + AkPropertyOptions {
+        {"fragmentDuration" ,
+         QObject::tr("Fragment duration (seconds)"),
+         QObject::tr("Write a fragmented MP4 with a fragment every this amount of seconds, so the file stays playable if the recording is interrupted, 0 to disable"),
+         AkPropertyOption::OptionType_Number,
+         0.0,
+         3600.0,
+         1.0,
+         0.0,
+         {}},
+    };
+
     if (this->m_packetSync)
         QObject::connect(this->m_packetSync.data(),
                          &AkElement::oStream,
@@ -399,11 +430,12 @@ bool VideoMuxerLSmashElementPrivate::init()
 
     // Create the file
 
+    this->m_fragmentDuration =
+            qMax(self->optionValue("fragmentDuration").toReal(), 0.0);
+    this->m_fragmentStart = -1.0;
     auto location = self->location();
 
-    if (lsmash_open_file(location.toStdString().c_str(),
-                         0,
-                         &this->m_fileParams) < 0) {
+    if (!this->openFile(location)) {
         qCritical() << "Failed to open an output file";
 
         return false;
@@ -518,6 +550,13 @@ void VideoMuxerLSmashElementPrivate::uninit()
     this->m_initialized = false;
     this->m_packetSync->setState(AkElement::ElementStateNull);
 
+    if (this->m_fragmentDuration > 0.0) {
+        this->finishFragments();
+        this->m_paused = false;
+
+        return;
+    }
+
     lsmash_movie_parameters_t movieParameters;
     auto result = lsmash_get_movie_parameters(this->m_root, &movieParameters);
 
@@ -584,10 +623,10 @@ void VideoMuxerLSmashElementPrivate::uninit()
     }
 
     lsmash_destroy_root(this->m_root);
-    result = lsmash_close_file(&this->m_fileParams);
+    this->closeFile();
 
-    if (result) {
-        qCritical() << "Error closing the file:" << errorToString(result);
+    if (this->m_writer.error()) {
+        qCritical() << "Error closing the file";
 
         return;
     }
@@ -595,6 +634,146 @@ void VideoMuxerLSmashElementPrivate::uninit()
     this->m_paused = false;
 }
 
+bool VideoMuxerLSmashElementPrivate::openFile(const QString &fileName)
+{
+    this->m_writer.configure(self);
+
+    if (!this->m_writer.open(fileName))
+        return false;
+
+    /* Same parameters that lsmash_open_file() sets for writing, but the I/O
+     * goes through the asynchronous writer instead of stdio.
+     */
+    memset(&this->m_fileParams, 0, sizeof(lsmash_file_parameters_t));
+    this->m_fileParams.mode = LSMASH_FILE_MODE_WRITE
+                            | LSMASH_FILE_MODE_BOX
+                            | LSMASH_FILE_MODE_INITIALIZATION
+                            | LSMASH_FILE_MODE_MEDIA;
+
+    if (this->m_fragmentDuration > 0.0)
+        this->m_fileParams.mode |= LSMASH_FILE_MODE_FRAGMENTED;
+
+    this->m_fileParams.opaque = &this->m_writer;
+    this->m_fileParams.read = VideoMuxerLSmashElementPrivate::readFile;
+    this->m_fileParams.write = VideoMuxerLSmashElementPrivate::writeFile;
+    this->m_fileParams.seek = VideoMuxerLSmashElementPrivate::seekFile;
+    this->m_fileParams.max_chunk_duration = 0.5;
+    this->m_fileParams.max_async_tolerance = 2.0;
+    this->m_fileParams.max_chunk_size = 4 * 1024 * 1024;
+    this->m_fileParams.max_read_size = 4 * 1024 * 1024;
+
+    return true;
+}
+
+void VideoMuxerLSmashElementPrivate::closeFile()
+{
+    this->m_writer.flush();
+    this->m_writer.logStats();
+    this->m_writer.close();
+}
+
+bool VideoMuxerLSmashElementPrivate::flushSamples()
+{
+    for (auto &trackInfo: this->m_trackInfo) {
+        if (trackInfo.firstWrittenPacket)
+            continue;
+
+        uint32_t lastDelta = trackInfo.largestPts - trackInfo.secondLargestPts;
+        auto result = lsmash_flush_pooled_samples(this->m_root,
+                                                  trackInfo.track,
+                                                  lastDelta);
+
+        if (result) {
+            qCritical() << "Failed to flush the samples:" << errorToString(result);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VideoMuxerLSmashElementPrivate::createFragment()
+{
+    // Write the samples of the current fragment before starting the next one.
+    if (!this->flushSamples())
+        return false;
+
+    auto result = lsmash_create_fragment_movie(this->m_root);
+
+    if (result) {
+        qCritical() << "Failed to create the movie fragment:" << errorToString(result);
+
+        return false;
+    }
+
+    return true;
+}
+
+void VideoMuxerLSmashElementPrivate::finishFragments()
+{
+    /* The moov was written with the first fragment, so the edit lists can't
+     * be added here, only the samples of the last fragment are left to
+     * write.
+     */
+    if (this->flushSamples()) {
+        auto result = lsmash_finish_movie(this->m_root, nullptr);
+
+        if (result)
+            qCritical() << "failed finishing the video:" << errorToString(result);
+    }
+
+    lsmash_destroy_root(this->m_root);
+    this->closeFile();
+
+    if (this->m_writer.error())
+        qCritical() << "Error closing the file";
+}
+
+int VideoMuxerLSmashElementPrivate::readFile(void *opaque,
+                                             uint8_t *buffer,
+                                             int size)
+{
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(opaque);
+
+    return int(writer->read(buffer, size));
+}
+
+int VideoMuxerLSmashElementPrivate::writeFile(void *opaque,
+                                              uint8_t *buffer,
+                                              int size)
+{
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(opaque);
+
+    return int(writer->write(buffer, size));
+}
+
+int64_t VideoMuxerLSmashElementPrivate::seekFile(void *opaque,
+                                                 int64_t offset,
+                                                 int whence)
+{
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(opaque);
+    qint64 pos = offset;
+
+    switch (whence) {
+    case SEEK_CUR:
+        pos += writer->pos();
+
+        break;
+    case SEEK_END:
+        pos += writer->size();
+
+        break;
+    default:
+        break;
+    }
+
+    if (!writer->seek(pos))
+        return -1;
+
+    return pos;
+}
+
 uint32_t VideoMuxerLSmashElementPrivate::addAudioTrack(lsmash_root_t *root,
                                                        lsmash_codec_type_t codecID,
                                                        const AkCompressedAudioCaps &audioCaps,
@@ -932,6 +1111,21 @@ void VideoMuxerLSmashElementPrivate::packetReady(const AkPacket &packet)
         trackInfo.firstPacket = false;
     }
 
+    /* Each fragment starts with a video key frame. The first one is created
+     * before writing any video sample, so the moov is written at the start
+     * of the recording and the file can be played even if it's not
+     * finished.
+     */
+    if (this->m_fragmentDuration > 0.0 && !isAudio && isSyncSample) {
+        auto time = packet.pts() * packet.timeBase().value();
+
+        if (this->m_fragmentStart < 0.0
+            || time - this->m_fragmentStart >= this->m_fragmentDuration) {
+            this->createFragment();
+            this->m_fragmentStart = time;
+        }
+    }
+
     auto sample = lsmash_create_sample(packet.size());
 
     if (!sample) {
@@ -19,11 +19,13 @@
 
 #include <QCoreApplication>
 #include <QFile>
+#include <QMap>
 #include <QMutex>
 #include <QTemporaryDir>
 #include <QThread>
 #include <QVector>
 #include <QWaitCondition>
+#include <akasyncfilewriter.h>
 #include <akaudiocaps.h>
 #include <akcompressedaudiocaps.h>
 #include <akcompressedaudiopacket.h>
@@ -121,6 +123,7 @@ class VideoMuxerMp4V2ElementPrivate
         VideoMuxerMp4V2Element *self;
         AkPropertyOptions m_options;
         MP4FileHandle m_file {nullptr};
+        AkAsyncFileWriter m_writer;
         MP4TrackId m_audioTrack {MP4_INVALID_TRACK_ID};
         MP4TrackId m_videoTrack {MP4_INVALID_TRACK_ID};
         uint32_t m_globalTimeScale {90000};
@@ -132,6 +135,21 @@ class VideoMuxerMp4V2ElementPrivate
         ~VideoMuxerMp4V2ElementPrivate();
         bool init();
         void uninit();
+        static QMutex &writersMutex();
+        static QMap<QString, AkAsyncFileWriter *> &writers();
+        static void *openFile(const char *name, MP4FileMode mode);
+        static int seekFile(void *handle, int64_t pos);
+        static int readFile(void *handle,
+                            void *buffer,
+                            int64_t size,
+                            int64_t *nin,
+                            int64_t maxChunkSize);
+        static int writeFile(void *handle,
+                             const void *buffer,
+                             int64_t size,
+                             int64_t *nout,
+                             int64_t maxChunkSize);
+        static int closeFile(void *handle);
         MP4TrackId addH264Track(MP4FileHandle file,
                                 const AkCompressedVideoCaps &videoCaps,
                                 QByteArray &privateData) const;
@@ -302,7 +320,7 @@ bool VideoMuxerMp4V2Element::setState(ElementState state)
 VideoMuxerMp4V2ElementPrivate::VideoMuxerMp4V2ElementPrivate(VideoMuxerMp4V2Element *self):
     self(self)
 {
-    this->m_options = {
+    this->m_options = AkPropertyOptions {
         {"optimize" ,
          QObject::tr("Optimize"),
          "",
@@ -312,7 +330,7 @@ VideoMuxerMp4V2ElementPrivate::VideoMuxerMp4V2ElementPrivate(VideoMuxerMp4V2Elem
          1.0,
          0.0,
          {}},
-    };
+    } + AkAsyncFileWriter::options();
 
     if (this->m_packetSync)
         QObject::connect(this->m_packetSync.data(),
@@ -369,7 +387,29 @@ bool VideoMuxerMp4V2ElementPrivate::init()
     // Create the file
 
     auto location = self->location();
-    this->m_file = MP4Create(location.toStdString().c_str(), 0);
+    auto fileName = location.toStdString();
+    this->m_writer.configure(self);
+
+    /* MP4v2 only gives the file name to the open callback, so the writer is
+     * passed to it through a table indexed by the file name.
+     */
+    static const MP4FileProvider fileProvider {
+        VideoMuxerMp4V2ElementPrivate::openFile,
+        VideoMuxerMp4V2ElementPrivate::seekFile,
+        VideoMuxerMp4V2ElementPrivate::readFile,
+        VideoMuxerMp4V2ElementPrivate::writeFile,
+        VideoMuxerMp4V2ElementPrivate::closeFile,
+    };
+
+    writersMutex().lock();
+    writers()[QString::fromStdString(fileName)] = &this->m_writer;
+    writersMutex().unlock();
+
+    this->m_file = MP4CreateProvider(fileName.c_str(), 0, &fileProvider);
+
+    writersMutex().lock();
+    writers().remove(QString::fromStdString(fileName));
+    writersMutex().unlock();
 
     if (this->m_file == MP4_INVALID_FILE_HANDLE) {
         qCritical() << "Failed to create the file";
@@ -500,6 +540,7 @@ void VideoMuxerMp4V2ElementPrivate::uninit()
     }
 
     MP4Close(this->m_file);
+    this->m_writer.logStats();
 
     if (self->optionValue("optimize").toBool()) {
         QTemporaryDir tempDir;
@@ -527,6 +568,89 @@ void VideoMuxerMp4V2ElementPrivate::uninit()
     this->m_paused = false;
 }
 
+QMutex &VideoMuxerMp4V2ElementPrivate::writersMutex()
+{
+    static QMutex mutex;
+
+    return mutex;
+}
+
+QMap<QString, AkAsyncFileWriter *> &VideoMuxerMp4V2ElementPrivate::writers()
+{
+    static QMap<QString, AkAsyncFileWriter *> writers;
+
+    return writers;
+}
+
+void *VideoMuxerMp4V2ElementPrivate::openFile(const char *name,
+                                              MP4FileMode mode)
+{
+    // The muxer only creates files.
+    if (mode != FILEMODE_CREATE)
+        return nullptr;
+
+    writersMutex().lock();
+    auto writer = writers().value(QString::fromStdString(name));
+    writersMutex().unlock();
+
+    if (!writer || !writer->open(QString::fromStdString(name)))
+        return nullptr;
+
+    return writer;
+}
+
+int VideoMuxerMp4V2ElementPrivate::seekFile(void *handle, int64_t pos)
+{
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(handle);
+
+    return !writer->seek(pos);
+}
+
+int VideoMuxerMp4V2ElementPrivate::readFile(void *handle,
+                                            void *buffer,
+                                            int64_t size,
+                                            int64_t *nin,
+                                            int64_t maxChunkSize)
+{
+    Q_UNUSED(maxChunkSize)
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(handle);
+    auto dataRead = writer->read(buffer, size);
+
+    if (dataRead < 0)
+        return true;
+
+    *nin = dataRead;
+
+    return false;
+}
+
+int VideoMuxerMp4V2ElementPrivate::writeFile(void *handle,
+                                             const void *buffer,
+                                             int64_t size,
+                                             int64_t *nout,
+                                             int64_t maxChunkSize)
+{
+    Q_UNUSED(maxChunkSize)
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(handle);
+    auto written = writer->write(buffer, size);
+
+    if (written < 0)
+        return true;
+
+    *nout = written;
+
+    return false;
+}
+
+int VideoMuxerMp4V2ElementPrivate::closeFile(void *handle)
+{
+    auto writer = reinterpret_cast<AkAsyncFileWriter *>(handle);
+    auto ok = writer->flush();
+    writer->close();
+
+    return !ok;
+}
+
 MP4TrackId VideoMuxerMp4V2ElementPrivate::addH264Track(MP4FileHandle file,
                                                        const AkCompressedVideoCaps &videoCaps,
                                                        QByteArray &privateData) const
@@ -0,0 +1,655 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QDebug>
+#include <QVector>
+
+#include "mkvasyncwriter.h"
+
+#define MKV_EBML         0x1A45DFA3
+#define MKV_SEGMENT      0x18538067
+#define MKV_SEEKHEAD     0x114D9B74
+#define MKV_SEEK         0x4DBB
+#define MKV_SEEKID       0x53AB
+#define MKV_SEEKPOSITION 0x53AC
+#define MKV_CLUSTER      0x1F43B675
+#define MKV_CUES         0x1C53BB6B
+#define MKV_VOID         0xEC
+
+// Maximum size of the header kept in memory while searching the first cluster.
+#define MAX_HEADER_SIZE (16 * 1024 * 1024)
+
+#define COPY_BLOCK_SIZE (4 * 1024 * 1024)
+
+struct EbmlElement
+{
+    quint64 id {0};
+    qint64 size {0};
+    qint64 headerSize {0};
+};
+
+struct SeekEntry
+{
+    quint64 id;
+    qint64 pos;
+};
+
+static int vintLength(quint8 byte)
+{
+    for (int i = 0; i < 8; i++)
+        if (byte & (0x80 >> i))
+            return i + 1;
+
+    return 0;
+}
+
+// The size of the element is -1 if it's unknown.
+static bool readElement(const quint8 *data, qint64 dataSize, EbmlElement *element)
+{
+    if (dataSize < 1)
+        return false;
+
+    auto idLength = vintLength(data[0]);
+
+    if (idLength < 1 || idLength > 4 || dataSize < idLength + 1)
+        return false;
+
+    quint64 id = 0;
+
+    for (int i = 0; i < idLength; i++)
+        id = (id << 8) | data[i];
+
+    auto sizeLength = vintLength(data[idLength]);
+
+    if (sizeLength < 1 || dataSize < idLength + sizeLength)
+        return false;
+
+    quint8 mask = 0xff >> sizeLength;
+    quint64 size = data[idLength] & mask;
+    bool unknown = size == mask;
+
+    for (int i = 1; i < sizeLength; i++) {
+        auto byte = data[idLength + i];
+        size = (size << 8) | byte;
+        unknown = unknown && byte == 0xff;
+    }
+
+    element->id = id;
+    element->size = unknown? -1: qint64(size);
+    element->headerSize = idLength + sizeLength;
+
+    return true;
+}
+
+static quint64 readUInt(const quint8 *data, qint64 size)
+{
+    quint64 value = 0;
+
+    for (qint64 i = 0; i < size; i++)
+        value = (value << 8) | data[i];
+
+    return value;
+}
+
+static QByteArray ebmlId(quint64 id)
+{
+    QByteArray bytes;
+
+    for (; id; id >>= 8)
+        bytes.prepend(char(id & 0xff));
+
+    return bytes;
+}
+
+static QByteArray ebmlSize(quint64 size, int length=0)
+{
+    if (length < 1) {
+        length = 1;
+
+        while (length < 8 && size >= (quint64(1) << (7 * length)) - 1)
+            length++;
+    }
+
+    QByteArray bytes(length, 0);
+    size |= quint64(1) << (7 * length);
+
+    for (int i = length - 1; i >= 0; i--, size >>= 8)
+        bytes[i] = char(size & 0xff);
+
+    return bytes;
+}
+
+static QByteArray ebmlUInt(quint64 value)
+{
+    QByteArray bytes;
+
+    do {
+        bytes.prepend(char(value & 0xff));
+        value >>= 8;
+    } while (value);
+
+    return bytes;
+}
+
+static QByteArray ebmlElement(quint64 id, const QByteArray &payload)
+{
+    return ebmlId(id) + ebmlSize(quint64(payload.size())) + payload;
+}
+
+/* Header of a Void element of the given total size, the content of the
+ * element is left as is.
+ */
+static QByteArray ebmlVoidHeader(qint64 size)
+{
+    for (int length = 1; length <= 8; length++) {
+        auto payloadSize = size - 1 - length;
+
+        if (payloadSize < 0)
+            break;
+
+        if (payloadSize < (qint64(1) << (7 * length)) - 1)
+            return ebmlId(MKV_VOID) + ebmlSize(quint64(payloadSize), length);
+    }
+
+    return {};
+}
+
+static bool copyData(AkAsyncFileWriter &src,
+                     qint64 srcPos,
+                     AkAsyncFileWriter &dst,
+                     qint64 dstPos,
+                     qint64 size)
+{
+    QByteArray buffer(COPY_BLOCK_SIZE, Qt::Uninitialized);
+
+    if (!src.seek(srcPos) || !dst.seek(dstPos))
+        return false;
+
+    while (size > 0) {
+        auto blockSize = qMin<qint64>(size, buffer.size());
+
+        if (src.read(buffer.data(), blockSize) != blockSize
+            || dst.write(buffer.constData(), blockSize) != blockSize)
+            return false;
+
+        size -= blockSize;
+    }
+
+    return true;
+}
+
+bool MkvAsyncWriter::Open(const QString &fileName, qint64 cuesReservation)
+{
+    this->m_header.clear();
+    this->m_pos = 0;
+    this->m_size = 0;
+    this->m_cuesReservation = qMax<qint64>(cuesReservation, 0);
+    this->m_reserved = 0;
+    this->m_clustersPos = -1;
+    this->m_payloadPos = -1;
+    this->m_segmentSizePos = -1;
+    this->m_seekHeadPos = -1;
+    this->m_seekHeadEnd = -1;
+    this->m_shiftPositions = false;
+
+    return this->m_writer.open(fileName);
+}
+
+void MkvAsyncWriter::Close()
+{
+    // The reserved space was never placed, write the header as is.
+    if (!this->m_header.isEmpty()) {
+        this->m_writer.seek(0);
+        this->m_writer.write(this->m_header.constData(), this->m_header.size());
+        this->m_header.clear();
+    }
+
+    this->m_writer.close();
+}
+
+mkvmuxer::int32 MkvAsyncWriter::Write(const void *buffer,
+                                      mkvmuxer::uint32 length)
+{
+    auto data = reinterpret_cast<const char *>(buffer);
+
+    if (this->m_cuesReservation > 0 && this->m_clustersPos < 0) {
+        auto end = this->m_pos + qint64(length);
+
+        if (end > this->m_header.size())
+            this->m_header.resize(int(end));
+
+        memcpy(this->m_header.data() + this->m_pos, data, length);
+    } else if (!this->writeFile(data, length)) {
+        return -1;
+    }
+
+    this->m_pos += length;
+    this->m_size = qMax(this->m_size, this->m_pos);
+
+    return 0;
+}
+
+mkvmuxer::int64 MkvAsyncWriter::Position() const
+{
+    return this->m_pos;
+}
+
+mkvmuxer::int32 MkvAsyncWriter::Position(mkvmuxer::int64 position)
+{
+    if (position < 0)
+        return -1;
+
+    this->m_pos = position;
+
+    return 0;
+}
+
+bool MkvAsyncWriter::Seekable() const
+{
+    return true;
+}
+
+void MkvAsyncWriter::ElementStartNotify(mkvmuxer::uint64 elementId,
+                                        mkvmuxer::int64 position)
+{
+    Q_UNUSED(elementId)
+    Q_UNUSED(position)
+}
+
+bool MkvAsyncWriter::reserveCues()
+{
+    if (this->m_cuesReservation < 1 || this->m_clustersPos >= 0)
+        return true;
+
+    if (!this->parseHeader() || this->m_seekHeadPos < 0) {
+        if (this->m_clustersPos < 0 && this->m_header.size() < MAX_HEADER_SIZE)
+            return false;
+
+        qWarning() << "Can't reserve space for the cues";
+        this->m_cuesReservation = 0;
+        this->m_clustersPos = -1;
+        auto header = this->m_header;
+        this->m_header.clear();
+        auto pos = this->m_pos;
+        this->m_pos = 0;
+        this->writeFile(header.constData(), header.size());
+        this->m_pos = pos;
+
+        return false;
+    }
+
+    auto header = this->m_header;
+    this->m_header.clear();
+    this->m_reserved = this->m_cuesReservation;
+    auto voidHeader = ebmlVoidHeader(this->m_reserved);
+    auto clustersSize = header.size() - this->m_clustersPos;
+
+    if (!this->m_writer.seek(0)
+        || this->m_writer.write(header.constData(),
+                                this->m_clustersPos) != this->m_clustersPos
+        || this->m_writer.write(voidHeader.constData(),
+                                voidHeader.size()) != voidHeader.size()
+        || !this->m_writer.seek(this->m_clustersPos + this->m_reserved)
+        || this->m_writer.write(header.constData() + this->m_clustersPos,
+                                clustersSize) != clustersSize) {
+        qCritical() << "Failed to write the segment header";
+    }
+
+    this->m_shiftPositions = true;
+
+    return true;
+}
+
+bool MkvAsyncWriter::hasCuesReservation() const
+{
+    return this->m_reserved > 0;
+}
+
+bool MkvAsyncWriter::moveCues(mkvmuxer::Cues *cues)
+{
+    if (!this->hasCuesReservation()
+        || !cues
+        || cues->cue_entries_size() < 1)
+        return false;
+
+    auto cuesPos = this->cuesPosition(cues);
+
+    if (cuesPos < this->m_clustersPos)
+        return false;
+
+    this->shiftCues(cues, this->m_reserved);
+    auto space = this->m_reserved - qint64(cues->Size());
+
+    if (space < 0 || space == 1) {
+        this->shiftCues(cues, -this->m_reserved);
+
+        return false;
+    }
+
+    // From here the positions are the real positions in the file.
+    this->m_shiftPositions = false;
+    auto clustersEnd = cuesPos + this->m_reserved;
+
+    if (!this->writeCues(*this, cues, this->m_clustersPos, space)
+        || !this->updateSeekHead(this->m_writer,
+                                 this->m_clustersPos - this->m_payloadPos,
+                                 this->m_reserved)
+        || !this->updateSegmentSize(this->m_writer,
+                                    clustersEnd - this->m_payloadPos)
+        || !this->m_writer.resize(clustersEnd)) {
+        qCritical() << "Failed writing the cues in the reserved space";
+    }
+
+    this->shiftCues(cues, -this->m_reserved);
+
+    return true;
+}
+
+bool MkvAsyncWriter::copyCues(mkvmuxer::Cues *cues, const QString &fileName)
+{
+    if (!this->hasCuesReservation() || !cues)
+        return false;
+
+    auto cuesPos = this->cuesPosition(cues);
+
+    if (cuesPos < this->m_clustersPos)
+        return false;
+
+    /* The size of the cues depends on the position of the clusters, which
+     * depends on the size of the cues, so iterate until both matches.
+     */
+    qint64 shift = qint64(cues->Size());
+    qint64 shifted = 0;
+    qint64 space = -1;
+
+    for (int i = 0; i < 16 && space < 0; i++) {
+        this->shiftCues(cues, shift - shifted);
+        shifted = shift;
+        auto cuesSize = qint64(cues->Size());
+
+        if (cuesSize == shift || shift - cuesSize > 1)
+            space = shift - cuesSize;
+        else
+            shift = qMax(cuesSize, shift + 1);
+    }
+
+    if (space < 0) {
+        this->shiftCues(cues, -shifted);
+
+        return false;
+    }
+
+    MkvAsyncWriter output;
+    output.m_writer.setBufferSize(this->m_writer.bufferSize());
+    output.m_writer.setMaxBacklog(this->m_writer.maxBacklog());
+    output.m_writer.setPreallocationSize(this->m_writer.preallocationSize());
+    output.m_writer.setSyncInterval(this->m_writer.syncInterval());
+
+    if (!output.Open(fileName)) {
+        this->shiftCues(cues, -shifted);
+
+        return false;
+    }
+
+    auto clustersSize = cuesPos - this->m_clustersPos;
+    bool ok = copyData(this->m_writer,
+                       0,
+                       output.m_writer,
+                       0,
+                       this->m_clustersPos)
+              && this->writeCues(output, cues, this->m_clustersPos, space)
+              && copyData(this->m_writer,
+                          this->m_clustersPos + this->m_reserved,
+                          output.m_writer,
+                          this->m_clustersPos + shift,
+                          clustersSize)
+              && this->updateSeekHead(output.m_writer,
+                                      this->m_clustersPos - this->m_payloadPos,
+                                      shift)
+              && this->updateSegmentSize(output.m_writer,
+                                         this->m_clustersPos
+                                         + shift
+                                         + clustersSize
+                                         - this->m_payloadPos);
+    output.Close();
+    this->shiftCues(cues, -shifted);
+
+    return ok && !output.m_writer.error();
+}
+
+qint64 MkvAsyncWriter::filePosition(qint64 pos) const
+{
+    if (this->m_shiftPositions && pos >= this->m_clustersPos)
+        return pos + this->m_reserved;
+
+    return pos;
+}
+
+bool MkvAsyncWriter::writeFile(const char *data, qint64 size)
+{
+    auto pos = this->m_pos;
+
+    while (size > 0) {
+        auto blockSize = size;
+
+        // Don't let a write cross the reserved space.
+        if (this->m_shiftPositions && pos < this->m_clustersPos)
+            blockSize = qMin(size, this->m_clustersPos - pos);
+
+        if (!this->m_writer.seek(this->filePosition(pos))
+            || this->m_writer.write(data, blockSize) != blockSize)
+            return false;
+
+        data += blockSize;
+        pos += blockSize;
+        size -= blockSize;
+    }
+
+    return true;
+}
+
+bool MkvAsyncWriter::parseHeader()
+{
+    auto data = reinterpret_cast<const quint8 *>(this->m_header.constData());
+    qint64 size = this->m_header.size();
+    EbmlElement element;
+
+    if (!readElement(data, size, &element)
+        || element.id != MKV_EBML
+        || element.size < 0)
+        return false;
+
+    qint64 pos = element.headerSize + element.size;
+
+    // mkvmuxer writes the size of the segment with 8 bytes.
+    if (!readElement(data + pos, size - pos, &element)
+        || element.id != MKV_SEGMENT
+        || element.headerSize != 12)
+        return false;
+
+    auto segmentSizePos = pos + 4;
+    auto payloadPos = pos + element.headerSize;
+    qint64 seekHeadPos = -1;
+    qint64 seekHeadEnd = -1;
+
+    for (pos = payloadPos; pos < size;) {
+        if (!readElement(data + pos, size - pos, &element))
+            return false;
+
+        if (element.id == MKV_CLUSTER) {
+            this->m_clustersPos = pos;
+            this->m_payloadPos = payloadPos;
+            this->m_segmentSizePos = segmentSizePos;
+            this->m_seekHeadPos = seekHeadPos;
+            this->m_seekHeadEnd = seekHeadEnd;
+
+            return true;
+        }
+
+        if (element.size < 0)
+            return false;
+
+        /* In file mode, mkvmuxer reserves the space for the seek head with a
+         * Void element at the start of the segment.
+         */
+        if (pos == payloadPos
+            && (element.id == MKV_VOID || element.id == MKV_SEEKHEAD)) {
+            seekHeadPos = pos;
+            seekHeadEnd = pos + element.headerSize + element.size;
+        }
+
+        pos += element.headerSize + element.size;
+    }
+
+    return false;
+}
+
+qint64 MkvAsyncWriter::cuesPosition(mkvmuxer::Cues *cues)
+{
+    // The cues are the last element written when finalizing the segment.
+    return this->m_size - qint64(cues->Size());
+}
+
+void MkvAsyncWriter::shiftCues(mkvmuxer::Cues *cues, qint64 shift) const
+{
+    for (int i = 0; i < cues->cue_entries_size(); i++) {
+        auto cue = cues->GetCueByIndex(i);
+
+        if (cue)
+            cue->set_cluster_pos(mkvmuxer::uint64(qint64(cue->cluster_pos())
+                                                  + shift));
+    }
+}
+
+bool MkvAsyncWriter::writeCues(MkvAsyncWriter &writer,
+                               mkvmuxer::Cues *cues,
+                               qint64 pos,
+                               qint64 space)
+{
+    if (writer.Position(pos) || !cues->Write(&writer))
+        return false;
+
+    if (space < 1)
+        return true;
+
+    auto voidHeader = ebmlVoidHeader(space);
+
+    return !voidHeader.isEmpty()
+           && !writer.Write(voidHeader.constData(),
+                            mkvmuxer::uint32(voidHeader.size()));
+}
+
+bool MkvAsyncWriter::updateSeekHead(AkAsyncFileWriter &writer,
+                                    qint64 cuesPos,
+                                    qint64 shift) const
+{
+    auto regionSize = this->m_seekHeadEnd - this->m_seekHeadPos;
+    QByteArray region(int(regionSize), 0);
+
+    if (!writer.seek(this->m_seekHeadPos)
+        || writer.read(region.data(), regionSize) != regionSize)
+        return false;
+
+    auto data = reinterpret_cast<const quint8 *>(region.constData());
+    EbmlElement seekHead;
+
+    if (!readElement(data, regionSize, &seekHead)
+        || seekHead.id != MKV_SEEKHEAD
+        || seekHead.size < 0
+        || seekHead.headerSize + seekHead.size > regionSize)
+        return false;
+
+    // Read the entries written by mkvmuxer.
+    QVector<SeekEntry> entries;
+    auto end = seekHead.headerSize + seekHead.size;
+    EbmlElement element;
+
+    for (auto pos = seekHead.headerSize; pos < end;) {
+        if (!readElement(data + pos, end - pos, &element) || element.size < 0)
+            return false;
+
+        if (element.id == MKV_SEEK) {
+            SeekEntry entry {0, -1};
+            auto entryEnd = pos + element.headerSize + element.size;
+            EbmlElement child;
+
+            for (auto childPos = pos + element.headerSize;
+                 childPos < entryEnd;
+                 childPos += child.headerSize + child.size) {
+                if (!readElement(data + childPos, entryEnd - childPos, &child)
+                    || child.size < 0)
+                    return false;
+
+                auto value = readUInt(data + childPos + child.headerSize,
+                                      child.size);
+
+                if (child.id == MKV_SEEKID)
+                    entry.id = value;
+                else if (child.id == MKV_SEEKPOSITION)
+                    entry.pos = qint64(value);
+            }
+
+            if (entry.id && entry.pos >= 0)
+                entries << entry;
+        }
+
+        pos += element.headerSize + element.size;
+    }
+
+    // Write the seek head again with the real positions.
+    auto clustersPos = this->m_clustersPos - this->m_payloadPos;
+    QByteArray payload;
+
+    for (auto &entry: entries) {
+        auto pos = entry.pos;
+
+        if (entry.id == MKV_CUES)
+            pos = cuesPos;
+        else if (pos >= clustersPos)
+            pos += shift;
+
+        payload += ebmlElement(MKV_SEEK,
+                               ebmlElement(MKV_SEEKID, ebmlId(entry.id))
+                               + ebmlElement(MKV_SEEKPOSITION,
+                                             ebmlUInt(quint64(pos))));
+    }
+
+    auto newSeekHead = ebmlElement(MKV_SEEKHEAD, payload);
+    auto space = regionSize - newSeekHead.size();
+
+    if (space < 0 || space == 1)
+        return false;
+
+    if (space > 0)
+        newSeekHead += ebmlVoidHeader(space);
+
+    return writer.seek(this->m_seekHeadPos)
+           && writer.write(newSeekHead.constData(),
+                           newSeekHead.size()) == newSeekHead.size();
+}
+
+bool MkvAsyncWriter::updateSegmentSize(AkAsyncFileWriter &writer,
+                                       qint64 size) const
+{
+    auto segmentSize = ebmlSize(quint64(size), 8);
+
+    return writer.seek(this->m_segmentSizePos)
+           && writer.write(segmentSize.constData(),
+                           segmentSize.size()) == segmentSize.size();
+}
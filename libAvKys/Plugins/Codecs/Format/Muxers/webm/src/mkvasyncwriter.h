@@ -0,0 +1,100 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef MKVASYNCWRITER_H
+#define MKVASYNCWRITER_H
+
+#include <QByteArray>
+#include <akasyncfilewriter.h>
+#include <mkvmuxer/mkvmuxer.h>
+#include <mkvmuxer/mkvmuxertypes.h>
+
+/* Routes the output of mkvmuxer through the asynchronous writer, so the
+ * thread that delivers the packets is never blocked by the disk.
+ *
+ * Optionally, a Void element can be reserved between the segment header and
+ * the first cluster, so the cues can be written in front of the clusters when
+ * the segment is finalized without copying the whole file. mkvmuxer is not
+ * aware of the reserved space, the positions it sees after the reservation
+ * are shifted when writing to the file, and the cues and the seek head are
+ * rewritten with the real positions by moveCues() or copyCues().
+ */
+class MkvAsyncWriter: public mkvmuxer::IMkvWriter
+{
+    public:
+        AkAsyncFileWriter m_writer;
+
+        // Reserve this amount of bytes for the cues, 0 to disable.
+        bool Open(const QString &fileName, qint64 cuesReservation=0);
+        void Close();
+        mkvmuxer::int32 Write(const void *buffer,
+                              mkvmuxer::uint32 length) override;
+        mkvmuxer::int64 Position() const override;
+        mkvmuxer::int32 Position(mkvmuxer::int64 position) override;
+        bool Seekable() const override;
+        void ElementStartNotify(mkvmuxer::uint64 elementId,
+                                mkvmuxer::int64 position) override;
+
+        /* The header is kept in memory until the first cluster starts,
+         * call it after adding each frame to place the reserved space once
+         * the position of the first cluster is known.
+         */
+        bool reserveCues();
+
+        bool hasCuesReservation() const;
+
+        /* Write the cues in the reserved space after finalizing the segment,
+         * returns false if they don't fit.
+         */
+        bool moveCues(mkvmuxer::Cues *cues);
+
+        /* Write a copy of the file with the cues before the clusters, used
+         * when the cues don't fit in the reserved space.
+         */
+        bool copyCues(mkvmuxer::Cues *cues, const QString &fileName);
+
+    private:
+        QByteArray m_header;
+        qint64 m_pos {0};
+        qint64 m_size {0};
+        qint64 m_cuesReservation {0};
+        qint64 m_reserved {0};
+        qint64 m_clustersPos {-1};
+        qint64 m_payloadPos {-1};
+        qint64 m_segmentSizePos {-1};
+        qint64 m_seekHeadPos {-1};
+        qint64 m_seekHeadEnd {-1};
+        bool m_shiftPositions {false};
+
+        qint64 filePosition(qint64 pos) const;
+        bool writeFile(const char *data, qint64 size);
+        bool parseHeader();
+        qint64 cuesPosition(mkvmuxer::Cues *cues);
+        void shiftCues(mkvmuxer::Cues *cues, qint64 shift) const;
+        bool writeCues(AkAsyncFileWriter &writer,
+                       mkvmuxer::Cues *cues,
+                       qint64 pos,
+                       qint64 space);
+        bool updateSeekHead(AkAsyncFileWriter &writer,
+                            qint64 cuesPos,
+                            qint64 shift) const;
+        bool updateSegmentSize(AkAsyncFileWriter &writer, qint64 size) const;
+};
+
+#endif // MKVASYNCWRITER_H
@@ -36,9 +36,12 @@
 #include <mkvparser/mkvreader.h>
 #include <mkvmuxer/mkvmuxer.h>
 #include <mkvmuxer/mkvmuxertypes.h>
-#include <mkvmuxer/mkvwriter.h>
 
 #include "videomuxerwebmelement.h"
+#include "mkvasyncwriter.h"
+
+// Bitrate assumed when the streams don't have one, in bits per second.
+#define DEFAULT_BITRATE_HINT 8000000
 
 struct AudioCodecsTable
 {
@@ -123,7 +126,8 @@ class VideoMuxerWebmElementPrivate
 {
     public:
         VideoMuxerWebmElement *self;
-        mkvmuxer::MkvWriter m_writer;
+        AkPropertyOptions m_options;
+        MkvAsyncWriter m_writer;
         mkvmuxer::Segment m_muxerSegment;
         uint64_t m_audioTrackIndex {0};
         uint64_t m_videoTrackIndex {0};
@@ -147,6 +151,10 @@ class VideoMuxerWebmElementPrivate
         ~VideoMuxerWebmElementPrivate();
         bool init();
         void uninit();
+        void closeWriter();
+        qint64 cuesReservationSize(const AkCompressedVideoCaps &videoCaps,
+                                   const AkCompressedAudioCaps &audioCaps) const;
+        void writeReservedCues();
         void packetReady(const AkPacket &packet);
 };
 
@@ -238,6 +246,11 @@ AkCodecID VideoMuxerWebmElement::defaultCodec(const QString &muxer,
     return codecs.first();
 }
 
+AkPropertyOptions VideoMuxerWebmElement::options() const
+{
+    return this->d->m_options;
+}
+
 void VideoMuxerWebmElement::resetOptions()
 {
     AkVideoMuxer::resetOptions();
@@ -314,6 +327,36 @@ bool VideoMuxerWebmElement::setState(ElementState state)
 VideoMuxerWebmElementPrivate::VideoMuxerWebmElementPrivate(VideoMuxerWebmElement *self):
     self(self)
 {
+    this->m_options = AkAsyncFileWriter::options() + AkPropertyOptions {
+        {"liveMode" ,
+         QObject::tr("Live mode"),
+         QObject::tr("Write the file without seeking back, the cues are not written"),
+         AkPropertyOption::OptionType_Boolean,
+         0.0,
+         1.0,
+         1.0,
+         1.0,
+         {}},
+        {"cuesBeforeClusters" ,
+         QObject::tr("Cues before clusters"),
+         QObject::tr("Write the cues at the start of the file, so it can be seeked before downloading it"),
+         AkPropertyOption::OptionType_Boolean,
+         0.0,
+         1.0,
+         1.0,
+         0.0,
+         {}},
+        {"cuesReservationDuration" ,
+         QObject::tr("Cues reservation (seconds)"),
+         QObject::tr("Reserve space for the cues of a recording of this duration, so they can be written in place, 0 to always copy the file"),
+         AkPropertyOption::OptionType_Number,
+         0.0,
+         86400.0,
+         60.0,
+         3600.0,
+         {}},
+    };
+
     if (this->m_packetSync)
         QObject::connect(this->m_packetSync.data(),
                          &AkElement::oStream,
@@ -338,6 +381,8 @@ bool VideoMuxerWebmElementPrivate::init()
     this->m_videoDuration = 0.0;
     this->m_audioTrackIndex = 0;
     this->m_videoTrackIndex = 0;
+    this->m_liveMode = self->optionValue("liveMode").toBool();
+    this->m_cuesBeforeClusters = self->optionValue("cuesBeforeClusters").toBool();
 
     AkCompressedVideoCaps videoCaps =
             self->streamCaps(AkCompressedCaps::CapsType_Video);
@@ -372,8 +417,13 @@ bool VideoMuxerWebmElementPrivate::init()
     }
 
     auto location = self->location();
+    this->m_writer.m_writer.configure(self);
+    qint64 cuesReservation = 0;
+
+    if (this->m_cuesBeforeClusters && !this->m_liveMode && this->m_outputCues)
+        cuesReservation = this->cuesReservationSize(videoCaps, audioCaps);
 
-    if (!this->m_writer.Open(location.toStdString().c_str())) {
+    if (!this->m_writer.Open(location, cuesReservation)) {
         qCritical() << "Failed to open file for writting:" << location;
 
         return false;
@@ -554,7 +604,14 @@ void VideoMuxerWebmElementPrivate::uninit()
     if (!this->m_muxerSegment.Finalize())
         qCritical() << "Finalization of segment failed";
 
-    this->m_writer.Close();
+    if (this->m_cuesBeforeClusters && this->m_writer.hasCuesReservation()) {
+        this->writeReservedCues();
+        this->m_paused = false;
+
+        return;
+    }
+
+    this->closeWriter();
 
     if (this->m_cuesBeforeClusters) {
         mkvparser::MkvReader reader;
@@ -581,7 +638,7 @@ void VideoMuxerWebmElementPrivate::uninit()
                                     + fileInfo.completeSuffix());
         QFile::remove(tmp);
 
-        if (this->m_writer.Open(tmp.toStdString().c_str())) {
+        if (this->m_writer.Open(tmp)) {
             if (this->m_muxerSegment.CopyAndMoveCuesBeforeClusters(&reader,
                                                                    &this->m_writer)) {
                 reader.Close();
@@ -605,6 +662,95 @@ void VideoMuxerWebmElementPrivate::uninit()
     this->m_paused = false;
 }
 
+void VideoMuxerWebmElementPrivate::closeWriter()
+{
+    auto &writer = this->m_writer.m_writer;
+    writer.flush();
+    writer.logStats();
+    this->m_writer.Close();
+}
+
+qint64 VideoMuxerWebmElementPrivate::cuesReservationSize(const AkCompressedVideoCaps &videoCaps,
+                                                         const AkCompressedAudioCaps &audioCaps) const
+{
+    qint64 duration = self->optionValue("cuesReservationDuration").toLongLong();
+
+    if (duration < 1)
+        return 0;
+
+    /* The size of the file is estimated from the bitrate, to know how many
+     * bytes takes the position of a cluster.
+     */
+    qint64 bitrate = videoCaps.bitrate() + (audioCaps? audioCaps.bitrate(): 0);
+
+    if (bitrate < 1)
+        bitrate = DEFAULT_BITRATE_HINT;
+
+    auto fileSize = bitrate * duration / 8;
+    int positionSize = 1;
+
+    while (positionSize < 8 && (fileSize >> (8 * positionSize)) > 0)
+        positionSize++;
+
+    auto timeCode = qint64(duration * 1e9 / this->m_timeCodeScale);
+    int timeCodeSize = 1;
+
+    while (timeCodeSize < 8 && (timeCode >> (8 * timeCodeSize)) > 0)
+        timeCodeSize++;
+
+    /* A cue point is added for every video key frame, assume a key frame
+     * every half second. Each cue point stores the time, the track, the
+     * position of the cluster and the block number.
+     */
+    qint64 cuePointSize = 2
+                        + 2 + timeCodeSize
+                        + 2
+                        + 3
+                        + 2 + positionSize
+                        + 4;
+    auto size = 2 * duration * cuePointSize + 16;
+
+    // Round it to the page size.
+    return (size + 4095) / 4096 * 4096;
+}
+
+void VideoMuxerWebmElementPrivate::writeReservedCues()
+{
+    auto cues = this->m_muxerSegment.GetCues();
+
+    if (this->m_writer.moveCues(cues)) {
+        this->closeWriter();
+
+        return;
+    }
+
+    qInfo() << "The cues don't fit in the reserved space, copying the file";
+    QTemporaryDir tempDir;
+
+    if (!tempDir.isValid()) {
+        qCritical() << "Can't create the temporary directory";
+        this->closeWriter();
+
+        return;
+    }
+
+    QFileInfo fileInfo(self->location());
+    auto tmp = tempDir.filePath(fileInfo.baseName()
+                                + "_tmp."
+                                + fileInfo.completeSuffix());
+    QFile::remove(tmp);
+    bool ok = this->m_writer.copyCues(cues, tmp);
+    this->closeWriter();
+
+    if (ok) {
+        QFile::remove(self->location());
+        QFile::rename(tmp, self->location());
+    } else {
+        qCritical() << "Unable to copy and move cues before clusters";
+        QFile::remove(tmp);
+    }
+}
+
 void VideoMuxerWebmElementPrivate::packetReady(const AkPacket &packet)
 {
     bool isAudio = packet.type() == AkPacket::PacketAudio
@@ -631,6 +777,8 @@ void VideoMuxerWebmElementPrivate::packetReady(const AkPacket &packet)
             qCritical() << "Failed to write the video packet";
     }
 
+    this->m_writer.reserveCues();
+
     auto streamDuration =
             (packet.pts() + packet.duration()) * packet.timeBase().value();
 
@@ -39,6 +39,7 @@ class VideoMuxerWebmElement: public AkVideoMuxer
         Q_INVOKABLE bool gapsAllowed(AkCodecType type) const override;
         Q_INVOKABLE QList<AkCodecID> supportedCodecs(const QString &muxer,
                                                      AkCodecType type) const override;
+        Q_INVOKABLE AkPropertyOptions options() const override;
         Q_INVOKABLE AkCodecID defaultCodec(const QString &muxer,
                                            AkCodecType type) const override;
 
@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QVariant>
@@ -109,6 +110,9 @@ class VideoEncoderAv1ElementPrivate
         QMutex m_mutex;
         qint64 m_id {0};
         int m_index {0};
+        int m_speed {0};
+        int m_maxSpeed {0};
+        int m_speedLevel {0};
         bool m_initialized {false};
         bool m_paused {false};
         qint64 m_encodedTimePts {0};
@@ -124,6 +128,7 @@ class VideoEncoderAv1ElementPrivate
                                const aom_codec_ctx_t *codecContext=nullptr);
         void encodeFrame(const AkVideoPacket &src);
         void sendFrame(const aom_codec_cx_pkt_t *aomPacket) const;
+        void setSpeedLevel(int speedLevel);
         unsigned int aomLevel(const AkVideoCaps &caps) const;
 };
 
@@ -410,8 +415,26 @@ bool VideoEncoderAv1ElementPrivate::init()
         return false;
     }
 
-    int speed = qBound(0, self->optionValue("speed").toInt(), 11);
-    aom_codec_control(&this->m_encoder, AOME_SET_CPUUSED, speed);
+    this->m_speed = qBound(0, self->optionValue("speed").toInt(), 11);
+    this->m_speedLevel = 0;
+    aom_codec_control(&this->m_encoder, AOME_SET_CPUUSED, this->m_speed);
+
+    // Highest speed supported by each usage mode.
+    switch (self->optionValue("usage").toUInt()) {
+    case AOM_USAGE_REALTIME:
+        this->m_maxSpeed = 10;
+
+        break;
+    case AOM_USAGE_ALL_INTRA:
+        this->m_maxSpeed = 9;
+
+        break;
+    default:
+        this->m_maxSpeed = 6;
+
+        break;
+    }
+
     auto level = this->aomLevel(this->m_videoConverter.outputCaps());
     aom_codec_control(&this->m_encoder,
                       AV1E_SET_TARGET_SEQ_LEVEL_IDX,
@@ -437,6 +460,8 @@ bool VideoEncoderAv1ElementPrivate::init()
     }
 
     this->updateHeaders();
+    self->startSpeedGovernor(this->m_videoConverter.outputCaps().fps(),
+                             qMax(this->m_maxSpeed - this->m_speed, 0));
 
     if (this->m_fpsControl) {
         this->m_fpsControl->setProperty("fps", QVariant::fromValue(this->m_videoConverter.outputCaps().fps()));
@@ -570,6 +595,8 @@ void VideoEncoderAv1ElementPrivate::printError(aom_codec_err_t error,
 
 void VideoEncoderAv1ElementPrivate::encodeFrame(const AkVideoPacket &src)
 {
+    QElapsedTimer timer;
+    timer.start();
     this->m_id = src.id();
     this->m_index = src.index();
 
@@ -613,6 +640,8 @@ void VideoEncoderAv1ElementPrivate::encodeFrame(const AkVideoPacket &src)
 
     this->m_encodedTimePts = src.pts() + src.duration();
     emit self->encodedTimePtsChanged(this->m_encodedTimePts);
+
+    this->setSpeedLevel(self->updateSpeedGovernor(timer.nsecsElapsed()));
 }
 
 void VideoEncoderAv1ElementPrivate::sendFrame(const aom_codec_cx_pkt_t *aomPacket) const
@@ -634,6 +663,19 @@ void VideoEncoderAv1ElementPrivate::sendFrame(const aom_codec_cx_pkt_t *aomPacke
     emit self->oStream(packet);
 }
 
+void VideoEncoderAv1ElementPrivate::setSpeedLevel(int speedLevel)
+{
+    if (this->m_speedLevel == speedLevel)
+        return;
+
+    this->m_speedLevel = speedLevel;
+    auto speed = qMin(this->m_speed + speedLevel, this->m_maxSpeed);
+    auto result = aom_codec_control(&this->m_encoder, AOME_SET_CPUUSED, speed);
+
+    if (result != AOM_CODEC_OK)
+        printError(result, &this->m_encoder);
+}
+
 unsigned int VideoEncoderAv1ElementPrivate::aomLevel(const AkVideoCaps &caps) const
 {
     // https://aomediacodec.github.io/av1-spec/#levels
@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QTime>
@@ -425,6 +426,9 @@ bool VideoEncoderRav1eElementPrivate::init()
     rav1e_config_unref(config);
     this->updateHeaders();
 
+    // The speed preset is part of the rav1e context, it can't be adjusted.
+    self->startSpeedGovernor(this->m_videoConverter.outputCaps().fps(), 0);
+
     if (this->m_fpsControl) {
         this->m_fpsControl->setProperty("fps", QVariant::fromValue(this->m_videoConverter.outputCaps().fps()));
         this->m_fpsControl->setProperty("fillGaps", self->fillGaps());
@@ -554,6 +558,8 @@ void VideoEncoderRav1eElementPrivate::updateOutputCaps(const AkVideoCaps &inputC
 
 void VideoEncoderRav1eElementPrivate::encodeFrame(const AkVideoPacket &src)
 {
+    QElapsedTimer timer;
+    timer.start();
     this->m_id = src.id();
     this->m_index = src.index();
 
@@ -622,6 +628,8 @@ void VideoEncoderRav1eElementPrivate::encodeFrame(const AkVideoPacket &src)
     }
 
     rav1e_frame_unref(frame);
+
+    self->updateSpeedGovernor(timer.nsecsElapsed());
 }
 
 void VideoEncoderRav1eElementPrivate::sendFrame(const RaPacket *av1Packet) const
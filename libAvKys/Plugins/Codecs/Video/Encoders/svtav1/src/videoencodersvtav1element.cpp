@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QVariant>
@@ -404,6 +405,11 @@ bool VideoEncoderSvtAv1ElementPrivate::init()
             gop == 1? EB_AV1_KEY_PICTURE: EB_AV1_INVALID_PICTURE;
     this->updateHeaders();
 
+    /* SVT-AV1 can't change the speed of a running encoder, the speed governor
+     * only keeps track of the dropped frames.
+     */
+    self->startSpeedGovernor(this->m_videoConverter.outputCaps().fps(), 0);
+
     if (this->m_fpsControl) {
         this->m_fpsControl->setProperty("fps",
                                         QVariant::fromValue(this->m_videoConverter.outputCaps().fps()));
@@ -571,6 +577,8 @@ const char *VideoEncoderSvtAv1ElementPrivate::errortToStr(EbErrorType error)
 
 void VideoEncoderSvtAv1ElementPrivate::encodeFrame(const AkVideoPacket &src)
 {
+    QElapsedTimer timer;
+    timer.start();
     this->m_id = src.id();
     this->m_index = src.index();
 
@@ -604,6 +612,8 @@ void VideoEncoderSvtAv1ElementPrivate::encodeFrame(const AkVideoPacket &src)
 
     this->m_encodedTimePts = src.pts() + src.duration();
     emit self->encodedTimePtsChanged(this->m_encodedTimePts);
+
+    self->updateSpeedGovernor(timer.nsecsElapsed());
 }
 
 void VideoEncoderSvtAv1ElementPrivate::sendFrame(const EbBufferHeaderType *buffer) const
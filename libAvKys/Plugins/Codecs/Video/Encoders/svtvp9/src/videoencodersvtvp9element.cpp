@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QVariant>
@@ -329,6 +330,9 @@ bool VideoEncoderSvtVp9ElementPrivate::init()
     this->m_frame.pic_type = gop == 1? EB_IDR_PICTURE: EB_INVALID_PICTURE;
     this->updateHeaders();
 
+    // The encoding mode is fixed once the encoder starts, only report drops.
+    self->startSpeedGovernor(this->m_videoConverter.outputCaps().fps(), 0);
+
     if (this->m_fpsControl) {
         this->m_fpsControl->setProperty("fps", QVariant::fromValue(this->m_videoConverter.outputCaps().fps()));
         this->m_fpsControl->setProperty("fillGaps", self->fillGaps());
@@ -497,6 +501,8 @@ const char *VideoEncoderSvtVp9ElementPrivate::errortToStr(EbErrorType error)
 
 void VideoEncoderSvtVp9ElementPrivate::encodeFrame(const AkVideoPacket &src)
 {
+    QElapsedTimer timer;
+    timer.start();
     this->m_id = src.id();
     this->m_index = src.index();
 
@@ -530,6 +536,8 @@ void VideoEncoderSvtVp9ElementPrivate::encodeFrame(const AkVideoPacket &src)
 
     this->m_encodedTimePts = src.pts() + src.duration();
     emit self->encodedTimePtsChanged(this->m_encodedTimePts);
+
+    self->updateSpeedGovernor(timer.nsecsElapsed());
 }
 
 void VideoEncoderSvtVp9ElementPrivate::sendFrame(const EbBufferHeaderType *buffer) const
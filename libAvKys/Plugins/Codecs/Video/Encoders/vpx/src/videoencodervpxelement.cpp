@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QVariant>
@@ -161,6 +162,9 @@ class VideoEncoderVpxElementPrivate
         bool m_initialized {false};
         bool m_paused {false};
         int m_deadline {VPX_DL_REALTIME};
+        int m_speed {0};
+        int m_maxSpeed {0};
+        int m_speedLevel {0};
         qint64 m_encodedTimePts {0};
         AkElementPtr m_fpsControl {akPluginManager->create<AkElement>("VideoFilter/FpsControl")};
 
@@ -174,6 +178,7 @@ class VideoEncoderVpxElementPrivate
                                vpx_codec_ctx_t *codecContext=nullptr);
         void encodeFrame(const AkVideoPacket &src);
         void sendFrame(const vpx_codec_cx_pkt_t *vpxPacket) const;
+        void setSpeedLevel(int speedLevel);
         int vp9Level(const AkVideoCaps &caps) const;
 };
 
@@ -472,11 +477,13 @@ bool VideoEncoderVpxElementPrivate::init()
     }
 
     int speed = self->optionValue("speed").toInt();
-    speed = codecID == AkCompressedVideoCaps::VideoCodecID_vp9?
-                qBound(0, 9 * speed / 16, 9):
-                qBound(0, speed, 16);
+    this->m_maxSpeed = codecID == AkCompressedVideoCaps::VideoCodecID_vp9? 9: 16;
+    this->m_speed = codecID == AkCompressedVideoCaps::VideoCodecID_vp9?
+                        qBound(0, 9 * speed / 16, 9):
+                        qBound(0, speed, 16);
+    this->m_speedLevel = 0;
 
-    vpx_codec_control(&this->m_encoder, VP8E_SET_CPUUSED, speed);
+    vpx_codec_control(&this->m_encoder, VP8E_SET_CPUUSED, this->m_speed);
 
     if (codecID == AkCompressedVideoCaps::VideoCodecID_vp9) {
         auto level = this->vp9Level(this->m_videoConverter.outputCaps());
@@ -513,6 +520,12 @@ bool VideoEncoderVpxElementPrivate::init()
     this->m_deadline = self->optionValue("deadline").toInt();
     this->updateHeaders();
 
+    // The speed can only be adjusted on the fly when encoding in real time.
+    self->startSpeedGovernor(this->m_videoConverter.outputCaps().fps(),
+                             this->m_deadline == VPX_DL_REALTIME?
+                                 this->m_maxSpeed - this->m_speed:
+                                 0);
+
     if (this->m_fpsControl) {
         this->m_fpsControl->setProperty("fps", QVariant::fromValue(this->m_videoConverter.outputCaps().fps()));
         this->m_fpsControl->setProperty("fillGaps", self->fillGaps());
@@ -651,6 +664,8 @@ void VideoEncoderVpxElementPrivate::printError(vpx_codec_err_t error,
 
 void VideoEncoderVpxElementPrivate::encodeFrame(const AkVideoPacket &src)
 {
+    QElapsedTimer timer;
+    timer.start();
     this->m_id = src.id();
     this->m_index = src.index();
 
@@ -695,6 +710,8 @@ void VideoEncoderVpxElementPrivate::encodeFrame(const AkVideoPacket &src)
 
     this->m_encodedTimePts = src.pts() + src.duration();
     emit self->encodedTimePtsChanged(this->m_encodedTimePts);
+
+    this->setSpeedLevel(self->updateSpeedGovernor(timer.nsecsElapsed()));
 }
 
 void VideoEncoderVpxElementPrivate::sendFrame(const vpx_codec_cx_pkt_t *vpxPacket) const
@@ -716,6 +733,19 @@ void VideoEncoderVpxElementPrivate::sendFrame(const vpx_codec_cx_pkt_t *vpxPacke
     emit self->oStream(packet);
 }
 
+void VideoEncoderVpxElementPrivate::setSpeedLevel(int speedLevel)
+{
+    if (this->m_speedLevel == speedLevel)
+        return;
+
+    this->m_speedLevel = speedLevel;
+    auto speed = qMin(this->m_speed + speedLevel, this->m_maxSpeed);
+    auto result = vpx_codec_control(&this->m_encoder, VP8E_SET_CPUUSED, speed);
+
+    if (result != VPX_CODEC_OK)
+        printError(result, &this->m_encoder);
+}
+
 int VideoEncoderVpxElementPrivate::vp9Level(const AkVideoCaps &caps) const
 {
     // https://www.webmproject.org/vp9/levels
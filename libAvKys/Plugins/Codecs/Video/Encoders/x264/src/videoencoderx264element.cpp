@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
 #include <QVariant>
@@ -96,6 +97,9 @@ class VideoEncoderX264ElementPrivate
         QMutex m_mutex;
         qint64 m_id {0};
         int m_index {0};
+        int m_presetIndex {0};
+        int m_frameReference {0};
+        int m_speedLevel {0};
         bool m_initialized {false};
         bool m_paused {false};
         qint64 m_encodedTimePts {0};
@@ -109,6 +113,7 @@ class VideoEncoderX264ElementPrivate
         void updateOutputCaps(const AkVideoCaps &inputCaps);
         void encodeFrame(const AkVideoPacket &src);
         void sendFrame(const x264_nal_t *nal, int writtenSize) const;
+        void setSpeedLevel(int speedLevel);
         unsigned int x264Level(const AkVideoCaps &caps) const;
 };
 
@@ -414,6 +419,22 @@ bool VideoEncoderX264ElementPrivate::init()
     memset(&this->m_frameOut, 0, sizeof(x264_picture_t));
     this->updateHeaders();
 
+    // The speed governor can go up to ultrafast from the selected preset.
+    auto preset = self->optionValue("preset").toString();
+    this->m_presetIndex = 0;
+
+    for (int i = 0; x264_preset_names[i]; i++)
+        if (preset == x264_preset_names[i]) {
+            this->m_presetIndex = i;
+
+            break;
+        }
+
+    this->m_frameReference = params.i_frame_reference;
+    this->m_speedLevel = 0;
+    self->startSpeedGovernor(this->m_videoConverter.outputCaps().fps(),
+                             this->m_presetIndex);
+
     if (this->m_fpsControl) {
         this->m_fpsControl->setProperty("fps", QVariant::fromValue(this->m_videoConverter.outputCaps().fps()));
         this->m_fpsControl->setProperty("fillGaps", self->fillGaps());
@@ -547,6 +568,8 @@ void VideoEncoderX264ElementPrivate::updateOutputCaps(const AkVideoCaps &inputCa
 
 void VideoEncoderX264ElementPrivate::encodeFrame(const AkVideoPacket &src)
 {
+    QElapsedTimer timer;
+    timer.start();
     this->m_id = src.id();
     this->m_index = src.index();
 
@@ -581,6 +604,8 @@ void VideoEncoderX264ElementPrivate::encodeFrame(const AkVideoPacket &src)
 
     this->m_encodedTimePts = src.pts() + src.duration();
     emit self->encodedTimePtsChanged(this->m_encodedTimePts);
+
+    this->setSpeedLevel(self->updateSpeedGovernor(timer.nsecsElapsed()));
 }
 
 void VideoEncoderX264ElementPrivate::sendFrame(const x264_nal_t *nal,
@@ -601,6 +626,46 @@ void VideoEncoderX264ElementPrivate::sendFrame(const x264_nal_t *nal,
     emit self->oStream(packet);
 }
 
+void VideoEncoderX264ElementPrivate::setSpeedLevel(int speedLevel)
+{
+    if (this->m_speedLevel == speedLevel)
+        return;
+
+    this->m_speedLevel = speedLevel;
+
+    /* x264 can't switch the preset of an open encoder, but the analysis
+     * parameters, that are the bulk of the encoding time, can be replaced
+     * with the ones of a faster preset.
+     */
+    auto preset = x264_preset_names[qMax(this->m_presetIndex - speedLevel, 0)];
+    x264_param_t presetParams;
+    memset(&presetParams, 0, sizeof(x264_param_t));
+
+    if (x264_param_default_preset(&presetParams,
+                                  preset,
+                                  self->optionValue("tuneContent").toString().toStdString().c_str()) < 0) {
+        return;
+    }
+
+    x264_param_t params;
+    x264_encoder_parameters(this->m_encoder, &params);
+
+    // Keep the tools restricted by the profile.
+    auto transform8x8 = params.analyse.b_transform_8x8;
+    auto weightedPred = params.analyse.i_weighted_pred;
+    auto weightedBipred = params.analyse.b_weighted_bipred;
+    params.analyse = presetParams.analyse;
+    params.analyse.b_transform_8x8 = transform8x8;
+    params.analyse.i_weighted_pred = weightedPred;
+    params.analyse.b_weighted_bipred = weightedBipred;
+    // The encoder can't use more references than it was opened with.
+    params.i_frame_reference = qMin(this->m_frameReference,
+                                    presetParams.i_frame_reference);
+
+    if (x264_encoder_reconfig(this->m_encoder, &params) < 0)
+        qCritical() << "Can't switch to the" << preset << "preset";
+}
+
 unsigned int VideoEncoderX264ElementPrivate::x264Level(const AkVideoCaps &caps) const
 {
     int mbWidth = (caps.width() + 15) / 16;
@@ -22,11 +22,11 @@
 #include <QSize>
 #include <QVariant>
 #include <QVector>
-#include <qrgb.h>
 #include <akfrac.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
+#include <akvideoconvolver.h>
 #include <akvideopacket.h>
 
 #include "convolveelement.h"
@@ -40,6 +40,7 @@ class ConvolveElementPrivate
         QMutex m_mutex;
         int m_bias {0};
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_argbpack, 0, 0, {}}};
+        AkVideoConvolver m_convolver;
 };
 
 ConvolveElement::ConvolveElement(): AkElement()
@@ -51,6 +52,7 @@ ConvolveElement::ConvolveElement(): AkElement()
         0, 1, 0,
         0, 0, 0
     };
+    this->d->m_convolver.setKernel(this->d->m_kernel, this->d->m_kernelSize);
 }
 
 ConvolveElement::~ConvolveElement()
@@ -108,9 +110,6 @@ AkPacket ConvolveElement::iVideoStream(const AkVideoPacket &packet)
     if (!src)
         return {};
 
-    AkVideoPacket dst(src.caps());
-    dst.copyMetadata(src);
-
     this->d->m_mutex.lock();
 
     if (this->d->m_kernel.size() < 9) {
@@ -122,60 +121,7 @@ AkPacket ConvolveElement::iVideoStream(const AkVideoPacket &packet)
         return packet;
     }
 
-    auto kernel = this->d->m_kernel.constData();
-    qint64 factorNum = this->d->m_factor.num();
-    qint64 factorDen = this->d->m_factor.den();
-    int kernelWidth = this->d->m_kernelSize.width();
-    int kernelHeight = this->d->m_kernelSize.height();
-
-    int minI = -(kernelWidth - 1) / 2;
-    int maxI = (kernelWidth + 1) / 2;
-    int minJ = -(kernelHeight - 1) / 2;
-    int maxJ = (kernelHeight + 1) / 2;
-
-    for (int y = 0; y < src.caps().height(); y++) {
-        auto iLine = reinterpret_cast<const QRgb *>(src.constLine(0, y));
-        auto oLine = reinterpret_cast<QRgb *>(dst.line(0, y));
-
-        for (int x = 0; x < src.caps().width(); x++) {
-            int r = 0;
-            int g = 0;
-            int b = 0;
-
-            for (int j = minJ, k = 0; j < maxJ; j++) {
-                int yp = qBound(0, y + j, src.caps().height() - 1);
-                auto iLine =
-                        reinterpret_cast<const QRgb *>(src.constLine(0, yp));
-
-                for (int i = minI; i < maxI; i++, k++) {
-                    int xp = qBound(0, x + i, src.caps().width() - 1);
-
-                    if (kernel[k]) {
-                        auto pixel = iLine[xp];
-                        r += kernel[k] * qRed(pixel);
-                        g += kernel[k] * qGreen(pixel);
-                        b += kernel[k] * qBlue(pixel);
-                    }
-                }
-            }
-
-            if (factorNum) {
-                r = int(factorNum * r / factorDen + this->d->m_bias);
-                g = int(factorNum * g / factorDen + this->d->m_bias);
-                b = int(factorNum * b / factorDen + this->d->m_bias);
-
-                r = qBound(0, r, 255);
-                g = qBound(0, g, 255);
-                b = qBound(0, b, 255);
-            } else {
-                r = 255;
-                g = 255;
-                b = 255;
-            }
-
-            oLine[x] = qRgba(r, g, b, qAlpha(iLine[x]));
-        }
-    }
+    auto dst = this->d->m_convolver.convolve(src);
 
     this->d->m_mutex.unlock();
 
@@ -197,6 +143,7 @@ void ConvolveElement::setKernel(const QVariantList &kernel)
 
     this->d->m_mutex.lock();
     this->d->m_kernel = k;
+    this->d->m_convolver.setKernel(k);
     this->d->m_mutex.unlock();
     emit this->kernelChanged(kernel);
 }
@@ -208,6 +155,7 @@ void ConvolveElement::setKernelSize(const QSize &kernelSize)
 
     this->d->m_mutex.lock();
     this->d->m_kernelSize = kernelSize;
+    this->d->m_convolver.setKernelSize(kernelSize);
     this->d->m_mutex.unlock();
     emit this->kernelSizeChanged(kernelSize);
 }
@@ -219,6 +167,7 @@ void ConvolveElement::setFactor(const AkFrac &factor)
 
     this->d->m_mutex.lock();
     this->d->m_factor = factor;
+    this->d->m_convolver.setFactor(factor);
     this->d->m_mutex.unlock();
     emit this->factorChanged(factor);
 }
@@ -230,6 +179,7 @@ void ConvolveElement::setBias(int bias)
 
     this->d->m_mutex.lock();
     this->d->m_bias = bias;
+    this->d->m_convolver.setBias(bias);
     this->d->m_mutex.unlock();
     emit this->biasChanged(bias);
 }
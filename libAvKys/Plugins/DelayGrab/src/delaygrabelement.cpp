@@ -23,10 +23,10 @@
 #include <QQmlContext>
 #include <QRandomGenerator>
 #include <QSize>
-#include <QVector>
 #include <QtMath>
 #include <qrgb.h>
 #include <akfrac.h>
+#include <akframering.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
@@ -42,7 +42,7 @@ class DelayGrabElementPrivate
         int m_nFrames {71};
         QMutex m_mutex;
         QSize m_frameSize;
-        QVector<AkVideoPacket> m_frames;
+        AkFrameRing m_frames {71};
         AkVideoPacket m_delayMap;
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_argbpack, 0, 0, {}}};
 
@@ -109,11 +109,8 @@ AkPacket DelayGrabElement::iVideoStream(const AkVideoPacket &packet)
     }
 
     int nFrames = this->d->m_nFrames > 0? this->d->m_nFrames: 1;
-    this->d->m_frames << src;
-    int diff = this->d->m_frames.size() - nFrames;
-
-    for (int i = 0; i < diff; i++)
-        this->d->m_frames.removeFirst();
+    this->d->m_frames.setCapacity(nFrames);
+    this->d->m_frames.push(src);
 
     if (this->d->m_frames.isEmpty()) {
         if (packet)
@@ -151,7 +148,7 @@ AkPacket DelayGrabElement::iVideoStream(const AkVideoPacket &packet)
         for (int x = 0; x < delayMapWidth; x++) {
             int curFrame = qAbs(this->d->m_frames.size() - delayLine[x] - 1)
                            % this->d->m_frames.size();
-            auto &frame = this->d->m_frames[curFrame];
+            auto &frame = this->d->m_frames.at(curFrame);
             size_t iLineSize = frame.lineSize(0);
             size_t xoffset = blockSize * x * sizeof(QRgb);
             auto srcLineX = frame.constLine(0, yb) + xoffset;
@@ -49,10 +49,19 @@
 #include <X11/extensions/Xrandr.h>
 #endif
 
+#ifdef HAVE_XDAMAGE_SUPPORT
+#include <X11/extensions/Xdamage.h>
+#endif
+
 #include "xlibdev.h"
 
 #define DEFAULT_XIMAGE_FORMAT ZPixmap
 
+/* If the screen has more damaged rectangles than this, read the bounding
+ * rectangle of all of them in one request.
+ */
+#define MAX_DAMAGED_RECTS 16
+
 class XlibDevPrivate
 {
     public:
@@ -73,15 +82,33 @@ class XlibDevPrivate
         XShmSegmentInfo m_shmInfo;
 #endif
         XImage *m_xImage {nullptr};
+        Visual *m_visual {nullptr};
+        int m_depth {0};
+#ifdef HAVE_XDAMAGE_SUPPORT
+        Damage m_damage {0};
+        XserverRegion m_damagedRegion {0};
+#endif
+        AkVideoPacket m_frame;
+        QRect m_cursorRect;
+        unsigned long m_cursorSerial {0};
         AkElementPtr m_rotateFilter {akPluginManager->create<AkElement>("VideoFilter/Rotate")};
         bool m_haveShmExtension {false};
         bool m_showCursor {false};
         bool m_followCursor {false};
+        bool m_useDamage {false};
 
         explicit XlibDevPrivate(XlibDev *self);
         AkVideoCaps::PixelFormat pixelFormat(int depth, int bpp) const;
         qreal screenRotation() const;
         void readFrame();
+        void readDamagedFrame();
+        QVector<QRect> damagedRects();
+        bool grabRect(const QRect &rect);
+#ifdef HAVE_XFIXES_SUPPORT
+        XFixesCursorImage *readCursor(QVector<QRect> &dirtyRegion);
+        void drawCursor(AkVideoPacket &packet,
+                        const XFixesCursorImage *cursorImage) const;
+#endif
         void updateDevices();
 };
 
@@ -281,19 +308,19 @@ bool XlibDev::init()
     XGetWindowAttributes(this->d->m_display,
                          this->d->m_rootWindow,
                          &this->d->m_windowAttributes);
+    this->d->m_visual = DefaultVisual(this->d->m_display, screen);
+    this->d->m_depth = DefaultDepth(this->d->m_display, screen);
 #ifdef HAVE_XEXT_SUPPORT
     this->d->m_haveShmExtension = XShmQueryExtension(this->d->m_display);
 
     if (this->d->m_haveShmExtension) {
-        auto visual = DefaultVisual(this->d->m_display, screen);
-        auto depth = DefaultDepth(this->d->m_display, screen);
         this->d->m_shmInfo.shmseg = 0;
         this->d->m_shmInfo.shmid = -1;
         this->d->m_shmInfo.shmaddr = (char *) -1;
         this->d->m_shmInfo.readOnly = false;
         this->d->m_xImage = XShmCreateImage(this->d->m_display,
-                                            visual,
-                                            depth,
+                                            this->d->m_visual,
+                                            this->d->m_depth,
                                             DEFAULT_XIMAGE_FORMAT,
                                             nullptr,
                                             &this->d->m_shmInfo,
@@ -354,6 +381,32 @@ bool XlibDev::init()
     }
 #endif
 
+#ifdef HAVE_XDAMAGE_SUPPORT
+    /* Watch the changes in the screen, so only the areas that changed are
+     * read, instead of reading the whole screen in every frame.
+     */
+    this->d->m_useDamage = false;
+    int damageEvent = 0;
+    int damageError = 0;
+    int fixesEvent = 0;
+    int fixesError = 0;
+
+    if (XDamageQueryExtension(this->d->m_display, &damageEvent, &damageError)
+        && XFixesQueryExtension(this->d->m_display, &fixesEvent, &fixesError)) {
+        this->d->m_damage = XDamageCreate(this->d->m_display,
+                                          this->d->m_rootWindow,
+                                          XDamageReportNonEmpty);
+        this->d->m_damagedRegion = XFixesCreateRegion(this->d->m_display,
+                                                      nullptr,
+                                                      0);
+        this->d->m_useDamage = this->d->m_damage && this->d->m_damagedRegion;
+    }
+#endif
+
+    this->d->m_frame = {};
+    this->d->m_cursorRect = {};
+    this->d->m_cursorSerial = 0;
+
     // Disable sync for fast capture
 
 #ifdef HAVE_XEXT_SUPPORT
@@ -374,6 +427,24 @@ bool XlibDev::uninit()
 {
     this->d->m_timer.stop();
 
+#ifdef HAVE_XDAMAGE_SUPPORT
+    if (this->d->m_display) {
+        if (this->d->m_damage) {
+            XDamageDestroy(this->d->m_display, this->d->m_damage);
+            this->d->m_damage = 0;
+        }
+
+        if (this->d->m_damagedRegion) {
+            XFixesDestroyRegion(this->d->m_display, this->d->m_damagedRegion);
+            this->d->m_damagedRegion = 0;
+        }
+    }
+
+    this->d->m_useDamage = false;
+#endif
+
+    this->d->m_frame = {};
+
 #ifdef HAVE_XEXT_SUPPORT
     if (this->d->m_haveShmExtension && this->d->m_display) {
         XShmDetach(this->d->m_display, &this->d->m_shmInfo);
@@ -444,6 +515,12 @@ void XlibDevPrivate::readFrame()
     if (!this->m_display)
         return;
 
+    if (this->m_useDamage) {
+        this->readDamagedFrame();
+
+        return;
+    }
+
     XImage *image = nullptr;
 
 #ifdef HAVE_XEXT_SUPPORT
@@ -585,6 +662,299 @@ void XlibDevPrivate::readFrame()
     emit self->oStream(videoPacket);
 }
 
+void XlibDevPrivate::readDamagedFrame()
+{
+    QVector<QRect> dirtyRegion;
+
+    if (this->m_frame) {
+        dirtyRegion = this->damagedRects();
+    } else {
+        // Read the whole screen the first time.
+        this->damagedRects();
+        dirtyRegion << QRect(0,
+                             0,
+                             this->m_windowAttributes.width,
+                             this->m_windowAttributes.height);
+    }
+
+    // Read the damaged areas to the frame.
+    if (dirtyRegion.size() > MAX_DAMAGED_RECTS) {
+        QRect boundingRect;
+
+        for (auto &rect: dirtyRegion)
+            boundingRect |= rect;
+
+        dirtyRegion = {boundingRect};
+    }
+
+    for (auto &rect: dirtyRegion)
+        if (!this->grabRect(rect)) {
+            // Read the whole screen again in the next frame.
+            this->m_frame = {};
+
+            return;
+        }
+
+    if (!this->m_frame)
+        return;
+
+#ifdef HAVE_XFIXES_SUPPORT
+    XFixesCursorImage *cursorImage = nullptr;
+
+    if (this->m_followCursor)
+        cursorImage = this->readCursor(dirtyRegion);
+#endif
+
+    // Nothing changed, don't send the frame.
+    if (dirtyRegion.isEmpty()) {
+#ifdef HAVE_XFIXES_SUPPORT
+        if (cursorImage)
+            XFree(cursorImage);
+#endif
+
+        return;
+    }
+
+    // The cursor is drawn in a copy, so the frame keeps only the screen.
+    AkVideoPacket videoPacket = this->m_frame;
+
+#ifdef HAVE_XFIXES_SUPPORT
+    if (cursorImage) {
+        this->drawCursor(videoPacket, cursorImage);
+        XFree(cursorImage);
+    }
+#endif
+
+    this->m_mutex.lock();
+    auto fps = this->m_fps;
+    this->m_mutex.unlock();
+
+    auto pts = qRound64(QTime::currentTime().msecsSinceStartOfDay()
+                        * fps.value() / 1e3);
+    videoPacket.setPts(pts);
+    videoPacket.setDuration(1);
+    videoPacket.setTimeBase(fps.invert());
+    videoPacket.setIndex(0);
+    videoPacket.setId(this->m_id);
+    videoPacket.setDirtyRegion(dirtyRegion);
+
+#ifdef HAVE_XRANDR_SUPPORT
+    if (this->m_rotateFilter) {
+        auto angle = -this->screenRotation();
+
+        if (!qFuzzyIsNull(angle)) {
+            this->m_rotateFilter->setProperty("angle", angle);
+            videoPacket = this->m_rotateFilter->iStream(videoPacket);
+
+            // The rectangles are not valid for the rotated frame.
+            videoPacket.setDirtyRegion({});
+        }
+    }
+#endif
+
+    emit self->oStream(videoPacket);
+}
+
+QVector<QRect> XlibDevPrivate::damagedRects()
+{
+    QVector<QRect> rects;
+
+#ifdef HAVE_XDAMAGE_SUPPORT
+    /* The damage events only tell that something changed, the damaged area
+     * is read from the region, so just discard them.
+     */
+    while (XPending(this->m_display)) {
+        XEvent event;
+        XNextEvent(this->m_display, &event);
+    }
+
+    // Move the damaged area to the region and clear it.
+    XDamageSubtract(this->m_display,
+                    this->m_damage,
+                    None,
+                    this->m_damagedRegion);
+    int nRects = 0;
+    auto damagedRects = XFixesFetchRegion(this->m_display,
+                                          this->m_damagedRegion,
+                                          &nRects);
+
+    if (!damagedRects)
+        return {};
+
+    QRect screenRect(0,
+                     0,
+                     this->m_windowAttributes.width,
+                     this->m_windowAttributes.height);
+
+    for (int i = 0; i < nRects; i++) {
+        auto rect = screenRect.intersected({damagedRects[i].x,
+                                            damagedRects[i].y,
+                                            damagedRects[i].width,
+                                            damagedRects[i].height});
+
+        if (!rect.isEmpty())
+            rects << rect;
+    }
+
+    XFree(damagedRects);
+#endif
+
+    return rects;
+}
+
+bool XlibDevPrivate::grabRect(const QRect &rect)
+{
+    XImage *image = nullptr;
+
+#ifdef HAVE_XEXT_SUPPORT
+    if (this->m_haveShmExtension) {
+        // Read the rectangle to the beginning of the shared memory segment.
+        image = XShmCreateImage(this->m_display,
+                                this->m_visual,
+                                this->m_depth,
+                                DEFAULT_XIMAGE_FORMAT,
+                                this->m_shmInfo.shmaddr,
+                                &this->m_shmInfo,
+                                rect.width(),
+                                rect.height());
+
+        if (image && !XShmGetImage(this->m_display,
+                                   this->m_rootWindow,
+                                   image,
+                                   rect.x(),
+                                   rect.y(),
+                                   AllPlanes)) {
+            image->data = nullptr;
+            XDestroyImage(image);
+            image = nullptr;
+        }
+    } else {
+#endif
+        image = XGetImage(this->m_display,
+                          this->m_rootWindow,
+                          rect.x(),
+                          rect.y(),
+                          rect.width(),
+                          rect.height(),
+                          AllPlanes,
+                          DEFAULT_XIMAGE_FORMAT);
+#ifdef HAVE_XEXT_SUPPORT
+    }
+#endif
+
+    if (!image)
+        return false;
+
+    bool ok = image->bitmap_pad == 32;
+
+    if (ok && !this->m_frame) {
+        AkVideoCaps videoCaps(this->pixelFormat(image->depth,
+                                                image->bits_per_pixel),
+                              this->m_windowAttributes.width,
+                              this->m_windowAttributes.height,
+                              this->m_fps);
+        this->m_frame = AkVideoPacket(videoCaps, true);
+    }
+
+    if (ok) {
+        auto pixelSize = size_t(image->bits_per_pixel / 8);
+        auto xOffset = size_t(rect.x()) * pixelSize;
+        auto lineSize =
+            qMin<size_t>(size_t(rect.width()) * pixelSize,
+                         this->m_frame.lineSize(0) - xOffset);
+
+        for (int y = 0; y < rect.height(); y++) {
+            auto src = image->data + y * image->bytes_per_line;
+            auto dst = this->m_frame.line(0, rect.y() + y) + xOffset;
+            memcpy(dst, src, lineSize);
+        }
+    }
+
+#ifdef HAVE_XEXT_SUPPORT
+    // The shared memory segment is released in uninit().
+    if (this->m_haveShmExtension)
+        image->data = nullptr;
+#endif
+
+    XDestroyImage(image);
+
+    return ok;
+}
+
+#ifdef HAVE_XFIXES_SUPPORT
+XFixesCursorImage *XlibDevPrivate::readCursor(QVector<QRect> &dirtyRegion)
+{
+    auto cursorImage = XFixesGetCursorImage(this->m_display);
+
+    if (!cursorImage)
+        return nullptr;
+
+    QRect cursorRect(cursorImage->x,
+                     cursorImage->y,
+                     cursorImage->width,
+                     cursorImage->height);
+    cursorRect &= QRect(0,
+                        0,
+                        this->m_frame.caps().width(),
+                        this->m_frame.caps().height());
+
+    // Both the old and the new positions of the cursor must be repainted.
+    if (cursorRect != this->m_cursorRect
+        || cursorImage->cursor_serial != this->m_cursorSerial) {
+        if (!this->m_cursorRect.isEmpty())
+            dirtyRegion << this->m_cursorRect;
+
+        if (!cursorRect.isEmpty())
+            dirtyRegion << cursorRect;
+
+        this->m_cursorRect = cursorRect;
+        this->m_cursorSerial = cursorImage->cursor_serial;
+    }
+
+    return cursorImage;
+}
+
+void XlibDevPrivate::drawCursor(AkVideoPacket &packet,
+                                const XFixesCursorImage *cursorImage) const
+{
+    // The cursor is only blended in 32 bits frames.
+    if (packet.pixelSize(0) != 4)
+        return;
+
+    auto &cursorRect = this->m_cursorRect;
+
+    for (int y = 0; y < cursorRect.height(); y++) {
+        auto cursorLine = cursorImage->pixels
+                          + y * cursorImage->width;
+        auto line =
+            reinterpret_cast<quint32 *>(packet.line(0, cursorRect.y() + y))
+            + cursorRect.x();
+
+        for (int x = 0; x < cursorRect.width(); x++) {
+            auto &cursorPixel = cursorLine[x];
+            auto cursorA = quint8((cursorPixel >> 24) & 0xff);
+            auto cursorR = quint8((cursorPixel >> 16) & 0xff);
+            auto cursorG = quint8((cursorPixel >> 8) & 0xff);
+            auto cursorB = quint8(cursorPixel & 0xff);
+
+            auto &imagePixel = line[x];
+            auto imageR = quint8((imagePixel >> 16) & 0xff);
+            auto imageG = quint8((imagePixel >> 8) & 0xff);
+            auto imageB = quint8(imagePixel & 0xff);
+
+            quint8 r = (cursorA * (cursorR - imageR) + 255 * imageR) / 255;
+            quint8 g = (cursorA * (cursorG - imageG) + 255 * imageG) / 255;
+            quint8 b = (cursorA * (cursorB - imageB) + 255 * imageB) / 255;
+
+            imagePixel = (imagePixel & 0xff000000)
+                         | (quint32(r) << 16)
+                         | (quint32(g) << 8)
+                         | quint32(b);
+        }
+    }
+}
+#endif
+
 void XlibDevPrivate::updateDevices()
 {
     decltype(this->m_device) device;
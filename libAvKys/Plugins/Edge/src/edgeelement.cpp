@@ -18,8 +18,7 @@
  */
 
 #include <QQmlContext>
-#include <QVector>
-#include <QtMath>
+#include <akedgedetector.h>
 #include <akfrac.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
@@ -37,20 +36,10 @@ class EdgeElementPrivate
         bool m_equalize {false};
         bool m_invert {false};
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_ya88pack, 0, 0, {}}};
+        AkEdgeDetector m_edgeDetector;
 
         AkVideoPacket equalize(const AkVideoPacket &src);
-        void sobel(const AkVideoPacket &gray,
-                   AkVideoPacket &gradient,
-                   AkVideoPacket &direction) const;
-        AkVideoPacket thinning(const AkVideoPacket &gradient,
-                               const AkVideoPacket &direction) const;
-        AkVideoPacket threshold(const AkVideoPacket &thinned,
-                                const QVector<int> &thresholds,
-                                const QVector<int> &map) const;
-        void trace(AkVideoPacket &canny,
-                   int x,
-                   int y) const;
-        AkVideoPacket hysteresisThresholding(const AkVideoPacket &thresholded) const;
+        AkVideoPacket luma(const AkVideoPacket &src) const;
 };
 
 EdgeElement::EdgeElement(): AkElement()
@@ -122,17 +111,13 @@ AkPacket EdgeElement::iVideoStream(const AkVideoPacket &packet)
     else
         src_ = src;
 
-    AkVideoPacket gradient;
-    AkVideoPacket direction;
-    this->d->sobel(src_, gradient, direction);
+    auto gray = this->d->luma(src_);
     auto invert = this->d->m_invert;
 
     if (this->d->m_canny) {
-        auto thinned = this->d->thinning(gradient, direction);
-        QVector<int> thresholds {this->d->m_thLow, this->d->m_thHi};
-        QVector<int> colors {0, 127, 255};
-        auto thresholded = this->d->threshold(thinned, thresholds, colors);
-        auto canny = this->d->hysteresisThresholding(thresholded);
+        auto canny = this->d->m_edgeDetector.canny(gray,
+                                                   this->d->m_thLow,
+                                                   this->d->m_thHi);
 
         for (int y = 0; y < src.caps().height(); y++) {
             auto cannyLine = canny.constLine(0, y);
@@ -147,6 +132,8 @@ AkPacket EdgeElement::iVideoStream(const AkVideoPacket &packet)
             }
         }
     } else {
+        auto gradient = this->d->m_edgeDetector.gradient(gray);
+
         for (int y = 0; y < src.caps().height(); y++) {
             auto gradientLine = reinterpret_cast<const quint16 *>(gradient.constLine(0, y));
             auto srcLine = reinterpret_cast<const quint16 *>(src_.constLine(0, y));
@@ -289,256 +276,20 @@ AkVideoPacket EdgeElementPrivate::equalize(const AkVideoPacket &src)
     return dst;
 }
 
-void EdgeElementPrivate::sobel(const AkVideoPacket &gray,
-                               AkVideoPacket &gradient,
-                               AkVideoPacket &direction) const
+AkVideoPacket EdgeElementPrivate::luma(const AkVideoPacket &src) const
 {
-    auto caps = gray.caps();
-    caps.setFormat(AkVideoCaps::Format_y16);
-    gradient = {caps};
-    gradient.copyMetadata(gray);
+    auto caps = src.caps();
     caps.setFormat(AkVideoCaps::Format_y8);
-    direction = {caps};
-    direction.copyMetadata(gray);
-
-    auto width_1 = gray.caps().width() - 1;
-    auto height_1 = gray.caps().height() - 1;
-
-    for (int y = 0; y < gray.caps().height(); y++) {
-        auto grayLine = reinterpret_cast<const quint16 *>(gray.constLine(0, y));
-        auto grayLine_m1 = reinterpret_cast<const quint16 *>(gray.constLine(0, qMax(y - 1, 0)));
-        auto grayLine_p1 = reinterpret_cast<const quint16 *>(gray.constLine(0, qMin(y + 1, height_1)));
-
-        auto gradientLine  = reinterpret_cast<quint16 *>(gradient.line(0, y));
-        auto directionLine = direction.line(0, y);
-
-        for (int x = 0; x < gray.caps().width(); x++) {
-            int x_m1 = qMax(x - 1, 0);
-            int x_p1 = qMin(x + 1,  width_1);
-
-            int pixel_m1_p1 = grayLine_m1[x_p1] >> 8;
-            int pixel_p1_p1 = grayLine_p1[x_p1] >> 8;
-            int pixel_m1_m1 = grayLine_m1[x_m1] >> 8;
-            int pixel_p1_m1 = grayLine_p1[x_m1] >> 8;
-
-            int gradX = pixel_m1_p1
-                      + 2 * int(grayLine[x_p1] >> 8)
-                      + pixel_p1_p1
-                      - pixel_m1_m1
-                      - 2 * int(grayLine[x_m1] >> 8)
-                      - pixel_p1_m1;
-
-            int gradY = pixel_m1_m1
-                      + 2 * int(grayLine_m1[x] >> 8)
-                      + pixel_m1_p1
-                      - pixel_p1_m1
-                      - 2 * int(grayLine_p1[x] >> 8)
-                      - pixel_p1_p1;
-
-            gradientLine[x] = quint16(qAbs(gradX) + qAbs(gradY));
-
-            /* Gradient directions are classified in 4 possible cases
-             *
-             * dir 0
-             *
-             * x x x
-             * - - -
-             * x x x
-             *
-             * dir 1
-             *
-             * x x /
-             * x / x
-             * / x x
-             *
-             * dir 2
-             *
-             * \ x x
-             * x \ x
-             * x x \
-             *
-             * dir 3
-             *
-             * x | x
-             * x | x
-             * x | x
-             */
-            if (gradX == 0 && gradY == 0)
-                directionLine[x] = 0;
-            else if (gradX == 0)
-                directionLine[x] = 3;
-            else {
-                qreal a = 180. * atan(qreal(gradY) / gradX) / M_PI;
-
-                if (a >= -22.5 && a < 22.5)
-                    directionLine[x] = 0;
-                else if (a >= 22.5 && a < 67.5)
-                    directionLine[x] = 1;
-                else if (a >= -67.5 && a < -22.5)
-                    directionLine[x] = 2;
-                else
-                    directionLine[x] = 3;
-            }
-        }
-    }
-}
-
-AkVideoPacket EdgeElementPrivate::thinning(const AkVideoPacket &gradient,
-                                           const AkVideoPacket &direction) const
-{
-    AkVideoPacket thinned(gradient.caps(), true);
-    thinned.copyMetadata(gradient);
-
-    auto width_1 = gradient.caps().width() - 1;
-    auto height_1 = gradient.caps().height() - 1;
-
-    for (int y = 0; y < gradient.caps().height(); y++) {
-        auto edgesLine = reinterpret_cast<const quint16 *>(gradient.constLine(0, y));
-        auto edgesLine_m1 = reinterpret_cast<const quint16 *>(gradient.constLine(0, qMax(y - 1, 0)));
-        auto edgesLine_p1 = reinterpret_cast<const quint16 *>(gradient.constLine(0, qMin(y + 1, height_1)));
-
-        auto edgesAngleLine = direction.constLine(0, y);
-        auto thinnedLine = reinterpret_cast<quint16 *>(thinned.line(0, y));
-
-        for (int x = 0; x < gradient.caps().width(); x++) {
-            int x_m1 = qMax(x - 1, 0);
-            int x_p1 = qMin(x + 1,  width_1);
-
-            auto &direction = edgesAngleLine[x];
-
-            if (direction == 0) {
-                /* x x x
-                 * - - -
-                 * x x x
-                 */
-                if (edgesLine[x] >= edgesLine[x_m1]
-                    && edgesLine[x] >= edgesLine[x_p1])
-                    thinnedLine[x] = edgesLine[x];
-            } else if (direction == 1) {
-                /* x x /
-                 * x / x
-                 * / x x
-                 */
-                if (edgesLine[x] >= edgesLine_m1[x_p1]
-                    && edgesLine[x] >= edgesLine_p1[x_m1])
-                    thinnedLine[x] = edgesLine[x];
-            } else if (direction == 2) {
-                /* \ x x
-                 * x \ x
-                 * x x \
-                 */
-                if (edgesLine[x] >= edgesLine_m1[x_m1]
-                    && edgesLine[x] >= edgesLine_p1[x_p1])
-                    thinnedLine[x] = edgesLine[x];
-            } else {
-                /* x | x
-                 * x | x
-                 * x | x
-                 */
-                if (edgesLine[x] >= edgesLine_m1[x]
-                    && edgesLine[x] >= edgesLine_p1[x])
-                    thinnedLine[x] = edgesLine[x];
-            }
-        }
-    }
-
-    return thinned;
-}
-
-AkVideoPacket EdgeElementPrivate::threshold(const AkVideoPacket &thinned,
-                                            const QVector<int> &thresholds,
-                                            const QVector<int> &map) const
-{
-    auto caps = thinned.caps();
-    caps.setFormat(AkVideoCaps::Format_y8);
-    AkVideoPacket out(caps);
-    out.copyMetadata(thinned);
-
-    for (int y = 0; y < thinned.caps().height(); y++) {
-        auto srcLine = reinterpret_cast<const quint16 *>(thinned.constLine(0, y));
-        auto dstLine = out.line(0, y);
-
-        for (int x = 0; x < thinned.caps().width(); x++) {
-            auto &pixel = srcLine[x];
-            int value = -1;
-
-            for (int j = 0; j < thresholds.size(); j++)
-                if (pixel <= thresholds[j]) {
-                    value = map[j];
-
-                    break;
-                }
-
-            dstLine[x] = quint8(value < 0? map[thresholds.size()]: value);
-        }
-    }
-
-    return out;
-}
-
-AkVideoPacket EdgeElementPrivate::hysteresisThresholding(const AkVideoPacket &thresholded) const
-{
-    auto canny = thresholded;
-
-    for (int y = 0; y < canny.caps().height(); y++)
-        for (int x = 0; x < canny.caps().width(); x++)
-            this->trace(canny, x, y);
-
-    for (int y = 0; y < canny.caps().height(); y++) {
-        auto line = canny.line(0, y);
-
-        for (int x = 0; x < canny.caps().width(); x++) {
-            auto &pixel = line[x];
-
-            if (pixel == 127)
-                pixel = 0;
-        }
-    }
-
-    return canny;
-}
-
-void EdgeElementPrivate::trace(AkVideoPacket &canny, int x, int y) const
-{
-    auto cannyLine = canny.line(0, y);
-
-    if (cannyLine[x] != 255)
-        return;
+    AkVideoPacket gray(caps);
+    gray.copyMetadata(src);
 
-    auto lineSize = canny.lineSize(0);
-    bool isPoint = true;
-
-    for (int j = -1; j < 2; j++) {
-        int nextY = y + j;
-
-        if (nextY < 0 || nextY >= canny.caps().height())
-            continue;
-
-        auto cannyLineNext = cannyLine + j * lineSize;
-
-        for (int i = -1; i < 2; i++) {
-            int nextX = x + i;
-
-            if (i == 0 && j == 0)
-                continue;
-
-            if (nextX < 0 || nextX >= canny.caps().width())
-                continue;
-
-            auto &pixel = cannyLineNext[nextX];
-
-            if (pixel == 127) {
-                pixel = 255;
-                this->trace(canny, nextX, nextY);
-            }
+    for (int y = 0; y < src.caps().height(); y++) {
+        auto srcLine = reinterpret_cast<const quint16 *>(src.constLine(0, y));
+        auto dstLine = gray.line(0, y);
 
-            if (pixel > 0)
-                isPoint = false;
-        }
+        for (int x = 0; x < src.caps().width(); x++)
+            dstLine[x] = quint8(srcLine[x] >> 8);
     }
 
-    if (isPoint)
-        cannyLine[x] = 0;
+    return gray;
 }
-
-#include "moc_edgeelement.cpp"
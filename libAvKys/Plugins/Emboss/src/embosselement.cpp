@@ -23,6 +23,7 @@
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
+#include <akvideoconvolver.h>
 #include <akvideopacket.h>
 
 #include "embosselement.h"
@@ -33,11 +34,19 @@ class EmbossElementPrivate
         qreal m_factor {1.0};
         qreal m_bias {128.0};
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_ya88pack, 0, 0, {}}};
+        AkVideoConvolver m_convolver;
+
+        inline void updateConvolver();
 };
 
 EmbossElement::EmbossElement(): AkElement()
 {
     this->d = new EmbossElementPrivate;
+    this->d->m_convolver.setKernel({2,  1,  0,
+                                    1,  0, -1,
+                                    0, -1, -2},
+                                   {3, 3});
+    this->d->updateConvolver();
 }
 
 EmbossElement::~EmbossElement()
@@ -80,39 +89,7 @@ AkPacket EmbossElement::iVideoStream(const AkVideoPacket &packet)
     if (!src)
         return {};
 
-    AkVideoPacket dst(src.caps());
-    dst.copyMetadata(src);
-
-    auto width_1 = src.caps().width() - 1;
-    auto height_1 = src.caps().height() - 1;
-
-    auto factor = this->d->m_factor;
-    auto bias = this->d->m_bias;
-
-    for (int y = 0; y < src.caps().height(); y++) {
-        auto srcLine = reinterpret_cast<const quint16 *>(src.constLine(0, y));
-        auto srcLine_m1 = reinterpret_cast<const quint16 *>(src.constLine(0, qMax(y - 1, 0)));
-        auto srcLine_p1 = reinterpret_cast<const quint16 *>(src.constLine(0, qMin(y + 1, height_1)));
-
-        auto dstLine  = reinterpret_cast<quint16 *>(dst.line(0, y));
-
-        for (int x = 0; x < src.caps().width(); x++) {
-            int x_m1 = qMax(x - 1, 0);
-            int x_p1 = qMin(x + 1,  width_1);
-
-            int gray = 2 * (srcLine_m1[x_m1] >> 8)
-                     + (srcLine_m1[x] >> 8)
-                     + (srcLine[x_m1] >> 8)
-                     - (srcLine[x_p1] >> 8)
-                     - (srcLine_p1[x] >> 8)
-                     - (2 * srcLine_p1[x_p1] >> 8);
-
-            gray = qRound(factor * gray + bias);
-            quint16 y = quint8(qBound(0, gray, 255));
-            quint16 a = srcLine[x] & 0xff;
-            dstLine[x] = y << 8 | a;
-        }
-    }
+    auto dst = this->d->m_convolver.convolve(src);
 
     if (dst)
         emit this->oStream(dst);
@@ -126,6 +103,7 @@ void EmbossElement::setFactor(qreal factor)
         return;
 
     this->d->m_factor = factor;
+    this->d->updateConvolver();
     emit this->factorChanged(factor);
 }
 
@@ -135,6 +113,7 @@ void EmbossElement::setBias(qreal bias)
         return;
 
     this->d->m_bias = bias;
+    this->d->updateConvolver();
     emit this->biasChanged(bias);
 }
 
@@ -148,4 +127,11 @@ void EmbossElement::resetBias()
     this->setBias(128);
 }
 
+void EmbossElementPrivate::updateConvolver()
+{
+    static const int factorDen = 1024;
+    this->m_convolver.setFactor({qRound(this->m_factor * factorDen), factorDen});
+    this->m_convolver.setBias(qRound(this->m_bias));
+}
+
 #include "moc_embosselement.cpp"
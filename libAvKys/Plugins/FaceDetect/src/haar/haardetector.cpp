@@ -59,6 +59,9 @@
 
 #include <QtMath>
 #include <QtConcurrent>
+#include <akedgedetector.h>
+#include <akvideocaps.h>
+#include <akvideopacket.h>
 
 #include "haarcascade.h"
 #include "haardetector.h"
@@ -76,6 +79,7 @@ class HaarDetectorPrivate
         qreal m_highCannyThreshold {50};
         int m_minNeighbors {3};
         QVector<int> m_weight;
+        AkEdgeDetector m_edgeDetector;
         QMutex m_mutex;
 
         QVector<int> makeWeightTable(int factor) const;
@@ -106,13 +110,7 @@ class HaarDetectorPrivate
         void denoise(int width, int height, const QVector<quint8> &gray,
                      int radius, int mu, int sigma,
                      QVector<quint8> &denoised) const;
-        void sobel(int width, int height, const QVector<quint8> &gray,
-                   QVector<quint16> &gradient, QVector<quint8> &direction) const;
-        QVector<quint16> thinning(int width, int height,
-                                  const QVector<quint16> &gradient,
-                                  const QVector<quint8> &direction) const;
-        QVector<int> calculateHistogram(int width, int height,
-                                        const QVector<quint16> &image,
+        QVector<int> calculateHistogram(const AkVideoPacket &image,
                                         int levels) const;
         QVector<qreal> buildTables(const QVector<int> &histogram) const;
         void forLoop(qreal *maxSum,
@@ -124,14 +122,6 @@ class HaarDetectorPrivate
                      int levels,
                      QVector<int> *index) const;
         QVector<int> otsu(QVector<int> histogram, int classes) const;
-        QVector<quint8> threshold(int width, int height,
-                                  const QVector<quint16> &image,
-                                  const QVector<int> &thresholds,
-                                  const QVector<int> &map) const;
-        void trace(int width, int height, QVector<quint8> &canny,
-                   int x, int y) const;
-        QVector<quint8> hysteresisThresholding(int width, int height,
-                                               const QVector<quint8> &thresholded) const;
         bool areSimilar(const QRect &r1, const QRect &r2, qreal eps) const;
         void markRectangle(const QVector<QRect> &rectangles,
                            QVector<int> &labels,
@@ -400,19 +390,20 @@ void HaarDetectorPrivate::computeIntegral(int width, int height,
 QVector<quint8> HaarDetectorPrivate::canny(int width, int height,
                                            const QVector<quint8> &gray) const
 {
-    QVector<quint16> gradient;
-    QVector<quint8> direction;
-    this->sobel(width, height, gray, gradient, direction);
-    auto thinned = this->thinning(width, height, gradient, direction);
+    AkVideoPacket grayPacket({AkVideoCaps::Format_y8, width, height, {}});
+
+    for (int y = 0; y < height; y++)
+        memcpy(grayPacket.line(0, y),
+               gray.constData() + size_t(y) * size_t(width),
+               size_t(width));
+
+    auto thinned = this->m_edgeDetector.thinnedGradient(grayPacket);
 
     QVector<int> otsu(2);
 
     if (qIsNaN(this->m_lowCannyThreshold)
         || qIsNaN(this->m_highCannyThreshold)) {
-        auto hist = this->calculateHistogram(width,
-                                             height,
-                                             thinned,
-                                             6 * 255 + 1);
+        auto hist = this->calculateHistogram(thinned, 6 * 255 + 1);
         otsu = this->otsu(hist, 3);
     }
 
@@ -422,10 +413,17 @@ QVector<quint8> HaarDetectorPrivate::canny(int width, int height,
     if (!qIsNaN(this->m_highCannyThreshold))
         otsu[1] = int(this->m_highCannyThreshold);
 
-    QVector<int> colors {0, 127, 255};
-    auto thresholded = this->threshold(width, height, thinned, otsu, colors);
+    auto cannyPacket = this->m_edgeDetector.hysteresis(thinned,
+                                                       otsu[0],
+                                                       otsu[1]);
+    QVector<quint8> canny(width * height);
+
+    for (int y = 0; y < height; y++)
+        memcpy(canny.data() + size_t(y) * size_t(width),
+               cannyPacket.constLine(0, y),
+               size_t(width));
 
-    return this->hysteresisThresholding(width, height, thresholded);
+    return canny;
 }
 
 void HaarDetectorPrivate::imagePadding(int width, int height,
@@ -514,158 +512,17 @@ void HaarDetectorPrivate::denoise(int width, int height,
     }
 }
 
-void HaarDetectorPrivate::sobel(int width, int height,
-                                const QVector<quint8> &gray,
-                                QVector<quint16> &gradient,
-                                QVector<quint8> &direction) const
-{
-    gradient.resize(gray.size());
-    direction.resize(gray.size());
-
-    for (int y = 0; y < height; y++) {
-        auto yOffset = size_t(y * width);
-        auto grayLine = gray.constData() + yOffset;
-
-        auto grayLine_m1 = y < 1? grayLine: grayLine - width;
-        auto grayLine_p1 = y >= height - 1? grayLine: grayLine + width;
-
-        quint16 *gradientLine = gradient.data() + yOffset;
-        quint8 *directionLine = direction.data() + yOffset;
-
-        for (int x = 0; x < width; x++) {
-            int x_m1 = x < 1? x: x - 1;
-            int x_p1 = x >= width - 1? x: x + 1;
-
-            int gradX = grayLine_m1[x_p1]
-                      + 2 * grayLine[x_p1]
-                      + grayLine_p1[x_p1]
-                      - grayLine_m1[x_m1]
-                      - 2 * grayLine[x_m1]
-                      - grayLine_p1[x_m1];
-
-            int gradY = grayLine_m1[x_m1]
-                      + 2 * grayLine_m1[x]
-                      + grayLine_m1[x_p1]
-                      - grayLine_p1[x_m1]
-                      - 2 * grayLine_p1[x]
-                      - grayLine_p1[x_p1];
-
-            gradientLine[x] = quint16(qAbs(gradX) + qAbs(gradY));
-
-            /* Gradient directions are classified in 4 possible cases
-             *
-             * dir 0
-             *
-             * x x x
-             * - - -
-             * x x x
-             *
-             * dir 1
-             *
-             * x x /
-             * x / x
-             * / x x
-             *
-             * dir 2
-             *
-             * \ x x
-             * x \ x
-             * x x \
-             *
-             * dir 3
-             *
-             * x | x
-             * x | x
-             * x | x
-             */
-            if (gradX == 0 && gradY == 0)
-                directionLine[x] = 0;
-            else if (gradX == 0)
-                directionLine[x] = 3;
-            else {
-                qreal a = 180. * atan(qreal(gradY) / gradX) / M_PI;
-
-                if (a >= -22.5 && a < 22.5)
-                    directionLine[x] = 0;
-                else if (a >= 22.5 && a < 67.5)
-                    directionLine[x] = 1;
-                else if (a >= -67.5 && a < -22.5)
-                    directionLine[x] = 2;
-                else
-                    directionLine[x] = 3;
-            }
-        }
-    }
-}
-
-QVector<quint16> HaarDetectorPrivate::thinning(int width, int height,
-                                               const QVector<quint16> &gradient,
-                                               const QVector<quint8> &direction) const
-{
-    QVector<quint16> thinned(gradient.size(), 0);
-
-    for (int y = 0; y < height; y++) {
-        int yOffset = y * width;
-        auto edgesLine = gradient.constData() + yOffset;
-        auto edgesLine_m1 = y < 1? edgesLine: edgesLine - width;
-        auto edgesLine_p1 = y >= height - 1? edgesLine: edgesLine + width;
-        auto edgesAngleLine = direction.constData() + yOffset;
-        auto thinnedLine = thinned.data() + yOffset;
-
-        for (int x = 0; x < width; x++) {
-            int x_m1 = x < 1? 0: x - 1;
-            int x_p1 = x >= width - 1? x: x + 1;
-
-            quint8 direction = edgesAngleLine[x];
-
-            if (direction == 0) {
-                /* x x x
-                 * - - -
-                 * x x x
-                 */
-                if (edgesLine[x] >= edgesLine[x_m1]
-                    && edgesLine[x] >= edgesLine[x_p1])
-                    thinnedLine[x] = edgesLine[x];
-            } else if (direction == 1) {
-                /* x x /
-                 * x / x
-                 * / x x
-                 */
-                if (edgesLine[x] >= edgesLine_m1[x_p1]
-                    && edgesLine[x] >= edgesLine_p1[x_m1])
-                    thinnedLine[x] = edgesLine[x];
-            } else if (direction == 2) {
-                /* \ x x
-                 * x \ x
-                 * x x \
-                 */
-                if (edgesLine[x] >= edgesLine_m1[x_m1]
-                    && edgesLine[x] >= edgesLine_p1[x_p1])
-                    thinnedLine[x] = edgesLine[x];
-            } else {
-                /* x | x
-                 * x | x
-                 * x | x
-                 */
-                if (edgesLine[x] >= edgesLine_m1[x]
-                    && edgesLine[x] >= edgesLine_p1[x])
-                    thinnedLine[x] = edgesLine[x];
-            }
-        }
-    }
-
-    return thinned;
-}
-
-QVector<int> HaarDetectorPrivate::calculateHistogram(int width, int height,
-                                                     const QVector<quint16> &image,
+QVector<int> HaarDetectorPrivate::calculateHistogram(const AkVideoPacket &image,
                                                      int levels) const
 {
     QVector<int> histogram(levels, 0);
-    int pixels = width * height;
 
-    for (int i = 0; i < pixels; i++)
-        histogram[image[i]]++;
+    for (int y = 0; y < image.caps().height(); y++) {
+        auto line = reinterpret_cast<const quint16 *>(image.constLine(0, y));
+
+        for (int x = 0; x < image.caps().width(); x++)
+            histogram[line[x]]++;
+    }
 
     // Since we use sum tables add one more to avoid unexistent colors.
     for (int i = 0; i < histogram.size(); i++)
@@ -770,89 +627,6 @@ QVector<int> HaarDetectorPrivate::otsu(QVector<int> histogram,
     return thresholds;
 }
 
-QVector<quint8> HaarDetectorPrivate::threshold(int width, int height,
-                                               const QVector<quint16> &image,
-                                               const QVector<int> &thresholds,
-                                               const QVector<int> &map) const
-{
-    int size = width * height;
-    auto in = image.constData();
-    QVector<quint8> out(size);
-
-    for (int i = 0; i < size; i++) {
-        int value = -1;
-
-        for (int j = 0; j < thresholds.size(); j++)
-            if (in[i] <= thresholds[j]) {
-                value = map[j];
-
-                break;
-            }
-
-        out[i] = quint8(value < 0? map[thresholds.size()]: value);
-    }
-
-    return out;
-}
-
-void HaarDetectorPrivate::trace(int width, int height, QVector<quint8> &canny,
-                                int x, int y) const
-{
-    int yOffset = y * width;
-    quint8 *cannyLine = canny.data() + yOffset;
-
-    if (cannyLine[x] != 255)
-        return;
-
-    bool isPoint = true;
-
-    for (int j = -1; j < 2; j++) {
-        int nextY = y + j;
-
-        if (nextY < 0 || nextY >= height)
-            continue;
-
-        quint8 *cannyLineNext = cannyLine + j * width;
-
-        for (int i = -1; i < 2; i++) {
-            int nextX = x + i;
-
-            if (i == 0 && j == 0)
-                continue;
-
-            if (nextX < 0 || nextX >= width)
-                continue;
-
-            if (cannyLineNext[nextX] == 127) {
-                cannyLineNext[nextX] = 255;
-                this->trace(width, height, canny, nextX, nextY);
-            }
-
-            if (cannyLineNext[nextX] > 0)
-                isPoint = false;
-        }
-    }
-
-    if (isPoint)
-        cannyLine[x] = 0;
-}
-
-QVector<quint8> HaarDetectorPrivate::hysteresisThresholding(int width, int height,
-                                                            const QVector<quint8> &thresholded) const
-{
-    QVector<quint8> canny = thresholded;
-
-    for (int y = 0; y < height; y++)
-        for (int x = 0; x < width; x++)
-            this->trace(width, height, canny, x, y);
-
-    for (auto &c: canny)
-        if (c == 127)
-            c = 0;
-
-    return canny;
-}
-
 bool HaarDetectorPrivate::areSimilar(const QRect &r1, const QRect &r2,
                                      qreal eps) const
 {
@@ -21,6 +21,7 @@
 #include <QSize>
 #include <qrgb.h>
 #include <akfrac.h>
+#include <akframering.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
@@ -41,7 +42,7 @@ class FrameOverlapElementPrivate
     public:
         int m_nFrames {16};
         int m_stride {4};
-        QVector<AkVideoPacket> m_frames;
+        AkFrameRing m_frames {16};
         QSize m_frameSize;
         AkVideoConverter m_videoConverter {{AkVideoCaps::Format_argbpack, 0, 0, {}}};
 };
@@ -98,11 +99,8 @@ AkPacket FrameOverlapElement::iVideoStream(const AkVideoPacket &packet)
         this->d->m_frameSize = frameSize;
     }
 
-    this->d->m_frames << src;
-    int diff = this->d->m_frames.size() - this->d->m_nFrames;
-
-    for (int i = 0; i < diff; i++)
-        this->d->m_frames.removeFirst();
+    this->d->m_frames.setCapacity(this->d->m_nFrames);
+    this->d->m_frames.push(src);
 
     int stride = qMax(this->d->m_stride, 1);
 
@@ -118,7 +116,7 @@ AkPacket FrameOverlapElement::iVideoStream(const AkVideoPacket &packet)
     for (int i = this->d->m_frames.size() - 1;
          i >= 0;
          i -= stride) {
-        auto &frame = this->d->m_frames[i];
+        auto &frame = this->d->m_frames.at(i);
         auto dstLine = sumFrame;
 
         for (int y = 0; y < dst.caps().height(); y++) {
@@ -28,10 +28,14 @@
 #include <akfrac.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
+#include <akvideoconverter.h>
 #include <akvideopacket.h>
 
 #include "imagesrcelement.h"
 
+// Animations bigger than this are decoded on the fly instead of cached.
+#define MAX_CACHE_SIZE (256 * 1024 * 1024)
+
 using ImageToPixelFormatMap = QMap<QImage::Format, AkVideoCaps::PixelFormat>;
 
 inline ImageToPixelFormatMap initImageToPixelFormatMap()
@@ -51,11 +55,20 @@ inline ImageToPixelFormatMap initImageToPixelFormatMap()
 
 Q_GLOBAL_STATIC_WITH_ARGS(ImageToPixelFormatMap, imageToAkFormat, (initImageToPixelFormatMap()))
 
+struct ImageFrame
+{
+    AkVideoPacket packet;
+    int delay {0};
+};
+
+using ImageFramePtr = QSharedPointer<ImageFrame>;
+
 class ImageSrcElementPrivate
 {
     public:
         ImageSrcElement *self;
         AkFrac m_fps {30000, 1001};
+        AkVideoCaps m_outputCaps;
         qint64 m_id {-1};
         QThreadPool m_threadPool;
         QFuture<void> m_framesThreadStatus;
@@ -63,11 +76,19 @@ class ImageSrcElementPrivate
         QImageReader m_imageReader;
         QReadWriteLock m_fpsMutex;
         QReadWriteLock m_imageReaderMutex;
+        QMutex m_framesMutex;
+        QVector<ImageFramePtr> m_frames;
+        QString m_framesMedia;
+        AkFrac m_framesFps;
+        AkVideoCaps m_framesCaps;
         bool m_forceFps {false};
         bool m_threadedRead {true};
         bool m_run {false};
 
         explicit ImageSrcElementPrivate(ImageSrcElement *self);
+        static AkVideoPacket imageToPacket(QImage image, const AkFrac &fps);
+        bool loadFrames(const AkFrac &fps, const AkVideoCaps &outputCaps);
+        ImageFramePtr decodeFrame(const AkFrac &fps);
         void readFrame();
         void sendPacket(const AkPacket &packet);
 };
@@ -146,6 +167,16 @@ AkCaps ImageSrcElement::caps(int stream)
     if (stream != 0 || isFileNameEmpty)
         return {};
 
+    this->d->m_fpsMutex.lockForRead();
+    AkVideoCaps outputCaps = this->d->m_outputCaps;
+    this->d->m_fpsMutex.unlock();
+
+    if (outputCaps) {
+        outputCaps.setFps(this->fps());
+
+        return outputCaps;
+    }
+
     this->d->m_imageReaderMutex.lockForRead();
     auto size = this->d->m_imageReader.size();
     this->d->m_imageReaderMutex.unlock();
@@ -183,6 +214,15 @@ AkFrac ImageSrcElement::fps() const
     return fps;
 }
 
+AkVideoCaps ImageSrcElement::outputCaps() const
+{
+    this->d->m_fpsMutex.lockForRead();
+    auto outputCaps = this->d->m_outputCaps;
+    this->d->m_fpsMutex.unlock();
+
+    return outputCaps;
+}
+
 QStringList ImageSrcElement::supportedFormats() const
 {
     QStringList supportedFormats;
@@ -239,6 +279,22 @@ void ImageSrcElement::setFps(const AkFrac &fps)
     emit this->fpsChanged(fps);
 }
 
+void ImageSrcElement::setOutputCaps(const AkVideoCaps &outputCaps)
+{
+    this->d->m_fpsMutex.lockForWrite();
+
+    if (this->d->m_outputCaps == outputCaps) {
+        this->d->m_fpsMutex.unlock();
+
+        return;
+    }
+
+    this->d->m_outputCaps = outputCaps;
+    this->d->m_fpsMutex.unlock();
+
+    emit this->outputCapsChanged(outputCaps);
+}
+
 void ImageSrcElement::resetForceFps()
 {
     this->setForceFps(false);
@@ -284,6 +340,11 @@ void ImageSrcElement::setMedia(const QString &media)
         emit this->isAnimatedChanged(curIsAnimation);
 }
 
+void ImageSrcElement::resetOutputCaps()
+{
+    this->setOutputCaps({});
+}
+
 void ImageSrcElement::resetMedia()
 {
     this->setMedia({});
@@ -365,23 +426,179 @@ ImageSrcElementPrivate::ImageSrcElementPrivate(ImageSrcElement *self):
     this->m_threadPool.setMaxThreadCount(4);
 }
 
+AkVideoPacket ImageSrcElementPrivate::imageToPacket(QImage image,
+                                                    const AkFrac &fps)
+{
+    if (!imageToAkFormat->contains(image.format()))
+        image = image.convertToFormat(QImage::Format_ARGB32);
+
+    AkVideoCaps caps(imageToAkFormat->value(image.format()),
+                     image.width(),
+                     image.height(),
+                     fps);
+    AkVideoPacket packet(caps);
+    auto lineSize = qMin<size_t>(image.bytesPerLine(), packet.lineSize(0));
+
+    for (int y = 0; y < image.height(); ++y) {
+        auto srcLine = image.constScanLine(y);
+        auto dstLine = packet.line(0, y);
+        memcpy(dstLine, srcLine, lineSize);
+    }
+
+    return packet;
+}
+
+bool ImageSrcElementPrivate::loadFrames(const AkFrac &fps,
+                                        const AkVideoCaps &outputCaps)
+{
+    this->m_imageReaderMutex.lockForRead();
+    auto fileName = this->m_imageReader.fileName();
+    this->m_imageReaderMutex.unlock();
+
+    this->m_framesMutex.lock();
+    auto isCached = !this->m_frames.isEmpty()
+                    && this->m_framesMedia == fileName
+                    && this->m_framesFps == fps
+                    && this->m_framesCaps == outputCaps;
+    this->m_framesMutex.unlock();
+
+    if (isCached)
+        return true;
+
+    // Decode all the frames just once, and keep them ready to be sent.
+    QImageReader imageReader(fileName);
+    QVector<ImageFramePtr> frames;
+    size_t cacheSize = 0;
+    AkVideoConverter videoConverter(outputCaps);
+    videoConverter.setScalingMode(AkVideoConverter::ScalingMode_Linear);
+    videoConverter.begin();
+
+    forever {
+        auto image = imageReader.read();
+
+        if (image.isNull())
+            break;
+
+        auto supportsAnimation = imageReader.supportsAnimation();
+        auto packet = imageToPacket(image, fps);
+
+        // Scale the frame now, instead of scaling it each time it's sent.
+        if (outputCaps)
+            packet = videoConverter.convert(packet);
+
+        packet = packet.toExternal();
+
+        if (!packet)
+            break;
+
+        cacheSize += packet.size();
+
+        if (cacheSize > MAX_CACHE_SIZE) {
+            frames.clear();
+
+            break;
+        }
+
+        auto frame = ImageFramePtr(new ImageFrame);
+        frame->packet = packet;
+        frame->delay = supportsAnimation? imageReader.nextImageDelay(): 0;
+        frames << frame;
+
+        if (!supportsAnimation)
+            break;
+
+        auto imageCount = imageReader.imageCount();
+
+        if (imageCount > 0) {
+            if (imageReader.currentImageNumber() >= imageCount - 1)
+                break;
+        } else if (!imageReader.canRead()) {
+            break;
+        }
+    }
+
+    videoConverter.end();
+
+    this->m_framesMutex.lock();
+    this->m_frames = frames;
+    this->m_framesMedia = fileName;
+    this->m_framesFps = fps;
+    this->m_framesCaps = outputCaps;
+    this->m_framesMutex.unlock();
+
+    return !frames.isEmpty();
+}
+
+ImageFramePtr ImageSrcElementPrivate::decodeFrame(const AkFrac &fps)
+{
+    this->m_imageReaderMutex.lockForRead();
+    auto image = this->m_imageReader.read();
+    auto error = this->m_imageReader.errorString();
+    auto supportsAnimation = this->m_imageReader.supportsAnimation();
+    auto delay = this->m_imageReader.nextImageDelay();
+    auto isLastFrame =
+            this->m_imageReader.currentImageNumber() >= this->m_imageReader.imageCount() - 1;
+    this->m_imageReaderMutex.unlock();
+
+    if (isLastFrame || image.isNull()) {
+        this->m_imageReaderMutex.lockForWrite();
+        auto fileName = this->m_imageReader.fileName();
+        this->m_imageReader.setFileName({});
+        this->m_imageReader.setFileName(fileName);
+        this->m_imageReaderMutex.unlock();
+    }
+
+    if (image.isNull()) {
+        qDebug() << "Error reading image:" << error;
+
+        return {};
+    }
+
+    auto frame = ImageFramePtr(new ImageFrame);
+    frame->packet = imageToPacket(image, fps);
+    frame->delay = supportsAnimation? delay: 0;
+
+    return frame;
+}
+
 void ImageSrcElementPrivate::readFrame()
 {
+    this->m_fpsMutex.lockForRead();
+    auto fps = this->m_fps;
+    auto outputCaps = this->m_outputCaps;
+    this->m_fpsMutex.unlock();
+
+    /* If the image is too big for being cached, the frames are decoded as
+     * they are needed.
+     */
+    auto isCached = this->loadFrames(fps, outputCaps);
+
+    this->m_framesMutex.lock();
+    auto frames = this->m_frames;
+    this->m_framesMutex.unlock();
+
+    AkVideoConverter videoConverter(outputCaps);
     qreal delayDiff = 0.0;
+    int frameIndex = 0;
+
+    if (!isCached)
+        videoConverter.begin();
 
     while (this->m_run) {
         this->m_fpsMutex.lockForRead();
-        auto fps = this->m_fps;
+        fps = this->m_fps;
         this->m_fpsMutex.unlock();
 
-        this->m_imageReaderMutex.lockForRead();
-        auto image = this->m_imageReader.read();
-        auto error = this->m_imageReader.errorString();
-        this->m_imageReaderMutex.unlock();
+        ImageFramePtr frame;
 
-        if (image.isNull()) {
-            qDebug() << "Error reading image:" << error;
+        if (isCached) {
+            frame = frames[frameIndex];
+            frameIndex = (frameIndex + 1) % frames.size();
+        } else {
+            frame = this->decodeFrame(fps);
+        }
 
+        if (!frame) {
             auto delay = (1000 / fps).value() + delayDiff;
             delayDiff = delay - qRound(delay);
             QThread::msleep(qRound(delay));
@@ -389,22 +606,11 @@ void ImageSrcElementPrivate::readFrame()
             continue;
         }
 
-        if (!imageToAkFormat->contains(image.format()))
-            image = image.convertToFormat(QImage::Format_ARGB32);
-
-        AkVideoCaps caps(imageToAkFormat->value(image.format()),
-                         image.width(),
-                         image.height(),
-                         fps);
-        AkVideoPacket packet(caps);
-        auto lineSize = qMin<size_t>(image.bytesPerLine(), packet.lineSize(0));
-
-        for (int y = 0; y < image.height(); ++y) {
-            auto srcLine = image.constScanLine(y);
-            auto dstLine = packet.line(0, y);
-            memcpy(dstLine, srcLine, lineSize);
-        }
-
+        // The cached frames are not copied, just the reference to the buffer.
+        AkVideoPacket packet =
+                isCached || !outputCaps?
+                    frame->packet:
+                    videoConverter.convert(frame->packet);
         auto pts = qRound64(QTime::currentTime().msecsSinceStartOfDay()
                             * fps.value() / 1e3);
         packet.setPts(pts);
@@ -423,42 +629,17 @@ void ImageSrcElementPrivate::readFrame()
                                       packet);
         }
 
-        this->m_imageReaderMutex.lockForRead();
-        auto isLastFrame =
-                this->m_imageReader.currentImageNumber() >= this->m_imageReader.imageCount() - 1;
-        this->m_imageReaderMutex.unlock();
-
-        if (isLastFrame) {
-            this->m_imageReaderMutex.lockForRead();
-            auto supportsAnimation = this->m_imageReader.supportsAnimation();
-            this->m_imageReaderMutex.unlock();
-
-            if (!supportsAnimation) {
-                auto delay = (1000 / fps).value() + delayDiff;
-                delayDiff = delay - qRound(delay);
-                QThread::msleep(qRound(delay));
-            }
-
-            this->m_imageReaderMutex.lockForWrite();
-            auto fileName = this->m_imageReader.fileName();
-            this->m_imageReader.setFileName({});
-            this->m_imageReader.setFileName(fileName);
-            this->m_imageReaderMutex.unlock();
+        if (this->m_forceFps || frame->delay < 1) {
+            auto delay = (1000 / fps).value() + delayDiff;
+            delayDiff = delay - qRound(delay);
+            QThread::msleep(qRound(delay));
         } else {
-            if (this->m_forceFps) {
-                auto delay = (1000 / fps).value() + delayDiff;
-                delayDiff = delay - qRound(delay);
-                QThread::msleep(qRound(delay));
-            } else {
-                this->m_imageReaderMutex.lockForRead();
-                auto delay = this->m_imageReader.nextImageDelay();
-                this->m_imageReaderMutex.unlock();
-
-                if (delay > 0)
-                    QThread::msleep(delay);
-            }
+            QThread::msleep(frame->delay);
         }
     }
+
+    if (!isCached)
+        videoConverter.end();
 }
 
 void ImageSrcElementPrivate::sendPacket(const AkPacket &packet)
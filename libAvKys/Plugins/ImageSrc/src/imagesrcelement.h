@@ -24,6 +24,7 @@
 
 class ImageSrcElementPrivate;
 class AkFrac;
+class AkVideoCaps;
 
 class ImageSrcElement: public AkMultimediaSourceElement
 {
@@ -59,6 +60,11 @@ class ImageSrcElement: public AkMultimediaSourceElement
                WRITE setFps
                RESET resetFps
                NOTIFY fpsChanged)
+    Q_PROPERTY(AkVideoCaps outputCaps
+               READ outputCaps
+               WRITE setOutputCaps
+               RESET resetOutputCaps
+               NOTIFY outputCapsChanged)
     Q_PROPERTY(QStringList supportedFormats
                READ supportedFormats
                CONSTANT)
@@ -76,6 +82,7 @@ class ImageSrcElement: public AkMultimediaSourceElement
         Q_INVOKABLE bool isAnimated() const;
         Q_INVOKABLE bool forceFps() const;
         Q_INVOKABLE AkFrac fps() const;
+        Q_INVOKABLE AkVideoCaps outputCaps() const;
         Q_INVOKABLE QStringList supportedFormats() const;
 
     private:
@@ -94,14 +101,17 @@ class ImageSrcElement: public AkMultimediaSourceElement
         void isAnimatedChanged(bool isAnimated);
         void forceFpsChanged(bool forceFps);
         void fpsChanged(const AkFrac &fps);
+        void outputCapsChanged(const AkVideoCaps &outputCaps);
         void sizeChanged(const QSize &size);
         void error(const QString &message);
 
     public slots:
         void setForceFps(bool forceFps);
         void setFps(const AkFrac &fps);
+        void setOutputCaps(const AkVideoCaps &outputCaps);
         void resetForceFps();
         void resetFps();
+        void resetOutputCaps();
         void setMedia(const QString &media) override;
         void resetMedia() override;
         bool setState(AkElement::ElementState state) override;
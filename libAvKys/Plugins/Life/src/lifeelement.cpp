@@ -21,6 +21,7 @@
 #include <QSize>
 #include <QtMath>
 #include <akfrac.h>
+#include <akframering.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
@@ -33,7 +34,7 @@ class LifeElementPrivate
 {
     public:
         QSize m_frameSize;
-        AkVideoPacket m_prevFrame;
+        AkFrameRing m_prevFrame {1};
         AkVideoPacket m_lifeBuffer;
         QRgb m_lifeColor {qRgb(255, 255, 255)};
         int m_threshold {15};
@@ -102,11 +103,11 @@ AkPacket LifeElement::iVideoStream(const AkVideoPacket &packet)
 
     if (frameSize != this->d->m_frameSize) {
         this->d->m_lifeBuffer = AkVideoPacket();
-        this->d->m_prevFrame = AkVideoPacket();
+        this->d->m_prevFrame.clear();
         this->d->m_frameSize = frameSize;
     }
 
-    if (!this->d->m_prevFrame) {
+    if (this->d->m_prevFrame.isEmpty()) {
         this->d->m_lifeBuffer = AkVideoPacket({AkVideoCaps::Format_y8,
                                                src.caps().width(),
                                                src.caps().height(),
@@ -115,7 +116,7 @@ AkPacket LifeElement::iVideoStream(const AkVideoPacket &packet)
     else {
         // Compute the difference between previous and current frame,
         // and save it to the buffer.
-        auto diff = this->d->imageDiff(this->d->m_prevFrame,
+        auto diff = this->d->imageDiff(this->d->m_prevFrame.last(),
                                        src,
                                        this->d->m_threshold,
                                        this->d->m_lumaThreshold);
@@ -146,7 +147,7 @@ AkPacket LifeElement::iVideoStream(const AkVideoPacket &packet)
         }
     }
 
-    this->d->m_prevFrame = src;
+    this->d->m_prevFrame.push(src);
 
     if (dst)
         emit this->oStream(dst);
@@ -18,10 +18,10 @@
  */
 
 #include <QApplication>
-#include <QFontMetrics>
 #include <QMutex>
 #include <QQmlContext>
 #include <akfrac.h>
+#include <akglyphatlas.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
 #include <akvideoconverter.h>
@@ -29,7 +29,6 @@
 #include <akvideopacket.h>
 
 #include "matrixelement.h"
-#include "character.h"
 #include "raindrop.h"
 
 using  HintingPreferenceToStr = QMap<QFont::HintingPreference, QString>;
@@ -81,6 +80,7 @@ class MatrixElementPrivate
     public:
         AkVideoConverter m_videoConverter;
         AkVideoMixer m_videoMixer;
+        AkGlyphAtlas m_atlas;
         int m_nDrops {25};
         QString m_charTable;
         QFont m_font {QApplication::font()};
@@ -94,29 +94,18 @@ class MatrixElementPrivate
         bool m_smooth {true};
         bool m_showCursor {true};
         bool m_showRain {true};
-        Character *m_characters {nullptr};
         QRgb m_palette[256];
-        int m_colorTable[256];
-        QSize m_fontSize;
         QList<RainDrop> m_rain;
         QMutex m_mutex;
 
         void updateCharTable();
         void updatePalette();
-        QSize fontSize(const QString &chrTable, const QFont &font) const;
-        QSize fontSize(const QChar &chr, const QFont &font) const;
-        AkVideoPacket createMask(const AkVideoPacket &src,
-                                 const QSize &fontSize,
-                                 const Character *characters);
-        AkVideoPacket applyMask(const AkVideoPacket &src,
-                                const AkVideoPacket &mask);
+        AkVideoPacket renderText(const AkVideoPacket &src,
+                                 const QSize &fontSize);
         AkVideoPacket renderdrop(const RainDrop &drop,
                                  const QSize &fontSize,
-                                 const Character *characters,
                                  bool showCursor);
-        void renderRain(AkVideoPacket &src,
-                        const QSize &fontSize,
-                        const Character *characters);
+        void renderRain(AkVideoPacket &src, const QSize &fontSize);
 };
 
 MatrixElement::MatrixElement(): AkElement()
@@ -135,9 +124,6 @@ MatrixElement::MatrixElement(): AkElement()
 
 MatrixElement::~MatrixElement()
 {
-    if (this->d->m_characters)
-        delete [] this->d->m_characters;
-
     delete this->d;
 }
 
@@ -237,7 +223,7 @@ void MatrixElement::controlInterfaceConfigure(QQmlContext *context,
 AkPacket MatrixElement::iVideoStream(const AkVideoPacket &packet)
 {
     this->d->m_mutex.lock();
-    auto fontSize = this->d->m_fontSize;
+    auto fontSize = this->d->m_atlas.glyphSize();
 
     int textWidth = packet.caps().width() / fontSize.width();
     int textHeight = packet.caps().height() / fontSize.height();
@@ -279,12 +265,10 @@ AkPacket MatrixElement::iVideoStream(const AkVideoPacket &packet)
     int outWidth = textWidth * fontSize.width();
     int outHeight = textHeight * fontSize.height();
 
-    auto mask = this->d->createMask(src, fontSize, this->d->m_characters);
-
-    src = this->d->applyMask(src, mask);
+    src = this->d->renderText(src, fontSize);
 
     if (this->d->m_showRain)
-        this->d->renderRain(src, fontSize, this->d->m_characters);
+        this->d->renderRain(src, fontSize);
 
     this->d->m_mutex.unlock();
 
@@ -573,35 +557,8 @@ void MatrixElement::resetShowRain()
 
 void MatrixElementPrivate::updateCharTable()
 {
-    if (this->m_characters)
-        delete [] this->m_characters;
-
-    if (this->m_charTable.isEmpty()) {
-        this->m_fontSize = this->fontSize(' ', this->m_font);
-        this->m_characters = new Character [1];
-        this->m_characters[0] = Character(' ', this->m_font, this->m_fontSize);
-        memset(this->m_colorTable, 0, 256);
-    } else {
-        this->m_fontSize = this->fontSize(this->m_charTable, this->m_font);
-        this->m_characters = new Character [this->m_charTable.size()];
-        int i = 0;
-
-        for (auto &chr: this->m_charTable) {
-            this->m_characters[i] = Character(chr, this->m_font, this->m_fontSize);
-            i++;
-        }
-
-        std::sort(this->m_characters,
-                  this->m_characters + this->m_charTable.size(),
-                  [] (const Character &chr1, const Character &chr2) {
-                      return chr1.weight() < chr2.weight();
-                  });
-
-        auto charMax = this->m_charTable.size() - 1;
-
-        for (int i = 0; i < 256; i++)
-            this->m_colorTable[i] = charMax * i / 255;
-    }
+    this->m_atlas.setFont(this->m_font);
+    this->m_atlas.setCharTable(this->m_charTable);
 }
 
 void MatrixElementPrivate::updatePalette()
@@ -639,83 +596,33 @@ void MatrixElementPrivate::updatePalette()
     }
 }
 
-QSize MatrixElementPrivate::fontSize(const QString &chrTable,
-                                     const QFont &font) const
-{
-    QFontMetrics metrics(font);
-    int width = -1;
-    int height = -1;
-
-    for (auto &chr: chrTable) {
-        auto size = metrics.size(Qt::TextSingleLine, chr);
-
-        if (size.width() > width)
-            width = size.width();
-
-        if (size.height() > height)
-            height = size.height();
-    }
-
-    return {width, height};
-}
-
-QSize MatrixElementPrivate::fontSize(const QChar &chr, const QFont &font) const
+AkVideoPacket MatrixElementPrivate::renderText(const AkVideoPacket &src,
+                                               const QSize &fontSize)
 {
-    return QFontMetrics(font).size(Qt::TextSingleLine, chr);
-}
-
-AkVideoPacket MatrixElementPrivate::createMask(const AkVideoPacket &src,
-                                               const QSize &fontSize,
-                                               const Character *characters)
-{
-    int outWidth = src.caps().width() * fontSize.width();
-    int outHeight = src.caps().height() * fontSize.height();
-
     auto ocaps = src.caps();
-    ocaps.setWidth(outWidth);
-    ocaps.setHeight(outHeight);
+    ocaps.setWidth(src.caps().width() * fontSize.width());
+    ocaps.setHeight(src.caps().height() * fontSize.height());
     AkVideoPacket dst(ocaps);
     dst.copyMetadata(src);
 
-    this->m_videoMixer.begin(&dst);
+    // Pick a glyph for each pixel and modulate it with the pixel luma.
 
-    for (int y = 0; y < src.caps().height(); y++) {
-        auto ys = y * fontSize.height();
-        auto srcLine = src.constLine(0, y);
+    auto &lumaTable = this->m_atlas.lumaTable();
 
-        for (int x = 0; x < src.caps().width(); x++) {
-            auto xs = x * fontSize.width();
-            auto &chr = characters[this->m_colorTable[srcLine[x]]];
-            this->m_videoMixer.draw(xs, ys, chr.image());
-        }
-    }
-
-    this->m_videoMixer.end();
-
-    return dst;
-}
-
-AkVideoPacket MatrixElementPrivate::applyMask(const AkVideoPacket &src,
-                                              const AkVideoPacket &mask)
-{
-    auto ocaps = src.caps();
-    ocaps.setWidth(mask.caps().width());
-    ocaps.setHeight(mask.caps().height());
-    AkVideoPacket dst(ocaps);
-    dst.copyMetadata(src);
-
-    auto fontWidth = mask.caps().width() / src.caps().width();
-    auto fontHeight = mask.caps().height() / src.caps().height();
-
-    for (int y = 0; y < dst.caps().height(); y++) {
-        int ys = y / fontHeight;
+    for (int ys = 0; ys < src.caps().height(); ys++) {
         auto srcLine = src.constLine(0, ys);
-        auto maskLine = mask.constLine(0, y);
-        auto dstLine = dst.line(0, y);
 
-        for (int x = 0; x < dst.caps().width(); x++) {
-            int xs = x / fontWidth;
-            dstLine[x] = maskLine[x] * srcLine[xs] / 255;
+        for (int y = 0; y < fontSize.height(); y++) {
+            auto dstLine = dst.line(0, ys * fontSize.height() + y);
+
+            for (int xs = 0; xs < src.caps().width(); xs++) {
+                auto &luma = srcLine[xs];
+                this->m_atlas.drawGlyphLine(lumaTable[luma],
+                                            y,
+                                            int(luma),
+                                            0,
+                                            dstLine + xs * fontSize.width());
+            }
         }
     }
 
@@ -724,7 +631,6 @@ AkVideoPacket MatrixElementPrivate::applyMask(const AkVideoPacket &src,
 
 AkVideoPacket MatrixElementPrivate::renderdrop(const RainDrop &drop,
                                                const QSize &fontSize,
-                                               const Character *characters,
                                                bool showCursor)
 {
     AkVideoPacket dropSprite({AkVideoCaps::Format_y8,
@@ -736,27 +642,24 @@ AkVideoPacket MatrixElementPrivate::renderdrop(const RainDrop &drop,
     int j = len_1;
 
     for (int i = 0; i < drop.length(); i++) {
-        auto character = characters[drop.chr(i)];
-        auto &sprite = character.image();
+        int glyph = drop.chr(i);
 
-        if (showCursor && i == 0) {
-            for (int y = 0; y < sprite.caps().height(); y++) {
-                auto srcLine = sprite.constLine(0, y);
-                auto dstLine = dropSprite.line(0, yd + y);
+        // The cursor is drawn in negative, the tail fades out.
+        int foreground = 0;
+        int background = 255;
 
-                for (int x = 0; x < sprite.caps().width(); x++)
-                    dstLine[x] = 255 - srcLine[x];
-            }
-        } else {
-            for (int y = 0; y < sprite.caps().height(); y++) {
-                auto srcLine = sprite.constLine(0, y);
-                auto dstLine = dropSprite.line(0, yd + y);
-
-                for (int x = 0; x < sprite.caps().width(); x++)
-                    dstLine[x] = j * srcLine[x] / len_1;
-            }
+        if (!showCursor || i > 0) {
+            foreground = len_1 > 0? 255 * j / len_1: 255;
+            background = 0;
         }
 
+        for (int y = 0; y < fontSize.height(); y++)
+            this->m_atlas.drawGlyphLine(glyph,
+                                        y,
+                                        foreground,
+                                        background,
+                                        dropSprite.line(0, yd + y));
+
         yd -= fontSize.height();
         j--;
     }
@@ -765,8 +668,7 @@ AkVideoPacket MatrixElementPrivate::renderdrop(const RainDrop &drop,
 }
 
 void MatrixElementPrivate::renderRain(AkVideoPacket &src,
-                                      const QSize &fontSize,
-                                      const Character *characters)
+                                      const QSize &fontSize)
 {
     int textWidth = src.caps().width() / fontSize.width();
     int textHeight = src.caps().height() / fontSize.height();
@@ -790,7 +692,6 @@ void MatrixElementPrivate::renderRain(AkVideoPacket &src,
         if (drop.isVisible()) {
             auto sprite = this->renderdrop(drop,
                                            fontSize,
-                                           characters,
                                            this->m_showCursor);
             this->m_videoMixer.draw(drop.x() * fontSize.width(),
                                     drop.y() * fontSize.height(),
@@ -19,6 +19,7 @@
 
 #include <QQueue>
 #include <QAbstractEventDispatcher>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QtConcurrent>
 #include <QFuture>
@@ -65,6 +66,8 @@ class AbstractStreamPrivate
         QQueue<FramePtr> m_frames;
         QQueue<SubtitlePtr> m_subtitles;
         qint64 m_packetQueueSize {0};
+        std::atomic<qreal> m_decodeLatency {0.0};
+        std::atomic<quint64> m_droppedFrames {0};
         Clock *m_globalClock {nullptr};
         QFuture<void> m_packetLoopResult;
         QFuture<void> m_dataLoopResult;
@@ -228,6 +231,21 @@ qint64 AbstractStream::queueSize() const
     return this->d->m_packetQueueSize;
 }
 
+int AbstractStream::queueLength() const
+{
+    return this->d->m_packets.size();
+}
+
+qreal AbstractStream::decodeLatency() const
+{
+    return this->d->m_decodeLatency;
+}
+
+quint64 AbstractStream::droppedFrames() const
+{
+    return this->d->m_droppedFrames;
+}
+
 Clock *AbstractStream::globalClock()
 {
     return this->d->m_globalClock;
@@ -329,6 +347,11 @@ void AbstractStream::processData(AVSubtitle *subtitle)
     Q_UNUSED(subtitle)
 }
 
+void AbstractStream::frameDropped()
+{
+    this->d->m_droppedFrames++;
+}
+
 void AbstractStream::flush()
 {
     this->d->m_dataMutex.lock();
@@ -356,6 +379,8 @@ bool AbstractStream::setState(AkElement::ElementState state)
                 return false;
 
             this->m_clockDiff = 0.0;
+            this->d->m_decodeLatency = 0.0;
+            this->d->m_droppedFrames = 0;
             this->d->m_run = true;
             this->d->m_runPacketLoop = true;
             this->d->m_paused = state == AkElement::ElementStatePaused;
@@ -506,13 +531,19 @@ void AbstractStreamPrivate::readPacket()
     }
 
     this->m_packetMutex.unlock();
+    QElapsedTimer timer;
+    timer.start();
 
     if (gotPacket) {
         self->processPacket(packet.data());
         emit self->notify();
     }
 
-    self->decodeData();
+    if (self->decodeData()) {
+        // Average time taken to decode a packet, in milliseconds.
+        auto latency = 1e-6 * qreal(timer.nsecsElapsed());
+        this->m_decodeLatency = 0.9 * this->m_decodeLatency + 0.1 * latency;
+    }
 
     if (!packet)
         this->m_runPacketLoop = false;
@@ -614,8 +645,12 @@ void AbstractStreamPrivate::deleteFrame(AVFrame *frame)
     if (!frame)
         return;
 
-    av_freep(&frame->data[0]);
-    frame->data[0] = nullptr;
+    // Frames referencing the buffers of the decoder are released by unref.
+    if (!frame->buf[0]) {
+        av_freep(&frame->data[0]);
+        frame->data[0] = nullptr;
+    }
+
     av_frame_unref(frame);
     av_frame_free(&frame);
 }
@@ -64,6 +64,9 @@ class AbstractStream: public QObject
         Q_INVOKABLE virtual AkCaps caps() const;
         Q_INVOKABLE bool sync() const;
         Q_INVOKABLE qint64 queueSize() const;
+        Q_INVOKABLE int queueLength() const;
+        Q_INVOKABLE qreal decodeLatency() const;
+        Q_INVOKABLE quint64 droppedFrames() const;
         Q_INVOKABLE Clock *globalClock();
         Q_INVOKABLE qreal clockDiff() const;
         Q_INVOKABLE qreal &clockDiff();
@@ -83,6 +86,7 @@ class AbstractStream: public QObject
         virtual void processPacket(AVPacket *packet);
         virtual void processData(AVFrame *frame);
         virtual void processData(AVSubtitle *subtitle);
+        void frameDropped();
 
     private:
         AbstractStreamPrivate *d;
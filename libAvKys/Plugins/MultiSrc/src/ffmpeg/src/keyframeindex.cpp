@@ -0,0 +1,315 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+#include <algorithm>
+
+extern "C"
+{
+    #include <libavformat/avformat.h>
+}
+
+#include "keyframeindex.h"
+
+#define KEYFRAMEINDEX_MAGIC 0x4b464958
+#define KEYFRAMEINDEX_VERSION 1
+
+KeyFrameIndex::KeyFrameIndex()
+{
+}
+
+bool KeyFrameIndex::isEmpty() const
+{
+    return this->m_stream < 0 || this->m_keyFrames.isEmpty();
+}
+
+int KeyFrameIndex::stream() const
+{
+    return this->m_stream;
+}
+
+AVRational KeyFrameIndex::timeBase() const
+{
+    return this->m_timeBase;
+}
+
+const QVector<qint64> &KeyFrameIndex::keyFrames() const
+{
+    return this->m_keyFrames;
+}
+
+qint64 KeyFrameIndex::keyFrame(qint64 pts, bool nearest) const
+{
+    if (this->m_keyFrames.isEmpty())
+        return AV_NOPTS_VALUE;
+
+    auto it = std::upper_bound(this->m_keyFrames.constBegin(),
+                               this->m_keyFrames.constEnd(),
+                               pts);
+
+    if (it == this->m_keyFrames.constBegin())
+        return *it;
+
+    auto previous = *(it - 1);
+
+    if (!nearest || it == this->m_keyFrames.constEnd())
+        return previous;
+
+    return *it - pts < pts - previous? *it: previous;
+}
+
+bool KeyFrameIndex::load(const QString &media)
+{
+    this->clear();
+    QFileInfo mediaInfo(KeyFrameIndex::localFile(media));
+
+    if (!mediaInfo.isFile())
+        return false;
+
+    for (auto &indexFile: KeyFrameIndex::indexFiles(media)) {
+        QFile file(indexFile);
+
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 magic = 0;
+        quint32 version = 0;
+        qint64 size = 0;
+        qint64 lastModified = 0;
+        qint32 streamIndex = -1;
+        qint32 num = 0;
+        qint32 den = 0;
+        QVector<qint64> keyFrames;
+        stream >> magic >> version >> size >> lastModified;
+
+        // Discard the index if the file was modified after creating it.
+        if (magic != KEYFRAMEINDEX_MAGIC
+            || version != KEYFRAMEINDEX_VERSION
+            || size != mediaInfo.size()
+            || lastModified != mediaInfo.lastModified().toMSecsSinceEpoch())
+            continue;
+
+        stream >> streamIndex >> num >> den >> keyFrames;
+
+        if (stream.status() != QDataStream::Ok
+            || streamIndex < 0
+            || num < 1
+            || den < 1
+            || keyFrames.isEmpty())
+            continue;
+
+        this->m_stream = streamIndex;
+        this->m_timeBase = {num, den};
+        this->m_keyFrames = keyFrames;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool KeyFrameIndex::save(const QString &media) const
+{
+    if (this->isEmpty())
+        return false;
+
+    QFileInfo mediaInfo(KeyFrameIndex::localFile(media));
+
+    if (!mediaInfo.isFile())
+        return false;
+
+    for (auto &indexFile: KeyFrameIndex::indexFiles(media)) {
+        QFileInfo indexInfo(indexFile);
+
+        if (!QDir().mkpath(indexInfo.absolutePath()))
+            continue;
+
+        QSaveFile file(indexFile);
+
+        if (!file.open(QIODevice::WriteOnly))
+            continue;
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << quint32(KEYFRAMEINDEX_MAGIC)
+               << quint32(KEYFRAMEINDEX_VERSION)
+               << qint64(mediaInfo.size())
+               << qint64(mediaInfo.lastModified().toMSecsSinceEpoch())
+               << qint32(this->m_stream)
+               << qint32(this->m_timeBase.num)
+               << qint32(this->m_timeBase.den)
+               << this->m_keyFrames;
+
+        if (file.commit())
+            return true;
+    }
+
+    return false;
+}
+
+bool KeyFrameIndex::build(const QString &media, const bool *run)
+{
+    this->clear();
+    auto fileName = KeyFrameIndex::localFile(media);
+
+    if (!QFileInfo(fileName).isFile())
+        return false;
+
+    AVFormatContext *context = nullptr;
+
+    if (avformat_open_input(&context,
+                            fileName.toStdString().c_str(),
+                            nullptr,
+                            nullptr) < 0)
+        return false;
+
+    if (avformat_find_stream_info(context, nullptr) < 0) {
+        avformat_close_input(&context);
+
+        return false;
+    }
+
+    int streamIndex = av_find_best_stream(context,
+                                          AVMEDIA_TYPE_VIDEO,
+                                          -1,
+                                          -1,
+                                          nullptr,
+                                          0);
+
+    if (streamIndex < 0) {
+        avformat_close_input(&context);
+
+        return false;
+    }
+
+    // Only the packets of the video stream are needed.
+    for (uint i = 0; i < context->nb_streams; i++)
+        if (int(i) != streamIndex)
+            context->streams[i]->discard = AVDISCARD_ALL;
+
+    auto packet = av_packet_alloc();
+    QVector<qint64> keyFrames;
+    bool aborted = false;
+
+    while (av_read_frame(context, packet) >= 0) {
+        if (run && !*run) {
+            av_packet_unref(packet);
+            aborted = true;
+
+            break;
+        }
+
+        if (packet->stream_index == streamIndex
+            && packet->flags & AV_PKT_FLAG_KEY) {
+            auto pts = packet->pts != AV_NOPTS_VALUE? packet->pts: packet->dts;
+
+            if (pts != AV_NOPTS_VALUE)
+                keyFrames << pts;
+        }
+
+        av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+    auto timeBase = context->streams[streamIndex]->time_base;
+    avformat_close_input(&context);
+
+    // A partial index is useless, it would make the seeks land in wrong places.
+    if (aborted || keyFrames.isEmpty())
+        return false;
+
+    std::sort(keyFrames.begin(), keyFrames.end());
+    keyFrames.erase(std::unique(keyFrames.begin(), keyFrames.end()),
+                    keyFrames.end());
+    this->m_stream = streamIndex;
+    this->m_timeBase = timeBase;
+    this->m_keyFrames = keyFrames;
+
+    return true;
+}
+
+void KeyFrameIndex::clear()
+{
+    this->m_stream = -1;
+    this->m_timeBase = {0, 1};
+    this->m_keyFrames.clear();
+}
+
+QString KeyFrameIndex::localFile(const QString &media)
+{
+    QUrl url(media);
+
+    return url.isLocalFile()? url.toLocalFile(): media;
+}
+
+QStringList KeyFrameIndex::indexFiles(const QString &media)
+{
+    QFileInfo mediaInfo(KeyFrameIndex::localFile(media));
+    QStringList indexFiles;
+
+    /* Only the recordings are ours to write next to, prefer a hidden file
+     * there so it's moved along with the recording, and keep the index of any
+     * other file in the cache.
+     */
+    auto recordingsDir = KeyFrameIndex::recordingsDirectory();
+    QFileInfo dirInfo(mediaInfo.absolutePath());
+
+    if (!recordingsDir.isEmpty()
+        && (mediaInfo.absolutePath() == recordingsDir
+            || mediaInfo.absolutePath().startsWith(recordingsDir + '/'))
+        && dirInfo.isWritable())
+        indexFiles << QDir(mediaInfo.absolutePath())
+                          .absoluteFilePath("." + mediaInfo.fileName() + ".kfi");
+
+    auto cacheDir =
+            QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (!cacheDir.isEmpty()) {
+        auto hash =
+                QCryptographicHash::hash(mediaInfo.absoluteFilePath().toUtf8(),
+                                         QCryptographicHash::Sha1).toHex();
+        indexFiles << QDir(cacheDir).absoluteFilePath("keyframes/"
+                                                      + QString::fromLatin1(hash)
+                                                      + ".kfi");
+    }
+
+    return indexFiles;
+}
+
+QString KeyFrameIndex::recordingsDirectory()
+{
+    auto moviesPath =
+            QStandardPaths::writableLocation(QStandardPaths::MoviesLocation);
+
+    if (moviesPath.isEmpty())
+        return {};
+
+    return QDir(moviesPath).absoluteFilePath(QCoreApplication::applicationName());
+}
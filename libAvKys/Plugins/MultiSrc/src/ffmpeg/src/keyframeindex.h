@@ -0,0 +1,67 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef KEYFRAMEINDEX_H
+#define KEYFRAMEINDEX_H
+
+#include <QStringList>
+#include <QVector>
+
+extern "C"
+{
+    #include <libavutil/avutil.h>
+}
+
+/* Position of the key frames of the video stream of a media file.
+ *
+ * The index is built once, by scanning the packets of the file without
+ * decoding them, and is then stored on disk next to the file if it's a
+ * recording, or in the cache directory otherwise, so seeking to a key frame
+ * doesn't need to ask the demuxer to search for it.
+ */
+class KeyFrameIndex
+{
+    public:
+        KeyFrameIndex();
+
+        bool isEmpty() const;
+        int stream() const;
+        AVRational timeBase() const;
+        const QVector<qint64> &keyFrames() const;
+
+        // Key frame at or before pts, or the closest one if nearest is true.
+        qint64 keyFrame(qint64 pts, bool nearest) const;
+
+        bool load(const QString &media);
+        bool save(const QString &media) const;
+        bool build(const QString &media, const bool *run=nullptr);
+        void clear();
+
+        static QString localFile(const QString &media);
+
+    private:
+        int m_stream {-1};
+        AVRational m_timeBase {0, 1};
+        QVector<qint64> m_keyFrames;
+
+        static QString recordingsDirectory();
+        static QStringList indexFiles(const QString &media);
+};
+
+#endif // KEYFRAMEINDEX_H
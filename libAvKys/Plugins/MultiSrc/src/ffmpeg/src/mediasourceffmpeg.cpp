@@ -18,6 +18,7 @@
  */
 
 #include <QApplication>
+#include <QFile>
 #include <QFileInfo>
 #include <QFuture>
 #include <QMutex>
@@ -28,10 +29,19 @@
 #include <QtConcurrent>
 #include <ak.h>
 #include <akcaps.h>
+#include <akfrac.h>
+#include <akvideocaps.h>
+#include <akvideopacket.h>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 extern "C"
 {
     #include <libavcodec/avcodec.h>
+    #include <libswscale/swscale.h>
 
 #ifdef HAVE_LIBAVDEVICE
     #include <libavdevice/avdevice.h>
@@ -41,9 +51,13 @@ extern "C"
 #include "mediasourceffmpeg.h"
 #include "audiostream.h"
 #include "clock.h"
+#include "keyframeindex.h"
 #include "subtitlestream.h"
 #include "videostream.h"
 
+// Amount of data the kernel is asked to read ahead of the demuxer
+#define READAHEAD_SIZE (8 * 1024 * 1024)
+
 using FormatContextPtr = QSharedPointer<AVFormatContext>;
 using AbstractStreamPtr = QSharedPointer<AbstractStream>;
 using AvMediaTypeAkMap = QMap<AVMediaType, AkCaps::CapsType>;
@@ -107,8 +121,15 @@ class MediaSourceFFmpegPrivate
         QList<int> m_streams;
         FormatContextPtr m_inputContext;
         qint64 m_maxPacketQueueSize {15 * 1024 * 1024};
+        int m_decodingThreads {0};
+        int m_readaheadFd {-1};
+        qint64 m_readaheadPos {0};
+        MediaSource::SeekMode m_seekMode {MediaSource::SeekModeAccurate};
+        KeyFrameIndex m_keyFrameIndex;
+        QString m_keyFrameIndexMedia;
         QThreadPool m_threadPool;
         QMutex m_dataMutex;
+        QMutex m_keyFrameIndexMutex;
         QWaitCondition m_packetQueueNotFull;
         QWaitCondition m_packetQueueEmpty;
         QMap<int, AbstractStreamPtr> m_streamsMap;
@@ -126,6 +147,13 @@ class MediaSourceFFmpegPrivate
         qint64 packetQueueSize() const;
         static void deleteFormatContext(AVFormatContext *context);
         AbstractStreamPtr createStream(int index, bool noModify=false);
+        void configureThreads(AVCodecContext *codecContext) const;
+        void openReadahead();
+        void closeReadahead();
+        void readahead();
+        void loadKeyFrameIndex(const QString &media);
+        bool seekKeyFrame(qint64 pts, bool nearest);
+        AkVideoPacket thumbnail(qint64 mSecs, const QSize &maxSize);
         void readPackets();
         void readPacket();
         void unlockQueue();
@@ -342,11 +370,62 @@ qint64 MediaSourceFFmpeg::maxPacketQueueSize() const
     return this->d->m_maxPacketQueueSize;
 }
 
+int MediaSourceFFmpeg::decodingThreads() const
+{
+    return this->d->m_decodingThreads;
+}
+
+qint64 MediaSourceFFmpeg::packetQueueSize() const
+{
+    return this->d->packetQueueSize();
+}
+
+int MediaSourceFFmpeg::packetQueueLength() const
+{
+    int length = 0;
+
+    for (auto &stream: this->d->m_streamsMap)
+        length += stream->queueLength();
+
+    return length;
+}
+
+qreal MediaSourceFFmpeg::decodeLatency() const
+{
+    qreal latency = 0.0;
+
+    for (auto &stream: this->d->m_streamsMap)
+        if (stream->mediaType() == AVMEDIA_TYPE_VIDEO)
+            latency = qMax(latency, stream->decodeLatency());
+
+    return latency;
+}
+
+quint64 MediaSourceFFmpeg::droppedFrames() const
+{
+    quint64 droppedFrames = 0;
+
+    for (auto &stream: this->d->m_streamsMap)
+        droppedFrames += stream->droppedFrames();
+
+    return droppedFrames;
+}
+
 bool MediaSourceFFmpeg::showLog() const
 {
     return this->d->m_showLog;
 }
 
+MediaSource::SeekMode MediaSourceFFmpeg::seekMode() const
+{
+    return this->d->m_seekMode;
+}
+
+AkVideoPacket MediaSourceFFmpeg::thumbnail(qint64 mSecs, const QSize &maxSize)
+{
+    return this->d->thumbnail(mSecs, maxSize);
+}
+
 AkElement::ElementState MediaSourceFFmpeg::state() const
 {
     return this->d->m_state;
@@ -382,8 +461,21 @@ void MediaSourceFFmpeg::seek(qint64 mSecs,
     for (auto &stream: this->d->m_streamsMap)
         stream->flush();
 
-    av_seek_frame(this->d->m_inputContext.data(), -1, pts, 0);
-    this->d->m_globalClock.setClock(qreal(pts) / AV_TIME_BASE);
+    /* Key frame seeks land exactly in a key frame, so the decoding can start
+     * right away, otherwise seek to the key frame before the requested
+     * position and let the video stream drop the frames before it.
+     */
+    if (this->d->m_seekMode == SeekModeAccurate
+        || !this->d->seekKeyFrame(pts,
+                                  this->d->m_seekMode == SeekModeNearestKeyFrame)) {
+        av_seek_frame(this->d->m_inputContext.data(),
+                      -1,
+                      pts,
+                      AVSEEK_FLAG_BACKWARD);
+        this->d->m_globalClock.setClock(qreal(pts) / AV_TIME_BASE);
+    }
+
+    this->d->m_readaheadPos = 0;
     this->d->m_dataMutex.unlock();
 }
 
@@ -424,6 +516,17 @@ void MediaSourceFFmpeg::setMaxPacketQueueSize(qint64 maxPacketQueueSize)
     emit this->maxPacketQueueSizeChanged(maxPacketQueueSize);
 }
 
+void MediaSourceFFmpeg::setDecodingThreads(int decodingThreads)
+{
+    decodingThreads = qMax(decodingThreads, 0);
+
+    if (this->d->m_decodingThreads == decodingThreads)
+        return;
+
+    this->d->m_decodingThreads = decodingThreads;
+    emit this->decodingThreadsChanged(decodingThreads);
+}
+
 void MediaSourceFFmpeg::setShowLog(bool showLog)
 {
     if (this->d->m_showLog == showLog)
@@ -433,6 +536,15 @@ void MediaSourceFFmpeg::setShowLog(bool showLog)
     emit this->showLogChanged(showLog);
 }
 
+void MediaSourceFFmpeg::setSeekMode(SeekMode seekMode)
+{
+    if (this->d->m_seekMode == seekMode)
+        return;
+
+    this->d->m_seekMode = seekMode;
+    emit this->seekModeChanged(seekMode);
+}
+
 void MediaSourceFFmpeg::setLoop(bool loop)
 {
     if (this->d->m_loop == loop)
@@ -473,11 +585,21 @@ void MediaSourceFFmpeg::resetMaxPacketQueueSize()
     this->setMaxPacketQueueSize(15 * 1024 * 1024);
 }
 
+void MediaSourceFFmpeg::resetDecodingThreads()
+{
+    this->setDecodingThreads(0);
+}
+
 void MediaSourceFFmpeg::resetShowLog()
 {
     this->setShowLog(false);
 }
 
+void MediaSourceFFmpeg::resetSeekMode()
+{
+    this->setSeekMode(SeekModeAccurate);
+}
+
 void MediaSourceFFmpeg::resetLoop()
 {
     this->setLoop(false);
@@ -547,6 +669,7 @@ bool MediaSourceFFmpeg::setState(AkElement::ElementState state)
                 stream->setState(state);
             }
 
+            this->d->openReadahead();
             this->d->m_curClockTime = 0.0;
             this->d->m_globalClock.setClock(0.0);
             this->d->m_run = true;
@@ -556,6 +679,23 @@ bool MediaSourceFFmpeg::setState(AkElement::ElementState state)
                                             &MediaSourceFFmpegPrivate::readPackets,
                                             this->d);
             Q_UNUSED(result)
+
+            this->d->m_keyFrameIndexMutex.lock();
+            bool hasIndex = this->d->m_keyFrameIndexMedia == this->d->m_media;
+            this->d->m_keyFrameIndexMutex.unlock();
+
+            /* A looped file is being streamed as a camera source, scanning
+             * the whole file would compete with the read-ahead of the
+             * playback.
+             */
+            if (!hasIndex && !this->d->m_loop) {
+                auto result = QtConcurrent::run(&this->d->m_threadPool,
+                                                &MediaSourceFFmpegPrivate::loadKeyFrameIndex,
+                                                this->d,
+                                                this->d->m_media);
+                Q_UNUSED(result)
+            }
+
             this->d->m_state = state;
             emit this->stateChanged(state);
 
@@ -580,6 +720,7 @@ bool MediaSourceFFmpeg::setState(AkElement::ElementState state)
 
             this->d->m_streamsMap.clear();
             this->d->m_inputContext.clear();
+            this->d->closeReadahead();
             this->d->m_state = state;
             emit this->stateChanged(state);
 
@@ -619,6 +760,7 @@ bool MediaSourceFFmpeg::setState(AkElement::ElementState state)
 
             this->d->m_streamsMap.clear();
             this->d->m_inputContext.clear();
+            this->d->closeReadahead();
             this->d->m_state = state;
             emit this->stateChanged(state);
 
@@ -705,12 +847,14 @@ void MediaSourceFFmpeg::log()
     } else
         return;
 
-    QString logFmt("%1 %2: %3 aq=%4KB vq=%5KB");
+    QString logFmt("%1 %2: %3 aq=%4KB vq=%5KB dl=%6ms df=%7");
     QString log = logFmt.arg(this->d->m_globalClock.clock(), 7, 'f', 2)
                         .arg(diffType)
                         .arg(diff, 7, 'f', 3)
                         .arg(audioQueueSize / 1024, 5)
-                        .arg(videoQueueSize / 1024, 5);
+                        .arg(videoQueueSize / 1024, 5)
+                        .arg(this->decodeLatency(), 6, 'f', 2)
+                        .arg(this->droppedFrames());
     qDebug() << log.toStdString().c_str();
 }
 
@@ -847,14 +991,20 @@ AbstractStreamPtr MediaSourceFFmpegPrivate::createStream(int index,
     auto id = Ak::id();
 
     switch (type) {
-    case AVMEDIA_TYPE_VIDEO:
-        return AbstractStreamPtr(new VideoStream(this->m_inputContext.data(),
+    case AVMEDIA_TYPE_VIDEO: {
+        AbstractStreamPtr stream(new VideoStream(this->m_inputContext.data(),
                                                  uint(index),
                                                  id,
                                                  &this->m_globalClock,
                                                  this->m_sync,
                                                  noModify));
 
+        if (!noModify && stream->codecContext())
+            this->configureThreads(stream->codecContext());
+
+        return stream;
+    }
+
     case AVMEDIA_TYPE_AUDIO:
         return AbstractStreamPtr(new AudioStream(this->m_inputContext.data(),
                                                  uint(index),
@@ -883,6 +1033,296 @@ AbstractStreamPtr MediaSourceFFmpegPrivate::createStream(int index,
                                                 noModify));
 }
 
+void MediaSourceFFmpegPrivate::configureThreads(AVCodecContext *codecContext) const
+{
+    // 0 lets FFmpeg use as many threads as CPU cores.
+    codecContext->thread_count = this->m_decodingThreads;
+    codecContext->thread_type = FF_THREAD_SLICE;
+
+    /* Frame threading delays the output by one frame per thread, that's fine
+     * for files but not for live sources like capture devices.
+     */
+    if (!(this->m_inputContext->iformat->flags & AVFMT_NOFILE))
+        codecContext->thread_type |= FF_THREAD_FRAME;
+}
+
+void MediaSourceFFmpegPrivate::openReadahead()
+{
+#ifdef Q_OS_LINUX
+    /* Local files are opened a second time just to tell the kernel which
+     * parts of the file will be read next, so they are already in the page
+     * cache when the demuxer needs them.
+     */
+    QUrl url(this->m_media);
+    auto path = url.isLocalFile()? url.toLocalFile(): this->m_media;
+
+    if (!QFileInfo(path).isFile())
+        return;
+
+    this->m_readaheadFd = open(QFile::encodeName(path).constData(),
+                               O_RDONLY | O_CLOEXEC);
+
+    if (this->m_readaheadFd < 0)
+        return;
+
+    posix_fadvise(this->m_readaheadFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    this->m_readaheadPos = 0;
+#endif
+}
+
+void MediaSourceFFmpegPrivate::closeReadahead()
+{
+#ifdef Q_OS_LINUX
+    if (this->m_readaheadFd >= 0) {
+        close(this->m_readaheadFd);
+        this->m_readaheadFd = -1;
+    }
+#endif
+}
+
+void MediaSourceFFmpegPrivate::readahead()
+{
+#ifdef Q_OS_LINUX
+    if (this->m_readaheadFd < 0 || !this->m_inputContext->pb)
+        return;
+
+    auto pos = avio_tell(this->m_inputContext->pb);
+
+    if (pos < 0 || pos + READAHEAD_SIZE / 2 < this->m_readaheadPos)
+        return;
+
+    posix_fadvise(this->m_readaheadFd, pos, READAHEAD_SIZE, POSIX_FADV_WILLNEED);
+    this->m_readaheadPos = pos + READAHEAD_SIZE;
+#endif
+}
+
+void MediaSourceFFmpegPrivate::loadKeyFrameIndex(const QString &media)
+{
+    KeyFrameIndex index;
+
+    if (!QFileInfo(KeyFrameIndex::localFile(media)).isFile())
+        return;
+
+    // Building the index reads the whole file, do it only once.
+    if (!index.load(media)) {
+        if (!index.build(media, &this->m_run))
+            return;
+
+        index.save(media);
+    }
+
+    this->m_keyFrameIndexMutex.lock();
+    this->m_keyFrameIndex = index;
+    this->m_keyFrameIndexMedia = media;
+    this->m_keyFrameIndexMutex.unlock();
+}
+
+bool MediaSourceFFmpegPrivate::seekKeyFrame(qint64 pts, bool nearest)
+{
+    this->m_keyFrameIndexMutex.lock();
+
+    if (this->m_keyFrameIndexMedia != this->m_media
+        || this->m_keyFrameIndex.isEmpty()
+        || !this->m_streamsMap.contains(this->m_keyFrameIndex.stream())) {
+        this->m_keyFrameIndexMutex.unlock();
+
+        return false;
+    }
+
+    auto streamIndex = this->m_keyFrameIndex.stream();
+    auto timeBase = this->m_keyFrameIndex.timeBase();
+
+    // The index stores the stream timestamps, which are offset by its start.
+    auto stream = this->m_inputContext->streams[streamIndex];
+    qint64 startTime = 0;
+
+    if (stream->start_time != AV_NOPTS_VALUE)
+        startTime = av_rescale_q(stream->start_time,
+                                 stream->time_base,
+                                 timeBase);
+
+    auto keyFrame =
+            this->m_keyFrameIndex.keyFrame(av_rescale_q(pts,
+                                                        AV_TIME_BASE_Q,
+                                                        timeBase)
+                                           + startTime,
+                                           nearest);
+    this->m_keyFrameIndexMutex.unlock();
+
+    if (av_seek_frame(this->m_inputContext.data(),
+                      streamIndex,
+                      keyFrame,
+                      AVSEEK_FLAG_BACKWARD) < 0)
+        return false;
+
+    this->m_globalClock.setClock((keyFrame - startTime) * av_q2d(timeBase));
+
+    return true;
+}
+
+AkVideoPacket MediaSourceFFmpegPrivate::thumbnail(qint64 mSecs,
+                                                  const QSize &maxSize)
+{
+    auto fileName = KeyFrameIndex::localFile(this->m_media);
+
+    if (fileName.isEmpty() || maxSize.isEmpty())
+        return {};
+
+    /* The thumbnail is taken from its own context, so it doesn't disturb the
+     * playback, and only the key frame is decoded.
+     */
+    AVFormatContext *context = nullptr;
+
+    if (avformat_open_input(&context,
+                            fileName.toStdString().c_str(),
+                            nullptr,
+                            nullptr) < 0)
+        return {};
+
+    FormatContextPtr inputContext(context, deleteFormatContext);
+
+    if (avformat_find_stream_info(context, nullptr) < 0)
+        return {};
+
+    int streamIndex = av_find_best_stream(context,
+                                          AVMEDIA_TYPE_VIDEO,
+                                          -1,
+                                          -1,
+                                          nullptr,
+                                          0);
+
+    if (streamIndex < 0)
+        return {};
+
+    auto stream = context->streams[streamIndex];
+    auto codec = avcodec_find_decoder(stream->codecpar->codec_id);
+
+    if (!codec)
+        return {};
+
+    auto codecContext = avcodec_alloc_context3(codec);
+
+    if (!codecContext)
+        return {};
+
+    avcodec_parameters_to_context(codecContext, stream->codecpar);
+    codecContext->skip_frame = AVDISCARD_NONKEY;
+    codecContext->thread_count = this->m_decodingThreads;
+    codecContext->thread_type = FF_THREAD_SLICE;
+
+    // Let the decoder scale the frame down if it can do it.
+    int lowres = 0;
+
+    while (lowres < codec->max_lowres
+           && (codecContext->width >> (lowres + 1)) >= maxSize.width()
+           && (codecContext->height >> (lowres + 1)) >= maxSize.height())
+        lowres++;
+
+    codecContext->lowres = lowres;
+
+    if (avcodec_open2(codecContext, codec, nullptr) < 0) {
+        avcodec_free_context(&codecContext);
+
+        return {};
+    }
+
+    for (uint i = 0; i < context->nb_streams; i++)
+        if (int(i) != streamIndex)
+            context->streams[i]->discard = AVDISCARD_ALL;
+
+    auto pts = av_rescale_q(qMax<qint64>(mSecs, 0),
+                            {1, 1000},
+                            stream->time_base);
+
+    if (stream->start_time != AV_NOPTS_VALUE)
+        pts += stream->start_time;
+
+    KeyFrameIndex index;
+
+    if (index.load(this->m_media) && index.stream() == streamIndex)
+        pts = index.keyFrame(pts, false);
+
+    av_seek_frame(context, streamIndex, pts, AVSEEK_FLAG_BACKWARD);
+
+    auto packet = av_packet_alloc();
+    auto frame = av_frame_alloc();
+    bool gotFrame = false;
+    bool eof = false;
+
+    while (!gotFrame) {
+        if (!eof) {
+            if (av_read_frame(context, packet) < 0) {
+                avcodec_send_packet(codecContext, nullptr);
+                eof = true;
+            } else {
+                if (packet->stream_index == streamIndex)
+                    avcodec_send_packet(codecContext, packet);
+
+                av_packet_unref(packet);
+            }
+        }
+
+        int r = avcodec_receive_frame(codecContext, frame);
+
+        if (r >= 0)
+            gotFrame = true;
+        else if (r != AVERROR(EAGAIN) || eof)
+            break;
+    }
+
+    av_packet_free(&packet);
+    AkVideoPacket thumbnail;
+
+    if (gotFrame) {
+        // Fit the frame in maxSize keeping the aspect ratio.
+        QSize size(frame->width, frame->height);
+
+        if (size.width() > maxSize.width() || size.height() > maxSize.height())
+            size.scale(maxSize, Qt::KeepAspectRatio);
+
+        size = size.expandedTo({1, 1});
+        auto scaleContext =
+                sws_getContext(frame->width,
+                               frame->height,
+                               AVPixelFormat(frame->format),
+                               size.width(),
+                               size.height(),
+                               AV_PIX_FMT_RGB32,
+                               SWS_FAST_BILINEAR,
+                               nullptr,
+                               nullptr,
+                               nullptr);
+
+        if (scaleContext) {
+            AkVideoCaps caps(AkVideoCaps::Format_argbpack,
+                             size.width(),
+                             size.height(),
+                             AkFrac(stream->avg_frame_rate.num,
+                                    stream->avg_frame_rate.den));
+            thumbnail = AkVideoPacket(caps);
+            uint8_t *dstData[4] {thumbnail.plane(0), nullptr, nullptr, nullptr};
+            int dstLineSize[4] {int(thumbnail.lineSize(0)), 0, 0, 0};
+            sws_scale(scaleContext,
+                      frame->data,
+                      frame->linesize,
+                      0,
+                      frame->height,
+                      dstData,
+                      dstLineSize);
+            sws_freeContext(scaleContext);
+            thumbnail.setPts(frame->best_effort_timestamp);
+            thumbnail.setTimeBase(AkFrac(stream->time_base.num,
+                                         stream->time_base.den));
+            thumbnail.setIndex(streamIndex);
+        }
+    }
+
+    av_frame_free(&frame);
+    avcodec_free_context(&codecContext);
+
+    return thumbnail;
+}
+
 void MediaSourceFFmpegPrivate::readPackets()
 {
     while (this->m_run) {
@@ -919,6 +1359,8 @@ void MediaSourceFFmpegPrivate::readPacket()
             av_packet_free(&packet);
             this->m_eos = true;
         } else {
+            this->readahead();
+
             if (this->m_streamsMap.contains(packet->stream_index)
                 && (this->m_streams.isEmpty()
                     || this->m_streams.contains(packet->stream_index))) {
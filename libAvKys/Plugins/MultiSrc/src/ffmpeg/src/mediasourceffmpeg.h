@@ -45,7 +45,15 @@ class MediaSourceFFmpeg: public MediaSource
         Q_INVOKABLE qint64 durationMSecs() override;
         Q_INVOKABLE qint64 currentTimeMSecs() override;
         Q_INVOKABLE qint64 maxPacketQueueSize() const override;
+        Q_INVOKABLE int decodingThreads() const override;
+        Q_INVOKABLE qint64 packetQueueSize() const;
+        Q_INVOKABLE int packetQueueLength() const;
+        Q_INVOKABLE qreal decodeLatency() const;
+        Q_INVOKABLE quint64 droppedFrames() const;
         Q_INVOKABLE bool showLog() const override;
+        Q_INVOKABLE MediaSource::SeekMode seekMode() const override;
+        Q_INVOKABLE AkVideoPacket thumbnail(qint64 mSecs,
+                                            const QSize &maxSize) override;
         Q_INVOKABLE AkElement::ElementState state() const override;
 
     private:
@@ -56,13 +64,17 @@ class MediaSourceFFmpeg: public MediaSource
         void setMedia(const QString &media) override;
         void setStreams(const QList<int> &streams) override;
         void setMaxPacketQueueSize(qint64 maxPacketQueueSize) override;
+        void setDecodingThreads(int decodingThreads) override;
         void setShowLog(bool showLog) override;
+        void setSeekMode(MediaSource::SeekMode seekMode) override;
         void setLoop(bool loop) override;
         void setSync(bool sync) override;
         void resetMedia() override;
         void resetStreams() override;
         void resetMaxPacketQueueSize() override;
+        void resetDecodingThreads() override;
         void resetShowLog() override;
+        void resetSeekMode() override;
         void resetLoop() override;
         void resetSync() override;
         bool setState(AkElement::ElementState state) override;
@@ -20,8 +20,10 @@
 #include <QThread>
 #include <akfrac.h>
 #include <akcaps.h>
+#include <akcolorplane.h>
 #include <akpacket.h>
 #include <akvideocaps.h>
+#include <akvideoformatspec.h>
 #include <akvideopacket.h>
 
 extern "C"
@@ -46,6 +48,68 @@ extern "C"
 // no AV correction is done if too big error
 #define AV_NOSYNC_THRESHOLD 10.0
 
+struct VideoPixelFormat
+{
+    AVPixelFormat ffFormat;
+    AkVideoCaps::PixelFormat akFormat;
+
+    static inline const VideoPixelFormat *byFF(AVPixelFormat ffFormat);
+};
+
+static const VideoPixelFormat multiSrcPixelFormatTable[] {
+    {AV_PIX_FMT_AYUV64   , AkVideoCaps::Format_ayuv64     },
+    {AV_PIX_FMT_BGR24    , AkVideoCaps::Format_bgr24      },
+    {AV_PIX_FMT_BGRA     , AkVideoCaps::Format_bgra       },
+    {AV_PIX_FMT_BGR0     , AkVideoCaps::Format_bgrx       },
+    {AV_PIX_FMT_GBRP     , AkVideoCaps::Format_gbrp       },
+    {AV_PIX_FMT_GBRP10   , AkVideoCaps::Format_gbrp10     },
+    {AV_PIX_FMT_GBRP12   , AkVideoCaps::Format_gbrp12     },
+    {AV_PIX_FMT_GBRP16   , AkVideoCaps::Format_gbrp16     },
+    {AV_PIX_FMT_NV12     , AkVideoCaps::Format_nv12       },
+    {AV_PIX_FMT_NV16     , AkVideoCaps::Format_nv16       },
+    {AV_PIX_FMT_NV20     , AkVideoCaps::Format_nv20       },
+    {AV_PIX_FMT_NV21     , AkVideoCaps::Format_nv21       },
+    {AV_PIX_FMT_NV24     , AkVideoCaps::Format_nv24       },
+    {AV_PIX_FMT_P010     , AkVideoCaps::Format_p010       },
+    {AV_PIX_FMT_P016     , AkVideoCaps::Format_p016       },
+    {AV_PIX_FMT_P210     , AkVideoCaps::Format_p210       },
+    {AV_PIX_FMT_P216     , AkVideoCaps::Format_p216       },
+    {AV_PIX_FMT_P416     , AkVideoCaps::Format_p416       },
+    {AV_PIX_FMT_RGB24    , AkVideoCaps::Format_rgb24      },
+    {AV_PIX_FMT_RGBA     , AkVideoCaps::Format_rgba       },
+    {AV_PIX_FMT_RGB0     , AkVideoCaps::Format_rgbx       },
+    {AV_PIX_FMT_UYVY422  , AkVideoCaps::Format_uyvy422    },
+    {AV_PIX_FMT_0BGR32   , AkVideoCaps::Format_xbgr       },
+    {AV_PIX_FMT_X2BGR10  , AkVideoCaps::Format_xbgr2101010},
+    {AV_PIX_FMT_0RGB32   , AkVideoCaps::Format_xrgb       },
+    {AV_PIX_FMT_X2RGB10  , AkVideoCaps::Format_xrgb2101010},
+    {AV_PIX_FMT_GRAY10   , AkVideoCaps::Format_y10        },
+    {AV_PIX_FMT_GRAY8    , AkVideoCaps::Format_y8         },
+    {AV_PIX_FMT_YUV420P  , AkVideoCaps::Format_yuv420p    },
+    {AV_PIX_FMT_YUV420P10, AkVideoCaps::Format_yuv420p10  },
+    {AV_PIX_FMT_YUV420P12, AkVideoCaps::Format_yuv420p12  },
+    {AV_PIX_FMT_YUV422P  , AkVideoCaps::Format_yuv422p    },
+    {AV_PIX_FMT_YUV422P10, AkVideoCaps::Format_yuv422p10  },
+    {AV_PIX_FMT_YUV422P12, AkVideoCaps::Format_yuv422p12  },
+    {AV_PIX_FMT_YUV444P  , AkVideoCaps::Format_yuv444p    },
+    {AV_PIX_FMT_YUV444P10, AkVideoCaps::Format_yuv444p10  },
+    {AV_PIX_FMT_YUV444P12, AkVideoCaps::Format_yuv444p12  },
+    {AV_PIX_FMT_YUVA420P , AkVideoCaps::Format_yuva420p   },
+    {AV_PIX_FMT_YUYV422  , AkVideoCaps::Format_yuyv422    },
+    {AV_PIX_FMT_NONE     , AkVideoCaps::Format_none       },
+};
+
+const VideoPixelFormat *VideoPixelFormat::byFF(AVPixelFormat ffFormat)
+{
+    auto fmt = multiSrcPixelFormatTable;
+
+    for (; fmt->akFormat != AkVideoCaps::Format_none; fmt++)
+        if (fmt->ffFormat == ffFormat)
+            return fmt;
+
+    return fmt;
+}
+
 class VideoStreamPrivate
 {
     public:
@@ -57,7 +121,11 @@ class VideoStreamPrivate
         explicit VideoStreamPrivate(VideoStream *self);
         AkFrac fps() const;
         AkPacket convert(AVFrame *iFrame);
-        AVFrame *copyFrame(AVFrame *frame) const;
+        AkVideoPacket wrapFrame(AVFrame *frame, const AkVideoCaps &caps) const;
+        AkVideoPacket copyFrame(AVFrame *frame, const AkVideoCaps &caps) const;
+        AkVideoPacket scaleFrame(AVFrame *frame);
+        AVFrame *refFrame(AVFrame *frame) const;
+        static void releaseFrame(void *userData);
 
         template<typename R, typename S>
         inline static R align(R value, S align)
@@ -95,7 +163,13 @@ VideoStream::~VideoStream()
 
 AkCaps VideoStream::caps() const
 {
-    return AkVideoCaps(AkVideoCaps::Format_rgb24,
+    auto format = VideoPixelFormat::byFF(this->codecContext()->pix_fmt)->akFormat;
+
+    // The formats that can't be represented are converted to RGB24.
+    if (format == AkVideoCaps::Format_none)
+        format = AkVideoCaps::Format_rgb24;
+
+    return AkVideoCaps(format,
                        this->codecContext()->width,
                        this->codecContext()->height,
                        this->d->fps());
@@ -113,8 +187,12 @@ bool VideoStream::decodeData()
         int r = avcodec_receive_frame(this->codecContext(), iFrame);
 
         if (r >= 0) {
-            this->dataEnqueue(this->d->copyFrame(iFrame));
-            result = true;
+            auto oFrame = this->d->refFrame(iFrame);
+
+            if (oFrame) {
+                this->dataEnqueue(oFrame);
+                result = true;
+            }
         }
 
         av_frame_free(&iFrame);
@@ -169,6 +247,7 @@ void VideoStream::processData(AVFrame *frame)
             if (diff <= -syncThreshold) {
                 // Drop frame.
                 this->d->m_lastPts = pts;
+                this->frameDropped();
 
                 break;
             }
@@ -215,106 +294,163 @@ AkFrac VideoStreamPrivate::fps() const
 
 AkPacket VideoStreamPrivate::convert(AVFrame *iFrame)
 {
-    static const AVPixelFormat outPixFormat = AV_PIX_FMT_RGB24;
+    auto format = VideoPixelFormat::byFF(AVPixelFormat(iFrame->format))->akFormat;
+    AkVideoPacket oPacket;
+
+    /* Send the frames in the format given by the decoder, the consumers will
+     * convert them only if they need to. Only the formats that can't be
+     * represented are converted here.
+     */
+    if (format == AkVideoCaps::Format_none) {
+        oPacket = this->scaleFrame(iFrame);
+    } else {
+        AkVideoCaps caps(format,
+                         iFrame->width,
+                         iFrame->height,
+                         this->fps());
+        oPacket = this->wrapFrame(iFrame, caps);
+
+        if (!oPacket)
+            oPacket = this->copyFrame(iFrame, caps);
+    }
 
-    // Initialize rescaling context.
-    this->m_scaleContext = sws_getCachedContext(this->m_scaleContext,
-                                                iFrame->width,
-                                                iFrame->height,
-                                                AVPixelFormat(iFrame->format),
-                                                iFrame->width,
-                                                iFrame->height,
-                                                outPixFormat,
-                                                SWS_FAST_BILINEAR,
-                                                nullptr,
-                                                nullptr,
-                                                nullptr);
+    if (!oPacket)
+        return {};
 
-    if (!this->m_scaleContext)
+    oPacket.setId(self->id());
+    oPacket.setPts(iFrame->pts);
+
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
+    oPacket.setDuration(iFrame->duration);
+#else
+    oPacket.setDuration(iFrame->pkt_duration);
+#endif
+
+    oPacket.setTimeBase(self->timeBase());
+    oPacket.setIndex(int(self->index()));
+
+    return oPacket;
+}
+
+AkVideoPacket VideoStreamPrivate::wrapFrame(AVFrame *frame,
+                                            const AkVideoCaps &caps) const
+{
+    /* The frame can be used without copying only if its planes are stored
+     * one after the other in the same buffer, as AkVideoPacket expects.
+     */
+    auto buffer = frame->buf[0];
+
+    if (!buffer || !frame->data[0] || frame->data[0] < buffer->data)
         return {};
 
-    // Create oPicture
-    AVFrame oFrame;
-    memset(&oFrame, 0, sizeof(AVFrame));
+    auto specs = AkVideoCaps::formatSpecs(caps.format());
+    size_t lineSize[4];
+    size_t offset = 0;
+
+    for (size_t plane = 0; plane < specs.planes(); ++plane) {
+        if (frame->linesize[plane] < 1
+            || frame->data[plane] != frame->data[0] + offset)
+            return {};
+
+        lineSize[plane] = size_t(frame->linesize[plane]);
+        offset += (lineSize[plane] * size_t(caps.height()))
+                  >> specs.plane(plane).heightDiv();
+    }
 
-    if (av_image_alloc(oFrame.data,
-                       oFrame.linesize,
-                       iFrame->width,
-                       iFrame->height,
-                       outPixFormat,
-                       1) < 1)
+    auto dataSize = size_t(buffer->data + buffer->size - frame->data[0]);
+
+    if (offset > dataSize)
         return {};
 
-    // Convert picture format
-    sws_scale(this->m_scaleContext,
-              iFrame->data,
-              iFrame->linesize,
-              0,
-              iFrame->height,
-              oFrame.data,
-              oFrame.linesize);
+    // The packet keeps a reference to the frame until it's released.
+    auto ref = av_frame_clone(frame);
 
-    // Create packet
-    auto nPlanes = av_pix_fmt_count_planes(AVPixelFormat(iFrame->format));
-    AkVideoCaps caps(AkVideoCaps::Format_rgb24,
-                     iFrame->width,
-                     iFrame->height,
-                     this->fps());
+    if (!ref)
+        return {};
+
+    return AkVideoPacket(caps,
+                         ref->data[0],
+                         dataSize,
+                         lineSize,
+                         VideoStreamPrivate::releaseFrame,
+                         ref);
+}
+
+AkVideoPacket VideoStreamPrivate::copyFrame(AVFrame *frame,
+                                            const AkVideoCaps &caps) const
+{
     AkVideoPacket oPacket(caps);
 
-    for (int plane = 0; plane < nPlanes; ++plane) {
-        auto planeData = oFrame.data[plane];
-        auto oLineSize = oFrame.linesize[plane];
-        auto lineSize = qMin<size_t>(oPacket.lineSize(plane), oLineSize);
-        auto heightDiv = oPacket.heightDiv(plane);
+    for (int plane = 0; plane < int(oPacket.planes()); ++plane) {
+        auto srcLineSize = frame->linesize[plane];
+        auto lineSize = qMin<size_t>(oPacket.bytesUsed(plane),
+                                     size_t(qAbs(srcLineSize)));
+        auto height = caps.height() >> oPacket.heightDiv(plane);
 
-        for (int y = 0; y < iFrame->height; ++y) {
-            auto ys = y >> heightDiv;
+        for (int y = 0; y < height; ++y)
             memcpy(oPacket.line(plane, y),
-                   planeData + ys * oLineSize,
+                   frame->data[plane] + ptrdiff_t(y) * srcLineSize,
                    lineSize);
-        }
     }
 
-    oPacket.setId(self->id());
-    oPacket.setPts(iFrame->pts);
+    return oPacket;
+}
 
-#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 30, 100)
-    oPacket.setDuration(iFrame->duration);
-#else
-    oPacket.setDuration(iFrame->pkt_duration);
-#endif
+AkVideoPacket VideoStreamPrivate::scaleFrame(AVFrame *frame)
+{
+    static const AVPixelFormat outPixFormat = AV_PIX_FMT_RGB24;
 
-    oPacket.setTimeBase(self->timeBase());
-    oPacket.setIndex(int(self->index()));
-    av_freep(&oFrame.data[0]);
+    // Initialize rescaling context.
+    this->m_scaleContext = sws_getCachedContext(this->m_scaleContext,
+                                                frame->width,
+                                                frame->height,
+                                                AVPixelFormat(frame->format),
+                                                frame->width,
+                                                frame->height,
+                                                outPixFormat,
+                                                SWS_FAST_BILINEAR,
+                                                nullptr,
+                                                nullptr,
+                                                nullptr);
+
+    if (!this->m_scaleContext)
+        return {};
+
+    AkVideoCaps caps(AkVideoCaps::Format_rgb24,
+                     frame->width,
+                     frame->height,
+                     this->fps());
+    AkVideoPacket oPacket(caps);
+
+    // Convert the picture straight into the packet.
+    uint8_t *dstData[] {oPacket.plane(0), nullptr, nullptr, nullptr};
+    int dstLineSize[] {int(oPacket.lineSize(0)), 0, 0, 0};
+    sws_scale(this->m_scaleContext,
+              frame->data,
+              frame->linesize,
+              0,
+              frame->height,
+              dstData,
+              dstLineSize);
 
     return oPacket;
 }
 
-AVFrame *VideoStreamPrivate::copyFrame(AVFrame *frame) const
+AVFrame *VideoStreamPrivate::refFrame(AVFrame *frame) const
 {
-    auto oFrame = av_frame_alloc();
-    oFrame->width = frame->width;
-    oFrame->height = frame->height;
-    oFrame->format = frame->format;
-    oFrame->pts = frame->best_effort_timestamp;
-
-    av_image_alloc(oFrame->data,
-                   oFrame->linesize,
-                   oFrame->width,
-                   oFrame->height,
-                   AVPixelFormat(oFrame->format),
-                   1);
-    av_image_copy(oFrame->data,
-                  oFrame->linesize,
-                  const_cast<const uint8_t **>(frame->data),
-                  frame->linesize,
-                  AVPixelFormat(oFrame->format),
-                  oFrame->width,
-                  oFrame->height);
+    // Reference the buffers of the decoder instead of copying the picture.
+    auto oFrame = av_frame_clone(frame);
+
+    if (oFrame)
+        oFrame->pts = frame->best_effort_timestamp;
 
     return oFrame;
 }
 
+void VideoStreamPrivate::releaseFrame(void *userData)
+{
+    auto frame = reinterpret_cast<AVFrame *>(userData);
+    av_frame_free(&frame);
+}
+
 #include "moc_videostream.cpp"
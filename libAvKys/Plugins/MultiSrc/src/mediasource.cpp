@@ -99,11 +99,29 @@ qint64 MediaSource::maxPacketQueueSize() const
     return 0;
 }
 
+int MediaSource::decodingThreads() const
+{
+    return 0;
+}
+
 bool MediaSource::showLog() const
 {
     return false;
 }
 
+MediaSource::SeekMode MediaSource::seekMode() const
+{
+    return SeekModeAccurate;
+}
+
+AkVideoPacket MediaSource::thumbnail(qint64 mSecs, const QSize &maxSize)
+{
+    Q_UNUSED(mSecs)
+    Q_UNUSED(maxSize)
+
+    return {};
+}
+
 AkElement::ElementState MediaSource::state() const
 {
     return AkElement::ElementStateNull;
@@ -130,11 +148,21 @@ void MediaSource::setMaxPacketQueueSize(qint64 maxPacketQueueSize)
     Q_UNUSED(maxPacketQueueSize)
 }
 
+void MediaSource::setDecodingThreads(int decodingThreads)
+{
+    Q_UNUSED(decodingThreads)
+}
+
 void MediaSource::setShowLog(bool showLog)
 {
     Q_UNUSED(showLog)
 }
 
+void MediaSource::setSeekMode(SeekMode seekMode)
+{
+    Q_UNUSED(seekMode)
+}
+
 void MediaSource::setLoop(bool loop)
 {
     Q_UNUSED(loop)
@@ -167,11 +195,21 @@ void MediaSource::resetMaxPacketQueueSize()
     this->setMaxPacketQueueSize(0);
 }
 
+void MediaSource::resetDecodingThreads()
+{
+    this->setDecodingThreads(0);
+}
+
 void MediaSource::resetShowLog()
 {
     this->setShowLog(false);
 }
 
+void MediaSource::resetSeekMode()
+{
+    this->setSeekMode(SeekModeAccurate);
+}
+
 void MediaSource::resetLoop()
 {
     this->setLoop(false);
@@ -20,8 +20,10 @@
 #ifndef MEDIASOURCE_H
 #define MEDIASOURCE_H
 
+#include <QSize>
 #include <iak/akelement.h>
 #include <akcaps.h>
+#include <akvideopacket.h>
 
 class MediaSource: public QObject
 {
@@ -60,11 +62,21 @@ class MediaSource: public QObject
                WRITE setMaxPacketQueueSize
                RESET resetMaxPacketQueueSize
                NOTIFY maxPacketQueueSizeChanged)
+    Q_PROPERTY(int decodingThreads
+               READ decodingThreads
+               WRITE setDecodingThreads
+               RESET resetDecodingThreads
+               NOTIFY decodingThreadsChanged)
     Q_PROPERTY(bool showLog
                READ showLog
                WRITE setShowLog
                RESET resetShowLog
                NOTIFY showLogChanged)
+    Q_PROPERTY(MediaSource::SeekMode seekMode
+               READ seekMode
+               WRITE setSeekMode
+               RESET resetSeekMode
+               NOTIFY seekModeChanged)
     Q_PROPERTY(AkElement::ElementState state
                READ state
                WRITE setState
@@ -78,6 +90,13 @@ class MediaSource: public QObject
             SeekEnd,
         };
 
+        enum SeekMode {
+            SeekModeAccurate,
+            SeekModeKeyFrame,
+            SeekModeNearestKeyFrame,
+        };
+        Q_ENUM(SeekMode)
+
         MediaSource(QObject *parent=nullptr);
         virtual ~MediaSource() = default;
 
@@ -94,7 +113,11 @@ class MediaSource: public QObject
         Q_INVOKABLE virtual qint64 durationMSecs();
         Q_INVOKABLE virtual qint64 currentTimeMSecs();
         Q_INVOKABLE virtual qint64 maxPacketQueueSize() const;
+        Q_INVOKABLE virtual int decodingThreads() const;
         Q_INVOKABLE virtual bool showLog() const;
+        Q_INVOKABLE virtual MediaSource::SeekMode seekMode() const;
+        Q_INVOKABLE virtual AkVideoPacket thumbnail(qint64 mSecs,
+                                                    const QSize &maxSize);
         Q_INVOKABLE virtual AkElement::ElementState state() const;
 
     signals:
@@ -104,7 +127,9 @@ class MediaSource: public QObject
         void durationMSecsChanged(qint64 durationMSecs);
         void currentTimeMSecsChanged(qint64 currentTimeMSecs);
         void maxPacketQueueSizeChanged(qint64 maxPacketQueue);
+        void decodingThreadsChanged(int decodingThreads);
         void showLogChanged(bool showLog);
+        void seekModeChanged(MediaSource::SeekMode seekMode);
         void loopChanged(bool loop);
         void syncChanged(bool sync);
         void mediasChanged(const QStringList &medias);
@@ -117,14 +142,18 @@ class MediaSource: public QObject
         virtual void setMedia(const QString &media);
         virtual void setStreams(const QList<int> &streams);
         virtual void setMaxPacketQueueSize(qint64 maxPacketQueueSize);
+        virtual void setDecodingThreads(int decodingThreads);
         virtual void setShowLog(bool showLog);
+        virtual void setSeekMode(MediaSource::SeekMode seekMode);
         virtual void setLoop(bool loop);
         virtual void setSync(bool sync);
         virtual bool setState(AkElement::ElementState state);
         virtual void resetMedia();
         virtual void resetStreams();
         virtual void resetMaxPacketQueueSize();
+        virtual void resetDecodingThreads();
         virtual void resetShowLog();
+        virtual void resetSeekMode();
         virtual void resetLoop();
         virtual void resetSync();
         virtual void resetState();
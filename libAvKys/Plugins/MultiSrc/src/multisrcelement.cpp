@@ -17,18 +17,37 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QSharedPointer>
 #include <QMutex>
 #include <QQmlContext>
 #include <QReadWriteLock>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <akaudiopacket.h>
+#include <akfrac.h>
 #include <akplugininfo.h>
 #include <akpluginmanager.h>
+#include <akvideoconverter.h>
+#include <akvideopacket.h>
 
 #include "multisrcelement.h"
 #include "mediasource.h"
 
+// Default memory limit for the frames of a looping clip.
+#define DEFAULT_LOOP_CACHE_SIZE (256 * 1024 * 1024)
+
 using MediaSourcePtr = QSharedPointer<MediaSource>;
 
+struct CachedPacket
+{
+    AkPacket packet;
+    qreal time;
+    qreal endTime;
+};
+
 class MultiSrcElementPrivate
 {
     public:
@@ -36,9 +55,46 @@ class MultiSrcElementPrivate
         MediaSourcePtr m_mediaSource;
         QString m_mediaSourceImpl;
         QReadWriteLock m_mutex;
+        AkVideoConverter m_videoConverter;
+        QMutex m_cacheMutex;
+        QVector<CachedPacket> m_loopCache;
+        QMap<int, qint64> m_lastPts;
+        QMap<int, qint64> m_sourcePts;
+        qint64 m_loopCacheSize {0};
+        qint64 m_maxLoopCacheSize {DEFAULT_LOOP_CACHE_SIZE};
+        std::atomic<quint64> m_loopCacheHits {0};
+        bool m_caching {false};
+        bool m_waitLoop {false};
+        bool m_cacheReady {false};
+        qreal m_replayPosition {0.0};
+        QThreadPool m_threadPool;
+        QFuture<void> m_replayLoopResult;
+        std::atomic<bool> m_replay {false};
+        std::atomic<AkElement::ElementState> m_replayState {AkElement::ElementStateNull};
 
         explicit MultiSrcElementPrivate(MultiSrcElement *self);
         void linksChanged(const AkPluginLinks &links);
+        void sourceStateChanged(AkElement::ElementState state);
+        void sourcePacket(const AkPacket &packet);
+        bool cachePacket(const AkPacket &packet);
+        void resetLoopCache(bool caching, bool waitLoop=false);
+        bool loopCacheEnabled();
+        void startReplay();
+        void stopReplay();
+        void replayLoop();
+
+        template<typename PacketType>
+        inline static AkPacket shiftPacket(const AkPacket &packet,
+                                           qreal offset)
+        {
+            PacketType oPacket(packet);
+            auto timeBase = oPacket.timeBase().value();
+
+            if (timeBase > 0.0)
+                oPacket.setPts(oPacket.pts() + qRound64(offset / timeBase));
+
+            return oPacket;
+        }
 };
 
 MultiSrcElement::MultiSrcElement():
@@ -56,11 +112,15 @@ MultiSrcElement::MultiSrcElement():
         QObject::connect(this->d->m_mediaSource.data(),
                          &MediaSource::stateChanged,
                          this,
-                         &MultiSrcElement::stateChanged);
+                         [this] (AkElement::ElementState state) {
+                            this->d->sourceStateChanged(state);
+                         });
         QObject::connect(this->d->m_mediaSource.data(),
                          &MediaSource::oStream,
                          this,
-                         &MultiSrcElement::oStream,
+                         [this] (const AkPacket &packet) {
+                            this->d->sourcePacket(packet);
+                         },
                          Qt::DirectConnection);
         QObject::connect(this->d->m_mediaSource.data(),
                          &MediaSource::error,
@@ -78,10 +138,20 @@ MultiSrcElement::MultiSrcElement():
                          &MediaSource::maxPacketQueueSizeChanged,
                          this,
                          &MultiSrcElement::maxPacketQueueSizeChanged);
+        QObject::connect(this->d->m_mediaSource.data(),
+                         &MediaSource::decodingThreadsChanged,
+                         this,
+                         &MultiSrcElement::decodingThreadsChanged);
         QObject::connect(this->d->m_mediaSource.data(),
                          &MediaSource::showLogChanged,
                          this,
                          &MultiSrcElement::showLogChanged);
+        QObject::connect(this->d->m_mediaSource.data(),
+                         &MediaSource::seekModeChanged,
+                         this,
+                         [this] (MediaSource::SeekMode seekMode) {
+                            emit this->seekModeChanged(MultiSrcElement::SeekMode(seekMode));
+                         });
         QObject::connect(this->d->m_mediaSource.data(),
                          &MediaSource::loopChanged,
                          this,
@@ -284,6 +354,19 @@ qint64 MultiSrcElement::maxPacketQueueSize() const
     return queueSize;
 }
 
+int MultiSrcElement::decodingThreads() const
+{
+    this->d->m_mutex.lockForRead();
+    int decodingThreads = 0;
+
+    if (this->d->m_mediaSource)
+        decodingThreads = this->d->m_mediaSource->decodingThreads();
+
+    this->d->m_mutex.unlock();
+
+    return decodingThreads;
+}
+
 bool MultiSrcElement::showLog() const
 {
     this->d->m_mutex.lockForRead();
@@ -297,8 +380,64 @@ bool MultiSrcElement::showLog() const
     return showLog;
 }
 
+MultiSrcElement::SeekMode MultiSrcElement::seekMode() const
+{
+    this->d->m_mutex.lockForRead();
+    auto seekMode = SeekModeAccurate;
+
+    if (this->d->m_mediaSource)
+        seekMode = SeekMode(this->d->m_mediaSource->seekMode());
+
+    this->d->m_mutex.unlock();
+
+    return seekMode;
+}
+
+AkVideoPacket MultiSrcElement::thumbnail(qint64 mSecs, const QSize &maxSize)
+{
+    // Don't block the element while the thumbnail is decoded.
+    this->d->m_mutex.lockForRead();
+    auto mediaSource = this->d->m_mediaSource;
+    this->d->m_mutex.unlock();
+
+    if (!mediaSource)
+        return {};
+
+    return mediaSource->thumbnail(mSecs, maxSize);
+}
+
+qint64 MultiSrcElement::maxLoopCacheSize() const
+{
+    return this->d->m_maxLoopCacheSize;
+}
+
+AkVideoCaps MultiSrcElement::outputCaps() const
+{
+    return this->d->m_videoConverter.outputCaps();
+}
+
+qint64 MultiSrcElement::loopCacheSize() const
+{
+    this->d->m_cacheMutex.lock();
+    auto loopCacheSize = this->d->m_loopCacheSize;
+    this->d->m_cacheMutex.unlock();
+
+    return loopCacheSize;
+}
+
+quint64 MultiSrcElement::loopCacheHits() const
+{
+    return this->d->m_loopCacheHits;
+}
+
 AkElement::ElementState MultiSrcElement::state() const
 {
+    // The clip is being played from the cache.
+    auto replayState = this->d->m_replayState.load();
+
+    if (replayState != ElementStateNull)
+        return replayState;
+
     this->d->m_mutex.lockForRead();
     ElementState state = ElementStateNull;
 
@@ -328,21 +467,41 @@ void MultiSrcElement::controlInterfaceConfigure(QQmlContext *context,
 
 void MultiSrcElement::seek(qint64 seekTo, SeekPosition position)
 {
+    /* The cached frames don't match the stream anymore after seeking, play
+     * the clip from the source again, and start caching it when the source
+     * wraps to the beginning of the clip.
+     */
+    auto replayState = this->d->m_replayState.exchange(ElementStateNull);
+    this->d->stopReplay();
+    this->d->resetLoopCache(false, this->d->loopCacheEnabled());
     this->d->m_mutex.lockForRead();
 
-    if (this->d->m_mediaSource)
+    if (this->d->m_mediaSource) {
+        if (replayState != ElementStateNull)
+            this->d->m_mediaSource->setState(replayState);
+
         this->d->m_mediaSource->seek(seekTo, MediaSource::SeekPosition(position));
+    }
 
     this->d->m_mutex.unlock();
 }
 
 void MultiSrcElement::setMedia(const QString &media)
 {
+    // Keep playing the new media if the previous one was played from the
+    // cache.
+    auto replayState = this->d->m_replayState.exchange(ElementStateNull);
+    this->d->stopReplay();
+    this->d->resetLoopCache(replayState != ElementStateNull);
     this->d->m_mutex.lockForRead();
 
-    if (this->d->m_mediaSource)
+    if (this->d->m_mediaSource) {
         this->d->m_mediaSource->setMedia(media);
 
+        if (replayState != ElementStateNull)
+            this->d->m_mediaSource->setState(replayState);
+    }
+
     this->d->m_mutex.unlock();
 }
 
@@ -364,6 +523,14 @@ void MultiSrcElement::setLoop(bool loop)
         this->d->m_mediaSource->setLoop(loop);
 
     this->d->m_mutex.unlock();
+
+    // The clip played from the cache ends here.
+    if (!loop
+        && this->d->m_replayState.exchange(ElementStateNull) != ElementStateNull) {
+        this->d->stopReplay();
+        this->d->resetLoopCache(false);
+        emit this->stateChanged(ElementStateNull);
+    }
 }
 
 void MultiSrcElement::setSync(bool sync)
@@ -386,6 +553,16 @@ void MultiSrcElement::setMaxPacketQueueSize(qint64 maxPacketQueueSize)
     this->d->m_mutex.unlock();
 }
 
+void MultiSrcElement::setDecodingThreads(int decodingThreads)
+{
+    this->d->m_mutex.lockForRead();
+
+    if (this->d->m_mediaSource)
+        this->d->m_mediaSource->setDecodingThreads(decodingThreads);
+
+    this->d->m_mutex.unlock();
+}
+
 void MultiSrcElement::setShowLog(bool showLog)
 {
     this->d->m_mutex.lockForRead();
@@ -396,6 +573,34 @@ void MultiSrcElement::setShowLog(bool showLog)
     this->d->m_mutex.unlock();
 }
 
+void MultiSrcElement::setSeekMode(SeekMode seekMode)
+{
+    this->d->m_mutex.lockForRead();
+
+    if (this->d->m_mediaSource)
+        this->d->m_mediaSource->setSeekMode(MediaSource::SeekMode(seekMode));
+
+    this->d->m_mutex.unlock();
+}
+
+void MultiSrcElement::setMaxLoopCacheSize(qint64 maxLoopCacheSize)
+{
+    if (this->d->m_maxLoopCacheSize == maxLoopCacheSize)
+        return;
+
+    this->d->m_maxLoopCacheSize = maxLoopCacheSize;
+    emit this->maxLoopCacheSizeChanged(maxLoopCacheSize);
+}
+
+void MultiSrcElement::setOutputCaps(const AkVideoCaps &outputCaps)
+{
+    if (this->d->m_videoConverter.outputCaps() == outputCaps)
+        return;
+
+    this->d->m_videoConverter.setOutputCaps(outputCaps);
+    emit this->outputCapsChanged(outputCaps);
+}
+
 void MultiSrcElement::resetMedia()
 {
     this->d->m_mutex.lockForRead();
@@ -446,6 +651,16 @@ void MultiSrcElement::resetMaxPacketQueueSize()
     this->d->m_mutex.unlock();
 }
 
+void MultiSrcElement::resetDecodingThreads()
+{
+    this->d->m_mutex.lockForRead();
+
+    if (this->d->m_mediaSource)
+        this->d->m_mediaSource->resetDecodingThreads();
+
+    this->d->m_mutex.unlock();
+}
+
 void MultiSrcElement::resetShowLog()
 {
     this->d->m_mutex.lockForRead();
@@ -456,13 +671,77 @@ void MultiSrcElement::resetShowLog()
     this->d->m_mutex.unlock();
 }
 
+void MultiSrcElement::resetSeekMode()
+{
+    this->d->m_mutex.lockForRead();
+
+    if (this->d->m_mediaSource)
+        this->d->m_mediaSource->resetSeekMode();
+
+    this->d->m_mutex.unlock();
+}
+
+void MultiSrcElement::resetMaxLoopCacheSize()
+{
+    this->setMaxLoopCacheSize(DEFAULT_LOOP_CACHE_SIZE);
+}
+
+void MultiSrcElement::resetOutputCaps()
+{
+    this->setOutputCaps({});
+}
+
 bool MultiSrcElement::setState(ElementState state)
 {
+    // Control the playback of the cached clip.
+    switch (this->d->m_replayState.load()) {
+    case ElementStateNull:
+        break;
+
+    case ElementStatePaused:
+        if (state == ElementStatePlaying) {
+            this->d->startReplay();
+
+            return true;
+        }
+
+        if (state == ElementStateNull) {
+            this->d->resetLoopCache(false);
+            this->d->m_replayState = state;
+            emit this->stateChanged(state);
+
+            return true;
+        }
+
+        return false;
+
+    case ElementStatePlaying:
+        if (state == ElementStatePlaying)
+            return false;
+
+        this->d->stopReplay();
+
+        if (state == ElementStateNull)
+            this->d->resetLoopCache(false);
+
+        this->d->m_replayState = state;
+        emit this->stateChanged(state);
+
+        return true;
+    }
+
     this->d->m_mutex.lockForRead();
     bool result = false;
 
-    if (this->d->m_mediaSource)
+    if (this->d->m_mediaSource) {
+        // Start filling the cache if the clip will be looped.
+        if (this->d->m_mediaSource->state() == ElementStateNull
+            && state != ElementStateNull)
+            this->d->resetLoopCache(this->d->m_mediaSource->loop()
+                                    && this->d->m_maxLoopCacheSize > 0);
+
         result = this->d->m_mediaSource->setState(state);
+    }
 
     this->d->m_mutex.unlock();
 
@@ -492,11 +771,15 @@ void MultiSrcElementPrivate::linksChanged(const AkPluginLinks &links)
     QString media;
     bool loop = false;
     bool showLog = false;
+    int decodingThreads = 0;
+    auto seekMode = MediaSource::SeekModeAccurate;
 
     if (this->m_mediaSource) {
         media = this->m_mediaSource->media();
         loop = this->m_mediaSource->loop();
         showLog = this->m_mediaSource->showLog();
+        decodingThreads = this->m_mediaSource->decodingThreads();
+        seekMode = this->m_mediaSource->seekMode();
     }
 
     this->m_mediaSource =
@@ -510,11 +793,15 @@ void MultiSrcElementPrivate::linksChanged(const AkPluginLinks &links)
     QObject::connect(this->m_mediaSource.data(),
                      &MediaSource::stateChanged,
                      self,
-                     &MultiSrcElement::stateChanged);
+                     [this] (AkElement::ElementState state) {
+                        this->sourceStateChanged(state);
+                     });
     QObject::connect(this->m_mediaSource.data(),
                      &MediaSource::oStream,
                      self,
-                     &MultiSrcElement::oStream,
+                     [this] (const AkPacket &packet) {
+                        this->sourcePacket(packet);
+                     },
                      Qt::DirectConnection);
     QObject::connect(this->m_mediaSource.data(),
                      &MediaSource::error,
@@ -532,10 +819,20 @@ void MultiSrcElementPrivate::linksChanged(const AkPluginLinks &links)
                      &MediaSource::maxPacketQueueSizeChanged,
                      self,
                      &MultiSrcElement::maxPacketQueueSizeChanged);
+    QObject::connect(this->m_mediaSource.data(),
+                     &MediaSource::decodingThreadsChanged,
+                     self,
+                     &MultiSrcElement::decodingThreadsChanged);
     QObject::connect(this->m_mediaSource.data(),
                      &MediaSource::showLogChanged,
                      self,
                      &MultiSrcElement::showLogChanged);
+    QObject::connect(this->m_mediaSource.data(),
+                     &MediaSource::seekModeChanged,
+                     self,
+                     [self] (MediaSource::SeekMode seekMode) {
+                        emit self->seekModeChanged(MultiSrcElement::SeekMode(seekMode));
+                     });
     QObject::connect(this->m_mediaSource.data(),
                      &MediaSource::loopChanged,
                      self,
@@ -564,11 +861,294 @@ void MultiSrcElementPrivate::linksChanged(const AkPluginLinks &links)
     this->m_mediaSource->setMedia(media);
     this->m_mediaSource->setLoop(loop);
     this->m_mediaSource->setShowLog(showLog);
+    this->m_mediaSource->setDecodingThreads(decodingThreads);
+    this->m_mediaSource->setSeekMode(seekMode);
 
     emit self->streamsChanged(self->streams());
     emit self->maxPacketQueueSizeChanged(self->maxPacketQueueSize());
+    emit self->decodingThreadsChanged(self->decodingThreads());
+    emit self->seekModeChanged(self->seekMode());
 
     self->setState(state);
 }
 
+void MultiSrcElementPrivate::sourceStateChanged(AkElement::ElementState state)
+{
+    // The source is stopped when the clip is replayed from the cache.
+    if (this->m_replayState != AkElement::ElementStateNull || this->m_cacheReady)
+        return;
+
+    emit self->stateChanged(state);
+}
+
+void MultiSrcElementPrivate::sourcePacket(const AkPacket &packet)
+{
+    AkPacket oPacket = packet;
+
+    if (packet.type() == AkPacket::PacketVideo
+        && this->m_videoConverter.outputCaps()) {
+        this->m_videoConverter.begin();
+        oPacket = this->m_videoConverter.convert(packet);
+        this->m_videoConverter.end();
+
+        if (!oPacket)
+            return;
+    }
+
+    if (!this->cachePacket(oPacket))
+        return;
+
+    emit self->oStream(oPacket);
+}
+
+bool MultiSrcElementPrivate::cachePacket(const AkPacket &packet)
+{
+    this->m_cacheMutex.lock();
+
+    // The whole clip is in the cache already, drop the packets of the source.
+    if (this->m_cacheReady) {
+        this->m_cacheMutex.unlock();
+
+        return false;
+    }
+
+    if (!this->m_caching && !this->m_waitLoop) {
+        this->m_cacheMutex.unlock();
+
+        return true;
+    }
+
+    int index = 0;
+    qint64 pts = 0;
+    qint64 duration = 0;
+    qreal timeBase = 0.0;
+    size_t size = 0;
+
+    switch (packet.type()) {
+    case AkPacket::PacketVideo: {
+        AkVideoPacket videoPacket(packet);
+        index = videoPacket.index();
+        pts = videoPacket.pts();
+        duration = videoPacket.duration();
+        timeBase = videoPacket.timeBase().value();
+        size = videoPacket.size();
+
+        break;
+    }
+    case AkPacket::PacketAudio: {
+        AkAudioPacket audioPacket(packet);
+        index = audioPacket.index();
+        pts = audioPacket.pts();
+        duration = audioPacket.duration();
+        timeBase = audioPacket.timeBase().value();
+        size = audioPacket.size();
+
+        break;
+    }
+    default:
+        // Only audio and video are cached.
+        this->m_cacheMutex.unlock();
+
+        return true;
+    }
+
+    if (this->m_waitLoop && !this->m_lastPts.contains(index)) {
+        /* The playback didn't start from the beginning of the clip, wait for
+         * the source to wrap before caching the packets of this stream.
+         */
+        if (!this->m_sourcePts.contains(index)
+            || pts >= this->m_sourcePts[index]) {
+            this->m_sourcePts[index] = pts;
+            this->m_cacheMutex.unlock();
+
+            return true;
+        }
+
+        this->m_sourcePts.remove(index);
+        this->m_waitLoop = !this->m_sourcePts.isEmpty();
+        this->m_caching = true;
+    }
+
+    if (this->m_lastPts.contains(index) && pts < this->m_lastPts[index]) {
+        /* The source started the clip again, so all the frames are in the
+         * cache. Stop the source and play the clip from the cache.
+         */
+        this->m_caching = false;
+        this->m_waitLoop = false;
+
+        if (!this->m_loopCache.isEmpty()) {
+            this->m_cacheReady = true;
+            this->m_cacheMutex.unlock();
+            QMetaObject::invokeMethod(self,
+                                      [this] () {
+                                          this->startReplay();
+                                      },
+                                      Qt::QueuedConnection);
+
+            return false;
+        }
+
+        this->m_cacheMutex.unlock();
+
+        return true;
+    }
+
+    this->m_lastPts[index] = pts;
+    AkPacket cachedPacket;
+
+    if (this->m_loopCacheSize + qint64(size) <= this->m_maxLoopCacheSize) {
+        if (packet.type() == AkPacket::PacketVideo)
+            cachedPacket = AkVideoPacket(packet).toExternal();
+        else
+            cachedPacket = packet;
+    }
+
+    if (!cachedPacket) {
+        // The clip is too big, keep streaming it from the source.
+        this->m_caching = false;
+        this->m_waitLoop = false;
+        this->m_loopCache.clear();
+        this->m_loopCacheSize = 0;
+    } else {
+        this->m_loopCache << CachedPacket {cachedPacket,
+                                           timeBase * qreal(pts),
+                                           timeBase * qreal(pts + duration)};
+        this->m_loopCacheSize += qint64(size);
+    }
+
+    this->m_cacheMutex.unlock();
+
+    return true;
+}
+
+void MultiSrcElementPrivate::resetLoopCache(bool caching, bool waitLoop)
+{
+    this->m_cacheMutex.lock();
+    this->m_loopCache.clear();
+    this->m_lastPts.clear();
+    this->m_sourcePts.clear();
+    this->m_loopCacheSize = 0;
+    this->m_caching = caching;
+    this->m_waitLoop = waitLoop;
+    this->m_cacheReady = false;
+    this->m_replayPosition = 0.0;
+    this->m_cacheMutex.unlock();
+}
+
+bool MultiSrcElementPrivate::loopCacheEnabled()
+{
+    this->m_mutex.lockForRead();
+    bool enabled = this->m_mediaSource
+                   && this->m_mediaSource->loop()
+                   && this->m_maxLoopCacheSize > 0;
+    this->m_mutex.unlock();
+
+    return enabled;
+}
+
+void MultiSrcElementPrivate::startReplay()
+{
+    this->m_cacheMutex.lock();
+    bool cacheReady = this->m_cacheReady;
+    this->m_cacheMutex.unlock();
+
+    if (!cacheReady || this->m_replay)
+        return;
+
+    // Decoding the clip again is not needed anymore.
+    this->m_mutex.lockForRead();
+
+    if (this->m_mediaSource)
+        this->m_mediaSource->setState(AkElement::ElementStateNull);
+
+    this->m_mutex.unlock();
+
+    auto emitState =
+            this->m_replayState.exchange(AkElement::ElementStatePlaying)
+            != AkElement::ElementStatePlaying;
+    this->m_replay = true;
+    this->m_replayLoopResult =
+            QtConcurrent::run(&this->m_threadPool,
+                              &MultiSrcElementPrivate::replayLoop,
+                              this);
+
+    if (emitState)
+        emit self->stateChanged(AkElement::ElementStatePlaying);
+}
+
+void MultiSrcElementPrivate::stopReplay()
+{
+    this->m_replay = false;
+    this->m_replayLoopResult.waitForFinished();
+}
+
+void MultiSrcElementPrivate::replayLoop()
+{
+    this->m_cacheMutex.lock();
+    auto cache = this->m_loopCache;
+    auto position = this->m_replayPosition;
+    this->m_cacheMutex.unlock();
+
+    if (cache.isEmpty())
+        return;
+
+    // Audio and video were cached from different threads, sort them by time.
+    std::stable_sort(cache.begin(),
+                     cache.end(),
+                     [] (const CachedPacket &packet1,
+                         const CachedPacket &packet2) {
+        return packet1.time < packet2.time;
+    });
+
+    auto startTime = cache.first().time;
+    auto endTime = startTime;
+
+    for (auto &packet: cache)
+        endTime = qMax(endTime, qMax(packet.time, packet.endTime));
+
+    auto duration = qMax(endTime - startTime, 1e-3);
+    QElapsedTimer timer;
+    timer.start();
+
+    // Continue from the point where the replay was paused.
+    for (auto loop = qint64(position / duration); this->m_replay; loop++) {
+        auto offset = qreal(loop) * duration;
+
+        for (auto &cachedPacket: cache) {
+            auto time = cachedPacket.time - startTime + offset;
+
+            if (time < position)
+                continue;
+
+            // Wait until it's time to send the packet.
+            forever {
+                auto wait = time - position - 1e-9 * qreal(timer.nsecsElapsed());
+
+                if (!this->m_replay || wait <= 0.0)
+                    break;
+
+                QThread::usleep(ulong(1e6 * qMin(wait, 0.1)));
+            }
+
+            if (!this->m_replay)
+                break;
+
+            // Regenerate the timestamps of the packet.
+            AkPacket packet;
+
+            if (cachedPacket.packet.type() == AkPacket::PacketVideo)
+                packet = shiftPacket<AkVideoPacket>(cachedPacket.packet, offset);
+            else
+                packet = shiftPacket<AkAudioPacket>(cachedPacket.packet, offset);
+
+            this->m_loopCacheHits++;
+            emit self->oStream(packet);
+        }
+    }
+
+    this->m_cacheMutex.lock();
+    this->m_replayPosition = position + 1e-9 * qreal(timer.nsecsElapsed());
+    this->m_cacheMutex.unlock();
+}
+
 #include "moc_multisrcelement.cpp"
@@ -20,7 +20,10 @@
 #ifndef MULTISRCELEMENT_H
 #define MULTISRCELEMENT_H
 
+#include <QSize>
 #include <akcaps.h>
+#include <akvideocaps.h>
+#include <akvideopacket.h>
 #include <iak/akmultimediasourceelement.h>
 
 class MultiSrcElementPrivate;
@@ -62,11 +65,31 @@ class MultiSrcElement: public AkMultimediaSourceElement
                WRITE setMaxPacketQueueSize
                RESET resetMaxPacketQueueSize
                NOTIFY maxPacketQueueSizeChanged)
+    Q_PROPERTY(int decodingThreads
+               READ decodingThreads
+               WRITE setDecodingThreads
+               RESET resetDecodingThreads
+               NOTIFY decodingThreadsChanged)
     Q_PROPERTY(bool showLog
                READ showLog
                WRITE setShowLog
                RESET resetShowLog
                NOTIFY showLogChanged)
+    Q_PROPERTY(MultiSrcElement::SeekMode seekMode
+               READ seekMode
+               WRITE setSeekMode
+               RESET resetSeekMode
+               NOTIFY seekModeChanged)
+    Q_PROPERTY(qint64 maxLoopCacheSize
+               READ maxLoopCacheSize
+               WRITE setMaxLoopCacheSize
+               RESET resetMaxLoopCacheSize
+               NOTIFY maxLoopCacheSizeChanged)
+    Q_PROPERTY(AkVideoCaps outputCaps
+               READ outputCaps
+               WRITE setOutputCaps
+               RESET resetOutputCaps
+               NOTIFY outputCapsChanged)
 
     public:
         enum SeekPosition {
@@ -76,6 +99,13 @@ class MultiSrcElement: public AkMultimediaSourceElement
         };
         Q_ENUM(SeekPosition)
 
+        enum SeekMode {
+            SeekModeAccurate,
+            SeekModeKeyFrame,
+            SeekModeNearestKeyFrame,
+        };
+        Q_ENUM(SeekMode)
+
         MultiSrcElement();
         ~MultiSrcElement();
 
@@ -92,7 +122,14 @@ class MultiSrcElement: public AkMultimediaSourceElement
         Q_INVOKABLE qint64 durationMSecs();
         Q_INVOKABLE qint64 currentTimeMSecs();
         Q_INVOKABLE qint64 maxPacketQueueSize() const;
+        Q_INVOKABLE int decodingThreads() const;
         Q_INVOKABLE bool showLog() const;
+        Q_INVOKABLE MultiSrcElement::SeekMode seekMode() const;
+        Q_INVOKABLE AkVideoPacket thumbnail(qint64 mSecs, const QSize &maxSize);
+        Q_INVOKABLE qint64 maxLoopCacheSize() const;
+        Q_INVOKABLE AkVideoCaps outputCaps() const;
+        Q_INVOKABLE qint64 loopCacheSize() const;
+        Q_INVOKABLE quint64 loopCacheHits() const;
         Q_INVOKABLE AkElement::ElementState state() const override;
 
     private:
@@ -114,7 +151,11 @@ class MultiSrcElement: public AkMultimediaSourceElement
         void durationMSecsChanged(qint64 durationMSecs);
         void currentTimeMSecsChanged(qint64 currentTimeMSecs);
         void maxPacketQueueSizeChanged(qint64 maxPacketQueue);
+        void decodingThreadsChanged(int decodingThreads);
         void showLogChanged(bool showLog);
+        void seekModeChanged(MultiSrcElement::SeekMode seekMode);
+        void maxLoopCacheSizeChanged(qint64 maxLoopCacheSize);
+        void outputCapsChanged(const AkVideoCaps &outputCaps);
 
     public slots:
         void seek(qint64 seekTo, MultiSrcElement::SeekPosition position=SeekSet);
@@ -123,16 +164,25 @@ class MultiSrcElement: public AkMultimediaSourceElement
         void setLoop(bool loop) override;
         void setSync(bool sync);
         void setMaxPacketQueueSize(qint64 maxPacketQueueSize);
+        void setDecodingThreads(int decodingThreads);
         void setShowLog(bool showLog);
+        void setSeekMode(MultiSrcElement::SeekMode seekMode);
+        void setMaxLoopCacheSize(qint64 maxLoopCacheSize);
+        void setOutputCaps(const AkVideoCaps &outputCaps);
         void resetMedia() override;
         void resetStreams() override;
         void resetLoop() override;
         void resetSync();
         void resetMaxPacketQueueSize();
+        void resetDecodingThreads();
         void resetShowLog();
+        void resetSeekMode();
+        void resetMaxLoopCacheSize();
+        void resetOutputCaps();
         bool setState(AkElement::ElementState state) override;
 };
 
 Q_DECLARE_METATYPE(MultiSrcElement::SeekPosition)
+Q_DECLARE_METATYPE(MultiSrcElement::SeekMode)
 
 #endif // MULTISRCELEMENT_H
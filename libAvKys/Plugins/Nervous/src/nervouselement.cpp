@@ -20,7 +20,7 @@
 #include <QQmlContext>
 #include <QRandomGenerator>
 #include <QSize>
-#include <QVector>
+#include <akframering.h>
 #include <akpacket.h>
 #include <akvideopacket.h>
 
@@ -29,7 +29,7 @@
 class NervousElementPrivate
 {
     public:
-        QVector<AkVideoPacket> m_frames;
+        AkFrameRing m_frames {32};
         QSize m_frameSize;
         int m_nFrames {32};
         int m_stride {0};
@@ -85,11 +85,8 @@ AkPacket NervousElement::iVideoStream(const AkVideoPacket &packet)
         this->d->m_frameSize = frameSize;
     }
 
-    this->d->m_frames << packet;
-    int diff = this->d->m_frames.size() - this->d->m_nFrames;
-
-    for (int i = 0; i < diff && !this->d->m_frames.isEmpty(); i++)
-        this->d->m_frames.removeFirst();
+    this->d->m_frames.setCapacity(this->d->m_nFrames);
+    this->d->m_frames.push(packet);
 
     if (this->d->m_frames.isEmpty()) {
         emit this->oStream(packet);
@@ -119,7 +116,7 @@ AkPacket NervousElement::iVideoStream(const AkVideoPacket &packet)
         nFrame = QRandomGenerator::global()->bounded(this->d->m_frames.size());
     }
 
-    auto dst = this->d->m_frames[nFrame];
+    auto dst = this->d->m_frames.at(nFrame);
     dst.copyMetadata(packet);
 
     if (dst)
@@ -22,6 +22,7 @@
 #include <QSize>
 #include <QtMath>
 #include <akfrac.h>
+#include <akframering.h>
 #include <akpacket.h>
 #include <akpluginmanager.h>
 #include <akvideocaps.h>
@@ -35,7 +36,7 @@ class RadioactiveElementPrivate
 {
     public:
         QSize m_frameSize;
-        AkVideoPacket m_prevFrame;
+        AkFrameRing m_prevFrame {1};
         AkVideoPacket m_blurZoomBuffer;
         AkElementPtr m_blurFilter {akPluginManager->create<AkElement>("VideoFilter/Blur")};
         AkElementPtr m_zoomFilter {akPluginManager->create<AkElement>("VideoFilter/Zoom")};
@@ -143,16 +144,16 @@ AkPacket RadioactiveElement::iVideoStream(const AkVideoPacket &packet)
 
     if (frameSize != this->d->m_frameSize) {
         this->d->m_blurZoomBuffer = AkVideoPacket();
-        this->d->m_prevFrame = AkVideoPacket();
+        this->d->m_prevFrame.clear();
         this->d->m_frameSize = frameSize;
     }
 
-    if (!this->d->m_prevFrame) {
+    if (this->d->m_prevFrame.isEmpty()) {
         this->d->m_blurZoomBuffer = AkVideoPacket(src.caps(), true);
     } else {
         // Compute the difference between previous and current frame,
         // and save it to the buffer.
-        auto diff = this->d->imageDiff(this->d->m_prevFrame,
+        auto diff = this->d->imageDiff(this->d->m_prevFrame.last(),
                                        src,
                                        this->d->m_threshold,
                                        this->d->m_lumaThreshold,
@@ -180,7 +181,7 @@ AkPacket RadioactiveElement::iVideoStream(const AkVideoPacket &packet)
         this->d->m_videoMixer.end();
     }
 
-    this->d->m_prevFrame = src;
+    this->d->m_prevFrame.push(src);
 
     if (dst)
         emit this->oStream(dst);
@@ -266,6 +266,73 @@ class ConvertParameters
         }
 };
 
+class ConvolveParameters
+{
+    public:
+        SimdType simd;
+
+        ConvolveParameters()
+        {
+
+        }
+};
+
+class BlurParameters
+{
+    public:
+        SimdType simd;
+
+        BlurParameters()
+        {
+
+        }
+};
+
+class GlyphParameters
+{
+    public:
+        SimdType simd;
+
+        GlyphParameters()
+        {
+
+        }
+
+        // Rounded division by 255 of a value in the [0, 255 * 255] range.
+        inline VectorType div255(VectorType v) const
+        {
+            auto &s = this->simd;
+
+            return s.shr(s.add(s.mul(v, NativeType(257)), s.load(NativeType(32896))), 16);
+        }
+
+        inline VectorType blend(VectorType a, NativeType fg, NativeType bg) const
+        {
+            auto &s = this->simd;
+
+            return this->div255(s.add(s.mul(a, NativeType(fg - bg)),
+                                      s.load(NativeType(255 * bg))));
+        }
+};
+
+class EdgeParameters
+{
+    public:
+        SimdType simd;
+
+        EdgeParameters()
+        {
+
+        }
+
+        inline VectorType abs(VectorType v) const
+        {
+            auto &s = this->simd;
+
+            return s.max(v, s.sub(s.load(NativeType(0)), v));
+        }
+};
+
 class SimdCorePrivate
 {
     public:
@@ -547,6 +614,69 @@ class SimdCorePrivate
                                           const quint8 *src_line_a,
                                           quint8 *dst_line_x,
                                           int *x);
+
+        // Optimized convolution functions
+
+        static void *createConvolveParameters();
+        static void freeConvolveParameters(void *convolveParameters);
+        static void convolveLineH(void *convolveParameters,
+                                  const qint32 *kernel,
+                                  int kernelSize,
+                                  int width,
+                                  const qint32 *src_line,
+                                  qint32 *dst_line,
+                                  int *x);
+        static void convolveLineV(void *convolveParameters,
+                                  const qint32 *kernel,
+                                  int kernelSize,
+                                  int width,
+                                  const qint32 * const *src_lines,
+                                  qint32 *dst_line,
+                                  int *x);
+
+        // Optimized blur functions
+
+        static void *createBlurParameters();
+        static void freeBlurParameters(void *blurParameters);
+        static void blurSumLine(void *blurParameters,
+                                int width,
+                                const qint32 *add_line,
+                                const qint32 *sub_line,
+                                qint32 *sum_line,
+                                int *x);
+
+        // Optimized glyph functions
+
+        static void *createGlyphParameters();
+        static void freeGlyphParameters(void *glyphParameters);
+        static void drawGlyphLine3(void *glyphParameters,
+                                   int width,
+                                   const quint8 *alpha_line,
+                                   const qint32 *fg,
+                                   const qint32 *bg,
+                                   quint32 *dst_line,
+                                   int *x);
+        static void drawGlyphLine1(void *glyphParameters,
+                                   int width,
+                                   const quint8 *alpha_line,
+                                   qint32 fg,
+                                   qint32 bg,
+                                   quint8 *dst_line,
+                                   int *x);
+
+        // Optimized edge detection functions
+
+        static void *createEdgeParameters();
+        static void freeEdgeParameters(void *edgeParameters);
+        static void sobelLine(void *edgeParameters,
+                              int width,
+                              const quint8 *src_line_m1,
+                              const quint8 *src_line,
+                              const quint8 *src_line_p1,
+                              qint32 *grad_x,
+                              qint32 *grad_y,
+                              quint16 *gradient,
+                              int *x);
 };
 
 SimdCore::SimdCore(QObject *parent):
@@ -594,6 +724,32 @@ QFunctionPointer SimdCore::resolve(const char *functionName) const
     CHECK_FUNCTION(convertFast8bits1Ato3A)
     CHECK_FUNCTION(convertFast8bits1Ato1)
 
+    // Optimized convolution functions
+
+    CHECK_FUNCTION(createConvolveParameters)
+    CHECK_FUNCTION(freeConvolveParameters)
+    CHECK_FUNCTION(convolveLineH)
+    CHECK_FUNCTION(convolveLineV)
+
+    // Optimized blur functions
+
+    CHECK_FUNCTION(createBlurParameters)
+    CHECK_FUNCTION(freeBlurParameters)
+    CHECK_FUNCTION(blurSumLine)
+
+    // Optimized glyph functions
+
+    CHECK_FUNCTION(createGlyphParameters)
+    CHECK_FUNCTION(freeGlyphParameters)
+    CHECK_FUNCTION(drawGlyphLine3)
+    CHECK_FUNCTION(drawGlyphLine1)
+
+    // Optimized edge detection functions
+
+    CHECK_FUNCTION(createEdgeParameters)
+    CHECK_FUNCTION(freeEdgeParameters)
+    CHECK_FUNCTION(sobelLine)
+
     return nullptr;
 }
 
@@ -1773,4 +1929,304 @@ void SimdCorePrivate::convertFast8bits1Ato1(void *convertParameters,
     SimdType::end();
 }
 
+void *SimdCorePrivate::createConvolveParameters()
+{
+    return new ConvolveParameters;
+}
+
+void SimdCorePrivate::freeConvolveParameters(void *convolveParameters)
+{
+    if (convolveParameters)
+        delete reinterpret_cast<ConvolveParameters *>(convolveParameters);
+}
+
+void SimdCorePrivate::convolveLineH(void *convolveParameters,
+                                    const qint32 *kernel,
+                                    int kernelSize,
+                                    int width,
+                                    const qint32 *src_line,
+                                    qint32 *dst_line,
+                                    int *x)
+{
+    auto params = reinterpret_cast<ConvolveParameters *>(convolveParameters);
+    auto &s = params->simd;
+    auto vlen = int(s.size());
+    int xStart = *x;
+
+    for (int xLocal = xStart; xLocal <= width - vlen; xLocal += vlen) {
+        alignas(SIMD_ALIGN) NativeType src_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType dst_data[SIMD_DEFAULT_SIZE];
+
+        for (int i = 0; i < vlen; ++i)
+            dst_data[i] = static_cast<NativeType>(dst_line[xLocal + i]);
+
+        auto acc = s.load(dst_data);
+
+        for (int k = 0; k < kernelSize; ++k) {
+            if (!kernel[k])
+                continue;
+
+            auto src = src_line + xLocal + k;
+
+            for (int i = 0; i < vlen; ++i)
+                src_data[i] = static_cast<NativeType>(src[i]);
+
+            acc = s.add(acc, s.mul(s.load(src_data),
+                                   static_cast<NativeType>(kernel[k])));
+        }
+
+        s.store(dst_data, acc);
+
+        for (int i = 0; i < vlen; ++i)
+            dst_line[xLocal + i] = static_cast<qint32>(dst_data[i]);
+    }
+
+    *x = xStart + ((width - xStart) / vlen) * vlen;
+    SimdType::end();
+}
+
+void SimdCorePrivate::convolveLineV(void *convolveParameters,
+                                    const qint32 *kernel,
+                                    int kernelSize,
+                                    int width,
+                                    const qint32 * const *src_lines,
+                                    qint32 *dst_line,
+                                    int *x)
+{
+    auto params = reinterpret_cast<ConvolveParameters *>(convolveParameters);
+    auto &s = params->simd;
+    auto vlen = int(s.size());
+    int xStart = *x;
+
+    for (int xLocal = xStart; xLocal <= width - vlen; xLocal += vlen) {
+        alignas(SIMD_ALIGN) NativeType src_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType dst_data[SIMD_DEFAULT_SIZE];
+
+        auto acc = s.load(NativeType(0));
+
+        for (int k = 0; k < kernelSize; ++k) {
+            if (!kernel[k])
+                continue;
+
+            auto src = src_lines[k] + xLocal;
+
+            for (int i = 0; i < vlen; ++i)
+                src_data[i] = static_cast<NativeType>(src[i]);
+
+            acc = s.add(acc, s.mul(s.load(src_data),
+                                   static_cast<NativeType>(kernel[k])));
+        }
+
+        s.store(dst_data, acc);
+
+        for (int i = 0; i < vlen; ++i)
+            dst_line[xLocal + i] = static_cast<qint32>(dst_data[i]);
+    }
+
+    *x = xStart + ((width - xStart) / vlen) * vlen;
+    SimdType::end();
+}
+
+void *SimdCorePrivate::createBlurParameters()
+{
+    return new BlurParameters;
+}
+
+void SimdCorePrivate::freeBlurParameters(void *blurParameters)
+{
+    if (blurParameters)
+        delete reinterpret_cast<BlurParameters *>(blurParameters);
+}
+
+void SimdCorePrivate::blurSumLine(void *blurParameters,
+                                  int width,
+                                  const qint32 *add_line,
+                                  const qint32 *sub_line,
+                                  qint32 *sum_line,
+                                  int *x)
+{
+    auto params = reinterpret_cast<BlurParameters *>(blurParameters);
+    auto &s = params->simd;
+    auto vlen = int(s.size());
+    int xStart = *x;
+
+    for (int xLocal = xStart; xLocal <= width - vlen; xLocal += vlen) {
+        alignas(SIMD_ALIGN) NativeType add_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType sub_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType sum_data[SIMD_DEFAULT_SIZE];
+
+        for (int i = 0; i < vlen; ++i) {
+            add_data[i] = static_cast<NativeType>(add_line[xLocal + i]);
+            sub_data[i] = static_cast<NativeType>(sub_line[xLocal + i]);
+            sum_data[i] = static_cast<NativeType>(sum_line[xLocal + i]);
+        }
+
+        auto sum = s.add(s.load(sum_data),
+                         s.sub(s.load(add_data), s.load(sub_data)));
+        s.store(sum_data, sum);
+
+        for (int i = 0; i < vlen; ++i)
+            sum_line[xLocal + i] = static_cast<qint32>(sum_data[i]);
+    }
+
+    *x = xStart + ((width - xStart) / vlen) * vlen;
+    SimdType::end();
+}
+
+void *SimdCorePrivate::createGlyphParameters()
+{
+    return new GlyphParameters;
+}
+
+void SimdCorePrivate::freeGlyphParameters(void *glyphParameters)
+{
+    if (glyphParameters)
+        delete reinterpret_cast<GlyphParameters *>(glyphParameters);
+}
+
+void SimdCorePrivate::drawGlyphLine3(void *glyphParameters,
+                                     int width,
+                                     const quint8 *alpha_line,
+                                     const qint32 *fg,
+                                     const qint32 *bg,
+                                     quint32 *dst_line,
+                                     int *x)
+{
+    auto params = reinterpret_cast<GlyphParameters *>(glyphParameters);
+    auto &s = params->simd;
+    auto vlen = int(s.size());
+    int xStart = *x;
+
+    for (int xLocal = xStart; xLocal <= width - vlen; xLocal += vlen) {
+        alignas(SIMD_ALIGN) NativeType a_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType r_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType g_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType b_data[SIMD_DEFAULT_SIZE];
+
+        for (int i = 0; i < vlen; ++i)
+            a_data[i] = static_cast<NativeType>(alpha_line[xLocal + i]);
+
+        auto a = s.load(a_data);
+        s.store(r_data, params->blend(a, fg[0], bg[0]));
+        s.store(g_data, params->blend(a, fg[1], bg[1]));
+        s.store(b_data, params->blend(a, fg[2], bg[2]));
+
+        for (int i = 0; i < vlen; ++i)
+            dst_line[xLocal + i] = 0xff000000
+                                 | (quint32(r_data[i]) << 16)
+                                 | (quint32(g_data[i]) << 8)
+                                 | quint32(b_data[i]);
+    }
+
+    *x = xStart + ((width - xStart) / vlen) * vlen;
+    SimdType::end();
+}
+
+void SimdCorePrivate::drawGlyphLine1(void *glyphParameters,
+                                     int width,
+                                     const quint8 *alpha_line,
+                                     qint32 fg,
+                                     qint32 bg,
+                                     quint8 *dst_line,
+                                     int *x)
+{
+    auto params = reinterpret_cast<GlyphParameters *>(glyphParameters);
+    auto &s = params->simd;
+    auto vlen = int(s.size());
+    int xStart = *x;
+
+    for (int xLocal = xStart; xLocal <= width - vlen; xLocal += vlen) {
+        alignas(SIMD_ALIGN) NativeType a_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType y_data[SIMD_DEFAULT_SIZE];
+
+        for (int i = 0; i < vlen; ++i)
+            a_data[i] = static_cast<NativeType>(alpha_line[xLocal + i]);
+
+        s.store(y_data, params->blend(s.load(a_data), fg, bg));
+
+        for (int i = 0; i < vlen; ++i)
+            dst_line[xLocal + i] = static_cast<quint8>(y_data[i]);
+    }
+
+    *x = xStart + ((width - xStart) / vlen) * vlen;
+    SimdType::end();
+}
+
+void *SimdCorePrivate::createEdgeParameters()
+{
+    return new EdgeParameters;
+}
+
+void SimdCorePrivate::freeEdgeParameters(void *edgeParameters)
+{
+    if (edgeParameters)
+        delete reinterpret_cast<EdgeParameters *>(edgeParameters);
+}
+
+void SimdCorePrivate::sobelLine(void *edgeParameters,
+                                int width,
+                                const quint8 *src_line_m1,
+                                const quint8 *src_line,
+                                const quint8 *src_line_p1,
+                                qint32 *grad_x,
+                                qint32 *grad_y,
+                                quint16 *gradient,
+                                int *x)
+{
+    auto params = reinterpret_cast<EdgeParameters *>(edgeParameters);
+    auto &s = params->simd;
+    auto vlen = int(s.size());
+    int xStart = *x;
+
+    /* The source lines are padded with one pixel at both sides, so the pixel
+     * at x is in src_line[x + 1].
+     */
+    for (int xLocal = xStart; xLocal <= width - vlen; xLocal += vlen) {
+        alignas(SIMD_ALIGN) NativeType tl_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType tc_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType tr_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType ml_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType mr_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType bl_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType bc_data[SIMD_DEFAULT_SIZE];
+        alignas(SIMD_ALIGN) NativeType br_data[SIMD_DEFAULT_SIZE];
+
+        for (int i = 0; i < vlen; ++i) {
+            int xi = xLocal + i;
+            tl_data[i] = static_cast<NativeType>(src_line_m1[xi]);
+            tc_data[i] = static_cast<NativeType>(src_line_m1[xi + 1]);
+            tr_data[i] = static_cast<NativeType>(src_line_m1[xi + 2]);
+            ml_data[i] = static_cast<NativeType>(src_line[xi]);
+            mr_data[i] = static_cast<NativeType>(src_line[xi + 2]);
+            bl_data[i] = static_cast<NativeType>(src_line_p1[xi]);
+            bc_data[i] = static_cast<NativeType>(src_line_p1[xi + 1]);
+            br_data[i] = static_cast<NativeType>(src_line_p1[xi + 2]);
+        }
+
+        auto tl = s.load(tl_data);
+        auto tr = s.load(tr_data);
+        auto bl = s.load(bl_data);
+        auto br = s.load(br_data);
+
+        auto gx = s.sub(s.add(s.add(tr, br), s.mul(s.load(mr_data), NativeType(2))),
+                        s.add(s.add(tl, bl), s.mul(s.load(ml_data), NativeType(2))));
+        auto gy = s.sub(s.add(s.add(tl, tr), s.mul(s.load(tc_data), NativeType(2))),
+                        s.add(s.add(bl, br), s.mul(s.load(bc_data), NativeType(2))));
+        auto g = s.add(params->abs(gx), params->abs(gy));
+
+        s.store(tl_data, gx);
+        s.store(tr_data, gy);
+        s.store(bl_data, g);
+
+        for (int i = 0; i < vlen; ++i) {
+            grad_x[xLocal + i] = static_cast<qint32>(tl_data[i]);
+            grad_y[xLocal + i] = static_cast<qint32>(tr_data[i]);
+            gradient[xLocal + i] = static_cast<quint16>(bl_data[i]);
+        }
+    }
+
+    *x = xStart + ((width - xStart) / vlen) * vlen;
+    SimdType::end();
+}
+
 #include "moc_simdcore.cpp"
@@ -82,6 +82,21 @@ int Capture::nBuffers() const
     return 0;
 }
 
+bool Capture::latestFrameOnly() const
+{
+    return false;
+}
+
+qreal Capture::latency() const
+{
+    return 0.0;
+}
+
+quint64 Capture::droppedFrames() const
+{
+    return 0;
+}
+
 QString Capture::description(const QString &webcam) const
 {
     Q_UNUSED(webcam)
@@ -211,6 +226,11 @@ void Capture::setNBuffers(int nBuffers)
     Q_UNUSED(nBuffers)
 }
 
+void Capture::setLatestFrameOnly(bool latestFrameOnly)
+{
+    Q_UNUSED(latestFrameOnly)
+}
+
 void Capture::setTorchMode(TorchMode mode)
 {
     Q_UNUSED(mode)
@@ -232,6 +252,10 @@ void Capture::resetNBuffers()
 {
 }
 
+void Capture::resetLatestFrameOnly()
+{
+}
+
 void Capture::resetTorchMode()
 {
 
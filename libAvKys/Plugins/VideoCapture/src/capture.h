@@ -57,6 +57,17 @@ class Capture: public QObject
                WRITE setNBuffers
                RESET resetNBuffers
                NOTIFY nBuffersChanged)
+    Q_PROPERTY(bool latestFrameOnly
+               READ latestFrameOnly
+               WRITE setLatestFrameOnly
+               RESET resetLatestFrameOnly
+               NOTIFY latestFrameOnlyChanged)
+    Q_PROPERTY(qreal latency
+               READ latency
+               NOTIFY latencyChanged)
+    Q_PROPERTY(quint64 droppedFrames
+               READ droppedFrames
+               NOTIFY droppedFramesChanged)
     Q_PROPERTY(bool isTorchSupported
                READ isTorchSupported
                NOTIFY isTorchSupportedChanged)
@@ -93,6 +104,9 @@ class Capture: public QObject
         Q_INVOKABLE virtual QList<int> listTracks(AkCaps::CapsType type);
         Q_INVOKABLE virtual QString ioMethod() const;
         Q_INVOKABLE virtual int nBuffers() const;
+        Q_INVOKABLE virtual bool latestFrameOnly() const;
+        Q_INVOKABLE virtual qreal latency() const;
+        Q_INVOKABLE virtual quint64 droppedFrames() const;
         Q_INVOKABLE virtual QString description(const QString &webcam) const;
         Q_INVOKABLE virtual AkCapsList caps(const QString &webcam) const;
         Q_INVOKABLE virtual QVariantList imageControls() const;
@@ -119,6 +133,9 @@ class Capture: public QObject
         void streamsChanged(const QList<int> &streams);
         void ioMethodChanged(const QString &ioMethod);
         void nBuffersChanged(int nBuffers);
+        void latestFrameOnlyChanged(bool latestFrameOnly);
+        void latencyChanged(qreal latency);
+        void droppedFramesChanged(quint64 droppedFrames);
         void imageControlsChanged(const QVariantMap &imageControls);
         void cameraControlsChanged(const QVariantMap &cameraControls);
         void pictureTaken(int index, const AkPacket &picture);
@@ -133,11 +150,13 @@ class Capture: public QObject
         virtual void setStreams(const QList<int> &streams);
         virtual void setIoMethod(const QString &ioMethod);
         virtual void setNBuffers(int nBuffers);
+        virtual void setLatestFrameOnly(bool latestFrameOnly);
         virtual void setTorchMode(TorchMode mode);
         virtual void resetDevice();
         virtual void resetStreams();
         virtual void resetIoMethod();
         virtual void resetNBuffers();
+        virtual void resetLatestFrameOnly();
         virtual void resetTorchMode();
         virtual void reset();
         virtual void takePictures(int count, int delayMsecs=0);
@@ -21,7 +21,9 @@
 #include <QDir>
 #include <QFileSystemWatcher>
 #include <QMap>
+#include <QMutex>
 #include <QReadWriteLock>
+#include <QSharedPointer>
 #include <QSize>
 #include <QVariant>
 #include <QVector>
@@ -34,6 +36,8 @@
 #include <akvideopacket.h>
 #include <akcompressedvideocaps.h>
 #include <akcompressedvideopacket.h>
+#include <poll.h>
+#include <ctime>
 #include <linux/videodev2.h>
 
 #include "capturev4l2.h"
@@ -236,12 +240,62 @@ Q_GLOBAL_STATIC_WITH_ARGS(CompressedFormatToStrMap,
                           compressedFormatToStr,
                           (initCompressedFormatToStr()))
 
+// Keep at least this number of buffers queued when sharing buffers.
+#define MIN_QUEUED_BUFFERS 2
+
+// Limits of the number of buffers when it's choosen automatically.
+#define MIN_AUTO_BUFFERS 4
+#define MAX_AUTO_BUFFERS 32
+
+/* Frames held by the consumers at the same time until a capture measures the
+ * real usage, enough for decoding the frames in parallel without copying them.
+ */
+#define DEFAULT_BUFFERS_IN_FLIGHT 4
+
+// Maximum time waiting for a frame, in milliseconds.
+#define POLL_TIMEOUT 1000
+
+// Weight of the last frame in the average latency.
+#define LATENCY_SMOOTHING 0.1
+
 struct CaptureBuffer
 {
     char *start[VIDEO_MAX_PLANES];
     size_t length[VIDEO_MAX_PLANES];
 };
 
+/* The streaming buffers are shared with the packets that wraps them, so they
+ * are only unmapped, and the device closed, once all the packets are gone.
+ */
+class CaptureBufferPool
+{
+    public:
+        QMutex m_mutex;
+        QVector<CaptureBuffer> m_buffers;
+        CaptureV4L2::IoMethod m_ioMethod {CaptureV4L2::IoMethodUnknown};
+        int m_planesCount {0};
+        int m_fd {-1};
+        int m_inFlight {0};
+        int m_peakInFlight {0};
+        bool m_starved {false};
+        bool m_streaming {true};
+
+        CaptureBufferPool(const QVector<CaptureBuffer> &buffers,
+                          CaptureV4L2::IoMethod ioMethod,
+                          int planesCount,
+                          int fd);
+        ~CaptureBufferPool();
+};
+
+using CaptureBufferPoolPtr = QSharedPointer<CaptureBufferPool>;
+
+struct CaptureBufferRef
+{
+    CaptureBufferPoolPtr pool;
+    v4l2_buffer buffer;
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+};
+
 class DeviceV4L2Format
 {
     public:
@@ -283,10 +337,18 @@ class CaptureV4L2Private
         AkCaps m_caps;
         qint64 m_id {-1};
         QVector<CaptureBuffer> m_buffers;
+        CaptureBufferPoolPtr m_bufferPool;
         v4l2_format m_v4l2Format;
         CaptureV4L2::IoMethod m_ioMethod {CaptureV4L2::IoMethodUnknown};
-        int m_nBuffers {32};
+        QMutex m_statsMutex;
+        qreal m_latency {0.0};
+        quint64 m_droppedFrames {0};
+        qint64 m_lastSequence {-1};
+        int m_nBuffers {0};
+        int m_buffersUsage {DEFAULT_BUFFERS_IN_FLIGHT + 1};
+        int m_peakBacklog {0};
         int m_fd {-1};
+        bool m_latestFrameOnly {true};
 
 #ifdef HAVE_LIBUSB
         UvcExtendedControls m_extendedControls;
@@ -316,9 +378,21 @@ class CaptureV4L2Private
         bool startCapture(const v4l2_format &format);
         void stopCapture(const v4l2_format &format);
         QString fourccToStr(quint32 format) const;
+        int buffersCount() const;
+        bool waitForFrame() const;
+        bool dequeueBuffer(v4l2_buffer &buffer, v4l2_plane *planes) const;
+        static qint64 monotonicTime();
+        qint64 bufferTimestamp(const v4l2_buffer &buffer) const;
+        void updateSequence(const v4l2_buffer &buffer);
+        void updateLatency(qint64 timestamp);
+        void resetStats();
         AkPacket processFrame(const char * const *planeData,
                               const ssize_t *planeSize,
                               qint64 pts);
+        AkPacket wrapFrame(const v4l2_buffer &buffer,
+                           const ssize_t *planeSize,
+                           qint64 pts);
+        static void releaseBuffer(void *userData);
         QVariantList imageControls(int fd) const;
         bool setImageControls(int fd,
                               const QVariantMap &imageControls) const;
@@ -336,6 +410,33 @@ class CaptureV4L2Private
                                    __u32 &pixelformat) const;
 };
 
+CaptureBufferPool::CaptureBufferPool(const QVector<CaptureBuffer> &buffers,
+                                     CaptureV4L2::IoMethod ioMethod,
+                                     int planesCount,
+                                     int fd):
+    m_buffers(buffers),
+    m_ioMethod(ioMethod),
+    m_planesCount(planesCount),
+    m_fd(fd)
+{
+}
+
+CaptureBufferPool::~CaptureBufferPool()
+{
+    if (this->m_ioMethod == CaptureV4L2::IoMethodMemoryMap) {
+        for (auto &buffer: this->m_buffers)
+            for (int i = 0; i < this->m_planesCount; i++)
+                x_munmap(buffer.start[i], buffer.length[i]);
+    } else if (this->m_ioMethod == CaptureV4L2::IoMethodUserPointer) {
+        for (auto &buffer: this->m_buffers)
+            for (int i = 0; i < this->m_planesCount; i++)
+                delete [] buffer.start[i];
+    }
+
+    if (this->m_fd >= 0)
+        x_close(this->m_fd);
+}
+
 CaptureV4L2::CaptureV4L2(QObject *parent):
     Capture(parent)
 {
@@ -394,6 +495,29 @@ int CaptureV4L2::nBuffers() const
     return this->d->m_nBuffers;
 }
 
+bool CaptureV4L2::latestFrameOnly() const
+{
+    return this->d->m_latestFrameOnly;
+}
+
+qreal CaptureV4L2::latency() const
+{
+    this->d->m_statsMutex.lock();
+    auto latency = this->d->m_latency;
+    this->d->m_statsMutex.unlock();
+
+    return latency;
+}
+
+quint64 CaptureV4L2::droppedFrames() const
+{
+    this->d->m_statsMutex.lock();
+    auto droppedFrames = this->d->m_droppedFrames;
+    this->d->m_statsMutex.unlock();
+
+    return droppedFrames;
+}
+
 QString CaptureV4L2::description(const QString &webcam) const
 {
     return this->d->m_descriptions.value(webcam);
@@ -568,6 +692,9 @@ AkPacket CaptureV4L2::readFrame()
     ssize_t planeSize[planesCount];
     memset(planeSize, 0, planesCount * sizeof(ssize_t));
 
+    if (!this->d->waitForFrame())
+        return {};
+
     if (this->d->m_ioMethod == IoMethodReadWrite) {
         for (int i = 0; i < planesCount; i++) {
             planeSize[i] = x_read(this->d->m_fd,
@@ -578,31 +705,49 @@ AkPacket CaptureV4L2::readFrame()
                 return AkPacket();
         }
 
-        timeval timestamp {};
-        gettimeofday(&timestamp, nullptr);
-
-        auto pts = qint64((timestamp.tv_sec + 1e-6 * timestamp.tv_usec)
-                          * this->d->m_fps.value());
+        auto timestamp = CaptureV4L2Private::monotonicTime();
+        auto pts = qint64(1e-6 * timestamp * this->d->m_fps.value());
+        auto packet = this->d->processFrame(this->d->m_buffers[0].start,
+                                            planeSize,
+                                            pts);
+        this->d->updateLatency(timestamp);
 
-        return this->d->processFrame(this->d->m_buffers[0].start,
-                                     planeSize,
-                                     pts);
+        return packet;
     }
 
     if (this->d->m_ioMethod == IoMethodMemoryMap
         || this->d->m_ioMethod == IoMethodUserPointer) {
-        v4l2_buffer buffer;
-        memset(&buffer, 0, sizeof(v4l2_buffer));
-        buffer.type = this->d->m_v4l2Format.type;
-        buffer.memory = (this->d->m_ioMethod == IoMethodMemoryMap)?
-                            V4L2_MEMORY_MMAP:
-                            V4L2_MEMORY_USERPTR;
+        v4l2_plane planes[2][VIDEO_MAX_PLANES];
+        v4l2_buffer buffers[2];
+        int current = 0;
 
-        if (x_ioctl(this->d->m_fd, VIDIOC_DQBUF, &buffer) < 0)
+        if (!this->d->dequeueBuffer(buffers[current], planes[current]))
             return AkPacket();
 
-        if (buffer.index >= quint32(this->d->m_buffers.size()))
-            return AkPacket();
+        this->d->updateSequence(buffers[current]);
+        int backlog = 1;
+
+        /* Drain all the frames ready and keep the newest one, sending the
+         * older frames will only add latency.
+         */
+        if (this->d->m_latestFrameOnly) {
+            while (this->d->dequeueBuffer(buffers[1 - current],
+                                          planes[1 - current])) {
+                if (x_ioctl(this->d->m_fd, VIDIOC_QBUF, &buffers[current]) < 0) {
+                    // Return the newest buffer too, so it's not lost.
+                    x_ioctl(this->d->m_fd, VIDIOC_QBUF, &buffers[1 - current]);
+
+                    return AkPacket();
+                }
+
+                current = 1 - current;
+                this->d->updateSequence(buffers[current]);
+                backlog++;
+            }
+        }
+
+        this->d->m_peakBacklog = qMax(this->d->m_peakBacklog, backlog);
+        auto &buffer = buffers[current];
 
         if (this->d->m_v4l2Format.type == V4L2_BUF_TYPE_VIDEO_CAPTURE)
             planeSize[0] = buffer.bytesused;
@@ -610,17 +755,23 @@ AkPacket CaptureV4L2::readFrame()
             for (int i = 0; i < planesCount; i++)
                 planeSize[i] = buffer.m.planes[i].bytesused;
 
-        auto pts = qint64((buffer.timestamp.tv_sec
-                           + 1e-6 * buffer.timestamp.tv_usec)
-                          * this->d->m_fps.value());
+        auto timestamp = this->d->bufferTimestamp(buffer);
+        auto pts = qint64(1e-6 * timestamp * this->d->m_fps.value());
 
-        auto packet =
-                this->d->processFrame(this->d->m_buffers[int(buffer.index)].start,
-                                      planeSize,
-                                      pts);
+        // Try to send the buffer without copying it, else copy the frame.
+        auto packet = this->d->wrapFrame(buffer, planeSize, pts);
 
-        if (x_ioctl(this->d->m_fd, VIDIOC_QBUF, &buffer) < 0)
-            return AkPacket();
+        if (!packet) {
+            packet =
+                    this->d->processFrame(this->d->m_buffers[int(buffer.index)].start,
+                                          planeSize,
+                                          pts);
+
+            if (x_ioctl(this->d->m_fd, VIDIOC_QBUF, &buffer) < 0)
+                return AkPacket();
+        }
+
+        this->d->updateLatency(timestamp);
 
         return packet;
     }
@@ -633,10 +784,12 @@ bool CaptureV4L2::init()
     this->d->m_localImageControls.clear();
     this->d->m_localCameraControls.clear();
 
-    // Frames read must be blocking so we does not waste CPU time.
+    /* The frames are waited with poll(), so the reads never block and all
+     * the frames ready can be drained at once.
+     */
     this->d->m_fd =
             x_open(this->d->m_device.toStdString().c_str(),
-                   O_RDWR, // | O_NONBLOCK,
+                   O_RDWR | O_NONBLOCK,
                    0);
 
     if (this->d->m_fd < 0) {
@@ -717,6 +870,7 @@ bool CaptureV4L2::init()
     }
 
     memcpy(&this->d->m_v4l2Format, &fmt, sizeof(v4l2_format));
+    this->d->resetStats();
     this->d->m_fps = fps;
     this->d->setFps(this->d->m_fd, fmt.type, this->d->m_fps);
     this->d->m_caps = caps;
@@ -742,6 +896,13 @@ bool CaptureV4L2::init()
             return false;
         }
 
+        if (this->d->m_ioMethod != IoMethodReadWrite)
+            this->d->m_bufferPool =
+                    CaptureBufferPoolPtr::create(this->d->m_buffers,
+                                                 this->d->m_ioMethod,
+                                                 this->d->planesCount(fmt),
+                                                 this->d->m_fd);
+
         if (this->d->m_caps.type() == AkCaps::CapsVideo) {
             this->d->m_outPacket = {this->d->m_caps};
             this->d->m_outPacket.setTimeBase(this->d->m_timeBase);
@@ -773,6 +934,13 @@ bool CaptureV4L2::init()
         return false;
     }
 
+    if (this->d->m_ioMethod != IoMethodReadWrite)
+        this->d->m_bufferPool =
+                CaptureBufferPoolPtr::create(this->d->m_buffers,
+                                             this->d->m_ioMethod,
+                                             this->d->planesCount(fmt),
+                                             this->d->m_fd);
+
     if (this->d->m_caps.type() == AkCaps::CapsVideo) {
         this->d->m_outPacket = {this->d->m_caps};
         this->d->m_outPacket.setDuration(1);
@@ -786,10 +954,29 @@ bool CaptureV4L2::init()
 
 void CaptureV4L2::uninit()
 {
+    /* Stop requeuing the buffers released by the packets, and remember how
+     * many buffers were used, so the next capture allocates just enough.
+     */
+    if (this->d->m_bufferPool) {
+        auto &pool = this->d->m_bufferPool;
+        pool->m_mutex.lock();
+        pool->m_streaming = false;
+        int inFlight = pool->m_peakInFlight + (pool->m_starved? 1: 0);
+        pool->m_mutex.unlock();
+
+        this->d->m_buffersUsage = inFlight + this->d->m_peakBacklog;
+    }
+
     this->d->stopCapture(this->d->m_v4l2Format);
     int planesCount = this->d->planesCount(this->d->m_v4l2Format);
 
-    if (!this->d->m_buffers.isEmpty()) {
+    if (this->d->m_bufferPool) {
+        /* The pool frees the buffers and closes the device once the last
+         * packet using them is released.
+         */
+        this->d->m_bufferPool.clear();
+        this->d->m_fd = -1;
+    } else if (!this->d->m_buffers.isEmpty()) {
         if (this->d->m_ioMethod == IoMethodReadWrite) {
             for (auto &buffer: this->d->m_buffers)
                 for (int i = 0; i < planesCount; i++)
@@ -898,6 +1085,9 @@ void CaptureV4L2::setIoMethod(const QString &ioMethod)
 
 void CaptureV4L2::setNBuffers(int nBuffers)
 {
+    // 0 means choosing the number of buffers automatically.
+    nBuffers = qMax(nBuffers, 0);
+
     if (this->d->m_nBuffers == nBuffers)
         return;
 
@@ -905,6 +1095,15 @@ void CaptureV4L2::setNBuffers(int nBuffers)
     emit this->nBuffersChanged(nBuffers);
 }
 
+void CaptureV4L2::setLatestFrameOnly(bool latestFrameOnly)
+{
+    if (this->d->m_latestFrameOnly == latestFrameOnly)
+        return;
+
+    this->d->m_latestFrameOnly = latestFrameOnly;
+    emit this->latestFrameOnlyChanged(latestFrameOnly);
+}
+
 void CaptureV4L2::resetDevice()
 {
     this->setDevice("");
@@ -928,7 +1127,12 @@ void CaptureV4L2::resetIoMethod()
 
 void CaptureV4L2::resetNBuffers()
 {
-    this->setNBuffers(32);
+    this->setNBuffers(0);
+}
+
+void CaptureV4L2::resetLatestFrameOnly()
+{
+    this->setLatestFrameOnly(true);
 }
 
 void CaptureV4L2::reset()
@@ -1403,7 +1607,7 @@ bool CaptureV4L2Private::initMemoryMap(const v4l2_format &format)
     memset(&requestBuffers, 0, sizeof(v4l2_requestbuffers));
     requestBuffers.type = format.type;
     requestBuffers.memory = V4L2_MEMORY_MMAP;
-    requestBuffers.count = __u32(this->m_nBuffers);
+    requestBuffers.count = __u32(this->buffersCount());
 
     if (x_ioctl(this->m_fd, VIDIOC_REQBUFS, &requestBuffers) < 0)
         return false;
@@ -1498,7 +1702,7 @@ bool CaptureV4L2Private::initUserPointer(const v4l2_format &format)
     memset(&requestBuffers, 0, sizeof(v4l2_requestbuffers));
     requestBuffers.type = format.type;
     requestBuffers.memory = V4L2_MEMORY_USERPTR;
-    requestBuffers.count = __u32(this->m_nBuffers);
+    requestBuffers.count = __u32(this->buffersCount());
 
     if (x_ioctl(this->m_fd, VIDIOC_REQBUFS, &requestBuffers) < 0)
         return false;
@@ -1633,6 +1837,136 @@ QString CaptureV4L2Private::fourccToStr(quint32 format) const
     return QString(fourcc);
 }
 
+int CaptureV4L2Private::buffersCount() const
+{
+    if (this->m_nBuffers > 0)
+        return this->m_nBuffers;
+
+    /* Allocate the buffers hold by the consumers of the frames, plus the
+     * frames waiting to be read, plus the buffers being filled by the driver.
+     * The first capture uses DEFAULT_BUFFERS_IN_FLIGHT for the consumers.
+     */
+    return qBound(MIN_AUTO_BUFFERS,
+                  this->m_buffersUsage + MIN_QUEUED_BUFFERS,
+                  MAX_AUTO_BUFFERS);
+}
+
+bool CaptureV4L2Private::waitForFrame() const
+{
+    pollfd fds;
+    memset(&fds, 0, sizeof(pollfd));
+    fds.fd = this->m_fd;
+    fds.events = POLLIN;
+
+    if (poll(&fds, 1, POLL_TIMEOUT) < 1)
+        return false;
+
+    return fds.revents & POLLIN;
+}
+
+bool CaptureV4L2Private::dequeueBuffer(v4l2_buffer &buffer,
+                                       v4l2_plane *planes) const
+{
+    memset(planes, 0, VIDEO_MAX_PLANES * sizeof(v4l2_plane));
+    memset(&buffer, 0, sizeof(v4l2_buffer));
+    buffer.type = this->m_v4l2Format.type;
+    buffer.memory = (this->m_ioMethod == CaptureV4L2::IoMethodMemoryMap)?
+                        V4L2_MEMORY_MMAP:
+                        V4L2_MEMORY_USERPTR;
+
+    if (buffer.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+        buffer.length = this->planesCount(this->m_v4l2Format);
+        buffer.m.planes = planes;
+    }
+
+    // Returns EAGAIN when there are no more frames ready.
+    if (x_ioctl(this->m_fd, VIDIOC_DQBUF, &buffer) < 0)
+        return false;
+
+    return buffer.index < quint32(this->m_buffers.size());
+}
+
+qint64 CaptureV4L2Private::monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+qint64 CaptureV4L2Private::bufferTimestamp(const v4l2_buffer &buffer) const
+{
+    /* Use the time in which the driver captured the frame, if it's not in the
+     * monotonic clock, use the time in which the frame was read.
+     */
+#ifdef V4L2_BUF_FLAG_TIMESTAMP_MASK
+    if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK)
+        == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+        return qint64(buffer.timestamp.tv_sec) * 1000000
+               + buffer.timestamp.tv_usec;
+#else
+    Q_UNUSED(buffer)
+#endif
+
+    return CaptureV4L2Private::monotonicTime();
+}
+
+void CaptureV4L2Private::updateSequence(const v4l2_buffer &buffer)
+{
+    // A gap in the sequence numbers means the driver dropped frames.
+    quint64 dropped = 0;
+
+    if (this->m_lastSequence >= 0
+        && qint64(buffer.sequence) > this->m_lastSequence + 1)
+        dropped = quint64(qint64(buffer.sequence) - this->m_lastSequence - 1);
+
+    this->m_lastSequence = qint64(buffer.sequence);
+
+    if (dropped < 1)
+        return;
+
+    this->m_statsMutex.lock();
+    this->m_droppedFrames += dropped;
+    auto droppedFrames = this->m_droppedFrames;
+    this->m_statsMutex.unlock();
+
+    emit self->droppedFramesChanged(droppedFrames);
+}
+
+void CaptureV4L2Private::updateLatency(qint64 timestamp)
+{
+    auto latency = qMax(0.0, 1e-3 * (CaptureV4L2Private::monotonicTime()
+                                     - timestamp));
+
+    this->m_statsMutex.lock();
+    auto lastLatency = this->m_latency;
+
+    if (qFuzzyIsNull(lastLatency))
+        this->m_latency = latency;
+    else
+        this->m_latency += LATENCY_SMOOTHING * (latency - lastLatency);
+
+    latency = this->m_latency;
+    this->m_statsMutex.unlock();
+
+    // Notify only the changes bigger than one millisecond.
+    if (qRound(latency) != qRound(lastLatency))
+        emit self->latencyChanged(latency);
+}
+
+void CaptureV4L2Private::resetStats()
+{
+    this->m_statsMutex.lock();
+    this->m_latency = 0.0;
+    this->m_droppedFrames = 0;
+    this->m_statsMutex.unlock();
+    this->m_lastSequence = -1;
+    this->m_peakBacklog = 0;
+
+    emit self->latencyChanged(0.0);
+    emit self->droppedFramesChanged(0);
+}
+
 AkPacket CaptureV4L2Private::processFrame(const char * const *planeData,
                                           const ssize_t *planeSize,
                                           qint64 pts)
@@ -1683,6 +2017,125 @@ AkPacket CaptureV4L2Private::processFrame(const char * const *planeData,
     return this->m_outPacket;
 }
 
+AkPacket CaptureV4L2Private::wrapFrame(const v4l2_buffer &buffer,
+                                       const ssize_t *planeSize,
+                                       qint64 pts)
+{
+    if (!this->m_bufferPool)
+        return {};
+
+    // Only the buffers containing all the planes can be wrapped.
+    if (this->planesCount(this->m_v4l2Format) != 1 || planeSize[0] < 1)
+        return {};
+
+    auto planeData = this->m_buffers[int(buffer.index)].start[0];
+    size_t lineSize[VIDEO_MAX_PLANES];
+    memset(lineSize, 0, VIDEO_MAX_PLANES * sizeof(size_t));
+
+    if (this->m_caps.type() == AkCaps::CapsVideo) {
+        AkVideoCaps caps(this->m_caps);
+        auto specs = AkVideoCaps::formatSpecs(caps.format());
+        size_t bytesPerLine =
+                this->m_v4l2Format.type == V4L2_BUF_TYPE_VIDEO_CAPTURE?
+                    this->m_v4l2Format.fmt.pix.bytesperline:
+                    this->m_v4l2Format.fmt.pix_mp.plane_fmt[0].bytesperline;
+
+        if (bytesPerLine < 1
+            || specs.planes() < 1
+            || specs.planes() > VIDEO_MAX_PLANES)
+            return {};
+
+        // The lines of each plane are scaled from the lines of the first one.
+        size_t frameSize = 0;
+
+        for (size_t plane = 0; plane < specs.planes(); plane++) {
+            lineSize[plane] = bytesPerLine
+                            * specs.plane(plane).bitsSize()
+                            / specs.plane(0).bitsSize();
+            frameSize += (lineSize[plane] * caps.height())
+                         >> specs.plane(plane).heightDiv();
+        }
+
+        if (frameSize > size_t(planeSize[0]))
+            return {};
+    }
+
+    auto &pool = this->m_bufferPool;
+    pool->m_mutex.lock();
+    int queued = pool->m_buffers.size() - pool->m_inFlight - 1;
+    bool canWrap = queued >= MIN_QUEUED_BUFFERS;
+
+    if (canWrap) {
+        pool->m_inFlight++;
+        pool->m_peakInFlight = qMax(pool->m_peakInFlight, pool->m_inFlight);
+    } else {
+        pool->m_starved = true;
+    }
+
+    pool->m_mutex.unlock();
+
+    if (!canWrap)
+        return {};
+
+    auto ref = new CaptureBufferRef;
+    ref->pool = pool;
+    memcpy(&ref->buffer, &buffer, sizeof(v4l2_buffer));
+    memset(ref->planes, 0, VIDEO_MAX_PLANES * sizeof(v4l2_plane));
+
+    if (buffer.type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+        memcpy(ref->planes,
+               buffer.m.planes,
+               buffer.length * sizeof(v4l2_plane));
+        ref->buffer.m.planes = ref->planes;
+    }
+
+    if (this->m_caps.type() == AkCaps::CapsVideoCompressed) {
+        AkCompressedVideoPacket oPacket(this->m_caps,
+                                        planeData,
+                                        size_t(planeSize[0]),
+                                        CaptureV4L2Private::releaseBuffer,
+                                        ref);
+        oPacket.setPts(pts);
+        oPacket.setDuration(1);
+        oPacket.setTimeBase(this->m_timeBase);
+        oPacket.setIndex(0);
+        oPacket.setId(this->m_id);
+
+        return oPacket;
+    }
+
+    AkVideoPacket oPacket(this->m_caps,
+                          reinterpret_cast<quint8 *>(planeData),
+                          size_t(planeSize[0]),
+                          lineSize,
+                          CaptureV4L2Private::releaseBuffer,
+                          ref);
+    oPacket.setPts(pts);
+    oPacket.setDuration(1);
+    oPacket.setTimeBase(this->m_timeBase);
+    oPacket.setIndex(0);
+    oPacket.setId(this->m_id);
+
+    return oPacket;
+}
+
+void CaptureV4L2Private::releaseBuffer(void *userData)
+{
+    auto ref = reinterpret_cast<CaptureBufferRef *>(userData);
+    auto &pool = ref->pool;
+
+    pool->m_mutex.lock();
+
+    if (pool->m_streaming)
+        x_ioctl(pool->m_fd, VIDIOC_QBUF, &ref->buffer);
+
+    pool->m_inFlight--;
+    pool->m_mutex.unlock();
+
+    // This may free the buffers if the capture was already stopped.
+    delete ref;
+}
+
 QVariantList CaptureV4L2Private::imageControls(int fd) const
 {
     return this->controls(fd, V4L2_CTRL_CLASS_USER);
@@ -46,6 +46,9 @@ class CaptureV4L2: public Capture
         Q_INVOKABLE QList<int> listTracks(AkCaps::CapsType type) override;
         Q_INVOKABLE QString ioMethod() const override;
         Q_INVOKABLE int nBuffers() const override;
+        Q_INVOKABLE bool latestFrameOnly() const override;
+        Q_INVOKABLE qreal latency() const override;
+        Q_INVOKABLE quint64 droppedFrames() const override;
         Q_INVOKABLE QString description(const QString &webcam) const override;
         Q_INVOKABLE AkCapsList caps(const QString &webcam) const override;
         Q_INVOKABLE QVariantList imageControls() const override;
@@ -66,10 +69,12 @@ class CaptureV4L2: public Capture
         void setStreams(const QList<int> &streams) override;
         void setIoMethod(const QString &ioMethod) override;
         void setNBuffers(int nBuffers) override;
+        void setLatestFrameOnly(bool latestFrameOnly) override;
         void resetDevice() override;
         void resetStreams() override;
         void resetIoMethod() override;
         void resetNBuffers() override;
+        void resetLatestFrameOnly() override;
         void reset() override;
 };
 
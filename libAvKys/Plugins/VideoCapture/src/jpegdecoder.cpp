@@ -0,0 +1,371 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QBuffer>
+#include <QImage>
+#include <QImageReader>
+#include <QSize>
+#include <QVector>
+#include <akcompressedvideocaps.h>
+#include <akcompressedvideopacket.h>
+#include <akfrac.h>
+#include <akvideocaps.h>
+
+#ifdef HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+    #include <jpeglib.h>
+}
+
+#if JPEG_LIB_VERSION >= 70
+#define DCT_H_SCALED_SIZE(comp) (comp)->DCT_h_scaled_size
+#define DCT_V_SCALED_SIZE(comp) (comp)->DCT_v_scaled_size
+#define MIN_DCT_V_SCALED_SIZE(cinfo) (cinfo)->min_DCT_v_scaled_size
+#else
+#define DCT_H_SCALED_SIZE(comp) (comp)->DCT_scaled_size
+#define DCT_V_SCALED_SIZE(comp) (comp)->DCT_scaled_size
+#define MIN_DCT_V_SCALED_SIZE(cinfo) (cinfo)->min_DCT_scaled_size
+#endif
+#endif
+
+#include "jpegdecoder.h"
+
+#ifdef HAVE_LIBJPEG
+struct JpegErrorManager
+{
+    jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+};
+#endif
+
+class JpegDecoderPrivate
+{
+    public:
+        static AkVideoPacket decodeQt(const AkCompressedVideoPacket &packet,
+                                      int scale);
+
+#ifdef HAVE_LIBJPEG
+        static AkVideoPacket decodeYuv(const AkCompressedVideoPacket &packet,
+                                       int scale);
+        static bool readYuv(jpeg_decompress_struct *cinfo,
+                            JpegErrorManager *errorManager,
+                            const AkCompressedVideoPacket &packet,
+                            int scale,
+                            AkVideoPacket &videoPacket,
+                            QVector<quint8> &rows,
+                            QVector<JSAMPROW> &rowPointers);
+        static AkVideoCaps::PixelFormat rawFormat(const jpeg_decompress_struct &cinfo);
+        static void errorExit(j_common_ptr cinfo);
+        static void outputMessage(j_common_ptr cinfo);
+#endif
+};
+
+bool JpegDecoder::isAvailable()
+{
+#ifdef HAVE_LIBJPEG
+    return true;
+#else
+    static const bool available =
+            QImageReader::supportedImageFormats().contains("jpeg");
+
+    return available;
+#endif
+}
+
+QSize JpegDecoder::scaledSize(const QSize &size, int scale)
+{
+    scale = qBound(1, scale, 8);
+
+    return {(size.width() + scale - 1) / scale,
+            (size.height() + scale - 1) / scale};
+}
+
+AkVideoCaps::PixelFormat JpegDecoder::defaultFormat()
+{
+#ifdef HAVE_LIBJPEG
+    return AkVideoCaps::Format_yuv422p;
+#else
+    return AkVideoCaps::Format_argbpack;
+#endif
+}
+
+AkVideoPacket JpegDecoder::decode(const AkCompressedVideoPacket &packet,
+                                  int scale)
+{
+    if (!packet
+        || packet.caps().codec() != AkCompressedVideoCaps::VideoCodecID_jpeg)
+        return {};
+
+    // Only the scales supported by the DCT are allowed.
+    if (scale != 2 && scale != 4 && scale != 8)
+        scale = 1;
+
+#ifdef HAVE_LIBJPEG
+    auto videoPacket = JpegDecoderPrivate::decodeYuv(packet, scale);
+
+    if (videoPacket)
+        return videoPacket;
+#endif
+
+    return JpegDecoderPrivate::decodeQt(packet, scale);
+}
+
+AkVideoPacket JpegDecoderPrivate::decodeQt(const AkCompressedVideoPacket &packet,
+                                           int scale)
+{
+    auto data = QByteArray::fromRawData(packet.constData(), int(packet.size()));
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, "JPG");
+    QSize size(packet.caps().rawCaps().width(),
+               packet.caps().rawCaps().height());
+
+    // The JPEG plugin of Qt scales in the DCT domain when possible.
+    if (scale > 1) {
+        auto imageSize = reader.size();
+
+        if (imageSize.isValid())
+            size = imageSize;
+
+        size = JpegDecoder::scaledSize(size, scale);
+        reader.setScaledSize(size);
+    }
+
+    auto image = reader.read();
+
+    if (image.isNull())
+        return {};
+
+    if (image.format() != QImage::Format_ARGB32)
+        image = image.convertToFormat(QImage::Format_ARGB32);
+
+    AkVideoCaps videoCaps(AkVideoCaps::Format_argbpack,
+                          scale > 1? image.width(): size.width(),
+                          scale > 1? image.height(): size.height(),
+                          packet.caps().rawCaps().fps());
+    AkVideoPacket videoPacket(videoCaps);
+    videoPacket.setPts(packet.pts());
+    videoPacket.setDuration(packet.duration());
+    videoPacket.setTimeBase(packet.timeBase());
+    videoPacket.setIndex(packet.index());
+    videoPacket.setId(packet.id());
+
+    auto lineSize =
+            qMin<size_t>(image.bytesPerLine(), videoPacket.lineSize(0));
+    auto height = qMin(image.height(), videoCaps.height());
+
+    for (int y = 0; y < height; ++y) {
+        auto srcLine = image.constScanLine(y);
+        auto dstLine = videoPacket.line(0, y);
+        memcpy(dstLine, srcLine, lineSize);
+    }
+
+    return videoPacket;
+}
+
+#ifdef HAVE_LIBJPEG
+AkVideoPacket JpegDecoderPrivate::decodeYuv(const AkCompressedVideoPacket &packet,
+                                            int scale)
+{
+    jpeg_decompress_struct cinfo;
+    memset(&cinfo, 0, sizeof(jpeg_decompress_struct));
+    JpegErrorManager errorManager;
+    cinfo.err = jpeg_std_error(&errorManager.pub);
+    errorManager.pub.error_exit = JpegDecoderPrivate::errorExit;
+    errorManager.pub.output_message = JpegDecoderPrivate::outputMessage;
+
+    /* libjpeg reports the errors with longjmp(), which skips the destructors
+     * and leaves undefined the local variables modified after setjmp().
+     * The buffers are owned here, and readYuv() does the decoding, so they
+     * are always valid and released.
+     */
+    AkVideoPacket videoPacket;
+    QVector<quint8> rows;
+    QVector<JSAMPROW> rowPointers;
+    auto ok = JpegDecoderPrivate::readYuv(&cinfo,
+                                          &errorManager,
+                                          packet,
+                                          scale,
+                                          videoPacket,
+                                          rows,
+                                          rowPointers);
+    jpeg_destroy_decompress(&cinfo);
+
+    if (!ok)
+        return {};
+
+    return videoPacket;
+}
+
+bool JpegDecoderPrivate::readYuv(jpeg_decompress_struct *cinfo,
+                                 JpegErrorManager *errorManager,
+                                 const AkCompressedVideoPacket &packet,
+                                 int scale,
+                                 AkVideoPacket &videoPacket,
+                                 QVector<quint8> &rows,
+                                 QVector<JSAMPROW> &rowPointers)
+{
+    if (setjmp(errorManager->setjmpBuffer))
+        return false;
+
+    jpeg_create_decompress(cinfo);
+    jpeg_mem_src(cinfo,
+                 reinterpret_cast<unsigned char *>(const_cast<char *>(packet.constData())),
+                 packet.size());
+
+    if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK)
+        return false;
+
+    auto format = JpegDecoderPrivate::rawFormat(*cinfo);
+
+    if (format == AkVideoCaps::Format_none)
+        return false;
+
+    // Read the planes as they are stored in the stream.
+    cinfo->raw_data_out = TRUE;
+    cinfo->do_fancy_upsampling = FALSE;
+    cinfo->dct_method = JDCT_IFAST;
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = scale;
+    jpeg_start_decompress(cinfo);
+
+    videoPacket = AkVideoPacket({format,
+                                 int(cinfo->output_width),
+                                 int(cinfo->output_height),
+                                 packet.caps().rawCaps().fps()});
+    videoPacket.setPts(packet.pts());
+    videoPacket.setDuration(packet.duration());
+    videoPacket.setTimeBase(packet.timeBase());
+    videoPacket.setIndex(packet.index());
+    videoPacket.setId(packet.id());
+
+    /* libjpeg writes whole blocks, so the lines of an iMCU row are decoded to
+     * a temporary buffer and then copied to the planes of the frame.
+     */
+    int components = cinfo->output_components;
+    int rowSize[MAX_COMPONENTS];
+    int rowsPerIMCU[MAX_COMPONENTS];
+    size_t rowsOffset[MAX_COMPONENTS];
+    size_t rowsSize = 0;
+    int nRows = 0;
+
+    for (int c = 0; c < components; c++) {
+        auto comp = cinfo->comp_info + c;
+        rowSize[c] = int(comp->width_in_blocks) * DCT_H_SCALED_SIZE(comp);
+        rowsPerIMCU[c] = comp->v_samp_factor * DCT_V_SCALED_SIZE(comp);
+        rowsOffset[c] = rowsSize;
+        rowsSize += size_t(rowSize[c]) * size_t(rowsPerIMCU[c]);
+        nRows += rowsPerIMCU[c];
+    }
+
+    rows.resize(int(rowsSize));
+    rowPointers.resize(nRows);
+    JSAMPARRAY planes[MAX_COMPONENTS];
+    auto rowPointer = rowPointers.data();
+
+    for (int c = 0; c < components; c++) {
+        planes[c] = rowPointer;
+
+        for (int row = 0; row < rowsPerIMCU[c]; row++)
+            rowPointer[row] = rows.data() + rowsOffset[c] + size_t(row * rowSize[c]);
+
+        rowPointer += rowsPerIMCU[c];
+    }
+
+    auto height = videoPacket.caps().height();
+    auto linesPerIMCU =
+            JDIMENSION(cinfo->max_v_samp_factor * MIN_DCT_V_SCALED_SIZE(cinfo));
+
+    while (cinfo->output_scanline < cinfo->output_height) {
+        auto y = int(cinfo->output_scanline);
+
+        if (jpeg_read_raw_data(cinfo, planes, linesPerIMCU) < 1)
+            break;
+
+        for (int c = 0; c < components; c++) {
+            auto comp = cinfo->comp_info + c;
+            int planeY = y * comp->v_samp_factor / cinfo->max_v_samp_factor;
+            int planeHeight = height >> videoPacket.heightDiv(c);
+            auto copyBytes =
+                    qMin<size_t>(videoPacket.bytesUsed(c), size_t(rowSize[c]));
+            auto lineSize = videoPacket.lineSize(c);
+            auto dstLine = videoPacket.plane(c) + size_t(planeY) * lineSize;
+
+            for (int row = 0;
+                 row < rowsPerIMCU[c] && planeY + row < planeHeight;
+                 row++) {
+                memcpy(dstLine, planes[c][row], copyBytes);
+                dstLine += lineSize;
+            }
+        }
+    }
+
+    if (cinfo->output_scanline < cinfo->output_height)
+        jpeg_abort_decompress(cinfo);
+    else
+        jpeg_finish_decompress(cinfo);
+
+    return true;
+}
+
+AkVideoCaps::PixelFormat JpegDecoderPrivate::rawFormat(const jpeg_decompress_struct &cinfo)
+{
+    if (cinfo.num_components == 1
+        && cinfo.jpeg_color_space == JCS_GRAYSCALE)
+        return AkVideoCaps::Format_y8;
+
+    if (cinfo.num_components != 3
+        || cinfo.jpeg_color_space != JCS_YCbCr)
+        return AkVideoCaps::Format_none;
+
+    // The chroma planes must not be subsampled relative to each other.
+    for (int c = 1; c < 3; c++)
+        if (cinfo.comp_info[c].h_samp_factor != 1
+            || cinfo.comp_info[c].v_samp_factor != 1)
+            return AkVideoCaps::Format_none;
+
+    auto &luma = cinfo.comp_info[0];
+
+    if (luma.h_samp_factor == 2 && luma.v_samp_factor == 2)
+        return AkVideoCaps::Format_yuv420p;
+
+    if (luma.h_samp_factor == 2 && luma.v_samp_factor == 1)
+        return AkVideoCaps::Format_yuv422p;
+
+    if (luma.h_samp_factor == 1 && luma.v_samp_factor == 1)
+        return AkVideoCaps::Format_yuv444p;
+
+    return AkVideoCaps::Format_none;
+}
+
+void JpegDecoderPrivate::errorExit(j_common_ptr cinfo)
+{
+    auto errorManager = reinterpret_cast<JpegErrorManager *>(cinfo->err);
+    longjmp(errorManager->setjmpBuffer, 1);
+}
+
+void JpegDecoderPrivate::outputMessage(j_common_ptr cinfo)
+{
+    // Corrupted frames are common in MJPEG streams, don't flood the log.
+    Q_UNUSED(cinfo)
+}
+#endif
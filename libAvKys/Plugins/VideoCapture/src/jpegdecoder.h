@@ -0,0 +1,54 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef JPEGDECODER_H
+#define JPEGDECODER_H
+
+#include <akvideopacket.h>
+
+class AkCompressedVideoPacket;
+
+/* Decodes the frames of MJPEG cameras.
+ *
+ * When libjpeg is available, the frames are decoded to the planar YUV format
+ * stored in the JPEG, without upsampling the chroma nor converting to RGB.
+ * Otherwise the frames are decoded with Qt as ARGB.
+ *
+ * The frames can be scaled down by 2, 4 or 8 while decoding, in the DCT
+ * domain, which is a lot faster than decoding at full size and scaling.
+ */
+class JpegDecoder
+{
+    public:
+        static bool isAvailable();
+
+        // Size of the decoded frame for the given scale.
+        static QSize scaledSize(const QSize &size, int scale);
+
+        /* Format of the decoded frames. The real format depends on the
+         * chroma subsampling of each stream, so this is the format of most
+         * MJPEG cameras until a frame is decoded.
+         */
+        static AkVideoCaps::PixelFormat defaultFormat();
+
+        static AkVideoPacket decode(const AkCompressedVideoPacket &packet,
+                                    int scale);
+};
+
+#endif // JPEGDECODER_H
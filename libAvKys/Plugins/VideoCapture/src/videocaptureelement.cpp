@@ -19,11 +19,13 @@
 
 #include <QAbstractEventDispatcher>
 #include <QFuture>
-#include <QImage>
+#include <QMutex>
 #include <QQmlContext>
+#include <QQueue>
 #include <QReadWriteLock>
 #include <QSharedPointer>
 #include <QThreadPool>
+#include <QWaitCondition>
 #include <QtConcurrent>
 #include <akcaps.h>
 #include <akcompressedvideocaps.h>
@@ -39,9 +41,13 @@
 #include "videocaptureelement.h"
 #include "convertvideo.h"
 #include "capture.h"
+#include "jpegdecoder.h"
 
 #define PAUSE_TIMEOUT 500
 
+// Maximum number of frames being decoded at the same time.
+#define MAX_JPEG_DECODERS 4
+
 template <typename T>
 inline void waitLoop(const QFuture<T> &loop)
 {
@@ -82,14 +88,22 @@ class VideoCaptureElementPrivate
         QString m_captureImpl;
         QMap<QString, StringsCache> m_stringsCache;
         QThreadPool m_threadPool;
+        QThreadPool m_decodingPool;
         QFuture<void> m_cameraLoopResult;
         QReadWriteLock m_mutex;
+        QMutex m_decodingMutex;
+        QWaitCondition m_decodingCondition;
+        quint64 m_nextDecodedFrame {0};
+        std::atomic<int> m_jpegScale {1};
+        std::atomic<AkVideoCaps::PixelFormat> m_jpegFormat {AkVideoCaps::Format_none};
         bool m_runCameraLoop {false};
         bool m_pause {false};
 
         explicit VideoCaptureElementPrivate(VideoCaptureElement *self);
         QString capsDescription(const AkCaps &caps) const;
-        AkVideoPacket decodeJpg(const AkCompressedVideoPacket &packet);
+        void decodeJpg(const AkCompressedVideoPacket &packet,
+                       int scale,
+                       quint64 frame);
         void cameraLoop();
         void linksChanged(const AkPluginLinks &links);
         void buildStringCache();
@@ -136,6 +150,18 @@ VideoCaptureElement::VideoCaptureElement():
                          &Capture::pictureTaken,
                          this,
                          &VideoCaptureElement::pictureTaken);
+        QObject::connect(this->d->m_capture.data(),
+                         &Capture::latestFrameOnlyChanged,
+                         this,
+                         &VideoCaptureElement::latestFrameOnlyChanged);
+        QObject::connect(this->d->m_capture.data(),
+                         &Capture::latencyChanged,
+                         this,
+                         &VideoCaptureElement::latencyChanged);
+        QObject::connect(this->d->m_capture.data(),
+                         &Capture::droppedFramesChanged,
+                         this,
+                         &VideoCaptureElement::droppedFramesChanged);
         QObject::connect(this->d->m_capture.data(),
                          &Capture::isTorchSupportedChanged,
                          this,
@@ -311,9 +337,24 @@ AkCaps VideoCaptureElement::caps(int stream)
 
     if (deviceCaps.type() == AkCaps::CapsVideoCompressed) {
         AkVideoCaps videoCaps(deviceCaps);
-        caps = AkVideoCaps(AkVideoCaps::Format_argb,
-                           videoCaps.width(),
-                           videoCaps.height(),
+        QSize size(videoCaps.width(), videoCaps.height());
+        AkCompressedVideoCaps compressedCaps(deviceCaps);
+        auto format = AkVideoCaps::Format_argb;
+
+        if (compressedCaps.codec() == AkCompressedVideoCaps::VideoCodecID_jpeg
+            && JpegDecoder::isAvailable()) {
+            size = JpegDecoder::scaledSize(size, this->d->m_jpegScale);
+
+            // Report the format of the last decoded frame when possible.
+            format = this->d->m_jpegFormat;
+
+            if (format == AkVideoCaps::Format_none)
+                format = JpegDecoder::defaultFormat();
+        }
+
+        caps = AkVideoCaps(format,
+                           size.width(),
+                           size.height(),
                            videoCaps.fps());
     } else {
         caps = deviceCaps;
@@ -403,6 +444,53 @@ int VideoCaptureElement::nBuffers() const
     return nBuffers;
 }
 
+bool VideoCaptureElement::latestFrameOnly() const
+{
+    this->d->m_mutex.lockForRead();
+    auto capture = this->d->m_capture;
+    this->d->m_mutex.unlock();
+
+    bool latestFrameOnly = false;
+
+    if (capture)
+        latestFrameOnly = capture->latestFrameOnly();
+
+    return latestFrameOnly;
+}
+
+qreal VideoCaptureElement::latency() const
+{
+    this->d->m_mutex.lockForRead();
+    auto capture = this->d->m_capture;
+    this->d->m_mutex.unlock();
+
+    qreal latency = 0.0;
+
+    if (capture)
+        latency = capture->latency();
+
+    return latency;
+}
+
+quint64 VideoCaptureElement::droppedFrames() const
+{
+    this->d->m_mutex.lockForRead();
+    auto capture = this->d->m_capture;
+    this->d->m_mutex.unlock();
+
+    quint64 droppedFrames = 0;
+
+    if (capture)
+        droppedFrames = capture->droppedFrames();
+
+    return droppedFrames;
+}
+
+int VideoCaptureElement::jpegScale() const
+{
+    return this->d->m_jpegScale;
+}
+
 QVariantList VideoCaptureElement::imageControls() const
 {
     this->d->m_mutex.lockForRead();
@@ -801,6 +889,28 @@ void VideoCaptureElement::setNBuffers(int nBuffers)
         capture->setNBuffers(nBuffers);
 }
 
+void VideoCaptureElement::setLatestFrameOnly(bool latestFrameOnly)
+{
+    this->d->m_mutex.lockForRead();
+    auto capture = this->d->m_capture;
+    this->d->m_mutex.unlock();
+
+    if (capture)
+        capture->setLatestFrameOnly(latestFrameOnly);
+}
+
+void VideoCaptureElement::setJpegScale(int jpegScale)
+{
+    if (jpegScale != 2 && jpegScale != 4 && jpegScale != 8)
+        jpegScale = 1;
+
+    if (this->d->m_jpegScale == jpegScale)
+        return;
+
+    this->d->m_jpegScale = jpegScale;
+    emit this->jpegScaleChanged(jpegScale);
+}
+
 void VideoCaptureElement::setTorchMode(TorchMode mode)
 {
     this->d->m_mutex.lockForRead();
@@ -851,6 +961,21 @@ void VideoCaptureElement::resetNBuffers()
         capture->resetNBuffers();
 }
 
+void VideoCaptureElement::resetLatestFrameOnly()
+{
+    this->d->m_mutex.lockForRead();
+    auto capture = this->d->m_capture;
+    this->d->m_mutex.unlock();
+
+    if (capture)
+        capture->resetLatestFrameOnly();
+}
+
+void VideoCaptureElement::resetJpegScale()
+{
+    this->setJpegScale(1);
+}
+
 void VideoCaptureElement::resetTorchMode()
 {
     this->d->m_mutex.lockForRead();
@@ -873,6 +998,8 @@ void VideoCaptureElement::reset()
     auto capture = this->d->m_capture;
     this->d->m_mutex.unlock();
 
+    this->resetJpegScale();
+
     if (capture) {
         capture->reset();
         media = capture->device();
@@ -1007,6 +1134,9 @@ VideoCaptureElementPrivate::VideoCaptureElementPrivate(VideoCaptureElement *self
     this->m_captureImpl =
             akPluginManager->defaultPlugin("VideoSource/CameraCapture/Impl/*",
                                            {"CameraCaptureImpl"}).id();
+    this->m_decodingPool.setMaxThreadCount(qBound(1,
+                                                  QThread::idealThreadCount(),
+                                                  MAX_JPEG_DECODERS));
 }
 
 QString VideoCaptureElementPrivate::capsDescription(const AkCaps &caps) const
@@ -1041,44 +1171,30 @@ QString VideoCaptureElementPrivate::capsDescription(const AkCaps &caps) const
     return {};
 }
 
-AkVideoPacket VideoCaptureElementPrivate::decodeJpg(const AkCompressedVideoPacket &packet)
+void VideoCaptureElementPrivate::decodeJpg(const AkCompressedVideoPacket &packet,
+                                           int scale,
+                                           quint64 frame)
 {
-    if (!packet
-        || packet.caps().codec() != AkCompressedVideoCaps::VideoCodecID_jpeg)
-        return {};
+    auto oPacket = JpegDecoder::decode(packet, scale);
 
-    auto image =
-            QImage::fromData(reinterpret_cast<const uchar *>(packet.constData()),
-                             packet.size(),
-                             "JPG");
+    if (oPacket)
+        this->m_jpegFormat = oPacket.caps().format();
 
-    if (image.isNull())
-        return {};
+    /* Consecutive frames are decoded in parallel, wait for the previous
+     * frames to be sent, so the frames are sent in the same order they
+     * were captured.
+     */
+    this->m_decodingMutex.lock();
 
-    if (image.format() != QImage::Format_ARGB32)
-        image = image.convertToFormat(QImage::Format_ARGB32);
-
-    AkVideoCaps videoCaps(AkVideoCaps::Format_argbpack,
-                          packet.caps().rawCaps().width(),
-                          packet.caps().rawCaps().height(),
-                          packet.caps().rawCaps().fps());
-    AkVideoPacket videoPacket(videoCaps);
-    videoPacket.setPts(packet.pts());
-    videoPacket.setDuration(packet.duration());
-    videoPacket.setTimeBase(packet.timeBase());
-    videoPacket.setIndex(packet.index());
-    videoPacket.setId(packet.id());
-
-    auto lineSize =
-            qMin<size_t>(image.bytesPerLine(), videoPacket.lineSize(0));
-
-    for (int y = 0; y < image.height(); ++y) {
-        auto srcLine = image.constScanLine(y);
-        auto dstLine = videoPacket.line(0, y);
-        memcpy(dstLine, srcLine, lineSize);
-    }
+    while (this->m_nextDecodedFrame != frame)
+        this->m_decodingCondition.wait(&this->m_decodingMutex);
+
+    if (oPacket)
+        emit self->oStream(oPacket);
 
-    return videoPacket;
+    this->m_nextDecodedFrame++;
+    this->m_decodingCondition.wakeAll();
+    this->m_decodingMutex.unlock();
 }
 
 void VideoCaptureElementPrivate::cameraLoop()
@@ -1090,6 +1206,12 @@ void VideoCaptureElementPrivate::cameraLoop()
     if (capture && capture->init()) {
         QSharedPointer<ConvertVideo> convertVideo;
         bool initConvert = true;
+        QQueue<QFuture<void>> decodingQueue;
+        int maxDecoding = this->m_decodingPool.maxThreadCount();
+        bool useJpegDecoder = JpegDecoder::isAvailable();
+        quint64 frame = 0;
+        this->m_nextDecodedFrame = 0;
+        this->m_jpegFormat = AkVideoCaps::Format_none;
 
         while (this->m_runCameraLoop) {
             if (this->m_pause) {
@@ -1106,10 +1228,23 @@ void VideoCaptureElementPrivate::cameraLoop()
             auto caps = packet.caps();
 
             if (caps.type() == AkCaps::CapsVideoCompressed) {
-                auto oPacket = this->decodeJpg(packet);
-
-                if (oPacket) {
-                    emit self->oStream(oPacket);
+                AkCompressedVideoCaps compressedCaps(caps);
+
+                if (useJpegDecoder
+                    && compressedCaps.codec() == AkCompressedVideoCaps::VideoCodecID_jpeg) {
+                    while (!decodingQueue.isEmpty()
+                           && (decodingQueue.size() >= maxDecoding
+                               || decodingQueue.head().isFinished()))
+                        decodingQueue.dequeue().waitForFinished();
+
+                    decodingQueue <<
+                        QtConcurrent::run(&this->m_decodingPool,
+                                          &VideoCaptureElementPrivate::decodeJpg,
+                                          this,
+                                          AkCompressedVideoPacket(packet),
+                                          int(this->m_jpegScale),
+                                          frame);
+                    frame++;
                 } else {
                     if (initConvert) {
                         convertVideo =
@@ -1137,6 +1272,9 @@ void VideoCaptureElementPrivate::cameraLoop()
             }
         }
 
+        while (!decodingQueue.isEmpty())
+            decodingQueue.dequeue().waitForFinished();
+
         if (convertVideo)
             convertVideo->uninit();
 
@@ -1195,6 +1333,18 @@ void VideoCaptureElementPrivate::linksChanged(const AkPluginLinks &links)
                      &Capture::pictureTaken,
                      self,
                      &VideoCaptureElement::pictureTaken);
+    QObject::connect(this->m_capture.data(),
+                     &Capture::latestFrameOnlyChanged,
+                     self,
+                     &VideoCaptureElement::latestFrameOnlyChanged);
+    QObject::connect(this->m_capture.data(),
+                     &Capture::latencyChanged,
+                     self,
+                     &VideoCaptureElement::latencyChanged);
+    QObject::connect(this->m_capture.data(),
+                     &Capture::droppedFramesChanged,
+                     self,
+                     &VideoCaptureElement::droppedFramesChanged);
     QObject::connect(this->m_capture.data(),
                      &Capture::isTorchSupportedChanged,
                      self,
@@ -58,6 +58,22 @@ class VideoCaptureElement: public AkMultimediaSourceElement
                WRITE setNBuffers
                RESET resetNBuffers
                NOTIFY nBuffersChanged)
+    Q_PROPERTY(bool latestFrameOnly
+               READ latestFrameOnly
+               WRITE setLatestFrameOnly
+               RESET resetLatestFrameOnly
+               NOTIFY latestFrameOnlyChanged)
+    Q_PROPERTY(qreal latency
+               READ latency
+               NOTIFY latencyChanged)
+    Q_PROPERTY(quint64 droppedFrames
+               READ droppedFrames
+               NOTIFY droppedFramesChanged)
+    Q_PROPERTY(int jpegScale
+               READ jpegScale
+               WRITE setJpegScale
+               RESET resetJpegScale
+               NOTIFY jpegScaleChanged)
     Q_PROPERTY(bool isTorchSupported
                READ isTorchSupported
                NOTIFY isTorchSupportedChanged)
@@ -102,6 +118,10 @@ class VideoCaptureElement: public AkMultimediaSourceElement
         Q_INVOKABLE QStringList listCapsDescription() const;
         Q_INVOKABLE QString ioMethod() const;
         Q_INVOKABLE int nBuffers() const;
+        Q_INVOKABLE bool latestFrameOnly() const;
+        Q_INVOKABLE qreal latency() const;
+        Q_INVOKABLE quint64 droppedFrames() const;
+        Q_INVOKABLE int jpegScale() const;
         Q_INVOKABLE QVariantList imageControls() const;
         Q_INVOKABLE bool setImageControls(const QVariantMap &imageControls);
         Q_INVOKABLE bool resetImageControls();
@@ -144,6 +164,10 @@ class VideoCaptureElement: public AkMultimediaSourceElement
         void loopChanged(bool loop);
         void ioMethodChanged(const QString &ioMethod);
         void nBuffersChanged(int nBuffers);
+        void latestFrameOnlyChanged(bool latestFrameOnly);
+        void latencyChanged(qreal latency);
+        void droppedFramesChanged(quint64 droppedFrames);
+        void jpegScaleChanged(int jpegScale);
         void imageControlsChanged(const QVariantMap &imageControls);
         void cameraControlsChanged(const QVariantMap &cameraControls);
         void pictureTaken(int index, const AkPacket &picture);
@@ -156,11 +180,15 @@ class VideoCaptureElement: public AkMultimediaSourceElement
         void setStreams(const QList<int> &streams) override;
         void setIoMethod(const QString &ioMethod);
         void setNBuffers(int nBuffers);
+        void setLatestFrameOnly(bool latestFrameOnly);
+        void setJpegScale(int jpegScale);
         void setTorchMode(TorchMode mode);
         void resetMedia() override;
         void resetStreams() override;
         void resetIoMethod();
         void resetNBuffers();
+        void resetLatestFrameOnly();
+        void resetJpegScale();
         void resetTorchMode();
         void reset();
         void takePictures(int count, int delayMsecs=0);
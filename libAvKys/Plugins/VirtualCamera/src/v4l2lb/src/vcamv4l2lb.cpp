@@ -23,16 +23,22 @@
 #include <QDir>
 #include <QElapsedTimer>
 #include <QFileSystemWatcher>
+#include <QFuture>
 #include <QMutex>
 #include <QProcessEnvironment>
+#include <QQueue>
 #include <QRegularExpression>
 #include <QSettings>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrent>
 #include <fcntl.h>
 #include <limits>
 #include <linux/videodev2.h>
+#include <poll.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -59,6 +65,12 @@
 
 #define MAX_CAMERAS 64
 
+// Maximum number of frames waiting to be written to the device.
+#define MAX_QUEUED_FRAMES 2
+
+// Time to wait for the clients to release an output buffer.
+#define POLL_TIMEOUT 1000
+
 enum IoMethod
 {
     IoMethodUnknown = -1,
@@ -79,6 +91,18 @@ struct CaptureBuffer
     size_t length[VIDEO_MAX_PLANES];
 };
 
+struct OutputFrame
+{
+    AkVideoPacket packet;
+    bool horizontalFlip;
+    bool verticalFlip;
+    bool swapRedBlue;
+    AkVideoConverter::ScalingMode scalingMode;
+    AkVideoConverter::AspectRatioMode aspectRatioMode;
+};
+
+using OutputFramePtr = QSharedPointer<OutputFrame>;
+
 using RwMode = __u32;
 
 struct DeviceInfo
@@ -132,16 +156,26 @@ class VCamV4L2LoopBackPrivate
         QVector<CaptureBuffer> m_buffers;
         QMap<QString, DeviceControlValues> m_deviceControlValues;
         QMutex m_controlsMutex;
-        AkElementPtr m_flipFilter   {akPluginManager->create<AkElement>("VideoFilter/Flip")};
         AkElementPtr m_swapRBFilter {akPluginManager->create<AkElement>("VideoFilter/SwapRB")};
         QString m_error;
         AkVideoCaps m_currentCaps;
+        AkVideoCaps m_outputCaps;
         AkVideoConverter m_videoConverter;
         QString m_rootMethod;
         v4l2_format m_v4l2Format;
+        QVector<size_t> m_lineSizes;
         IoMethod m_ioMethod {IoMethodUnknown};
         int m_fd {-1};
         int m_nBuffers {32};
+        QThreadPool m_threadPool;
+        QFuture<void> m_writerResult;
+        QMutex m_framesMutex;
+        QWaitCondition m_framesAvailable;
+        QQueue<OutputFramePtr> m_frames;
+        VCam::DropPolicy m_dropPolicy {VCam::DropPolicy_Oldest};
+        bool m_runWriter {false};
+        bool m_writeError {false};
+        quint64 m_droppedFrames {0};
 
         explicit VCamV4L2LoopBackPrivate(VCamV4L2LoopBack *self);
         VCamV4L2LoopBackPrivate(const VCamV4L2LoopBackPrivate &other) = delete;
@@ -191,6 +225,13 @@ class VCamV4L2LoopBackPrivate
         void stopOutput(const v4l2_format &format);
         void writeFrame(char * const *planeData,
                         const AkVideoPacket &videoPacket);
+        void updateLineSizes(const v4l2_format &format);
+        AkVideoPacket wrapBuffer(const CaptureBuffer &buffer) const;
+        bool convertFrame(const AkVideoPacket &packet,
+                          const CaptureBuffer &buffer);
+        bool writeOutputFrame(const OutputFrame &frame);
+        void writerLoop();
+        void stopWriter();
         void updateDevices();
         QString cleanDescription(const QString &description) const;
         QVector<int> requestDeviceNR(size_t count) const;
@@ -403,6 +444,16 @@ AkVideoCaps VCamV4L2LoopBack::currentCaps() const
     return this->d->m_currentCaps;
 }
 
+AkVideoCaps VCamV4L2LoopBack::outputCaps() const
+{
+    return this->d->m_outputCaps;
+}
+
+VCam::DropPolicy VCamV4L2LoopBack::dropPolicy() const
+{
+    return this->d->m_dropPolicy;
+}
+
 QVariantList VCamV4L2LoopBack::controls() const
 {
     return this->d->m_globalControls;
@@ -1216,7 +1267,9 @@ bool VCamV4L2LoopBack::init()
     v4l2_fract fps = {__u32(outputCaps.fps().num()),
                       __u32(outputCaps.fps().den())};
     this->d->setFps(this->d->m_fd, fmt.type, fps);
+    this->d->m_outputCaps = outputCaps;
     this->d->m_videoConverter.setOutputCaps(outputCaps);
+    this->d->updateLineSizes(fmt);
 
     if (this->d->m_ioMethod == IoMethodReadWrite
         && capabilities.capabilities & V4L2_CAP_READWRITE
@@ -1297,11 +1350,6 @@ void VCamV4L2LoopBack::setDevice(const QString &device)
             close(fd);
 
             for (auto &control: this->d->deviceControls()) {
-                if ((control.name == "Horizontal Flip" || control.name == "Vertical Flip")
-                    && !this->d->m_flipFilter) {
-                    continue;
-                }
-
                 if ((control.name == "Swap Red and Blue")
                     && !this->d->m_swapRBFilter) {
                     continue;
@@ -1347,6 +1395,17 @@ void VCamV4L2LoopBack::setCurrentCaps(const AkVideoCaps &currentCaps)
     emit this->currentCapsChanged(this->d->m_currentCaps);
 }
 
+void VCamV4L2LoopBack::setDropPolicy(VCam::DropPolicy dropPolicy)
+{
+    if (this->d->m_dropPolicy == dropPolicy)
+        return;
+
+    this->d->m_framesMutex.lock();
+    this->d->m_dropPolicy = dropPolicy;
+    this->d->m_framesMutex.unlock();
+    emit this->dropPolicyChanged(dropPolicy);
+}
+
 void VCamV4L2LoopBack::setRootMethod(const QString &rootMethod)
 {
     if (this->d->m_rootMethod == rootMethod)
@@ -1393,56 +1452,57 @@ bool VCamV4L2LoopBack::write(const AkVideoPacket &packet)
     }
 
     auto values = this->d->m_deviceControlValues[this->d->m_device];
-    auto packet_ = packet;
+    OutputFramePtr frame(new OutputFrame {
+        packet,
+        bool(values.value("Horizontal Flip", false)),
+        bool(values.value("Vertical Flip", false)),
+        bool(values.value("Swap Red and Blue", false)),
+        AkVideoConverter::ScalingMode(values.value("Scaling Mode", 0)),
+        AkVideoConverter::AspectRatioMode(values.value("Aspect Ratio Mode", 0)),
+    });
 
-    if (this->d->m_flipFilter) {
-        this->d->m_flipFilter->setProperty("horizontalFlip", values.value("Horizontal Flip", false));
-        this->d->m_flipFilter->setProperty("verticalFlip", values.value("Vertical Flip", false));
-        packet_ = this->d->m_flipFilter->iStream(packet_);
+    // The converter can't swap red and blue if none of the formats is RGB.
+    if (frame->swapRedBlue
+        && AkVideoCaps::formatSpecs(packet.caps().format()).type() != AkVideoFormatSpec::VFT_RGB
+        && AkVideoCaps::formatSpecs(this->d->m_outputCaps.format()).type() != AkVideoFormatSpec::VFT_RGB) {
+        if (this->d->m_swapRBFilter)
+            frame->packet = this->d->m_swapRBFilter->iStream(packet);
+
+        frame->swapRedBlue = false;
     }
 
-    if (this->d->m_swapRBFilter && values.value("Swap Red and Blue", false))
-        packet_ = this->d->m_swapRBFilter->iStream(packet_);
+    /* The frame is written to the device from another thread, so a slow
+     * client does not block the capture. When the queue is full a frame is
+     * discarded according to the drop policy.
+     */
+    this->d->m_framesMutex.lock();
 
-    this->d->m_videoConverter.setScalingMode(AkVideoConverter::ScalingMode(values.value("Scaling Mode", 0)));
-    this->d->m_videoConverter.setAspectRatioMode(AkVideoConverter::AspectRatioMode(values.value("Aspect Ratio Mode", 0)));
-    this->d->m_videoConverter.begin();
-    auto videoPacket = this->d->m_videoConverter.convert(packet_);
-    this->d->m_videoConverter.end();
+    if (!this->d->m_runWriter) {
+        this->d->m_framesMutex.unlock();
 
-    if (!videoPacket)
         return false;
+    }
 
-    if (this->d->m_ioMethod == IoMethodReadWrite) {
-        this->d->writeFrame(this->d->m_buffers[0].start, videoPacket);
-        int planesCount = this->d->planesCount(this->d->m_v4l2Format);
+    if (this->d->m_frames.size() >= MAX_QUEUED_FRAMES) {
+        this->d->m_droppedFrames++;
 
-        for (int i = 0; i < planesCount; i++) {
-            if (::write(this->d->m_fd,
-                           this->d->m_buffers[0].start[i],
-                           this->d->m_buffers[0].length[i]) < 0)
-                return false;
-        }
-    } else if (this->d->m_ioMethod == IoMethodMemoryMap
-        || this->d->m_ioMethod == IoMethodUserPointer) {
-        v4l2_buffer buffer;
-        memset(&buffer, 0, sizeof(v4l2_buffer));
-        buffer.type = this->d->m_v4l2Format.type;
-        buffer.memory = (this->d->m_ioMethod == IoMethodMemoryMap)?
-                            V4L2_MEMORY_MMAP:
-                            V4L2_MEMORY_USERPTR;
+        if (this->d->m_dropPolicy == VCam::DropPolicy_Newest) {
+            this->d->m_framesMutex.unlock();
 
-        if (this->d->xioctl(this->d->m_fd, VIDIOC_DQBUF, &buffer) < 0)
             return false;
+        }
 
-        if (buffer.index < quint32(this->d->m_buffers.size()))
-            this->d->writeFrame(this->d->m_buffers[int(buffer.index)].start,
-                    videoPacket);
-
-        return this->d->xioctl(this->d->m_fd, VIDIOC_QBUF, &buffer) >= 0;
+        this->d->m_frames.removeFirst();
     }
 
-    return false;
+    this->d->m_frames << frame;
+    this->d->m_framesAvailable.wakeAll();
+
+    // Report the result of the last frame written by the writer thread.
+    bool ok = !this->d->m_writeError;
+    this->d->m_framesMutex.unlock();
+
+    return ok;
 }
 
 VCamV4L2LoopBackPrivate::VCamV4L2LoopBackPrivate(VCamV4L2LoopBack *self):
@@ -1461,6 +1521,7 @@ VCamV4L2LoopBackPrivate::VCamV4L2LoopBackPrivate(VCamV4L2LoopBack *self):
 
 VCamV4L2LoopBackPrivate::~VCamV4L2LoopBackPrivate()
 {
+    this->stopWriter();
     delete this->m_fsWatcher;
 }
 
@@ -2404,14 +2465,33 @@ bool VCamV4L2LoopBackPrivate::startOutput(const v4l2_format &format)
         }
     }
 
-    if (error)
+    if (error) {
         self->uninit();
 
-    return !error;
+        return false;
+    }
+
+    this->m_frames.clear();
+    this->m_droppedFrames = 0;
+    this->m_writeError = false;
+    this->m_runWriter = true;
+    this->m_writerResult =
+            QtConcurrent::run(&this->m_threadPool,
+                              &VCamV4L2LoopBackPrivate::writerLoop,
+                              this);
+
+    return true;
 }
 
 void VCamV4L2LoopBackPrivate::stopOutput(const v4l2_format &format)
 {
+    this->stopWriter();
+    this->m_frames.clear();
+
+    if (this->m_droppedFrames > 0)
+        qDebug() << "VirtualCamera: Frames dropped by the writer:"
+                 << this->m_droppedFrames;
+
     if (this->m_ioMethod == IoMethodMemoryMap
         || this->m_ioMethod == IoMethodUserPointer) {
         auto type = v4l2_buf_type(format.type);
@@ -2450,6 +2530,163 @@ void VCamV4L2LoopBackPrivate::writeFrame(char * const *planeData,
     }
 }
 
+void VCamV4L2LoopBackPrivate::updateLineSizes(const v4l2_format &format)
+{
+    this->m_lineSizes.clear();
+
+    // Only the frames stored in a single buffer can be wrapped.
+    if (format.type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+        return;
+
+    AkVideoPacket layout(this->m_outputCaps);
+    auto bytesUsed = layout.bytesUsed(0);
+
+    if (bytesUsed < 1)
+        return;
+
+    /* The line size of the other planes is scaled the same way as the line
+     * size of the first plane, like in the V4L2 planar formats.
+     */
+    for (size_t plane = 0; plane < layout.planes(); ++plane)
+        this->m_lineSizes << layout.bytesUsed(int(plane))
+                             * format.fmt.pix.bytesperline
+                             / bytesUsed;
+}
+
+AkVideoPacket VCamV4L2LoopBackPrivate::wrapBuffer(const CaptureBuffer &buffer) const
+{
+    if (this->m_lineSizes.isEmpty())
+        return {};
+
+    return {this->m_outputCaps,
+            reinterpret_cast<quint8 *>(buffer.start[0]),
+            buffer.length[0],
+            this->m_lineSizes.constData(),
+            nullptr,
+            nullptr,
+            true};
+}
+
+bool VCamV4L2LoopBackPrivate::convertFrame(const AkVideoPacket &packet,
+                                           const CaptureBuffer &buffer)
+{
+    // Convert the frame straight into the buffer of the device if possible.
+    auto output = this->wrapBuffer(buffer);
+
+    if (output && this->m_videoConverter.convert(packet, output))
+        return true;
+
+    auto videoPacket = this->m_videoConverter.convert(packet);
+
+    if (!videoPacket)
+        return false;
+
+    this->writeFrame(buffer.start, videoPacket);
+
+    return true;
+}
+
+bool VCamV4L2LoopBackPrivate::writeOutputFrame(const OutputFrame &frame)
+{
+    this->m_videoConverter.setScalingMode(frame.scalingMode);
+    this->m_videoConverter.setAspectRatioMode(frame.aspectRatioMode);
+    this->m_videoConverter.setHorizontalFlip(frame.horizontalFlip);
+    this->m_videoConverter.setVerticalFlip(frame.verticalFlip);
+    this->m_videoConverter.setSwapRedBlue(frame.swapRedBlue);
+
+    if (this->m_ioMethod == IoMethodReadWrite) {
+        auto &buffer = this->m_buffers[0];
+        this->m_videoConverter.begin();
+        bool ok = this->convertFrame(frame.packet, buffer);
+        this->m_videoConverter.end();
+
+        if (!ok)
+            return false;
+
+        int planesCount = this->planesCount(this->m_v4l2Format);
+
+        for (int i = 0; i < planesCount; i++) {
+            if (::write(this->m_fd,
+                        buffer.start[i],
+                        buffer.length[i]) < 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    if (this->m_ioMethod != IoMethodMemoryMap
+        && this->m_ioMethod != IoMethodUserPointer)
+        return false;
+
+    // Wait until the clients release a buffer.
+    pollfd fds;
+    fds.fd = this->m_fd;
+    fds.events = POLLOUT;
+    fds.revents = 0;
+
+    if (poll(&fds, 1, POLL_TIMEOUT) < 1)
+        return false;
+
+    v4l2_buffer buffer;
+    memset(&buffer, 0, sizeof(v4l2_buffer));
+    buffer.type = this->m_v4l2Format.type;
+    buffer.memory = (this->m_ioMethod == IoMethodMemoryMap)?
+                        V4L2_MEMORY_MMAP:
+                        V4L2_MEMORY_USERPTR;
+
+    if (this->xioctl(this->m_fd, VIDIOC_DQBUF, &buffer) < 0)
+        return false;
+
+    bool ok = false;
+
+    if (buffer.index < quint32(this->m_buffers.size())) {
+        this->m_videoConverter.begin();
+        ok = this->convertFrame(frame.packet,
+                                this->m_buffers[int(buffer.index)]);
+        this->m_videoConverter.end();
+    }
+
+    // The buffer must be returned to the device even if the frame failed.
+    if (this->xioctl(this->m_fd, VIDIOC_QBUF, &buffer) < 0)
+        return false;
+
+    return ok;
+}
+
+void VCamV4L2LoopBackPrivate::writerLoop()
+{
+    forever {
+        this->m_framesMutex.lock();
+
+        while (this->m_runWriter && this->m_frames.isEmpty())
+            this->m_framesAvailable.wait(&this->m_framesMutex);
+
+        if (!this->m_runWriter) {
+            this->m_framesMutex.unlock();
+
+            break;
+        }
+
+        auto frame = this->m_frames.takeFirst();
+        this->m_framesMutex.unlock();
+        bool ok = this->writeOutputFrame(*frame);
+
+        this->m_framesMutex.lock();
+        this->m_writeError = !ok;
+        this->m_framesMutex.unlock();
+    }
+}
+
+void VCamV4L2LoopBackPrivate::stopWriter()
+{
+    this->m_framesMutex.lock();
+    this->m_runWriter = false;
+    this->m_framesAvailable.wakeAll();
+    this->m_framesMutex.unlock();
+    this->m_writerResult.waitForFinished();
+}
+
 void VCamV4L2LoopBackPrivate::updateDevices()
 {
     decltype(this->m_devices) devices;
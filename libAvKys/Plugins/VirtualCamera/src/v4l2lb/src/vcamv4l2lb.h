@@ -42,6 +42,8 @@ class VCamV4L2LoopBack: public VCam
         Q_INVOKABLE AkVideoCaps::PixelFormat defaultOutputPixelFormat() const override;
         Q_INVOKABLE AkVideoCapsList caps(const QString &webcam) const override;
         Q_INVOKABLE AkVideoCaps currentCaps() const override;
+        Q_INVOKABLE AkVideoCaps outputCaps() const override;
+        Q_INVOKABLE VCam::DropPolicy dropPolicy() const override;
         Q_INVOKABLE QVariantList controls() const override;
         Q_INVOKABLE bool setControls(const QVariantMap &controls) override;
         Q_INVOKABLE QList<quint64> clientsPids() const override;
@@ -68,6 +70,7 @@ class VCamV4L2LoopBack: public VCam
         void uninit() override;
         void setDevice(const QString &device) override;
         void setCurrentCaps(const AkVideoCaps &currentCaps) override;
+        void setDropPolicy(VCam::DropPolicy dropPolicy) override;
         void setRootMethod(const QString &rootMethod) override;
         bool write(const AkVideoPacket &packet) override;
 };
@@ -78,6 +78,16 @@ AkVideoCaps VCam::currentCaps() const
     return {};
 }
 
+AkVideoCaps VCam::outputCaps() const
+{
+    return {};
+}
+
+VCam::DropPolicy VCam::dropPolicy() const
+{
+    return DropPolicy_Oldest;
+}
+
 QVariantList VCam::controls() const
 {
     return {};
@@ -199,6 +209,11 @@ void VCam::setCurrentCaps(const AkVideoCaps &currentCaps)
     Q_UNUSED(currentCaps)
 }
 
+void VCam::setDropPolicy(VCam::DropPolicy dropPolicy)
+{
+    Q_UNUSED(dropPolicy)
+}
+
 void VCam::setPicture(const QString &picture)
 {
     Q_UNUSED(picture)
@@ -219,6 +234,11 @@ void VCam::resetCurrentCaps()
     this->setCurrentCaps({});
 }
 
+void VCam::resetDropPolicy()
+{
+    this->setDropPolicy(DropPolicy_Oldest);
+}
+
 void VCam::resetPicture()
 {
     this->setPicture({});
@@ -50,6 +50,11 @@ class VCam: public QObject
                WRITE setCurrentCaps
                RESET resetCurrentCaps
                NOTIFY currentCapsChanged)
+    Q_PROPERTY(VCam::DropPolicy dropPolicy
+               READ dropPolicy
+               WRITE setDropPolicy
+               RESET resetDropPolicy
+               NOTIFY dropPolicyChanged)
     Q_PROPERTY(QString picture
                READ picture
                WRITE setPicture
@@ -71,6 +76,14 @@ class VCam: public QObject
                CONSTANT)
 
     public:
+        // Which frame is discarded when the device can't keep up.
+        enum DropPolicy
+        {
+            DropPolicy_Oldest,
+            DropPolicy_Newest
+        };
+        Q_ENUM(DropPolicy)
+
         VCam(QObject *parent=nullptr);
         virtual ~VCam() = default;
 
@@ -84,6 +97,10 @@ class VCam: public QObject
         Q_INVOKABLE virtual AkVideoCaps::PixelFormat defaultOutputPixelFormat() const;
         Q_INVOKABLE virtual AkVideoCapsList caps(const QString &webcam) const;
         Q_INVOKABLE virtual AkVideoCaps currentCaps() const;
+
+        // Caps of the frames written to the device, valid after init().
+        Q_INVOKABLE virtual AkVideoCaps outputCaps() const;
+        Q_INVOKABLE virtual VCam::DropPolicy dropPolicy() const;
         Q_INVOKABLE virtual QVariantList controls() const;
         Q_INVOKABLE virtual bool setControls(const QVariantMap &controls);
         Q_INVOKABLE virtual QList<quint64> clientsPids() const;
@@ -108,6 +125,7 @@ class VCam: public QObject
         void webcamsChanged(const QStringList &webcams);
         void deviceChanged(const QString &device);
         void currentCapsChanged(const AkVideoCaps &error);
+        void dropPolicyChanged(VCam::DropPolicy dropPolicy);
         void pictureChanged(const QString &picture);
         void rootMethodChanged(const QString &rootMethod);
         void controlsChanged(const QVariantMap &controls);
@@ -119,12 +137,16 @@ class VCam: public QObject
         virtual bool applyPicture();
         virtual void setDevice(const QString &device);
         virtual void setCurrentCaps(const AkVideoCaps &currentCaps);
+        virtual void setDropPolicy(VCam::DropPolicy dropPolicy);
         virtual void setPicture(const QString &picture);
         virtual void setRootMethod(const QString &rootMethod);
         virtual void resetDevice();
         virtual void resetCurrentCaps();
+        virtual void resetDropPolicy();
         virtual void resetPicture();
         virtual void resetRootMethod();
 };
 
+Q_DECLARE_METATYPE(VCam::DropPolicy)
+
 #endif // VCAM_H
@@ -20,12 +20,15 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
+#include <QFuture>
 #include <QImage>
 #include <QMutex>
 #include <QQmlComponent>
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QSharedPointer>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <akfrac.h>
 #include <akpacket.h>
 #include <akplugininfo.h>
@@ -38,11 +41,32 @@
 
 #define MAX_CAMERAS 64
 
+using AkVideoConverterPtr = QSharedPointer<AkVideoConverter>;
+
+struct OutputSettings
+{
+    AkVideoCaps caps;
+    VCam::DropPolicy dropPolicy {VCam::DropPolicy_Oldest};
+};
+
+struct OutputGroup
+{
+    AkVideoCaps caps;
+    QList<VCamPtr> outputs;
+    AkVideoPacket packet;
+};
+
 class VirtualCameraElementPrivate
 {
     public:
         VirtualCameraElement *self;
         VCamPtr m_vcam;
+        QList<VCamPtr> m_outputs;
+        QStringList m_outputMedias;
+        QMap<QString, OutputSettings> m_outputSettings;
+        QList<AkVideoConverterPtr> m_converters;
+        QThreadPool m_threadPool;
+        AkVideoCaps m_streamCaps;
         QString m_vcamImpl;
         QMutex m_mutex;
         int m_streamIndex {-1};
@@ -50,6 +74,12 @@ class VirtualCameraElementPrivate
 
         explicit VirtualCameraElementPrivate(VirtualCameraElement *self);
         static inline int roundTo(int value, int n);
+        void configureOutput(VCamPtr output, const QString &media);
+        void initOutputs();
+        void uninitOutputs();
+        AkVideoConverterPtr converter(const AkVideoCaps &caps);
+        void writeOutputs(const QList<VCamPtr> &outputs,
+                          const AkVideoPacket &packet);
         void linksChanged(const AkPluginLinks &links);
 };
 
@@ -142,6 +172,33 @@ QString VirtualCameraElement::media() const
     return media;
 }
 
+QStringList VirtualCameraElement::outputMedias() const
+{
+    this->d->m_mutex.lock();
+    auto outputMedias = this->d->m_outputMedias;
+    this->d->m_mutex.unlock();
+
+    return outputMedias;
+}
+
+AkVideoCaps VirtualCameraElement::outputMediaCaps(const QString &media) const
+{
+    this->d->m_mutex.lock();
+    auto caps = this->d->m_outputSettings.value(media).caps;
+    this->d->m_mutex.unlock();
+
+    return caps;
+}
+
+VCam::DropPolicy VirtualCameraElement::outputMediaDropPolicy(const QString &media) const
+{
+    this->d->m_mutex.lock();
+    auto dropPolicy = this->d->m_outputSettings.value(media).dropPolicy;
+    this->d->m_mutex.unlock();
+
+    return dropPolicy;
+}
+
 QList<int> VirtualCameraElement::streams() const
 {
     return {0};
@@ -246,6 +303,7 @@ QVariantMap VirtualCameraElement::addStream(int streamIndex,
 
     this->d->m_mutex.lock();
     auto vcam = this->d->m_vcam;
+    this->d->m_streamCaps = streamCaps;
     this->d->m_mutex.unlock();
 
     if (vcam)
@@ -273,6 +331,7 @@ QVariantMap VirtualCameraElement::updateStream(int streamIndex,
 
     this->d->m_mutex.lock();
     auto vcam = this->d->m_vcam;
+    this->d->m_streamCaps = streamCaps;
     this->d->m_mutex.unlock();
 
     if (vcam)
@@ -563,10 +622,18 @@ AkPacket VirtualCameraElement::iVideoStream(const AkVideoPacket &packet)
     if (this->state() == AkElement::ElementStatePlaying) {
         this->d->m_mutex.lock();
         auto vcam = this->d->m_vcam;
+        auto outputs = this->d->m_outputs;
         this->d->m_mutex.unlock();
 
-        if (vcam)
-            vcam->write(packet);
+        if (outputs.isEmpty()) {
+            if (vcam)
+                vcam->write(packet);
+        } else {
+            if (vcam)
+                outputs.prepend(vcam);
+
+            this->d->writeOutputs(outputs, packet);
+        }
     }
 
     if (packet)
@@ -599,6 +666,44 @@ void VirtualCameraElement::setMedia(const QString &media)
         vcam->setDevice(media);
 }
 
+void VirtualCameraElement::setOutputMedias(const QStringList &outputMedias)
+{
+    this->d->m_mutex.lock();
+
+    if (this->d->m_outputMedias == outputMedias) {
+        this->d->m_mutex.unlock();
+
+        return;
+    }
+
+    this->d->m_outputMedias = outputMedias;
+    this->d->m_mutex.unlock();
+    emit this->outputMediasChanged(outputMedias);
+}
+
+void VirtualCameraElement::setOutputMediaCaps(const QString &media,
+                                              const AkVideoCaps &caps)
+{
+    this->d->m_mutex.lock();
+    this->d->m_outputSettings[media].caps = caps;
+    this->d->m_mutex.unlock();
+}
+
+void VirtualCameraElement::setOutputMediaDropPolicy(const QString &media,
+                                                    VCam::DropPolicy dropPolicy)
+{
+    this->d->m_mutex.lock();
+    this->d->m_outputSettings[media].dropPolicy = dropPolicy;
+    auto outputs = this->d->m_outputs;
+    outputs << this->d->m_vcam;
+    this->d->m_mutex.unlock();
+
+    // Apply the policy right away to the devices that are already running.
+    for (auto &output: outputs)
+        if (output && output->device() == media)
+            output->setDropPolicy(dropPolicy);
+}
+
 void VirtualCameraElement::setPicture(const QString &picture)
 {
     this->d->m_mutex.lock();
@@ -629,6 +734,11 @@ void VirtualCameraElement::resetMedia()
         vcam->resetPicture();
 }
 
+void VirtualCameraElement::resetOutputMedias()
+{
+    this->setOutputMedias({});
+}
+
 void VirtualCameraElement::resetPicture()
 {
     this->d->m_mutex.lock();
@@ -655,6 +765,7 @@ void VirtualCameraElement::clearStreams()
 
     this->d->m_mutex.lock();
     auto vcam = this->d->m_vcam;
+    this->d->m_streamCaps = {};
     this->d->m_mutex.unlock();
 
     if (vcam)
@@ -679,9 +790,12 @@ bool VirtualCameraElement::setState(AkElement::ElementState state)
                 return false;
             }
 
+            this->d->configureOutput(vcam, vcam->device());
+
             if (!vcam->init())
                 return false;
 
+            this->d->initOutputs();
             this->d->m_playing = true;
 
             return AkElement::setState(state);
@@ -704,6 +818,8 @@ bool VirtualCameraElement::setState(AkElement::ElementState state)
             if (vcam)
                 vcam->uninit();
 
+            this->d->uninitOutputs();
+
             return AkElement::setState(state);
         }
         case AkElement::ElementStatePlaying:
@@ -726,6 +842,8 @@ bool VirtualCameraElement::setState(AkElement::ElementState state)
             if (vcam)
                 vcam->uninit();
 
+            this->d->uninitOutputs();
+
             return AkElement::setState(state);
         }
         case AkElement::ElementStatePaused:
@@ -756,6 +874,138 @@ int VirtualCameraElementPrivate::roundTo(int value, int n)
     return n * qRound(value / qreal(n));
 }
 
+void VirtualCameraElementPrivate::configureOutput(VCamPtr output,
+                                                  const QString &media)
+{
+    this->m_mutex.lock();
+    auto settings = this->m_outputSettings.value(media);
+    auto streamCaps = this->m_streamCaps;
+    this->m_mutex.unlock();
+
+    // The caps are used for selecting the nearest format of the device.
+    if (settings.caps)
+        output->setCurrentCaps(settings.caps);
+    else if (streamCaps)
+        output->setCurrentCaps(streamCaps);
+
+    output->setDropPolicy(settings.dropPolicy);
+}
+
+void VirtualCameraElementPrivate::initOutputs()
+{
+    QList<VCamPtr> outputs;
+    QStringList medias;
+
+    if (this->m_vcam)
+        medias << this->m_vcam->device();
+
+    this->m_mutex.lock();
+    auto outputMedias = this->m_outputMedias;
+    this->m_mutex.unlock();
+
+    for (auto &media: outputMedias) {
+        if (media.isEmpty() || medias.contains(media))
+            continue;
+
+        medias << media;
+        auto output =
+                akPluginManager->create<VCam>("VideoSink/VirtualCamera/Impl/*");
+
+        if (!output)
+            break;
+
+        output->setDevice(media);
+        this->configureOutput(output, media);
+
+        if (output->init())
+            outputs << output;
+        else
+            qDebug() << "VirtualCamera: Can't open the output device" << media;
+    }
+
+    this->m_mutex.lock();
+    this->m_outputs = outputs;
+    this->m_mutex.unlock();
+}
+
+void VirtualCameraElementPrivate::uninitOutputs()
+{
+    this->m_mutex.lock();
+    auto outputs = this->m_outputs;
+    this->m_outputs.clear();
+    this->m_converters.clear();
+    this->m_mutex.unlock();
+
+    for (auto &output: outputs)
+        output->uninit();
+}
+
+AkVideoConverterPtr VirtualCameraElementPrivate::converter(const AkVideoCaps &caps)
+{
+    this->m_mutex.lock();
+
+    for (auto &converter: this->m_converters)
+        if (converter->outputCaps() == caps) {
+            auto curConverter = converter;
+            this->m_mutex.unlock();
+
+            return curConverter;
+        }
+
+    auto converter = AkVideoConverterPtr(new AkVideoConverter(caps));
+    this->m_converters << converter;
+    this->m_mutex.unlock();
+
+    return converter;
+}
+
+void VirtualCameraElementPrivate::writeOutputs(const QList<VCamPtr> &outputs,
+                                               const AkVideoPacket &packet)
+{
+    // Group the devices with the same output caps.
+    QVector<OutputGroup> groups;
+
+    for (auto &output: outputs) {
+        auto caps = output->outputCaps();
+        auto it = std::find_if(groups.begin(),
+                               groups.end(),
+                               [&caps] (const OutputGroup &group) {
+            return group.caps == caps;
+        });
+
+        if (caps && it != groups.end())
+            it->outputs << output;
+        else
+            groups << OutputGroup {caps, {output}, {}};
+    }
+
+    /* The frame is converted just once for all the devices in a group, and
+     * the groups are converted in parallel. A device alone in its group
+     * converts the frame by itself in its own writing thread.
+     */
+    QVector<QFuture<void>> results;
+
+    for (auto &group: groups) {
+        if (group.outputs.size() < 2)
+            continue;
+
+        auto converter = this->converter(group.caps);
+        results << QtConcurrent::run(&this->m_threadPool,
+                                     [&group, converter, &packet] () {
+            converter->begin();
+            group.packet = converter->convert(packet);
+            converter->end();
+        });
+    }
+
+    for (auto &result: results)
+        result.waitForFinished();
+
+    for (auto &group: groups)
+        for (auto &output: group.outputs)
+            output->write(group.packet? group.packet: packet);
+}
+
 void VirtualCameraElementPrivate::linksChanged(const AkPluginLinks &links)
 {
     if (!links.contains("VideoSink/VirtualCamera/Impl/*")
@@ -25,6 +25,8 @@
 #include <iak/akelement.h>
 #include <akvideocaps.h>
 
+#include "vcam.h"
+
 class VirtualCameraElementPrivate;
 
 class VirtualCameraElement: public AkElement
@@ -41,6 +43,11 @@ class VirtualCameraElement: public AkElement
                WRITE setMedia
                RESET resetMedia
                NOTIFY mediaChanged)
+    Q_PROPERTY(QStringList outputMedias
+               READ outputMedias
+               WRITE setOutputMedias
+               RESET resetOutputMedias
+               NOTIFY outputMediasChanged)
     Q_PROPERTY(QList<int> streams
                READ streams
                NOTIFY streamsChanged)
@@ -89,6 +96,9 @@ class VirtualCameraElement: public AkElement
         Q_INVOKABLE QString error() const;
         Q_INVOKABLE QStringList medias() const;
         Q_INVOKABLE QString media() const;
+        Q_INVOKABLE QStringList outputMedias() const;
+        Q_INVOKABLE AkVideoCaps outputMediaCaps(const QString &media) const;
+        Q_INVOKABLE VCam::DropPolicy outputMediaDropPolicy(const QString &media) const;
         Q_INVOKABLE QList<int> streams() const;
         Q_INVOKABLE int maxCameras() const;
         Q_INVOKABLE AkVideoCaps::PixelFormatList supportedOutputPixelFormats() const;
@@ -137,6 +147,7 @@ class VirtualCameraElement: public AkElement
         void errorChanged(const QString &error);
         void mediasChanged(const QStringList &medias);
         void mediaChanged(const QString &media);
+        void outputMediasChanged(const QStringList &outputMedias);
         void streamsChanged(const QList<int> &streams);
         void maxCamerasChanged(int maxCameras);
         void supportedOutputPixelFormatsChanged(const AkVideoCaps::PixelFormatList &supportedOutputPixelFormats);
@@ -147,9 +158,14 @@ class VirtualCameraElement: public AkElement
     public slots:
         bool applyPicture();
         void setMedia(const QString &media);
+        void setOutputMedias(const QStringList &outputMedias);
+        void setOutputMediaCaps(const QString &media, const AkVideoCaps &caps);
+        void setOutputMediaDropPolicy(const QString &media,
+                                      VCam::DropPolicy dropPolicy);
         void setPicture(const QString &picture);
         void setRootMethod(const QString &rootMethod);
         void resetMedia();
+        void resetOutputMedias();
         void resetPicture();
         void resetRootMethod();
         void clearStreams();
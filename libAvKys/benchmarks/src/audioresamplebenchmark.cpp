@@ -0,0 +1,117 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMetaEnum>
+#include <QVector>
+#include <QtMath>
+#include <akaudioconverter.h>
+#include <akaudiocaps.h>
+#include <akaudiopacket.h>
+#include <akfrac.h>
+
+/* Time the resampling methods of AkAudioConverter, converting a stereo sweep
+ * captured at 48 kHz to the rates commonly used for speech and for low
+ * bandwidth streaming.
+ */
+
+// Seconds of audio resampled for each method and rate.
+#define SIGNAL_DURATION 60
+
+// Samples per input packet, a typical capture period.
+#define PACKET_SAMPLES 1024
+
+static QVector<AkAudioPacket> sweep(const AkAudioCaps &caps, int duration)
+{
+    QVector<AkAudioPacket> packets;
+    qint64 nSamples = qint64(duration) * caps.rate();
+    qreal phase = 0.0;
+
+    for (qint64 pts = 0; pts < nSamples; pts += PACKET_SAMPLES) {
+        AkAudioPacket packet(caps, PACKET_SAMPLES);
+        packet.setPts(pts);
+        packet.setTimeBase({1, caps.rate()});
+        auto data = reinterpret_cast<qint16 *>(packet.data());
+
+        for (int i = 0; i < PACKET_SAMPLES; i++) {
+            // Sweep from 20 Hz to 20 kHz in one second.
+            auto t = qreal((pts + i) % caps.rate()) / caps.rate();
+            auto frequency = 20.0 * qPow(1000.0, t);
+            phase += 2.0 * M_PI * frequency / caps.rate();
+            auto sample = qint16(16384.0 * qSin(phase));
+            data[2 * i] = sample;
+            data[2 * i + 1] = sample;
+        }
+
+        packets << packet;
+    }
+
+    return packets;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    AkAudioCaps inputCaps(AkAudioCaps::SampleFormat_s16,
+                          AkAudioCaps::Layout_stereo,
+                          false,
+                          48000);
+    auto packets = sweep(inputCaps, SIGNAL_DURATION);
+    auto methodEnum = QMetaEnum::fromType<AkAudioConverter::ResampleMethod>();
+
+    for (auto &rate: {16000, 22050}) {
+        AkAudioCaps outputCaps(inputCaps);
+        outputCaps.setRate(rate);
+
+        qInfo().noquote() << QString("48000 Hz -> %1 Hz").arg(rate);
+
+        for (auto &method: {AkAudioConverter::ResampleMethod_Fast,
+                            AkAudioConverter::ResampleMethod_Linear,
+                            AkAudioConverter::ResampleMethod_Quadratic,
+                            AkAudioConverter::ResampleMethod_Sinc}) {
+            AkAudioConverter converter(outputCaps);
+            converter.setResampleMethod(method);
+
+            /* The time includes building the sinc filters bank in the first
+             * packet, which is negligible for the length of the signal.
+             */
+            qint64 outputSamples = 0;
+            QElapsedTimer timer;
+            timer.start();
+
+            for (auto &packet: packets)
+                outputSamples += converter.convert(packet).samples();
+
+            auto elapsed = timer.nsecsElapsed();
+            QString methodStr(methodEnum.valueToKey(method));
+            methodStr.remove("ResampleMethod_");
+
+            qInfo().noquote()
+                    << QString("    %1 %2 ms, %3 ns/sample, %4x realtime")
+                       .arg(methodStr, -10)
+                       .arg(qreal(elapsed) / 1e6, 8, 'f', 2)
+                       .arg(qreal(elapsed) / qMax<qint64>(outputSamples, 1), 6, 'f', 2)
+                       .arg(1e9 * SIGNAL_DURATION / qMax<qint64>(elapsed, 1), 0, 'f', 0);
+        }
+    }
+
+    return 0;
+}
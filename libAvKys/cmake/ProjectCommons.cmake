@@ -43,6 +43,8 @@ set(ANDROID_OPENSSL_SUFFIX "_3" CACHE STRING "Set OpenSSL libraries suffix")
 set(ENABLE_ANDROID_DEBUGGING OFF CACHE BOOL "Enable debugging logs in Android")
 set(ENABLE_ANDROID_LOG_FILE OFF CACHE BOOL "Enable debugging logs in Android")
 set(ENABLE_IPO OFF CACHE BOOL "Enable interprocedural optimization")
+set(ENABLE_BENCHMARKS OFF CACHE BOOL "Build the benchmarks")
+set(ENABLE_TESTS OFF CACHE BOOL "Build the unit tests")
 set(ENABLE_SINGLE_INSTANCE OFF CACHE BOOL "Enable single instance mode (Buggy)")
 set(NOCHECKUPDATES ON CACHE BOOL "Disable updates check")
 set(NOOPENMP OFF CACHE BOOL "Disable OpenMP support")
@@ -53,6 +55,7 @@ set(NOFFMPEGSCREENCAP OFF CACHE BOOL "Disable FFmpeg screen capture support")
 set(NOGSTREAMER OFF CACHE BOOL "Disable GStreamer support")
 set(NOJACK OFF CACHE BOOL "Disable JACK support")
 set(NOLIBAVDEVICE OFF CACHE BOOL "Disable libavdevice support in FFmpeg")
+set(NOLIBJPEG OFF CACHE BOOL "Disable libjpeg support")
 set(NOLIBUSB OFF CACHE BOOL "Disable libusb  support")
 set(NOLIBUVC OFF CACHE BOOL "Disable libuvc  support")
 set(NOMEDIAFOUNDATION OFF CACHE BOOL "Disable Microsoft Media Foundation support")
@@ -0,0 +1,69 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2025  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QtTest>
+#include <akfrac.h>
+#include <akvideocaps.h>
+#include <akvideopacket.h>
+
+class AkVideoPacketTest: public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void toExternalOddHeight();
+};
+
+void AkVideoPacketTest::toExternalOddHeight()
+{
+    /* The height is not a multiple of the alignment, so the native planes
+     * are padded and the external ones are not.
+     */
+    AkVideoCaps caps(AkVideoCaps::Format_yuv420p, 640, 481, {30, 1});
+    AkVideoPacket packet(caps);
+    QVERIFY(packet);
+
+    /* The last line of the subsampled planes is incomplete for odd heights,
+     * and in the external layout it's shared with the next plane, skip it.
+     */
+    auto height = [&packet, &caps] (size_t plane) -> int {
+        return caps.height() & ~((1 << packet.heightDiv(int(plane))) - 1);
+    };
+
+    for (size_t plane = 0; plane < packet.planes(); plane++)
+        for (int y = 0; y < height(plane); y++)
+            memset(packet.line(int(plane), y),
+                   int(64 * plane + (y >> packet.heightDiv(int(plane))) % 64),
+                   packet.bytesUsed(int(plane)));
+
+    auto external = packet.toExternal();
+    QVERIFY(external);
+    QCOMPARE(external.caps(), caps);
+    QCOMPARE(external.planes(), packet.planes());
+
+    for (size_t plane = 0; plane < packet.planes(); plane++)
+        for (int y = 0; y < height(plane); y++)
+            QVERIFY(memcmp(external.constLine(int(plane), y),
+                           packet.constLine(int(plane), y),
+                           packet.bytesUsed(int(plane))) == 0);
+}
+
+QTEST_GUILESS_MAIN(AkVideoPacketTest)
+
+#include "akvideopackettest.moc"
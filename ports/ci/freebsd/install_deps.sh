@@ -31,6 +31,7 @@ pkg install -y \
     gstreamer1-plugins-good \
     jackit \
     libuvc \
+    libXdamage \
     libXext \
     libXfixes \
     pkgconf \
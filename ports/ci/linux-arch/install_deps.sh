@@ -108,6 +108,7 @@ pacman --noconfirm --needed -S \
     jack \
     libpulse \
     libusb \
+    libxdamage \
     libxext \
     libxfixes \
     make \
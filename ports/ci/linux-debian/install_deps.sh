@@ -191,6 +191,7 @@ apt-get -y install \
     libvlccore-dev \
     libvulkan-dev \
     libwebpdemux2 \
+    libxdamage-dev \
     libxext-dev \
     libxfixes-dev \
     lintian \
@@ -107,6 +107,7 @@ dnf -y install \
     lib64usb1.0-devel \
     lib64v4l-devel \
     lib64vlc-devel \
+    lib64xdamage-devel \
     lib64xext-devel \
     lib64xfixes-devel \
     make \
@@ -103,6 +103,7 @@ zypper -n in \
     libpulse-devel \
     libusb-1_0-devel \
     libv4l-devel \
+    libXdamage-devel \
     libXext-devel \
     libXfixes-devel \
     patchelf \
@@ -38,6 +38,7 @@ brew install \
     libomp \
     libuvc \
     libx11 \
+    libxdamage \
     libxext \
     libxfixes \
     p7zip \